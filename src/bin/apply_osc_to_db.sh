@@ -19,7 +19,7 @@
 
 if [[ -z $3  ]]; then
 {
-  echo "Usage: $0 replicate_dir start_id --meta=(attic|yes|no)"
+  echo "Usage: $0 replicate_dir start_id --meta=(attic|yes|no) [--record-area-changes]"
   exit 0
 }; fi
 
@@ -52,6 +52,11 @@ else
   exit 0
 }; fi
 
+AREA_CHANGES=
+if [[ $4 == "--record-area-changes" ]]; then
+  AREA_CHANGES="--record-area-changes"
+fi
+
 PRODUCE_DIFF=
 
 get_replicate_filename()
@@ -73,11 +78,12 @@ collect_minute_diffs()
 
   get_replicate_filename $TARGET
 
-  while [[ ( -s $REPLICATE_DIR/$REPLICATE_FILENAME.state.txt ) && ( $(($START + 1440)) -ge $(($TARGET)) ) && ( `du -m $TEMP_DIR | awk '{ print $1; }'` -le 512 ) ]];
+  # update_from_dir decompresses the diffs itself while it writes the already parsed changes
+  while [[ ( -s $REPLICATE_DIR/$REPLICATE_FILENAME.state.txt ) && ( $(($START + 1440)) -ge $(($TARGET)) ) && ( `du -mL $TEMP_DIR | awk '{ print $1; }'` -le 64 ) ]];
   do
   {
     printf -v TARGET_FILE %09u $TARGET
-    gunzip <$REPLICATE_DIR/$REPLICATE_FILENAME.osc.gz >$TEMP_DIR/$TARGET_FILE.osc
+    ln -s $REPLICATE_DIR/$REPLICATE_FILENAME.osc.gz $TEMP_DIR/$TARGET_FILE.osc.gz
     TARGET=$(($TARGET + 1))
     get_replicate_filename $TARGET
   };
@@ -88,13 +94,13 @@ collect_minute_diffs()
 
 apply_minute_diffs()
 {
-  ./update_from_dir --osc-dir=$1 --version=$DATA_VERSION $META --flush-size=0
+  ./update_from_dir --osc-dir=$1 --version=$DATA_VERSION $META $AREA_CHANGES --flush-size=0
   EXITCODE=$?
   while [[ $EXITCODE -ne 0 ]];
   do
   {
     sleep 60
-    ./update_from_dir --osc-dir=$1 --version=$DATA_VERSION $META --flush-size=0
+    ./update_from_dir --osc-dir=$1 --version=$DATA_VERSION $META $AREA_CHANGES --flush-size=0
     EXITCODE=$?
   };
   done
@@ -27,19 +27,17 @@ if [[ -z $1  ]]; then
 DIFFS_TO_KEEP=60
 CURRENT_DIFF="$1"
 DB_DIR="`./dispatcher --show-dir`"
-CACHE_DIR="/tmp/osm3s_augmented_diffs_cache/"
+# The archive lives next to the database to survive a reboot
+CACHE_DIR="$DB_DIR/augmented_diffs/"
 
 
 mkdir -p $CACHE_DIR
-while [[ true ]]; do
+# The archive is only contiguous if the loop continues where it stopped
+if [[ `cat "$CACHE_DIR/newest" 2>/dev/null` != $(($CURRENT_DIFF - 1)) || ! -r "$CACHE_DIR/oldest" ]]; then
+  echo $CURRENT_DIFF >"$CACHE_DIR/oldest"
+fi
 
-  # Delete outdated files in CACHE_DIR
-  for FILE in /tmp/osm3s_augmented_diffs_cache/*.osc.gz; do
-    if [[ `basename $FILE .osc.gz` -lt $(($CURRENT_DIFF - $DIFFS_TO_KEEP)) ]]; then
-      echo "Purged $FILE"
-      rm $FILE
-    fi
-  done
+while [[ true ]]; do
 
   EPOCHSECS=$(($CURRENT_DIFF * 60 + 1347432900))
   SINCE=`date --utc --date="@$EPOCHSECS" '+%FT%H:%M:%SZ'`
@@ -50,13 +48,21 @@ while [[ true ]]; do
     sleep 5
   done
 
-  FILE="$CACHE_DIR/$CURRENT_DIFF.osc.gz"
-  echo -n "Create $FILE ..."
+  echo -n "Archive diff $CURRENT_DIFF ..."
 
+  # The archive keeps the newest diffs and serves any window and bounding box of them
   QUERY_STRING='[adiff:"'$SINCE'","'$UNTIL'"];(node(changed:"'$SINCE'","'$UNTIL'");way(changed:"'$SINCE'","'$UNTIL'");rel(changed:"'$SINCE'","'$UNTIL'"););out meta geom;'
-  echo $QUERY_STRING | ./osm3s_query | gzip >"$FILE"
+  # An incomplete diff is rejected by the archive, hence it is tried again
+  if ! echo $QUERY_STRING | ./osm3s_query | ./augmented_diff_archive --archive-dir=$CACHE_DIR --add=$CURRENT_DIFF --keep=$DIFFS_TO_KEEP; then
+    echo " failed, retrying."
+    sleep 5
+    continue
+  fi
   echo " done."
 
+  if [[ $(($CURRENT_DIFF - $DIFFS_TO_KEEP + 1)) -gt `cat "$CACHE_DIR/oldest"` ]]; then
+    echo $(($CURRENT_DIFF - $DIFFS_TO_KEEP + 1)) >"$CACHE_DIR/oldest"
+  fi
   echo $CURRENT_DIFF >"$CACHE_DIR/newest"
   CURRENT_DIFF=$(($CURRENT_DIFF + 1))
 
@@ -66,6 +66,7 @@ mkdir -p "$ABS_CLONE_DIR"
 rm -f "$ABS_CLONE_DIR"/*.bin
 rm -f "$ABS_CLONE_DIR"/*.map
 rm -f "$ABS_CLONE_DIR"/*.idx
+rm -f "$ABS_CLONE_DIR"/*.manifest
 #cp "$DB_DIR/replicate_id" "$ABS_CLONE_DIR/replicate_id"
 ./osm3s_query --clone="$ABS_CLONE_DIR"
 
@@ -94,19 +94,29 @@ retry_fetch_file()
 download_file()
 {
   echo
-  echo "Fetching $1"
-  retry_fetch_file "$REMOTE_DIR/$1" "$CLONE_DIR/$1"
+  # A replica that already has a copy of the file fetches only the blocks that have changed
+  if [[ -s "$CLONE_DIR/$1" ]] && "$EXEC_DIR/bin/clone_delta" --db-dir="$CLONE_DIR" --source="$REMOTE_DIR" --file="$1"; then
+  {
+    rm -f "$CLONE_DIR/$1.idx"
+  }; else
+  {
+    echo "Fetching $1"
+    rm -f "$CLONE_DIR/$1" "$CLONE_DIR/$1.idx"
+    retry_fetch_file "$REMOTE_DIR/$1" "$CLONE_DIR/$1"
+  }; fi
   echo "Fetching $1.idx"
   retry_fetch_file "$REMOTE_DIR/$1.idx" "$CLONE_DIR/$1.idx"
 }
 
 mkdir -p "$CLONE_DIR"
+rm -f "$CLONE_DIR/base-url"
 fetch_file "$SOURCE/trigger_clone" "$CLONE_DIR/base-url"
 
 REMOTE_DIR=`cat <"$CLONE_DIR/base-url"`
 #echo "Triggered generation of a recent clone"
 #sleep 30
 
+rm -f "$CLONE_DIR/replicate_id"
 retry_fetch_file "$REMOTE_DIR/replicate_id" "$CLONE_DIR/replicate_id"
 
 for I in $FILES_BASE; do
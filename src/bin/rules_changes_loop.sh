@@ -0,0 +1,98 @@
+#!/usr/bin/env bash
+
+# Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+#
+# This file is part of Overpass_API.
+#
+# Overpass_API is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as
+# published by the Free Software Foundation, either version 3 of the
+# License, or (at your option) any later version.
+#
+# Overpass_API is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with Overpass_API. If not, see <https://www.gnu.org/licenses/>.
+
+if [[ -z $1  ]]; then
+{
+  echo Usage: $0 database_dir
+  echo The updates must run with --record-area-changes.
+  exit 0
+};
+fi
+
+DB_DIR=$1
+
+EXEC_DIR="`dirname $0`/"
+if [[ ! ${EXEC_DIR:0:1} == "/" ]]; then
+{
+  EXEC_DIR="`pwd`/$EXEC_DIR"
+};
+fi
+
+pushd "$EXEC_DIR"
+
+
+while [[ true ]]; do
+{
+  # The updates append under the same lock, hence none of them writes to the moved copy.
+  # Ids left over from an interrupted run are processed before new ones are taken.
+  if [[ -s $DB_DIR/area_changes && ! -a $DB_DIR/area_changes.processing ]]; then
+    flock $DB_DIR/area_changes.lock mv $DB_DIR/area_changes $DB_DIR/area_changes.processing
+  fi
+  if [[ -s $DB_DIR/area_changes.processing ]]; then
+  {
+    echo "`date '+%F %T'`: update started" >>$DB_DIR/rules_loop.log
+    # Runs the criteria of areas_delta.osm3s on the changed ways and relations
+    # and on the relations that contain a changed way
+    awk -v CHANGES=$DB_DIR/area_changes.processing '
+      function print_id_query(TYPE, IDS, COUNT,  I) {
+        if (COUNT == 0)
+          return;
+        printf "  <id-query type=\"%s\"", TYPE;
+        for (I = 0; I < COUNT; ++I)
+          printf " ref_%u=\"%s\"", I, IDS[I];
+        print "/>";
+      }
+      BEGIN {
+        while ((getline LINE <CHANGES) > 0) {
+          split(LINE, FIELD, " ");
+          if ((FIELD[1], FIELD[2]) in SEEN)
+            continue;
+          SEEN[FIELD[1], FIELD[2]] = 1;
+          if (FIELD[1] == "way")
+            WAYS[WAY_COUNT++] = FIELD[2];
+          else if (FIELD[1] == "relation")
+            RELATIONS[RELATION_COUNT++] = FIELD[2];
+        }
+      }
+      /<osm-script/ {
+        print;
+        print "";
+        print "<union into=\"changed_ways\">";
+        print_id_query("way", WAYS, WAY_COUNT + 0);
+        print "</union>";
+        print "<union into=\"changed_relations\">";
+        print_id_query("relation", RELATIONS, RELATION_COUNT + 0);
+        print "  <recurse type=\"way-relation\" from=\"changed_ways\"/>";
+        print "</union>";
+        next;
+      }
+      /<query type="way">/ { CHANGED_SET = "changed_ways" }
+      /<query type="relation">/ { CHANGED_SET = "changed_relations" }
+      /<changed since="{{area_version}}" until="{{area_version}}"\/>/ {
+        sub(/<changed[^>]*>/, "<item set=\"" CHANGED_SET "\"/>");
+      }
+      { print }' $DB_DIR/rules/areas_delta.osm3s | ./osm3s_query --progress --rules
+    if [[ $? -eq 0 ]]; then
+      rm $DB_DIR/area_changes.processing
+    fi
+    echo "`date '+%F %T'`: update finished" >>$DB_DIR/rules_loop.log
+  };
+  fi
+  sleep 60
+}; done
@@ -25,22 +25,35 @@ std::string escape_cstr(const std::string& s)
 {
   std::string result;
   result.reserve(s.length()*2);
+  escape_cstr(s, result);
+  return result;
+}
+
+
+void escape_cstr(const std::string& s, std::string& result)
+{
+  std::string::size_type unescaped_begin = 0;
   for (std::string::size_type i(0); i < s.size(); ++i)
   {
+    const char* replacement = 0;
     if (s[i] == '\"')
-      result += "\\\"";
+      replacement = "\\\"";
     else if (s[i] == '\\')
-      result += "\\\\";
+      replacement = "\\\\";
     else if (s[i] == '\n')
-      result += "\\n";
+      replacement = "\\n";
     else if (s[i] == '\t')
-      result += "\\t";
+      replacement = "\\t";
     else if (s[i] == '\r')
-      result += "\\r";
+      replacement = "\\r";
     else if ((unsigned char)s[i] < 32)
-      result += '?';
+      replacement = "?";
     else
-      result += s[i];
+      continue;
+
+    result.append(s, unescaped_begin, i - unescaped_begin);
+    result.append(replacement);
+    unescaped_begin = i + 1;
   }
-  return result;
+  result.append(s, unescaped_begin, std::string::npos);
 }
@@ -23,12 +23,26 @@
 
 std::string escape_xml(const std::string& s)
 {
-  const char* digit = "0123456789abcdef";
-
   std::string result;
   result.reserve(s.length()*2);
+  escape_xml(s, result);
+  return result;
+}
+
+
+void escape_xml(const std::string& s, std::string& result)
+{
+  const char* digit = "0123456789abcdef";
+
+  std::string::size_type unescaped_begin = 0;
   for (std::string::size_type i(0); i < s.size(); ++i)
   {
+    if (s[i] != '&' && s[i] != '\"' && s[i] != '<' && s[i] != '>' && (unsigned char)s[i] >= 32)
+      continue;
+
+    result.append(s, unescaped_begin, i - unescaped_begin);
+    unescaped_begin = i + 1;
+
     if (s[i] == '&')
       result += "&amp;";
     else if (s[i] == '\"')
@@ -37,15 +51,15 @@ std::string escape_xml(const std::string& s)
       result += "&lt;";
     else if (s[i] == '>')
       result += "&gt;";
-    else if ((unsigned char)s[i] < 32)
+    else if ((s[i] == '\n') || (s[i] == '\t') || (s[i] == '\r'))
     {
-      if ((s[i] == '\n') || (s[i] == '\t') || (s[i] == '\r'))
-	result += std::string("&#x") + digit[s[i] / 16] + digit[s[i] % 16] + ';';
-      else
-        result += '?';
+      result += "&#x";
+      result += digit[s[i] / 16];
+      result += digit[s[i] % 16];
+      result += ';';
     }
     else
-      result += s[i];
+      result += '?';
   }
-  return result;
+  result.append(s, unescaped_begin, std::string::npos);
 }
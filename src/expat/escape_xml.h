@@ -24,5 +24,8 @@
 
 std::string escape_xml(const std::string& s);
 
+// Appends the escaped string to result
+void escape_xml(const std::string& s, std::string& result);
+
 
 #endif
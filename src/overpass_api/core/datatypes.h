@@ -445,6 +445,16 @@ struct User_Data
 };
 
 
+// The file of user names is indexed by this hash (FNV-1a) of the name
+inline uint32 user_name_hash(const std::string& name)
+{
+  uint32 hash = 2166136261u;
+  for (std::string::size_type i = 0; i < name.size(); ++i)
+    hash = (hash ^ (uint8)name[i]) * 16777619u;
+  return hash;
+}
+
+
 struct OSM_Element_Metadata
 {
   OSM_Element_Metadata() : user_id(0) {}
@@ -603,6 +613,8 @@ struct Change_Entry
 
 struct Timestamp
 {
+  typedef uint64 Id_Type;
+
   Timestamp(uint64 timestamp_) : timestamp(timestamp_) {}
 
   uint64 timestamp;
@@ -18,6 +18,7 @@
 
 #include "four_field_index.h"
 #include "geometry.h"
+#include "great_circle.h"
 #include "index_computations.h"
 
 #include <cmath>
@@ -2112,16 +2113,27 @@ double length(const Opaque_Geometry& geometry)
   else if (geometry.has_line_geometry())
   {
     const std::vector< Point_Double >* line_geometry = geometry.get_line_geometry();
-    for (unsigned int i = 1; i < line_geometry->size(); ++i)
-      result += great_circle_dist((*line_geometry)[i-1].lat, (*line_geometry)[i-1].lon,
-          (*line_geometry)[i].lat, (*line_geometry)[i].lon);
+    Cartesian_Batch path;
+    path.reserve(line_geometry->size());
+    for (std::vector< Point_Double >::const_iterator it = line_geometry->begin(); it != line_geometry->end(); ++it)
+      path.push_back(it->lat, it->lon);
+    result = great_circle_length(path);
   }
   else if (geometry.has_faithful_way_geometry())
   {
-    for (unsigned int i = 1; i < geometry.way_size(); ++i)
-      result += (geometry.way_pos_is_valid(i-1) && geometry.way_pos_is_valid(i) ?
-          great_circle_dist(geometry.way_pos_lat(i-1), geometry.way_pos_lon(i-1),
-              geometry.way_pos_lat(i), geometry.way_pos_lon(i)) : 0);
+    // Invalid positions split the way into independent paths
+    Cartesian_Batch path;
+    for (unsigned int i = 0; i < geometry.way_size(); ++i)
+    {
+      if (geometry.way_pos_is_valid(i))
+        path.push_back(geometry.way_pos_lat(i), geometry.way_pos_lon(i));
+      else
+      {
+        result += great_circle_length(path);
+        path.clear();
+      }
+    }
+    result += great_circle_length(path);
   }
 
   return result;
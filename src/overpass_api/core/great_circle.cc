@@ -0,0 +1,303 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "great_circle.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace
+{
+  const double ARC_TO_METER = 10*1000*1000/acos(0);
+  const double PI = 2*acos(0);
+
+  // The kernels work on chunks of this size to avoid heap allocations for intermediate results.
+  const unsigned int CHUNK_SIZE = 256;
+
+
+  // result[i] = |a_i - b|^2
+  void squared_chords(double bx, double by, double bz,
+      const double* ax, const double* ay, const double* az, unsigned int size, double* result)
+  {
+    unsigned int i = 0;
+#if defined(__AVX2__)
+    __m256d vbx = _mm256_set1_pd(bx);
+    __m256d vby = _mm256_set1_pd(by);
+    __m256d vbz = _mm256_set1_pd(bz);
+    for (; i + 4 <= size; i += 4)
+    {
+      __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(ax + i), vbx);
+      __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ay + i), vby);
+      __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(az + i), vbz);
+      __m256d acc = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+      _mm256_storeu_pd(result + i, _mm256_add_pd(acc, _mm256_mul_pd(dz, dz)));
+    }
+#elif defined(__SSE2__)
+    __m128d vbx = _mm_set1_pd(bx);
+    __m128d vby = _mm_set1_pd(by);
+    __m128d vbz = _mm_set1_pd(bz);
+    for (; i + 2 <= size; i += 2)
+    {
+      __m128d dx = _mm_sub_pd(_mm_loadu_pd(ax + i), vbx);
+      __m128d dy = _mm_sub_pd(_mm_loadu_pd(ay + i), vby);
+      __m128d dz = _mm_sub_pd(_mm_loadu_pd(az + i), vbz);
+      __m128d acc = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+      _mm_storeu_pd(result + i, _mm_add_pd(acc, _mm_mul_pd(dz, dz)));
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      double dx = ax[i] - bx;
+      double dy = ay[i] - by;
+      double dz = az[i] - bz;
+      result[i] = dx*dx + dy*dy + dz*dz;
+    }
+  }
+
+
+  // result[i] = |a_i - b_i|^2
+  void squared_chord_pairs(const double* ax, const double* ay, const double* az,
+      const double* bx, const double* by, const double* bz, unsigned int size, double* result)
+  {
+    unsigned int i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= size; i += 4)
+    {
+      __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(ax + i), _mm256_loadu_pd(bx + i));
+      __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ay + i), _mm256_loadu_pd(by + i));
+      __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(az + i), _mm256_loadu_pd(bz + i));
+      __m256d acc = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+      _mm256_storeu_pd(result + i, _mm256_add_pd(acc, _mm256_mul_pd(dz, dz)));
+    }
+#elif defined(__SSE2__)
+    for (; i + 2 <= size; i += 2)
+    {
+      __m128d dx = _mm_sub_pd(_mm_loadu_pd(ax + i), _mm_loadu_pd(bx + i));
+      __m128d dy = _mm_sub_pd(_mm_loadu_pd(ay + i), _mm_loadu_pd(by + i));
+      __m128d dz = _mm_sub_pd(_mm_loadu_pd(az + i), _mm_loadu_pd(bz + i));
+      __m128d acc = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+      _mm_storeu_pd(result + i, _mm_add_pd(acc, _mm_mul_pd(dz, dz)));
+    }
+#endif
+    for (; i < size; ++i)
+    {
+      double dx = ax[i] - bx[i];
+      double dy = ay[i] - by[i];
+      double dz = az[i] - bz[i];
+      result[i] = dx*dx + dy*dy + dz*dz;
+    }
+  }
+
+
+  // result[i] = |<a_i, n>|
+  void abs_scalar_prods(double nx, double ny, double nz,
+      const double* ax, const double* ay, const double* az, unsigned int size, double* result)
+  {
+    unsigned int i = 0;
+#if defined(__AVX2__)
+    __m256d vnx = _mm256_set1_pd(nx);
+    __m256d vny = _mm256_set1_pd(ny);
+    __m256d vnz = _mm256_set1_pd(nz);
+    __m256d sign = _mm256_set1_pd(-0.);
+    for (; i + 4 <= size; i += 4)
+    {
+      __m256d acc = _mm256_add_pd(
+          _mm256_mul_pd(_mm256_loadu_pd(ax + i), vnx), _mm256_mul_pd(_mm256_loadu_pd(ay + i), vny));
+      acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(az + i), vnz));
+      _mm256_storeu_pd(result + i, _mm256_andnot_pd(sign, acc));
+    }
+#elif defined(__SSE2__)
+    __m128d vnx = _mm_set1_pd(nx);
+    __m128d vny = _mm_set1_pd(ny);
+    __m128d vnz = _mm_set1_pd(nz);
+    __m128d sign = _mm_set1_pd(-0.);
+    for (; i + 2 <= size; i += 2)
+    {
+      __m128d acc = _mm_add_pd(
+          _mm_mul_pd(_mm_loadu_pd(ax + i), vnx), _mm_mul_pd(_mm_loadu_pd(ay + i), vny));
+      acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(az + i), vnz));
+      _mm_storeu_pd(result + i, _mm_andnot_pd(sign, acc));
+    }
+#endif
+    for (; i < size; ++i)
+      result[i] = std::abs(ax[i]*nx + ay[i]*ny + az[i]*nz);
+  }
+
+
+  // The central angle belonging to a chord of the unit sphere, converted to meters
+  inline double chord_to_meter(double squared_chord)
+  {
+    return 2*asin(std::min(sqrt(squared_chord)/2, 1.))*ARC_TO_METER;
+  }
+
+
+  // The squared chord belonging to radius. Every chord is shorter than the result
+  // if radius exceeds half of the circumference.
+  double squared_chord_limit(double radius)
+  {
+    double arc = radius/ARC_TO_METER;
+    if (arc >= PI)
+      return 5.;
+    double chord = 2*sin(arc/2);
+    return chord*chord;
+  }
+}
+
+
+Cartesian::Cartesian(double lat, double lon)
+{
+  x = sin(lat/90.0*acos(0));
+  y = cos(lat/90.0*acos(0))*sin(lon/90.0*acos(0));
+  z = cos(lat/90.0*acos(0))*cos(lon/90.0*acos(0));
+}
+
+
+void Cartesian_Batch::push_back(double lat_, double lon_)
+{
+  Cartesian pt(lat_, lon_);
+  lat.push_back(lat_);
+  lon.push_back(lon_);
+  x.push_back(pt.x);
+  y.push_back(pt.y);
+  z.push_back(pt.z);
+}
+
+
+void Cartesian_Batch::clear()
+{
+  lat.clear();
+  lon.clear();
+  x.clear();
+  y.clear();
+  z.clear();
+}
+
+
+void Cartesian_Batch::reserve(unsigned int size)
+{
+  lat.reserve(size);
+  lon.reserve(size);
+  x.reserve(size);
+  y.reserve(size);
+  z.reserve(size);
+}
+
+
+void great_circle_dists(const Cartesian& pt, const Cartesian_Batch& batch, std::vector< double >& result)
+{
+  result.resize(batch.size());
+  if (batch.empty())
+    return;
+
+  squared_chords(pt.x, pt.y, pt.z, &batch.x[0], &batch.y[0], &batch.z[0], batch.size(), &result[0]);
+  for (std::vector< double >::iterator it = result.begin(); it != result.end(); ++it)
+    *it = chord_to_meter(*it);
+}
+
+
+void great_circle_line_dists(const Cartesian& norm, const Cartesian_Batch& batch, std::vector< double >& result)
+{
+  result.resize(batch.size());
+  if (batch.empty())
+    return;
+
+  Cartesian unit_norm = norm.scaled(1.0/norm.norm());
+  abs_scalar_prods(unit_norm.x, unit_norm.y, unit_norm.z,
+      &batch.x[0], &batch.y[0], &batch.z[0], batch.size(), &result[0]);
+  for (std::vector< double >::iterator it = result.begin(); it != result.end(); ++it)
+    *it = asin(std::min(*it, 1.))*ARC_TO_METER;
+}
+
+
+void mark_within_dist(const Cartesian& pt, const Cartesian_Batch& batch, double radius, std::vector< char >& result)
+{
+  result.resize(batch.size(), false);
+  double limit = squared_chord_limit(radius);
+
+  double buf[CHUNK_SIZE];
+  for (unsigned int offset = 0; offset < batch.size(); offset += CHUNK_SIZE)
+  {
+    unsigned int size = std::min(CHUNK_SIZE, batch.size() - offset);
+    squared_chords(pt.x, pt.y, pt.z, &batch.x[offset], &batch.y[offset], &batch.z[offset], size, buf);
+    for (unsigned int i = 0; i < size; ++i)
+      result[offset + i] |= (buf[i] <= limit);
+  }
+}
+
+
+void mark_within_line_dist(const Cartesian& norm, const Cartesian_Batch& batch, double radius,
+    std::vector< char >& result)
+{
+  result.resize(batch.size(), false);
+  double arc = radius/ARC_TO_METER;
+  if (arc >= PI/2)
+  {
+    std::fill(result.begin(), result.end(), true);
+    return;
+  }
+  double limit = sin(arc);
+  Cartesian unit_norm = norm.scaled(1.0/norm.norm());
+
+  double buf[CHUNK_SIZE];
+  for (unsigned int offset = 0; offset < batch.size(); offset += CHUNK_SIZE)
+  {
+    unsigned int size = std::min(CHUNK_SIZE, batch.size() - offset);
+    abs_scalar_prods(unit_norm.x, unit_norm.y, unit_norm.z,
+        &batch.x[offset], &batch.y[offset], &batch.z[offset], size, buf);
+    for (unsigned int i = 0; i < size; ++i)
+      result[offset + i] |= (buf[i] <= limit);
+  }
+}
+
+
+double great_circle_length(const Cartesian_Batch& path)
+{
+  if (path.size() < 2)
+    return 0;
+
+  double result = 0;
+  double buf[CHUNK_SIZE];
+  for (unsigned int offset = 0; offset + 1 < path.size(); offset += CHUNK_SIZE)
+  {
+    unsigned int size = std::min(CHUNK_SIZE, path.size() - 1 - offset);
+    squared_chord_pairs(&path.x[offset], &path.y[offset], &path.z[offset],
+        &path.x[offset + 1], &path.y[offset + 1], &path.z[offset + 1], size, buf);
+    for (unsigned int i = 0; i < size; ++i)
+      result += chord_to_meter(buf[i]);
+  }
+  return result;
+}
+
+
+const char* great_circle_kernel_isa()
+{
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,94 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__CORE__GREAT_CIRCLE_H
+#define DE__OSM3S___OVERPASS_API__CORE__GREAT_CIRCLE_H
+
+
+#include <cmath>
+#include <vector>
+
+
+// A point on the unit sphere.
+// The axes are the same as in the former cartesian() helper of around.cc:
+// x points to the north pole, z to lat 0, lon 0, and y to lat 0, lon 90.
+struct Cartesian
+{
+  Cartesian() : x(0), y(0), z(0) {}
+  Cartesian(double x_, double y_, double z_) : x(x_), y(y_), z(z_) {}
+  Cartesian(double lat, double lon);
+
+  double x;
+  double y;
+  double z;
+
+  double scalar_prod(const Cartesian& rhs) const { return x*rhs.x + y*rhs.y + z*rhs.z; }
+  Cartesian cross_prod(const Cartesian& rhs) const
+  { return Cartesian(y*rhs.z - z*rhs.y, z*rhs.x - x*rhs.z, x*rhs.y - y*rhs.x); }
+  Cartesian operator+(const Cartesian& rhs) const { return Cartesian(x + rhs.x, y + rhs.y, z + rhs.z); }
+  Cartesian scaled(double a) const { return Cartesian(a*x, a*y, a*z); }
+  double norm() const { return sqrt(scalar_prod(*this)); }
+};
+
+
+// Many points on the unit sphere, stored as structure of arrays
+// such that the kernels below can process them with SIMD instructions.
+// The original coordinates are kept for the callers that need them.
+struct Cartesian_Batch
+{
+  std::vector< double > lat;
+  std::vector< double > lon;
+  std::vector< double > x;
+  std::vector< double > y;
+  std::vector< double > z;
+
+  void push_back(double lat, double lon);
+  void clear();
+  void reserve(unsigned int size);
+  unsigned int size() const { return x.size(); }
+  bool empty() const { return x.empty(); }
+};
+
+
+// All distances are in meters on a sphere with circumference 40'000 km,
+// i.e. they are compatible with great_circle_dist() from geometry.h.
+
+// Sets result[i] to the great circle distance between pt and the i-th point of the batch.
+void great_circle_dists(const Cartesian& pt, const Cartesian_Batch& batch, std::vector< double >& result);
+
+// Sets result[i] to the distance between the great circle with normal vector norm
+// and the i-th point of the batch. The norm needs not to have unit length.
+void great_circle_line_dists(const Cartesian& norm, const Cartesian_Batch& batch, std::vector< double >& result);
+
+// Sets result[i] to true if the i-th point of the batch is within radius of pt.
+// Entries that are already true are kept. No trigonometric function is evaluated per point.
+void mark_within_dist(const Cartesian& pt, const Cartesian_Batch& batch, double radius, std::vector< char >& result);
+
+// Sets result[i] to true if the i-th point of the batch is within radius of the great circle
+// with normal vector norm. Entries that are already true are kept.
+void mark_within_line_dist(const Cartesian& norm, const Cartesian_Batch& batch, double radius,
+    std::vector< char >& result);
+
+// Returns the length of the path that visits all points of the batch in their order.
+double great_circle_length(const Cartesian_Batch& path);
+
+// Returns the name of the instruction set the kernels have been compiled for.
+const char* great_circle_kernel_isa();
+
+
+#endif
@@ -0,0 +1,228 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "geometry.h"
+#include "great_circle.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sys/time.h>
+#include <vector>
+
+
+void make_coords(Cartesian_Batch& batch, unsigned int size, double lat, double lon, double extent)
+{
+  batch.clear();
+  batch.reserve(size);
+  for (unsigned int i = 0; i < size; ++i)
+    batch.push_back(lat + extent*(((i*7919) % 1000)/1000. - .5), lon + extent*(((i*104729) % 997)/997. - .5));
+}
+
+
+void check_close(const std::string& what, double expected, double result, double tolerance)
+{
+  if (std::abs(expected - result) <= tolerance)
+    std::cout<<what<<": OK\n";
+  else
+    std::cout<<what<<": failed: expected "<<std::fixed<<std::setprecision(3)<<expected<<", got "<<result<<'\n';
+}
+
+
+double seconds_since(const timeval& start)
+{
+  timeval now;
+  gettimeofday(&now, 0);
+  return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec)/1e6;
+}
+
+
+void report(const std::string& what, unsigned long long points, double seconds)
+{
+  std::cout<<std::left<<std::setw(28)<<what<<std::right<<std::setw(14)<<std::fixed<<std::setprecision(0)
+      <<points/seconds<<" points/s\n";
+}
+
+
+void benchmark(unsigned int size, unsigned int rounds)
+{
+  Cartesian_Batch batch;
+  make_coords(batch, size, 51.25, 7.15, 0.2);
+  Cartesian center(51.25, 7.15);
+  Cartesian norm = Cartesian(51.2, 7.1).cross_prod(Cartesian(51.3, 7.2));
+  std::vector< double > dists;
+  std::vector< char > marks;
+  double checksum = 0;
+
+  std::cout<<"kernel instruction set: "<<great_circle_kernel_isa()<<", "
+      <<size<<" points, "<<rounds<<" rounds\n";
+
+  timeval start;
+  gettimeofday(&start, 0);
+  for (unsigned int j = 0; j < rounds; ++j)
+  {
+    for (unsigned int i = 0; i < size; ++i)
+      checksum += (great_circle_dist(51.25, 7.15, batch.lat[i], batch.lon[i]) <= 1000.);
+  }
+  report("scalar great_circle_dist", (unsigned long long)size*rounds, seconds_since(start));
+
+  gettimeofday(&start, 0);
+  for (unsigned int j = 0; j < rounds; ++j)
+  {
+    great_circle_dists(center, batch, dists);
+    checksum += dists[j % size];
+  }
+  report("great_circle_dists", (unsigned long long)size*rounds, seconds_since(start));
+
+  gettimeofday(&start, 0);
+  for (unsigned int j = 0; j < rounds; ++j)
+  {
+    marks.assign(size, false);
+    mark_within_dist(center, batch, 1000., marks);
+    checksum += marks[j % size];
+  }
+  report("mark_within_dist", (unsigned long long)size*rounds, seconds_since(start));
+
+  gettimeofday(&start, 0);
+  for (unsigned int j = 0; j < rounds; ++j)
+  {
+    marks.assign(size, false);
+    mark_within_line_dist(norm, batch, 1000., marks);
+    checksum += marks[j % size];
+  }
+  report("mark_within_line_dist", (unsigned long long)size*rounds, seconds_since(start));
+
+  gettimeofday(&start, 0);
+  for (unsigned int j = 0; j < rounds; ++j)
+  {
+    double result = 0;
+    for (unsigned int i = 1; i < size; ++i)
+      result += great_circle_dist(batch.lat[i-1], batch.lon[i-1], batch.lat[i], batch.lon[i]);
+    checksum += result;
+  }
+  report("scalar path length", (unsigned long long)size*rounds, seconds_since(start));
+
+  gettimeofday(&start, 0);
+  for (unsigned int j = 0; j < rounds; ++j)
+    checksum += great_circle_length(batch);
+  report("great_circle_length", (unsigned long long)size*rounds, seconds_since(start));
+
+  // Prevents the compiler from optimizing the loops away
+  if (checksum == 0.5)
+    std::cout<<checksum<<'\n';
+}
+
+
+int main(int argc, char* args[])
+{
+  if (argc < 2)
+  {
+    std::cout<<"Usage: "<<args[0]<<" test_to_execute\n"
+        "or: "<<args[0]<<" benchmark [points] [rounds]\n";
+    return 0;
+  }
+  std::string test_to_execute = args[1];
+
+  if (test_to_execute == "benchmark")
+  {
+    benchmark(argc > 2 ? atoi(args[2]) : 100*1000, argc > 3 ? atoi(args[3]) : 100);
+    return 0;
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "1")
+  {
+    // Point distances against the scalar reference
+    Cartesian_Batch batch;
+    make_coords(batch, 1001, 51.25, 7.15, 2.);
+    std::vector< double > dists;
+    great_circle_dists(Cartesian(51.25, 7.15), batch, dists);
+    double max_diff = 0;
+    for (unsigned int i = 0; i < batch.size(); ++i)
+      max_diff = std::max(max_diff, std::abs(dists[i] - great_circle_dist(51.25, 7.15, batch.lat[i], batch.lon[i])));
+    check_close("great_circle_dists", 0, max_diff, 0.01);
+
+    check_close("antipodal distance", 20*1000*1000, great_circle_dist(0, 0, 0, 180), 0.01);
+    Cartesian_Batch antipode;
+    antipode.push_back(0, 180);
+    great_circle_dists(Cartesian(0, 0), antipode, dists);
+    check_close("antipodal kernel distance", 20*1000*1000, dists[0], 0.01);
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "2")
+  {
+    // Radius marks must agree with the scalar distance except for rounding on the boundary
+    Cartesian_Batch batch;
+    make_coords(batch, 1001, -33.9, 18.4, .1);
+    std::vector< char > marks(batch.size(), false);
+    mark_within_dist(Cartesian(-33.9, 18.4), batch, 2500., marks);
+    unsigned int mismatches = 0;
+    for (unsigned int i = 0; i < batch.size(); ++i)
+    {
+      double dist = great_circle_dist(-33.9, 18.4, batch.lat[i], batch.lon[i]);
+      if (std::abs(dist - 2500.) > 0.01 && (bool)marks[i] != (dist <= 2500.))
+        ++mismatches;
+    }
+    check_close("mark_within_dist", 0, mismatches, 0);
+
+    std::vector< char > all(batch.size(), false);
+    mark_within_dist(Cartesian(0, 0), batch, 30*1000*1000, all);
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < all.size(); ++i)
+      count += all[i];
+    check_close("mark_within_dist beyond antipode", batch.size(), count, 0);
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "3")
+  {
+    // Distances to the equator
+    Cartesian_Batch batch;
+    batch.push_back(0.01, 10.);
+    batch.push_back(-0.02, -170.);
+    batch.push_back(45., 90.);
+    std::vector< double > dists;
+    great_circle_line_dists(Cartesian(0, 0).cross_prod(Cartesian(0, 90)), batch, dists);
+    check_close("line distance 1", great_circle_dist(0.01, 10., 0., 10.), dists[0], 0.01);
+    check_close("line distance 2", great_circle_dist(-0.02, -170., 0., -170.), dists[1], 0.01);
+    check_close("line distance 3", 5*1000*1000, dists[2], 0.01);
+
+    std::vector< char > marks(batch.size(), false);
+    mark_within_line_dist(Cartesian(0, 0).cross_prod(Cartesian(0, 90)), batch, 3000., marks);
+    check_close("line marks", 3, marks[0] + 2*marks[1] + 4*marks[2], 0);
+  }
+
+  if (test_to_execute.empty() || test_to_execute == "4")
+  {
+    // Path lengths, including a path longer than one chunk of the kernels
+    Cartesian_Batch batch;
+    make_coords(batch, 1001, 51.25, 7.15, .5);
+    double expected = 0;
+    for (unsigned int i = 1; i < batch.size(); ++i)
+      expected += great_circle_dist(batch.lat[i-1], batch.lon[i-1], batch.lat[i], batch.lon[i]);
+    check_close("great_circle_length", expected, great_circle_length(batch), 0.1);
+
+    std::vector< Point_Double > points;
+    points.push_back(Point_Double(51.25, 7.15));
+    points.push_back(Point_Double(51.26, 7.15));
+    points.push_back(Point_Double(51.26, 7.16));
+    check_close("linestring length", great_circle_dist(51.25, 7.15, 51.26, 7.15)
+        + great_circle_dist(51.26, 7.15, 51.26, 7.16), length(Linestring_Geometry(points)), 0.001);
+  }
+
+  return 0;
+}
@@ -0,0 +1,209 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__CORE__ID_BITMAP_H
+#define DE__OSM3S___OVERPASS_API__CORE__ID_BITMAP_H
+
+#include "basic_types.h"
+
+#include <algorithm>
+#include <vector>
+
+
+/* Compressed set of ids for membership tests on large id lists.
+
+The ids are grouped into chunks of 2^16 consecutive ids.
+A chunk stores the lower 16 bits of its ids as a sorted array as long as it holds at most DENSE_LIMIT ids
+and as a bitmap of 8 KiB otherwise, hence no chunk needs more than two bytes per id.
+A lookup is a binary search over the chunk keys followed by a bit test or a binary search in a small array.
+
+Ids in ascending order are appended in constant time.
+*/
+
+inline uint64 id_bitmap_value(uint64 id) { return id; }
+inline uint64 id_bitmap_value(const Uint32_Index& id) { return id.val(); }
+inline uint64 id_bitmap_value(const Uint64& id) { return id.val(); }
+
+
+class Id_Bitmap
+{
+  public:
+    Id_Bitmap() : size_(0) {}
+
+    template< typename Iterator >
+    Id_Bitmap(Iterator begin, Iterator end) : size_(0)
+    {
+      for (; begin != end; ++begin)
+        insert(id_bitmap_value(*begin));
+    }
+
+    void insert(uint64 id);
+    bool contains(uint64 id) const;
+
+    template< typename Id_Type >
+    bool contains(const Id_Type& id) const { return contains(id_bitmap_value(id)); }
+
+    uint64 size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    void clear();
+
+    // Appends the ids in ascending order
+    void append_to(std::vector< uint64 >& ids) const;
+
+    static const uint32 DENSE_LIMIT = 4096;
+
+  private:
+    struct Chunk
+    {
+      Chunk() : count(0) {}
+
+      bool contains(uint16 low) const;
+      bool insert(uint16 low);
+      void make_dense();
+      void append_to(uint64 base, std::vector< uint64 >& ids) const;
+
+      std::vector< uint16 > sparse;
+      std::vector< uint64 > bits;
+      uint32 count;
+    };
+
+    const Chunk* find_chunk(uint64 key) const;
+
+    std::vector< uint64 > keys;
+    std::vector< Chunk > chunks;
+    uint64 size_;
+};
+
+
+inline bool Id_Bitmap::Chunk::contains(uint16 low) const
+{
+  if (bits.empty())
+    return std::binary_search(sparse.begin(), sparse.end(), low);
+  return (bits[low>>6]>>(low & 0x3f)) & 1;
+}
+
+
+inline bool Id_Bitmap::Chunk::insert(uint16 low)
+{
+  if (!bits.empty())
+  {
+    uint64 mask = 1ull<<(low & 0x3f);
+    if (bits[low>>6] & mask)
+      return false;
+    bits[low>>6] |= mask;
+    ++count;
+    return true;
+  }
+
+  if (sparse.empty() || sparse.back() < low)
+    sparse.push_back(low);
+  else
+  {
+    std::vector< uint16 >::iterator it = std::lower_bound(sparse.begin(), sparse.end(), low);
+    if (*it == low)
+      return false;
+    sparse.insert(it, low);
+  }
+  ++count;
+  if (count > DENSE_LIMIT)
+    make_dense();
+  return true;
+}
+
+
+inline void Id_Bitmap::Chunk::make_dense()
+{
+  bits.assign(1024, 0);
+  for (std::vector< uint16 >::const_iterator it = sparse.begin(); it != sparse.end(); ++it)
+    bits[*it>>6] |= 1ull<<(*it & 0x3f);
+  std::vector< uint16 >().swap(sparse);
+}
+
+
+inline void Id_Bitmap::Chunk::append_to(uint64 base, std::vector< uint64 >& ids) const
+{
+  if (bits.empty())
+  {
+    for (std::vector< uint16 >::const_iterator it = sparse.begin(); it != sparse.end(); ++it)
+      ids.push_back(base | *it);
+    return;
+  }
+  for (uint32 i = 0; i < bits.size(); ++i)
+  {
+    for (uint64 word = bits[i]; word; word &= word - 1)
+      ids.push_back(base | (i<<6) | __builtin_ctzll(word));
+  }
+}
+
+
+inline const Id_Bitmap::Chunk* Id_Bitmap::find_chunk(uint64 key) const
+{
+  std::vector< uint64 >::const_iterator it = std::lower_bound(keys.begin(), keys.end(), key);
+  if (it == keys.end() || *it != key)
+    return 0;
+  return &chunks[it - keys.begin()];
+}
+
+
+inline void Id_Bitmap::insert(uint64 id)
+{
+  uint64 key = id>>16;
+  if (keys.empty() || keys.back() < key)
+  {
+    keys.push_back(key);
+    chunks.push_back(Chunk());
+    chunks.back().insert(id & 0xffff);
+    ++size_;
+    return;
+  }
+
+  std::vector< uint64 >::iterator it = std::lower_bound(keys.begin(), keys.end(), key);
+  uint32 pos = it - keys.begin();
+  if (*it != key)
+  {
+    keys.insert(it, key);
+    chunks.insert(chunks.begin() + pos, Chunk());
+  }
+  if (chunks[pos].insert(id & 0xffff))
+    ++size_;
+}
+
+
+inline bool Id_Bitmap::contains(uint64 id) const
+{
+  const Chunk* chunk = find_chunk(id>>16);
+  return chunk && chunk->contains(id & 0xffff);
+}
+
+
+inline void Id_Bitmap::clear()
+{
+  keys.clear();
+  chunks.clear();
+  size_ = 0;
+}
+
+
+inline void Id_Bitmap::append_to(std::vector< uint64 >& ids) const
+{
+  for (uint32 i = 0; i < keys.size(); ++i)
+    chunks[i].append_to(keys[i]<<16, ids);
+}
+
+
+#endif
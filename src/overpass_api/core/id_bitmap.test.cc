@@ -0,0 +1,152 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "id_bitmap.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <sys/time.h>
+#include <vector>
+
+
+// Mixes sparse and dense chunks: every id below 2^17 is taken with probability 1/2, above only every 97th
+std::vector< uint64 > make_ids(uint64 offset, uint32 seed)
+{
+  std::vector< uint64 > ids;
+  for (uint64 i = 0; i < 1000*1000; ++i)
+  {
+    if (i < 128*1024 ? ((i*2654435761u + seed) >> 7) % 2 == 0 : (i + seed) % 97 == 0)
+      ids.push_back(offset + i);
+  }
+  ids.push_back(offset + (1ull<<40) + seed);
+  return ids;
+}
+
+
+void check(const std::string& what, const Id_Bitmap& bitmap, const std::set< uint64 >& expected)
+{
+  std::vector< uint64 > result;
+  bitmap.append_to(result);
+  bool ok = bitmap.size() == expected.size() && result.size() == expected.size()
+      && std::equal(result.begin(), result.end(), expected.begin());
+  for (std::set< uint64 >::const_iterator it = expected.begin(); ok && it != expected.end(); ++it)
+    ok &= bitmap.contains(*it) && !bitmap.contains(*it + (1ull<<41));
+  if (ok)
+    std::cout<<what<<": OK\n";
+  else
+    std::cout<<what<<": failed: expected "<<expected.size()<<" ids, got "<<bitmap.size()<<'\n';
+}
+
+
+double seconds_since(const timeval& start)
+{
+  timeval now;
+  gettimeofday(&now, 0);
+  return (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec)/1e6;
+}
+
+
+void report(const std::string& what, unsigned long long lookups, double seconds)
+{
+  std::cout<<std::left<<std::setw(28)<<what<<std::right<<std::setw(14)<<std::fixed<<std::setprecision(0)
+      <<lookups/seconds<<" lookups/s\n";
+}
+
+
+void benchmark(unsigned int size, unsigned int rounds)
+{
+  std::vector< Uint64 > ids;
+  for (unsigned int i = 0; i < size; ++i)
+    ids.push_back(Uint64(i*7ull));
+  Id_Bitmap bitmap(ids.begin(), ids.end());
+  unsigned long long found = 0;
+
+  std::cout<<size<<" ids, "<<rounds<<" rounds\n";
+
+  timeval start;
+  gettimeofday(&start, 0);
+  for (unsigned int j = 0; j < rounds; ++j)
+  {
+    for (unsigned int i = 0; i < size; ++i)
+      found += std::binary_search(ids.begin(), ids.end(), Uint64((i*7919ull) % (7ull*size)));
+  }
+  report("binary_search", (unsigned long long)size*rounds, seconds_since(start));
+
+  gettimeofday(&start, 0);
+  for (unsigned int j = 0; j < rounds; ++j)
+  {
+    for (unsigned int i = 0; i < size; ++i)
+      found += bitmap.contains((i*7919ull) % (7ull*size));
+  }
+  report("Id_Bitmap::contains", (unsigned long long)size*rounds, seconds_since(start));
+
+  // Prevents the compiler from optimizing the loops away
+  if (found == 1)
+    std::cout<<found<<'\n';
+}
+
+
+int main(int argc, char* args[])
+{
+  if (argc < 2)
+  {
+    std::cout<<"Usage: "<<args[0]<<" test_to_execute\n"
+        "or: "<<args[0]<<" benchmark [ids] [rounds]\n";
+    return 0;
+  }
+  std::string test_to_execute = args[1];
+
+  if (test_to_execute == "benchmark")
+  {
+    benchmark(argc > 2 ? atoi(args[2]) : 1000*1000, argc > 3 ? atoi(args[3]) : 10);
+    return 0;
+  }
+
+  std::vector< uint64 > lhs = make_ids(0, 1);
+  std::vector< uint64 > rhs = make_ids(50*1000, 2);
+  std::set< uint64 > lhs_set(lhs.begin(), lhs.end());
+  std::set< uint64 > rhs_set(rhs.begin(), rhs.end());
+
+  if (test_to_execute.empty() || test_to_execute == "1")
+  {
+    // Ascending and descending insertion yield the same set
+    check("ascending insert", Id_Bitmap(lhs.begin(), lhs.end()), lhs_set);
+    check("descending insert", Id_Bitmap(lhs.rbegin(), lhs.rend()), lhs_set);
+
+    Id_Bitmap twice(lhs.begin(), lhs.end());
+    for (std::vector< uint64 >::const_iterator it = lhs.begin(); it != lhs.end(); ++it)
+      twice.insert(*it);
+    check("duplicate insert", twice, lhs_set);
+
+    std::vector< Uint32_Index > small;
+    small.push_back(Uint32_Index(3u));
+    small.push_back(Uint32_Index(65536u));
+    Id_Bitmap small_bitmap(small.begin(), small.end());
+    std::set< uint64 > small_set;
+    small_set.insert(3);
+    small_set.insert(65536);
+    check("Uint32_Index ids", small_bitmap, small_set);
+    check("empty", Id_Bitmap(), std::set< uint64 >());
+  }
+
+  return 0;
+}
@@ -54,6 +54,7 @@ struct OSM_File_Properties : public File_Properties
   uint32 get_map_block_size() const { return map_block_size/8; }
   uint32 get_map_compression_factor() const { return 8; }
   uint32 get_map_compression_method() const { return basic_settings().map_compression_method; }
+  bool get_block_checksums() const { return basic_settings().block_checksums; }
 
   std::vector< bool > get_data_footprint(const std::string& db_dir) const
   {
@@ -104,7 +105,11 @@ Basic_Settings::Basic_Settings()
 #else
   compression_method(File_Blocks_Index< Uint31_Index >::ZLIB_COMPRESSION),
 #endif
-  map_compression_method(File_Blocks_Index< Uint31_Index >::NO_COMPRESSION)
+  map_compression_method(File_Blocks_Index< Uint31_Index >::NO_COMPRESSION),
+  inline_way_geometry(false),
+  record_area_changes(false),
+  area_build_workers(1),
+  block_checksums(false)
 {}
 
 Basic_Settings& basic_settings()
@@ -142,9 +147,14 @@ Osm_Base_Settings::Osm_Base_Settings()
       ("relation_tags_global", 512*1024, 0)),
   RELATION_KEYS(new OSM_File_Properties< Uint32_Index >
       ("relation_keys", 512*1024, 0)),
+  NODE_WAYS(new OSM_File_Properties< Node::Id_Type >
+      ("node_ways", 512*1024, 0)),
+  MEMBER_RELATIONS(new OSM_File_Properties< Uint64 >
+      ("member_relations", 512*1024, 0)),
 
   shared_name(basic_settings().shared_name_base + "_osm_base"),
   max_num_processes(20),
+  max_workers_per_query(4),
   purge_timeout(900),
   total_available_space(12ll*1024*1024*1024),
   total_available_time_units(256*1024)
@@ -167,6 +177,8 @@ Area_Settings::Area_Settings()
       ("area_tags_local", 256*1024, 0)),
   AREA_TAGS_GLOBAL(new OSM_File_Properties< Tag_Index_Global >
       ("area_tags_global", 512*1024, 0)),
+  AREA_RASTERS(new OSM_File_Properties< Uint31_Index >
+      ("area_rasters", 512*1024, 64*1024)),
 
   shared_name(basic_settings().shared_name_base + "_areas"),
   max_num_processes(5),
@@ -189,6 +201,14 @@ Meta_Settings::Meta_Settings()
       ("user_data", 512*1024, 0)),
   USER_INDICES(new OSM_File_Properties< Uint32_Index >
       ("user_indices", 512*1024, 0)),
+  USER_NAMES(new OSM_File_Properties< Uint32_Index >
+      ("user_names", 512*1024, 0)),
+  USER_NODES(new OSM_File_Properties< Uint32_Index >
+      ("user_nodes", 512*1024, 0)),
+  USER_WAYS(new OSM_File_Properties< Uint32_Index >
+      ("user_ways", 512*1024, 0)),
+  USER_RELATIONS(new OSM_File_Properties< Uint32_Index >
+      ("user_relations", 512*1024, 0)),
   NODES_META(new OSM_File_Properties< Uint31_Index >
       ("nodes_meta", 512*1024, 0)),
   WAYS_META(new OSM_File_Properties< Uint31_Index >
@@ -209,6 +229,7 @@ Attic_Settings::Attic_Settings()
 :
   NODES(new OSM_File_Properties< Uint31_Index >("nodes_attic", 512*1024, 256*1024)),
   NODES_UNDELETED(new OSM_File_Properties< Uint31_Index >("nodes_attic_undeleted", 512*1024, 64*1024)),
+  NODES_NEWEST(new OSM_File_Properties< Uint31_Index >("nodes_attic_newest", 64*1024, 0)),
   NODE_IDX_LIST(new OSM_File_Properties< Node::Id_Type >
       ("node_attic_indexes", 512*1024, 0)),
   NODE_TAGS_LOCAL(new OSM_File_Properties< Tag_Index_Local >
@@ -222,6 +243,7 @@ Attic_Settings::Attic_Settings()
 
   WAYS(new OSM_File_Properties< Uint31_Index >("ways_attic", 512*1024, 256*1024)),
   WAYS_UNDELETED(new OSM_File_Properties< Uint31_Index >("ways_attic_undeleted", 512*1024, 64*1024)),
+  WAYS_NEWEST(new OSM_File_Properties< Uint31_Index >("ways_attic_newest", 64*1024, 0)),
   WAY_IDX_LIST(new OSM_File_Properties< Way::Id_Type >
       ("way_attic_indexes", 512*1024, 0)),
   WAY_TAGS_LOCAL(new OSM_File_Properties< Tag_Index_Local >
@@ -235,6 +257,7 @@ Attic_Settings::Attic_Settings()
 
   RELATIONS(new OSM_File_Properties< Uint31_Index >("relations_attic", 1024*1024, 256*1024)),
   RELATIONS_UNDELETED(new OSM_File_Properties< Uint31_Index >("relations_attic_undeleted", 512*1024, 64*1024)),
+  RELATIONS_NEWEST(new OSM_File_Properties< Uint31_Index >("relations_attic_newest", 64*1024, 0)),
   RELATION_IDX_LIST(new OSM_File_Properties< Relation::Id_Type >
       ("relation_attic_indexes", 512*1024, 0)),
   RELATION_TAGS_LOCAL(new OSM_File_Properties< Tag_Index_Local >
@@ -255,6 +278,19 @@ const Attic_Settings& attic_settings()
 
 //-----------------------------------------------------------------------------
 
+Augmented_Diff_Settings::Augmented_Diff_Settings()
+:
+  ACTIONS(new OSM_File_Properties< Uint64 >("augmented_diff_actions", 512*1024, 0))
+{}
+
+const Augmented_Diff_Settings& augmented_diff_settings()
+{
+  static Augmented_Diff_Settings obj;
+  return obj;
+}
+
+//-----------------------------------------------------------------------------
+
 void show_mem_status()
 {
   std::ostringstream proc_file_name_("");
@@ -42,6 +42,18 @@ struct Basic_Settings
   uint32 compression_method;
   uint32 map_compression_method;
 
+  // Store the node coordinates in all ways, not only in ways spanning multiple index tiles
+  bool inline_way_geometry;
+
+  // Append the ids of all changed ways and relations to the file area_changes on each commit
+  bool record_area_changes;
+
+  // Number of worker processes that build the areas of a foreach loop in rules mode, 1 builds them sequentially
+  uint area_build_workers;
+
+  // Store a checksum per block in the index of newly created data files
+  bool block_checksums;
+
   Basic_Settings();
 };
 
@@ -61,9 +73,12 @@ struct Osm_Base_Settings
   File_Properties* RELATION_TAGS_LOCAL;
   File_Properties* RELATION_TAGS_GLOBAL;
   File_Properties* RELATION_KEYS;
+  File_Properties* NODE_WAYS;
+  File_Properties* MEMBER_RELATIONS;
 
   std::string shared_name;
   uint max_num_processes;
+  uint max_workers_per_query;
   uint purge_timeout;
   uint64 total_available_space;
   uint64 total_available_time_units;
@@ -78,6 +93,7 @@ struct Area_Settings
   File_Properties* AREAS;
   File_Properties* AREA_TAGS_LOCAL;
   File_Properties* AREA_TAGS_GLOBAL;
+  File_Properties* AREA_RASTERS;
 
   std::string shared_name;
   uint max_num_processes;
@@ -93,6 +109,10 @@ struct Meta_Settings
 {
   File_Properties* USER_DATA;
   File_Properties* USER_INDICES;
+  File_Properties* USER_NAMES;
+  File_Properties* USER_NODES;
+  File_Properties* USER_WAYS;
+  File_Properties* USER_RELATIONS;
   File_Properties* NODES_META;
   File_Properties* WAYS_META;
   File_Properties* RELATIONS_META;
@@ -105,6 +125,7 @@ struct Attic_Settings
 {
   File_Properties* NODES;
   File_Properties* NODES_UNDELETED;
+  File_Properties* NODES_NEWEST;
   File_Properties* NODE_IDX_LIST;
   File_Properties* NODE_TAGS_LOCAL;
   File_Properties* NODE_TAGS_GLOBAL;
@@ -112,6 +133,7 @@ struct Attic_Settings
   File_Properties* NODE_CHANGELOG;
   File_Properties* WAYS;
   File_Properties* WAYS_UNDELETED;
+  File_Properties* WAYS_NEWEST;
   File_Properties* WAY_IDX_LIST;
   File_Properties* WAY_TAGS_LOCAL;
   File_Properties* WAY_TAGS_GLOBAL;
@@ -119,6 +141,7 @@ struct Attic_Settings
   File_Properties* WAY_CHANGELOG;
   File_Properties* RELATIONS;
   File_Properties* RELATIONS_UNDELETED;
+  File_Properties* RELATIONS_NEWEST;
   File_Properties* RELATION_IDX_LIST;
   File_Properties* RELATION_TAGS_LOCAL;
   File_Properties* RELATION_TAGS_GLOBAL;
@@ -129,6 +152,15 @@ struct Attic_Settings
 };
 
 
+struct Augmented_Diff_Settings
+{
+  // The index has the sequence number of the diff in the upper and the tile of the action in the lower 32 bits
+  File_Properties* ACTIONS;
+
+  Augmented_Diff_Settings();
+};
+
+
 struct Clone_Settings
 {
   uint32 compression_method;
@@ -145,6 +177,7 @@ const Osm_Base_Settings& osm_base_settings();
 const Area_Settings& area_settings();
 const Meta_Settings& meta_settings();
 const Attic_Settings& attic_settings();
+const Augmented_Diff_Settings& augmented_diff_settings();
 
 void show_mem_status();
 
@@ -362,4 +362,95 @@ struct Area_Block
   }
 };
 
+
+/* A coarse raster of one area within one tile of the area blocks, i.e. within one Uint31_Index
+   of AREA_BLOCKS. The tile consists of the 16x16 cells that the node index uses,
+   such that the lowest byte of the Uint32_Index of a node is the cell of the node.
+   Each cell is known to be entirely inside, entirely outside or to be a boundary cell.
+   Only for nodes in boundary cells the area blocks need to be evaluated.
+   The tile state summarizes all cells if they have the same state. */
+struct Area_Raster
+{
+  typedef Area::Id_Type Id_Type;
+
+  static const uint8 OUTSIDE = 0;
+  static const uint8 INSIDE = 1;
+  static const uint8 BOUNDARY = 2;
+
+  Id_Type id;
+  uint8 tile_state;
+  uint8 cells[64];
+
+  Area_Raster() : id(0u), tile_state(BOUNDARY) { memset(cells, 0xaa, 64); }
+
+  Area_Raster(Id_Type id_) : id(id_), tile_state(BOUNDARY) { memset(cells, 0xaa, 64); }
+
+  Area_Raster(void* data) : id(*(Id_Type*)data)
+  {
+    tile_state = *((uint8*)data + 4);
+    memcpy(cells, (uint8*)data + 5, 64);
+  }
+
+  uint32 size_of() const
+  {
+    return 69;
+  }
+
+  static uint32 size_of(void* data)
+  {
+    return 69;
+  }
+
+  void to_data(void* data) const
+  {
+    *(Id_Type*)data = id.val();
+    *((uint8*)data + 4) = tile_state;
+    memcpy((uint8*)data + 5, cells, 64);
+  }
+
+  uint8 cell_state(uint32 node_idx) const
+  {
+    if (tile_state != BOUNDARY)
+      return tile_state;
+    return (cells[(node_idx & 0xff)>>2]>>(2*(node_idx & 0x3))) & 0x3;
+  }
+
+  void set_cell_state(uint32 node_idx, uint8 state)
+  {
+    uint8& cell = cells[(node_idx & 0xff)>>2];
+    cell = (cell & ~(0x3<<(2*(node_idx & 0x3)))) | (state<<(2*(node_idx & 0x3)));
+  }
+
+  // Sets the tile state to the state of the cells if all cells have the same state.
+  void summarize()
+  {
+    tile_state = BOUNDARY;
+    for (int i = 1; i < 64; ++i)
+    {
+      if (cells[i] != cells[0])
+        return;
+    }
+    if (cells[0] == 0x00)
+      tile_state = OUTSIDE;
+    else if (cells[0] == 0x55)
+      tile_state = INSIDE;
+  }
+
+  bool operator<(const Area_Raster& a) const
+  {
+    if (this->id < a.id)
+      return true;
+    else if (a.id < this->id)
+      return false;
+    if (this->tile_state != a.tile_state)
+      return (this->tile_state < a.tile_state);
+    return (memcmp(this->cells, a.cells, 64) < 0);
+  }
+
+  bool operator==(const Area_Raster& a) const
+  {
+    return ((this->id == a.id) && (this->tile_state == a.tile_state) && !memcmp(this->cells, a.cells, 64));
+  }
+};
+
 #endif
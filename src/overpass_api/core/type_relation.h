@@ -51,6 +51,13 @@ struct Relation_Entry
 };
 
 
+// The index of the reverse file from members to relations combines the member's id and type
+inline Uint64 member_relations_key(const Uint64& ref, uint32 type)
+{
+  return Uint64((ref.val()<<2) | type);
+}
+
+
 struct Relation
 {
   typedef Uint32_Index Id_Type;
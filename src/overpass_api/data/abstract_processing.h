@@ -20,6 +20,7 @@
 #define DE__OSM3S___OVERPASS_API__DATA__ABSTRACT_PROCESSING_H
 
 #include "../core/datatypes.h"
+#include "../core/id_bitmap.h"
 #include "../statements/statement.h"
 #include "collect_items.h"
 #include "filenames.h"
@@ -88,25 +89,24 @@ class Id_Predicate
 {
   public:
     Id_Predicate(const std::vector< typename Object::Id_Type >& ids_)
-      : ids(ids_) {}
-    bool match(const Object& obj) const { return binary_search(ids.begin(), ids.end(), obj.id); }
-    bool match(const Handle< Object >& h) const { return binary_search(ids.begin(), ids.end(), h.id()); }
-    bool match(const Handle< Attic< Object > >& h) const { return binary_search(ids.begin(), ids.end(), h.id()); }
+      : ids(ids_.begin(), ids_.end()) {}
+    bool match(const Object& obj) const { return ids.contains(obj.id); }
+    bool match(const Handle< Object >& h) const { return ids.contains(h.id()); }
+    bool match(const Handle< Attic< Object > >& h) const { return ids.contains(h.id()); }
 
   private:
-    const std::vector< typename Object::Id_Type >& ids;
+    Id_Bitmap ids;
 };
 
 //-----------------------------------------------------------------------------
 
 inline bool has_a_child_with_id
-    (const Relation_Skeleton& relation, const std::vector< Uint64 >& ids, uint32 type)
+    (const Relation_Skeleton& relation, const Id_Bitmap& ids, uint32 type)
 {
   for (std::vector< Relation_Entry >::const_iterator it3(relation.members.begin());
       it3 != relation.members.end(); ++it3)
   {
-    if (it3->type == type &&
-        binary_search(ids.begin(), ids.end(), it3->ref))
+    if (it3->type == type && ids.contains(it3->ref))
       return true;
   }
   return false;
@@ -114,13 +114,12 @@ inline bool has_a_child_with_id
 
 
 inline bool has_a_child_with_id_and_role
-    (const Relation_Skeleton& relation, const std::vector< Uint64 >& ids, uint32 type, uint32 role_id)
+    (const Relation_Skeleton& relation, const Id_Bitmap& ids, uint32 type, uint32 role_id)
 {
   for (std::vector< Relation_Entry >::const_iterator it3(relation.members.begin());
       it3 != relation.members.end(); ++it3)
   {
-    if (it3->type == type && it3->role == role_id &&
-        binary_search(ids.begin(), ids.end(), it3->ref))
+    if (it3->type == type && it3->role == role_id && ids.contains(it3->ref))
       return true;
   }
   return false;
@@ -128,12 +127,12 @@ inline bool has_a_child_with_id_and_role
 
 
 inline bool has_a_child_with_id
-    (const Way_Skeleton& way, const std::vector< Node::Id_Type >& ids)
+    (const Way_Skeleton& way, const Id_Bitmap& ids)
 {
   for (std::vector< Node::Id_Type >::const_iterator it3(way.nds.begin());
       it3 != way.nds.end(); ++it3)
   {
-    if (binary_search(ids.begin(), ids.end(), *it3))
+    if (ids.contains(*it3))
       return true;
   }
   return false;
@@ -144,7 +143,7 @@ class Get_Parent_Rels_Predicate
 {
 public:
   Get_Parent_Rels_Predicate(const std::vector< Uint64 >& ids_, uint32 child_type_)
-    : ids(ids_), child_type(child_type_) {}
+    : ids(ids_.begin(), ids_.end()), child_type(child_type_) {}
   bool match(const Relation_Skeleton& obj) const
   { return has_a_child_with_id(obj, ids, child_type); }
   bool match(const Handle< Relation_Skeleton >& h) const
@@ -153,7 +152,7 @@ public:
   { return has_a_child_with_id(h.object(), ids, child_type); }
 
 private:
-  const std::vector< Uint64 >& ids;
+  Id_Bitmap ids;
   uint32 child_type;
 };
 
@@ -162,7 +161,7 @@ class Get_Parent_Rels_Role_Predicate
 {
 public:
   Get_Parent_Rels_Role_Predicate(const std::vector< Uint64 >& ids_, uint32 child_type_, uint32 role_id_)
-    : ids(ids_), child_type(child_type_), role_id(role_id_) {}
+    : ids(ids_.begin(), ids_.end()), child_type(child_type_), role_id(role_id_) {}
   bool match(const Relation_Skeleton& obj) const
   { return has_a_child_with_id_and_role(obj, ids, child_type, role_id); }
   bool match(const Handle< Relation_Skeleton >& h) const
@@ -171,7 +170,7 @@ public:
   { return has_a_child_with_id_and_role(h.object(), ids, child_type, role_id); }
 
 private:
-  const std::vector< Uint64 >& ids;
+  Id_Bitmap ids;
   uint32 child_type;
   uint32 role_id;
 };
@@ -181,13 +180,13 @@ class Get_Parent_Ways_Predicate
 {
 public:
   Get_Parent_Ways_Predicate(const std::vector< Node::Id_Type >& ids_)
-    : ids(ids_) {}
+    : ids(ids_.begin(), ids_.end()) {}
   bool match(const Way_Skeleton& obj) const { return has_a_child_with_id(obj, ids); }
   bool match(const Handle< Way_Skeleton >& h) const { return has_a_child_with_id(h.object(), ids); }
   bool match(const Handle< Attic< Way_Skeleton > >& h) const { return has_a_child_with_id(h.object(), ids); }
 
 private:
-  const std::vector< Node::Id_Type >& ids;
+  Id_Bitmap ids;
 };
 
 
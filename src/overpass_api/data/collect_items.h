@@ -19,9 +19,12 @@
 #ifndef DE__OSM3S___OVERPASS_API__DATA__COLLECT_ITEMS_H
 #define DE__OSM3S___OVERPASS_API__DATA__COLLECT_ITEMS_H
 
+#include "../core/settings.h"
 #include "filenames.h"
+#include "worker_pool.h"
 
 #include <exception>
+#include <set>
 
 
 inline uint64 timestamp_of(const Attic< Node_Skeleton >& skel) { return skel.timestamp; }
@@ -125,6 +128,16 @@ void reconstruct_items(const Statement* stmt, Resource_Manager& rman,
           reference = *skels_it;
         else
           reference = Object();
+
+        // A full delta does not depend on newer versions, hence expansion can start at the oldest one
+        typename std::vector< const Attic< typename Object::Delta >* >::const_iterator start = it;
+        for (typename std::vector< const Attic< typename Object::Delta >* >::const_iterator it2 = it;
+            it2 != delta_refs.end() && (*it2)->id == (*it)->id; ++it2)
+        {
+          if ((*it2)->full)
+            start = it2;
+        }
+        it = start;
       }
       try
       {
@@ -339,20 +352,43 @@ void collect_items_discrete(Transaction& transaction,
 }
 
 
-template < class Index, class Object, class Container, class Predicate >
-void collect_items_discrete_by_timestamp(const Statement* stmt, Resource_Manager& rman,
-                   const Container& req, const Predicate& predicate,
+// Returns whether the database keeps the newest attic timestamp per index for this type of skeleton
+template < class Object >
+bool attic_newest_kept(Resource_Manager& rman)
+{
+  File_Properties* file_prop = attic_newest_file_properties< Object >();
+  return file_exists(rman.get_transaction()->get_db_dir()
+      + file_prop->get_file_name_trunk() + file_prop->get_data_suffix());
+}
+
+
+// Returns the indexes whose newest attic element is newer than the given timestamp
+template < class Index, class Iterator >
+std::vector< Index > attic_indexes_newer_than(Iterator it, const Iterator& end, uint64 timestamp)
+{
+  std::vector< Index > result;
+  for (; !(it == end); ++it)
+  {
+    if (timestamp < it.object().timestamp && (result.empty() || !(result.back() == it.index())))
+      result.push_back(it.index());
+  }
+  return result;
+}
+
+
+template < class Index, class Object, class Current_Iterator, class Predicate >
+void collect_items_by_timestamp(const Statement* stmt, Resource_Manager& rman,
+                   Current_Iterator current_begin, Current_Iterator current_end,
+                   const std::vector< Index >& attic_req,
+                   const Predicate& predicate, uint64 timestamp,
                    std::map< Index, std::vector< Object > >& result,
                    std::map< Index, std::vector< Attic< Object > > >& attic_result)
 {
-  Block_Backend< Index, Object, typename Container::const_iterator > current_db
-      (rman.get_transaction()->data_index(current_skeleton_file_properties< Object >()));
-  Block_Backend< Index, Attic< typename Object::Delta >, typename Container::const_iterator > attic_db
+  Block_Backend< Index, Attic< typename Object::Delta >, typename std::vector< Index >::const_iterator > attic_db
       (rman.get_transaction()->data_index(attic_skeleton_file_properties< Object >()));
-  collect_items_by_timestamp(stmt, rman,
-      current_db.discrete_begin(req.begin(), req.end()), current_db.discrete_end(),
-      attic_db.discrete_begin(req.begin(), req.end()), attic_db.discrete_end(),
-      predicate, rman.get_desired_timestamp(), result, attic_result);
+  collect_items_by_timestamp(stmt, rman, current_begin, current_end,
+      attic_db.discrete_begin(attic_req.begin(), attic_req.end()), attic_db.discrete_end(),
+      predicate, timestamp, result, attic_result);
 }
 
 
@@ -364,6 +400,19 @@ void collect_items_discrete_by_timestamp(const Statement* stmt, Resource_Manager
 {
   Block_Backend< Index, Object, typename Container::const_iterator > current_db
       (rman.get_transaction()->data_index(current_skeleton_file_properties< Object >()));
+  if (attic_newest_kept< Object >(rman))
+  {
+    // Only indexes with attic elements newer than the timestamp can contain versions valid at that time
+    Block_Backend< Index, Timestamp, typename Container::const_iterator > newest_db
+        (rman.get_transaction()->data_index(attic_newest_file_properties< Object >()));
+    collect_items_by_timestamp(stmt, rman,
+        current_db.discrete_begin(req.begin(), req.end()), current_db.discrete_end(),
+        attic_indexes_newer_than< Index >(
+            newest_db.discrete_begin(req.begin(), req.end()), newest_db.discrete_end(), timestamp),
+        predicate, timestamp, result, attic_result);
+    return;
+  }
+
   Block_Backend< Index, Attic< typename Object::Delta >, typename Container::const_iterator > attic_db
       (rman.get_transaction()->data_index(attic_skeleton_file_properties< Object >()));
   collect_items_by_timestamp(stmt, rman,
@@ -374,7 +423,18 @@ void collect_items_discrete_by_timestamp(const Statement* stmt, Resource_Manager
 
 
 template < class Index, class Object, class Container, class Predicate >
-void collect_items_range(const Statement* stmt, Resource_Manager& rman,
+void collect_items_discrete_by_timestamp(const Statement* stmt, Resource_Manager& rman,
+                   const Container& req, const Predicate& predicate,
+                   std::map< Index, std::vector< Object > >& result,
+                   std::map< Index, std::vector< Attic< Object > > >& attic_result)
+{
+  collect_items_discrete_by_timestamp(stmt, rman, req, predicate, rman.get_desired_timestamp(),
+      result, attic_result);
+}
+
+
+template < class Index, class Object, class Container, class Predicate >
+void scan_items_range(const Statement* stmt, Resource_Manager& rman,
 		   File_Properties& file_properties,
 		   const Container& req, const Predicate& predicate,
 		   std::map< Index, std::vector< Object > >& result)
@@ -398,6 +458,137 @@ void collect_items_range(const Statement* stmt, Resource_Manager& rman,
 }
 
 
+// A range scan is split across workers only if every worker gets at least this many blocks
+const uint MIN_BLOCKS_PER_RANGE_WORKER = 16;
+
+
+/* Splits the ranges into at most max_parts consecutive parts that touch about the same number of blocks.
+The ranges are cut at block boundaries, so a single large range can be split as well.
+Returns less than two parts if the ranges are too small to be worth it or if they overlap. */
+template < class Index, class Container >
+std::vector< std::set< std::pair< Index, Index > > > partition_ranges
+    (File_Blocks_Index_Base* index, const Container& req, uint max_parts)
+{
+  std::vector< std::set< std::pair< Index, Index > > > result;
+  const std::list< File_Block_Index_Entry< Index > >& blocks = ((File_Blocks_Index< Index >*)index)->get_blocks();
+
+  std::vector< std::pair< Index, Index > > pieces;
+  typename std::list< File_Block_Index_Entry< Index > >::const_iterator block_it = blocks.begin();
+  for (typename Container::const_iterator it = req.begin(); it != req.end(); ++it)
+  {
+    if (!pieces.empty() && it->first < pieces.back().second)
+      return result;
+
+    Index lower = it->first;
+    while (block_it != blocks.end() && !(lower < block_it->index))
+      ++block_it;
+    while (block_it != blocks.end() && block_it->index < it->second)
+    {
+      if (lower < block_it->index)
+      {
+        pieces.push_back(std::make_pair(lower, block_it->index));
+        lower = block_it->index;
+      }
+      ++block_it;
+    }
+    if (lower < it->second)
+      pieces.push_back(std::make_pair(lower, it->second));
+  }
+
+  uint num_parts = std::min< uint >(max_parts, pieces.size() / MIN_BLOCKS_PER_RANGE_WORKER);
+  if (num_parts < 2)
+    return result;
+
+  result.resize(num_parts);
+  for (uint i = 0; i < pieces.size(); ++i)
+    result[(uint64)i * num_parts / pieces.size()].insert(pieces[i]);
+  return result;
+}
+
+
+template < class Index, class Object, class Predicate >
+class Range_Scan_Task : public Worker_Task
+{
+  public:
+    Range_Scan_Task(const Statement& stmt_, File_Properties& file_properties_,
+        const std::set< std::pair< Index, Index > >& req_, const Predicate& predicate_)
+        : stmt(&stmt_), file_properties(&file_properties_), req(&req_), predicate(&predicate_) {}
+
+    virtual bool run(Resource_Manager& rman, std::string& result)
+    {
+      std::map< Index, std::vector< Object > > items;
+      scan_items_range(stmt, rman, *file_properties, *req, *predicate, items);
+      append_map(items, result);
+      return true;
+    }
+
+  private:
+    const Statement* stmt;
+    File_Properties* file_properties;
+    const std::set< std::pair< Index, Index > >* req;
+    const Predicate* predicate;
+};
+
+
+template < class Index, class Object, class Container, class Predicate >
+bool collect_items_range_in_workers(const Statement& stmt, Resource_Manager& rman,
+		   File_Properties& file_properties,
+		   const Container& req, const Predicate& predicate,
+		   std::map< Index, std::vector< Object > >& result)
+{
+  uint max_workers = osm_base_settings().max_workers_per_query;
+  if (rman.is_worker() || max_workers < 2)
+    return false;
+
+  std::vector< std::set< std::pair< Index, Index > > > parts = partition_ranges< Index >(
+      rman.get_transaction()->data_index(&file_properties), req, max_workers);
+  if (parts.size() < 2)
+    return false;
+
+  std::vector< Range_Scan_Task< Index, Object, Predicate > > tasks;
+  for (uint i = 0; i < parts.size(); ++i)
+    tasks.push_back(Range_Scan_Task< Index, Object, Predicate >(stmt, file_properties, parts[i], predicate));
+  std::vector< Worker_Task* > task_ptrs;
+  for (uint i = 0; i < tasks.size(); ++i)
+    task_ptrs.push_back(&tasks[i]);
+
+  std::vector< std::string > buffers;
+  std::vector< bool > delivered = run_in_workers(task_ptrs, max_workers, rman, stmt, buffers);
+
+  // The parts cover disjoint indexes in ascending order, hence appending them keeps the sequential order
+  for (uint i = 0; i < parts.size(); ++i)
+  {
+    std::map< Index, std::vector< Object > > items;
+    std::string::size_type pos = 0;
+    if (!delivered[i] || !read_map(buffers[i], pos, items) || pos != buffers[i].size())
+    {
+      items.clear();
+      scan_items_range(&stmt, rman, file_properties, parts[i], predicate, items);
+    }
+    std::string().swap(buffers[i]);
+
+    for (typename std::map< Index, std::vector< Object > >::iterator it = items.begin(); it != items.end(); ++it)
+    {
+      std::vector< Object >& target = result[it->first];
+      target.insert(target.end(), it->second.begin(), it->second.end());
+    }
+  }
+  return true;
+}
+
+
+template < class Index, class Object, class Container, class Predicate >
+void collect_items_range(const Statement* stmt, Resource_Manager& rman,
+		   File_Properties& file_properties,
+		   const Container& req, const Predicate& predicate,
+		   std::map< Index, std::vector< Object > >& result)
+{
+  if (stmt && collect_items_range_in_workers(*stmt, rman, file_properties, req, predicate, result))
+    return;
+  scan_items_range(stmt, rman, file_properties, req, predicate, result);
+}
+
+
 template < class Index, class Object, class Container, class Predicate >
 void collect_items_range_by_timestamp(const Statement* stmt, Resource_Manager& rman,
                    const Container& req, const Predicate& predicate,
@@ -406,6 +597,19 @@ void collect_items_range_by_timestamp(const Statement* stmt, Resource_Manager& r
 {
   Block_Backend< Index, Object, typename Container::const_iterator > current_db
       (rman.get_transaction()->data_index(current_skeleton_file_properties< Object >()));
+  if (attic_newest_kept< Object >(rman))
+  {
+    // Only indexes with attic elements newer than the timestamp can contain versions valid at that time
+    Block_Backend< Index, Timestamp, typename Container::const_iterator > newest_db
+        (rman.get_transaction()->data_index(attic_newest_file_properties< Object >()));
+    collect_items_by_timestamp(stmt, rman,
+        current_db.range_begin(req.begin(), req.end()), current_db.range_end(),
+        attic_indexes_newer_than< Index >(
+            newest_db.range_begin(req.begin(), req.end()), newest_db.range_end(), rman.get_desired_timestamp()),
+        predicate, rman.get_desired_timestamp(), result, attic_result);
+    return;
+  }
+
   Block_Backend< Index, Attic< typename Object::Delta >, typename Container::const_iterator > attic_db
       (rman.get_transaction()->data_index(attic_skeleton_file_properties< Object >()));
   collect_items_by_timestamp(stmt, rman,
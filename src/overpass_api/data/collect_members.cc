@@ -1348,7 +1348,7 @@ void collect_ways
   std::set< Uint31_Index > req = extract_parent_indices(nodes);
   rman.health_check(stmt);
 
-  collect_items_discrete(&stmt, rman, *osm_base_settings().WAYS, req,
+  collect_parents(stmt, rman, ids, *osm_base_settings().NODE_WAYS, &req,
       Get_Parent_Ways_Predicate(ids), result);
 }
 
@@ -1365,12 +1365,12 @@ void collect_ways
   rman.health_check(stmt);
 
   if (!invert_ids)
-    collect_items_discrete(&stmt, rman, *osm_base_settings().WAYS, req,
+    collect_parents(stmt, rman, children_ids, *osm_base_settings().NODE_WAYS, &req,
         And_Predicate< Way_Skeleton,
 	    Id_Predicate< Way_Skeleton >, Get_Parent_Ways_Predicate >
 	    (Id_Predicate< Way_Skeleton >(ids), Get_Parent_Ways_Predicate(children_ids)), result);
   else
-    collect_items_discrete(&stmt, rman, *osm_base_settings().WAYS, req,
+    collect_parents(stmt, rman, children_ids, *osm_base_settings().NODE_WAYS, &req,
         And_Predicate< Way_Skeleton,
 	    Not_Predicate< Way_Skeleton, Id_Predicate< Way_Skeleton > >,
 	    Get_Parent_Ways_Predicate >
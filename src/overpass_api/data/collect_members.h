@@ -1018,6 +1018,69 @@ std::set< Uint31_Index > extract_parent_indices(const std::map< TIndex, std::vec
 }
 
 
+inline std::vector< Uint64 > member_relations_keys(const std::vector< Uint64 >& ids, uint32 type)
+{
+  std::vector< Uint64 > keys;
+  keys.reserve(ids.size());
+  for (std::vector< Uint64 >::const_iterator it = ids.begin(); it != ids.end(); ++it)
+    keys.push_back(member_relations_key(*it, type));
+  return keys;
+}
+
+
+/* Looks up in the reverse file reverse_file_prop the ids and current indexes of all parents of the given keys.
+ * Returns false if the database has no such file. */
+template< typename Skeleton >
+bool get_parents_from_reverse_file
+    (const Statement& stmt, Resource_Manager& rman,
+     const std::vector< Uint64 >& keys, const File_Properties& reverse_file_prop,
+     std::vector< typename Skeleton::Id_Type >& parent_ids, std::set< Uint31_Index >& req)
+{
+  // Databases from before the introduction of the reverse files lack them.
+  File_Blocks_Index< Uint64 >* index = (File_Blocks_Index< Uint64 >*)
+      rman.get_transaction()->data_index(&reverse_file_prop);
+  if (!file_exists(index->get_data_file_name()))
+    return false;
+
+  std::set< Uint64 > key_set(keys.begin(), keys.end());
+  Block_Backend< Uint64, typename Skeleton::Id_Type > db(index);
+  for (typename Block_Backend< Uint64, typename Skeleton::Id_Type >::Discrete_Iterator
+      it(db.discrete_begin(key_set.begin(), key_set.end())); !(it == db.discrete_end()); ++it)
+    parent_ids.push_back(it.object());
+  std::sort(parent_ids.begin(), parent_ids.end());
+  parent_ids.erase(std::unique(parent_ids.begin(), parent_ids.end()), parent_ids.end());
+  rman.health_check(stmt);
+
+  std::vector< Uint31_Index > idxs = get_indexes< Uint31_Index, Skeleton >(parent_ids, rman).first;
+  req.insert(idxs.begin(), idxs.end());
+  return true;
+}
+
+
+/* Collects the current parents that fulfill predicate.
+ * If the database has the reverse file then only the parents listed there are read.
+ * Otherwise all objects at the candidate indexes req are scanned, or all objects if req is null. */
+template< typename Skeleton, typename Predicate >
+void collect_parents
+    (const Statement& stmt, Resource_Manager& rman,
+     const std::vector< Uint64 >& keys, const File_Properties& reverse_file_prop,
+     const std::set< Uint31_Index >* req, const Predicate& predicate,
+     std::map< Uint31_Index, std::vector< Skeleton > >& result)
+{
+  std::vector< typename Skeleton::Id_Type > parent_ids;
+  std::set< Uint31_Index > parent_req;
+  if (get_parents_from_reverse_file< Skeleton >(stmt, rman, keys, reverse_file_prop, parent_ids, parent_req))
+    collect_items_discrete(&stmt, rman, *current_skeleton_file_properties< Skeleton >(), parent_req,
+        And_Predicate< Skeleton, Id_Predicate< Skeleton >, Predicate >
+            (Id_Predicate< Skeleton >(parent_ids), predicate), result);
+  else if (req)
+    collect_items_discrete(&stmt, rman, *current_skeleton_file_properties< Skeleton >(), *req,
+        predicate, result);
+  else
+    collect_items_flat(stmt, rman, *current_skeleton_file_properties< Skeleton >(), predicate, result);
+}
+
+
 void collect_ways(const Statement& query, Resource_Manager& rman,
 		  const std::map< Uint31_Index, std::vector< Relation_Skeleton > >& rels,
 		  const std::set< std::pair< Uint31_Index, Uint31_Index > >& ranges,
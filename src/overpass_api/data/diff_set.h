@@ -23,6 +23,7 @@
 #include "../core/datatypes.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -137,6 +138,7 @@ struct Diff_Set
 
   Set make_from_set() const;
   Set make_to_set() const;
+  std::set< uint32 > user_ids() const;
 };
 
 
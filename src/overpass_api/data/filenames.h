@@ -75,6 +75,23 @@ template< > inline File_Properties* attic_skeleton_file_properties< Relation_Ske
 
 
 
+template< typename Skeleton >
+File_Properties* attic_newest_file_properties()
+{
+  return 0;
+}
+
+template< > inline File_Properties* attic_newest_file_properties< Node_Skeleton >()
+{ return attic_settings().NODES_NEWEST; }
+
+template< > inline File_Properties* attic_newest_file_properties< Way_Skeleton >()
+{ return attic_settings().WAYS_NEWEST; }
+
+template< > inline File_Properties* attic_newest_file_properties< Relation_Skeleton >()
+{ return attic_settings().RELATIONS_NEWEST; }
+
+
+
 template< typename Skeleton >
 File_Properties* current_local_tags_file_properties()
 {
@@ -79,6 +79,7 @@ public:
   Attic_Meta_Collector(const std::map< Index, std::vector< Attic< Object > > >& items,
                        Transaction& transaction, bool turn_on);
 
+  void reset();
   const OSM_Element_Metadata_Skeleton< typename Object::Id_Type >* get
       (const Index& index, typename Object::Id_Type ref, uint64 timestamp = NOW);
 
@@ -150,6 +151,7 @@ void Meta_Collector< Index, Id_Type >::reset()
     delete current_index;
     current_index = 0;
   }
+  current_objects.clear();
 
   if (used_ranges.empty())
   {
@@ -263,6 +265,14 @@ Attic_Meta_Collector< Index, Object >::Attic_Meta_Collector(
 {}
 
 
+template< typename Index, typename Object >
+void Attic_Meta_Collector< Index, Object >::reset()
+{
+  current.reset();
+  attic.reset();
+}
+
+
 template< typename Index, typename Object >
 const OSM_Element_Metadata_Skeleton< typename Object::Id_Type >* Attic_Meta_Collector< Index, Object >::get(
     const Index& index, typename Object::Id_Type ref, uint64 timestamp)
@@ -30,7 +30,7 @@ Extra_Data_For_Diff::Extra_Data_For_Diff(
     Resource_Manager& rman, const Statement& stmt, const Set& to_print, unsigned int mode_,
     double south, double north, double west, double east)
     : mode(mode_), way_geometry_store(0), attic_way_geometry_store(0),
-    relation_geometry_store(0), attic_relation_geometry_store(0), roles(0), users(0)
+    relation_geometry_store(0), attic_relation_geometry_store(0), roles(0)
 {
   if (mode & (Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER))
   {
@@ -53,15 +53,6 @@ Extra_Data_For_Diff::Extra_Data_For_Diff(
   }
 
   roles = &relation_member_roles(*rman.get_transaction());
-
-  if (mode & Output_Mode::META)
-    users = &rman.users();
-}
-
-
-const std::map< uint32, std::string >* Extra_Data_For_Diff::get_users() const
-{
-  return users;
 }
 
 
@@ -83,12 +74,154 @@ void Set_Comparison::set_target(bool target)
 }
 
 
+namespace
+{
+  // FNV-1a over the content compared by compare_item
+  struct Content_Hash
+  {
+    Content_Hash() : value(0xcbf29ce484222325ull) {}
+
+    void add(const void* data, uint32 size)
+    {
+      for (const uint8* it = (const uint8*)data; it < (const uint8*)data + size; ++it)
+        value = (value ^ *it) * 0x100000001b3ull;
+    }
+    void add(uint64 v) { add(&v, 8); }
+    void add(const std::string& s)
+    {
+      add((uint64)s.size());
+      add(s.data(), s.size());
+    }
+
+    uint64 value;
+  };
+
+
+  template< typename Id_Type >
+  void add_common(Content_Hash& hash, uint32 ll_upper,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const OSM_Element_Metadata_Skeleton< Id_Type >* meta)
+  {
+    hash.add(ll_upper);
+    if (tags)
+    {
+      hash.add(tags->size());
+      for (std::vector< std::pair< std::string, std::string > >::const_iterator it = tags->begin();
+          it != tags->end(); ++it)
+      {
+        hash.add(it->first);
+        hash.add(it->second);
+      }
+    }
+    else
+      hash.add(0xffffffffffffffffull);
+    hash.add(meta ? meta->timestamp : 0xffffffffffffffffull);
+  }
+
+
+  void add_geometry(Content_Hash& hash, const std::vector< Quad_Coord >& geometry)
+  {
+    hash.add(geometry.size());
+    for (std::vector< Quad_Coord >::const_iterator it = geometry.begin(); it != geometry.end(); ++it)
+      hash.add(((uint64)it->ll_upper<<32) | it->ll_lower);
+  }
+
+
+  uint64 content_hash(uint32 ll_upper, const Node_Skeleton& skel,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type >* meta)
+  {
+    Content_Hash hash;
+    add_common(hash, ll_upper, tags, meta);
+    hash.add(skel.ll_lower);
+    return hash.value;
+  }
+
+
+  uint64 content_hash(uint32 ll_upper, const Way_Skeleton& skel,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const std::vector< Quad_Coord >* geometry,
+      const OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type >* meta)
+  {
+    Content_Hash hash;
+    add_common(hash, ll_upper, tags, meta);
+    hash.add(skel.nds.size());
+    for (std::vector< Node::Id_Type >::const_iterator it = skel.nds.begin(); it != skel.nds.end(); ++it)
+      hash.add(it->val());
+    if (geometry)
+      add_geometry(hash, *geometry);
+    return hash.value;
+  }
+
+
+  uint64 content_hash(uint32 ll_upper, const Relation_Skeleton& skel,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const std::vector< std::vector< Quad_Coord > >* geometry,
+      const OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type >* meta)
+  {
+    Content_Hash hash;
+    add_common(hash, ll_upper, tags, meta);
+    hash.add(skel.members.size());
+    for (std::vector< Relation_Entry >::const_iterator it = skel.members.begin(); it != skel.members.end(); ++it)
+    {
+      hash.add(it->ref.val());
+      hash.add(((uint64)it->type<<32) | it->role);
+    }
+    if (geometry)
+    {
+      hash.add(geometry->size());
+      for (std::vector< std::vector< Quad_Coord > >::const_iterator it = geometry->begin(); it != geometry->end(); ++it)
+        add_geometry(hash, *it);
+    }
+    return hash.value;
+  }
+}
+
+
+// Returns true for an element of the rhs that has no equal element on the lhs
+template< typename Id_Type >
+bool Set_Comparison::join_fingerprint(Fingerprint_Table< Id_Type >& table, std::vector< Id_Type >& changed,
+    Id_Type id, uint64 hash)
+{
+  if (!final_target)
+    table.insert(id, hash);
+  else if (!table.matches(id, hash))
+  {
+    changed.push_back(id);
+    return true;
+  }
+  return false;
+}
+
+
+template< typename Id_Type >
+void Set_Comparison::collect_changed(Fingerprint_Table< Id_Type >& table, std::vector< Id_Type >& changed)
+{
+  table.collect_unmatched(changed);
+  table.clear();
+  std::sort(changed.begin(), changed.end());
+  changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+}
+
+
 void Set_Comparison::print_item(Extra_Data_For_Diff& extra_data, uint32 ll_upper, const Node_Skeleton& skel,
                     const std::vector< std::pair< std::string, std::string > >* tags,
                     const OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type >* meta,
                     const std::map< uint32, std::string >* users)
 {
-  if (final_target)
+  if (pass == fingerprints)
+  {
+    if (join_fingerprint(node_fingerprints, changed_nodes, skel.id, content_hash(ll_upper, skel, tags, meta)))
+      unmatched_nodes.push_back(Unmatched_Item< Node_With_Context >(
+          Node_With_Context(ll_upper, skel, NOW,
+              meta ? *meta : OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type >(),
+              tags ? *tags : std::vector< std::pair< std::string, std::string > >()),
+          tags, false, meta));
+  }
+  else if (pass == changed_elements
+      && !std::binary_search(changed_nodes.begin(), changed_nodes.end(), skel.id))
+    return;
+  else if (final_target)
     compare_item(ll_upper, skel, tags, NOW, meta, users);
   else
     store_item(ll_upper, skel, tags, NOW, meta, users);
@@ -100,7 +233,19 @@ void Set_Comparison::print_item(Extra_Data_For_Diff& extra_data, uint32 ll_upper
                     const OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type >* meta,
                     const std::map< uint32, std::string >* users)
 {
-  if (final_target)
+  if (pass == fingerprints)
+  {
+    if (join_fingerprint(node_fingerprints, changed_nodes, skel.id, content_hash(ll_upper, skel, tags, meta)))
+      unmatched_nodes.push_back(Unmatched_Item< Node_With_Context >(
+          Node_With_Context(ll_upper, skel, skel.timestamp,
+              meta ? *meta : OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type >(),
+              tags ? *tags : std::vector< std::pair< std::string, std::string > >()),
+          tags, false, meta));
+  }
+  else if (pass == changed_elements
+      && !std::binary_search(changed_nodes.begin(), changed_nodes.end(), skel.id))
+    return;
+  else if (final_target)
     compare_item(ll_upper, skel, tags, skel.timestamp, meta, users);
   else
     store_item(ll_upper, skel, tags, skel.timestamp, meta, users);
@@ -112,28 +257,7 @@ void Set_Comparison::print_item(Extra_Data_For_Diff& extra_data, uint32 ll_upper
                     const OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type >* meta,
                     const std::map< uint32, std::string >* users)
 {
-  if (extra_data.way_geometry_store)
-  {
-    std::vector< Quad_Coord > geometry = extra_data.way_geometry_store->get_geometry(skel);
-    Double_Coords double_coords(geometry);
-    if (final_target)
-      compare_item(ll_upper, skel, tags,
-          geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode),
-          ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.nds.size()) ? &geometry : 0,
-          NOW, meta, users);
-    else
-      store_item(ll_upper, skel, tags,
-          geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode),
-          ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.nds.size()) ? &geometry : 0,
-          NOW, meta, users);
-  }
-  else
-  {
-    if (final_target)
-      compare_item(ll_upper, skel, tags, 0, 0, NOW, meta, users);
-    else
-      store_item(ll_upper, skel, tags, 0, 0, NOW, meta, users);
-  }
+  print_way(extra_data, extra_data.way_geometry_store, ll_upper, skel, NOW, tags, meta, users);
 }
 
 
@@ -142,28 +266,42 @@ void Set_Comparison::print_item(Extra_Data_For_Diff& extra_data, uint32 ll_upper
                     const OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type >* meta,
                     const std::map< uint32, std::string >* users)
 {
-  if (extra_data.attic_way_geometry_store)
+  print_way(extra_data, extra_data.attic_way_geometry_store, ll_upper, skel, skel.timestamp, tags, meta, users);
+}
+
+
+void Set_Comparison::print_way(Extra_Data_For_Diff& extra_data, Way_Bbox_Geometry_Store* geometry_store,
+    uint32 ll_upper, const Way_Skeleton& skel, uint64 timestamp,
+    const std::vector< std::pair< std::string, std::string > >* tags,
+    const OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type >* meta,
+    const std::map< uint32, std::string >* users)
+{
+  if (pass == changed_elements && !std::binary_search(changed_ways.begin(), changed_ways.end(), skel.id))
+    return;
+
+  std::vector< Quad_Coord > geometry;
+  if (geometry_store)
+    geometry_store->get_geometry(skel).swap(geometry);
+  Double_Coords double_coords(geometry);
+  const std::pair< Quad_Coord, Quad_Coord* >* bounds
+      = geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode);
+  const std::vector< Quad_Coord >* full_geometry
+      = ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.nds.size()) ? &geometry : 0;
+
+  if (pass == fingerprints)
   {
-    std::vector< Quad_Coord > geometry = extra_data.attic_way_geometry_store->get_geometry(skel);
-    Double_Coords double_coords(geometry);
-    if (final_target)
-      compare_item(ll_upper, skel, tags,
-          geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode),
-          ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.nds.size()) ? &geometry : 0,
-          skel.timestamp, meta, users);
-    else
-      store_item(ll_upper, skel, tags,
-          geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode),
-          ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.nds.size()) ? &geometry : 0,
-          skel.timestamp, meta, users);
+    if (join_fingerprint(way_fingerprints, changed_ways, skel.id,
+        content_hash(ll_upper, skel, tags, full_geometry, meta)))
+      unmatched_ways.push_back(Unmatched_Item< Way_With_Context >(
+          Way_With_Context(ll_upper, skel, full_geometry ? *full_geometry : std::vector< Quad_Coord >(),
+              timestamp, meta ? *meta : OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type >(),
+              tags ? *tags : std::vector< std::pair< std::string, std::string > >()),
+          tags, full_geometry, meta));
   }
+  else if (final_target)
+    compare_item(ll_upper, skel, tags, bounds, full_geometry, timestamp, meta, users);
   else
-  {
-    if (final_target)
-      compare_item(ll_upper, skel, tags, 0, 0, skel.timestamp, meta, users);
-    else
-      store_item(ll_upper, skel, tags, 0, 0, skel.timestamp, meta, users);
-  }
+    store_item(ll_upper, skel, tags, bounds, full_geometry, timestamp, meta, users);
 }
 
 
@@ -172,28 +310,7 @@ void Set_Comparison::print_item(Extra_Data_For_Diff& extra_data, uint32 ll_upper
                     const OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type >* meta,
                     const std::map< uint32, std::string >* users)
 {
-  if (extra_data.relation_geometry_store)
-  {
-    std::vector< std::vector< Quad_Coord > > geometry = extra_data.relation_geometry_store->get_geometry(skel);
-    Double_Coords double_coords(geometry);
-    if (final_target)
-      compare_item(ll_upper, skel, tags,
-          geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode),
-          ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.members.size()) ? &geometry : 0,
-          NOW, meta, users);
-    else
-      store_item(ll_upper, skel, tags,
-          geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode),
-          ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.members.size()) ? &geometry : 0,
-          NOW, meta, users);
-  }
-  else
-  {
-    if (final_target)
-      compare_item(ll_upper, skel, tags, 0, 0, NOW, meta, users);
-    else
-      store_item(ll_upper, skel, tags, 0, 0, NOW, meta, users);
-  }
+  print_relation(extra_data, extra_data.relation_geometry_store, ll_upper, skel, NOW, tags, meta, users);
 }
 
 
@@ -202,28 +319,45 @@ void Set_Comparison::print_item(Extra_Data_For_Diff& extra_data, uint32 ll_upper
                     const OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type >* meta,
                     const std::map< uint32, std::string >* users)
 {
-  if (extra_data.attic_relation_geometry_store)
+  print_relation(extra_data, extra_data.attic_relation_geometry_store, ll_upper, skel, skel.timestamp,
+      tags, meta, users);
+}
+
+
+void Set_Comparison::print_relation(Extra_Data_For_Diff& extra_data, Relation_Geometry_Store* geometry_store,
+    uint32 ll_upper, const Relation_Skeleton& skel, uint64 timestamp,
+    const std::vector< std::pair< std::string, std::string > >* tags,
+    const OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type >* meta,
+    const std::map< uint32, std::string >* users)
+{
+  if (pass == changed_elements
+      && !std::binary_search(changed_relations.begin(), changed_relations.end(), skel.id))
+    return;
+
+  std::vector< std::vector< Quad_Coord > > geometry;
+  if (geometry_store)
+    geometry_store->get_geometry(skel).swap(geometry);
+  Double_Coords double_coords(geometry);
+  const std::pair< Quad_Coord, Quad_Coord* >* bounds
+      = geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode);
+  const std::vector< std::vector< Quad_Coord > >* full_geometry
+      = ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.members.size()) ? &geometry : 0;
+
+  if (pass == fingerprints)
   {
-    std::vector< std::vector< Quad_Coord > > geometry = extra_data.attic_relation_geometry_store->get_geometry(skel);
-    Double_Coords double_coords(geometry);
-    if (final_target)
-      compare_item(ll_upper, skel, tags,
-        geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode),
-        ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.members.size()) ? &geometry : 0,
-        skel.timestamp, meta, users);
-    else
-      store_item(ll_upper, skel, tags,
-        geometry.empty() ? 0 : bound_variant(double_coords, extra_data.mode),
-        ((extra_data.mode & Output_Mode::GEOMETRY) && geometry.size() == skel.members.size()) ? &geometry : 0,
-        skel.timestamp, meta, users);
+    if (join_fingerprint(relation_fingerprints, changed_relations, skel.id,
+        content_hash(ll_upper, skel, tags, full_geometry, meta)))
+      unmatched_relations.push_back(Unmatched_Item< Relation_With_Context >(
+          Relation_With_Context(ll_upper, skel,
+              full_geometry ? *full_geometry : std::vector< std::vector< Quad_Coord > >(),
+              timestamp, meta ? *meta : OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type >(),
+              tags ? *tags : std::vector< std::pair< std::string, std::string > >()),
+          tags, full_geometry, meta));
   }
+  else if (final_target)
+    compare_item(ll_upper, skel, tags, bounds, full_geometry, timestamp, meta, users);
   else
-  {
-    if (final_target)
-      compare_item(ll_upper, skel, tags, 0, 0, skel.timestamp, meta, users);
-    else
-      store_item(ll_upper, skel, tags, 0, 0, skel.timestamp, meta, users);
-  }
+    store_item(ll_upper, skel, tags, bounds, full_geometry, timestamp, meta, users);
 }
 
 
@@ -247,7 +381,7 @@ void Set_Comparison::tags_quadtile
         it2 != item_it->second.end(); ++it2)
     {
       print_item(extra_data, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-          meta_printer.get(item_it->first, it2->id), extra_data.users);
+          meta_printer.get(item_it->first, it2->id), 0);
     }
     ++item_it;
   }
@@ -273,7 +407,7 @@ void Set_Comparison::tags_quadtile_attic
         it2 != item_it->second.end(); ++it2)
     {
       print_item(extra_data, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-                 meta_printer.get(item_it->first, it2->id, it2->timestamp), extra_data.users);
+                 meta_printer.get(item_it->first, it2->id, it2->timestamp), 0);
     }
     ++item_it;
   }
@@ -302,7 +436,7 @@ void Set_Comparison::tags_quadtile
     {
       if (std::binary_search(id_list.begin(), id_list.end(), it2->id))
         print_item(extra_data, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-            meta_printer.get(item_it->first, it2->id), extra_data.users);
+            meta_printer.get(item_it->first, it2->id), 0);
     }
     ++item_it;
   }
@@ -338,7 +472,7 @@ void Set_Comparison::tags_quadtile_attic
         if (!meta)
           meta = current_meta_printer.get(item_it->first, it2->id, it2->timestamp);
         print_item(extra_data, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-                 meta, extra_data.users);
+                 meta, 0);
       }
     }
     ++item_it;
@@ -490,6 +624,7 @@ void Set_Comparison::clear_nodes(Resource_Manager& rman, bool add_deletion_infor
 	searched_ids.push_back(it->elem.id);
     }
 
+    std::sort(searched_ids.begin(), searched_ids.end());
     std::vector< Uint32_Index > req = get_indexes_< Uint32_Index, Node_Skeleton >(searched_ids, rman, true);
     std::vector< Node_Skeleton::Id_Type > found_ids
         = find_still_existing_skeletons< Uint32_Index, Node_Skeleton >(
@@ -520,6 +655,7 @@ void Set_Comparison::clear_nodes(Resource_Manager& rman, bool add_deletion_infor
         searched_ids.push_back(it->second.elem.id);
     }
 
+    std::sort(searched_ids.begin(), searched_ids.end());
     get_indexes_< Uint32_Index, Node_Skeleton >(searched_ids, rman, true).swap(req);
     find_still_existing_skeletons< Uint32_Index, Node_Skeleton >(
         rman, rman.get_diff_from_timestamp(), req, searched_ids).swap(found_ids);
@@ -620,6 +756,7 @@ void Set_Comparison::clear_ways(Resource_Manager& rman, bool add_deletion_inform
 	searched_ids.push_back(it->elem.id);
     }
 
+    std::sort(searched_ids.begin(), searched_ids.end());
     std::vector< Uint31_Index > req = get_indexes_< Uint31_Index, Way_Skeleton >(searched_ids, rman, true);
     std::vector< Way_Skeleton::Id_Type > found_ids
         = find_still_existing_skeletons< Uint31_Index, Way_Skeleton >(
@@ -651,6 +788,7 @@ void Set_Comparison::clear_ways(Resource_Manager& rman, bool add_deletion_inform
         searched_ids.push_back(it->second.elem.id);
     }
 
+    std::sort(searched_ids.begin(), searched_ids.end());
     get_indexes_< Uint31_Index, Way_Skeleton >(searched_ids, rman, true).swap(req);
     find_still_existing_skeletons< Uint31_Index, Way_Skeleton >(
         rman, rman.get_diff_from_timestamp(), req, searched_ids).swap(found_ids);
@@ -752,6 +890,7 @@ void Set_Comparison::clear_relations(Resource_Manager& rman, bool add_deletion_i
 	searched_ids.push_back(it->elem.id);
     }
 
+    std::sort(searched_ids.begin(), searched_ids.end());
     std::vector< Uint31_Index > req = get_indexes_< Uint31_Index, Relation_Skeleton >(searched_ids, rman, true);
     std::vector< Relation_Skeleton::Id_Type > found_ids
         = find_still_existing_skeletons< Uint31_Index, Relation_Skeleton >(
@@ -786,6 +925,7 @@ void Set_Comparison::clear_relations(Resource_Manager& rman, bool add_deletion_i
         searched_ids.push_back(it->second.elem.id);
     }
 
+    std::sort(searched_ids.begin(), searched_ids.end());
     get_indexes_< Uint31_Index, Relation_Skeleton >(searched_ids, rman, true).swap(req);
     find_still_existing_skeletons< Uint31_Index, Relation_Skeleton >(
         rman, rman.get_diff_from_timestamp(), req, searched_ids).swap(found_ids);
@@ -1069,6 +1209,51 @@ void Set_Comparison::compute_deriveds(std::map< Uint31_Index, std::vector< Deriv
 }
 
 
+void Set_Comparison::collect_side(
+    Resource_Manager& rman, Extra_Data_For_Diff& extra_data, const Set& set, uint64 timestamp)
+{
+  rman.set_desired_timestamp(timestamp);
+
+  tags_quadtile(extra_data, set.nodes, rman);
+  if (rman.get_desired_timestamp() != NOW)
+    tags_quadtile_attic(extra_data, set.attic_nodes, rman);
+
+  tags_quadtile(extra_data, set.ways, rman);
+  if (rman.get_desired_timestamp() != NOW)
+    tags_quadtile_attic(extra_data, set.attic_ways, rman);
+
+  tags_quadtile(extra_data, set.relations, rman);
+  if (rman.get_desired_timestamp() != NOW)
+    tags_quadtile_attic(extra_data, set.attic_relations, rman);
+}
+
+
+// Compares the unmatched elements of the rhs as if they were printed again
+void Set_Comparison::compare_unmatched(Resource_Manager& rman, bool add_deletion_information)
+{
+  for (std::vector< Unmatched_Item< Node_With_Context > >::const_iterator it = unmatched_nodes.begin();
+      it != unmatched_nodes.end(); ++it)
+    compare_item(it->item.idx.val(), it->item.elem, it->has_tags ? &it->item.tags : 0,
+        it->item.expiration_date, it->has_meta ? &it->item.meta : 0);
+  unmatched_nodes.clear();
+  clear_nodes(rman, add_deletion_information);
+
+  for (std::vector< Unmatched_Item< Way_With_Context > >::const_iterator it = unmatched_ways.begin();
+      it != unmatched_ways.end(); ++it)
+    compare_item(it->item.idx.val(), it->item.elem, it->has_tags ? &it->item.tags : 0, 0,
+        it->has_geometry ? &it->item.geometry : 0, it->item.expiration_date, it->has_meta ? &it->item.meta : 0);
+  unmatched_ways.clear();
+  clear_ways(rman, add_deletion_information);
+
+  for (std::vector< Unmatched_Item< Relation_With_Context > >::const_iterator it = unmatched_relations.begin();
+      it != unmatched_relations.end(); ++it)
+    compare_item(it->item.idx.val(), it->item.elem, it->has_tags ? &it->item.tags : 0, 0,
+        it->has_geometry ? &it->item.geometry : 0, it->item.expiration_date, it->has_meta ? &it->item.meta : 0);
+  unmatched_relations.clear();
+  clear_relations(rman, add_deletion_information);
+}
+
+
 Diff_Set Set_Comparison::compare_to_lhs(Resource_Manager& rman, const Statement& stmt,
     const Set& input_set, double south, double north, double west, double east, bool add_deletion_information)
 {
@@ -1082,41 +1267,36 @@ Diff_Set Set_Comparison::compare_to_lhs(Resource_Manager& rman, const Statement&
       | Output_Mode::TAGS | Output_Mode::VERSION | Output_Mode::META
       | Output_Mode::GEOMETRY, south, north, west, east);
 
-  tags_quadtile(extra_data_lhs, lhs_set_.nodes, rman);
-  if (rman.get_desired_timestamp() != NOW)
-    tags_quadtile_attic(extra_data_lhs, lhs_set_.attic_nodes, rman);
-
-  tags_quadtile(extra_data_lhs, lhs_set_.ways, rman);
-  if (rman.get_desired_timestamp() != NOW)
-    tags_quadtile_attic(extra_data_lhs, lhs_set_.attic_ways, rman);
-
-  tags_quadtile(extra_data_lhs, lhs_set_.relations, rman);
-  if (rman.get_desired_timestamp() != NOW)
-    tags_quadtile_attic(extra_data_lhs, lhs_set_.attic_relations, rman);
-
   rman.set_desired_timestamp(rhs_timestamp);
 
-  set_target(true);
-
   Extra_Data_For_Diff extra_data_rhs(rman, stmt, input_set, Output_Mode::ID
       | Output_Mode::COORDS | Output_Mode::NDS | Output_Mode::MEMBERS
       | Output_Mode::TAGS | Output_Mode::VERSION | Output_Mode::META
       | Output_Mode::GEOMETRY, south, north, west, east);
 
-  tags_quadtile(extra_data_rhs, input_set.nodes, rman);
-  if (rman.get_desired_timestamp() != NOW)
-    tags_quadtile_attic(extra_data_rhs, input_set.attic_nodes, rman);
-  clear_nodes(rman, add_deletion_information);
-
-  tags_quadtile(extra_data_rhs, input_set.ways, rman);
-  if (rman.get_desired_timestamp() != NOW)
-    tags_quadtile_attic(extra_data_rhs, input_set.attic_ways, rman);
-  clear_ways(rman, add_deletion_information);
+  // The lhs is reduced to content hashes by id. The rhs is read once against them
+  // and keeps full copies of only the elements without an equal element on the lhs.
+  pass = fingerprints;
+  set_target(false);
+  collect_side(rman, extra_data_lhs, lhs_set_, lhs_timestamp_);
+  set_target(true);
+  collect_side(rman, extra_data_rhs, input_set, rhs_timestamp);
+  collect_changed(node_fingerprints, changed_nodes);
+  collect_changed(way_fingerprints, changed_ways);
+  collect_changed(relation_fingerprints, changed_relations);
+
+  // Then only the changed elements of the lhs are copied to compare the kept elements of the rhs with them
+  pass = changed_elements;
+  set_target(false);
+  collect_side(rman, extra_data_lhs, lhs_set_, lhs_timestamp_);
+  set_target(true);
+  rman.set_desired_timestamp(rhs_timestamp);
+  compare_unmatched(rman, add_deletion_information);
 
-  tags_quadtile(extra_data_rhs, input_set.relations, rman);
-  if (rman.get_desired_timestamp() != NOW)
-    tags_quadtile_attic(extra_data_rhs, input_set.attic_relations, rman);
-  clear_relations(rman, add_deletion_information);
+  pass = all_elements;
+  changed_nodes.clear();
+  changed_ways.clear();
+  changed_relations.clear();
 
   compute_deriveds(input_set.deriveds);
 
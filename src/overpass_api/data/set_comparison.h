@@ -41,26 +41,153 @@ struct Extra_Data_For_Diff
       double south, double north, double west, double east);
   ~Extra_Data_For_Diff();
 
-  const std::map< uint32, std::string >* get_users() const;
-
   unsigned int mode;
   Way_Bbox_Geometry_Store* way_geometry_store;
   Way_Bbox_Geometry_Store* attic_way_geometry_store;
   Relation_Geometry_Store* relation_geometry_store;
   Relation_Geometry_Store* attic_relation_geometry_store;
   const std::map< uint32, std::string >* roles;
-  const std::map< uint32, std::string >* users;
 };
 
 
+/* Keeps per element id a hash of the element's content.
+ * The table is filled from the elements of one side and then probed with the elements of the other side,
+ * hence unchanged elements are recognized without keeping a copy of them. */
+template< typename Id_Type >
+class Fingerprint_Table
+{
+public:
+  Fingerprint_Table() : size_(0) {}
+
+  void insert(Id_Type id, uint64 hash);
+  // Returns true if the id has been inserted with the same hash. The entry is then marked as matched.
+  bool matches(Id_Type id, uint64 hash);
+  // Appends all inserted ids that have not been matched
+  void collect_unmatched(std::vector< Id_Type >& result) const;
+  void clear();
+
+private:
+  enum State { empty, stored, matched, ambiguous };
+  struct Entry
+  {
+    Entry() : id(), hash(0), state(empty) {}
+
+    Id_Type id;
+    uint64 hash;
+    State state;
+  };
+
+  std::vector< Entry > entries;
+  uint32 size_;
+
+  uint32 bucket(Id_Type id) const
+  {
+    return (((uint64)id.val() * 0x9e3779b97f4a7c15ull)>>32) & (entries.size() - 1);
+  }
+  void grow();
+};
+
+
+template< typename Id_Type >
+void Fingerprint_Table< Id_Type >::insert(Id_Type id, uint64 hash)
+{
+  if (2*(size_ + 1) > entries.size())
+    grow();
+
+  uint32 pos = bucket(id);
+  while (entries[pos].state != empty && !(entries[pos].id == id))
+    pos = (pos + 1) & (entries.size() - 1);
+
+  if (entries[pos].state == empty)
+  {
+    entries[pos].id = id;
+    entries[pos].hash = hash;
+    entries[pos].state = stored;
+    ++size_;
+  }
+  else
+    // The same id twice on one side is always compared in full
+    entries[pos].state = ambiguous;
+}
+
+
+template< typename Id_Type >
+bool Fingerprint_Table< Id_Type >::matches(Id_Type id, uint64 hash)
+{
+  if (entries.empty())
+    return false;
+
+  uint32 pos = bucket(id);
+  while (entries[pos].state != empty && !(entries[pos].id == id))
+    pos = (pos + 1) & (entries.size() - 1);
+
+  if (entries[pos].state != stored || entries[pos].hash != hash)
+    return false;
+  entries[pos].state = matched;
+  return true;
+}
+
+
+template< typename Id_Type >
+void Fingerprint_Table< Id_Type >::collect_unmatched(std::vector< Id_Type >& result) const
+{
+  for (typename std::vector< Entry >::const_iterator it = entries.begin(); it != entries.end(); ++it)
+  {
+    if (it->state == stored || it->state == ambiguous)
+      result.push_back(it->id);
+  }
+}
+
+
+template< typename Id_Type >
+void Fingerprint_Table< Id_Type >::clear()
+{
+  std::vector< Entry >().swap(entries);
+  size_ = 0;
+}
+
+
+template< typename Id_Type >
+void Fingerprint_Table< Id_Type >::grow()
+{
+  std::vector< Entry > old_entries(entries.empty() ? 64 : 2*entries.size());
+  old_entries.swap(entries);
+  for (typename std::vector< Entry >::const_iterator it = old_entries.begin(); it != old_entries.end(); ++it)
+  {
+    if (it->state != empty)
+    {
+      uint32 pos = bucket(it->id);
+      while (entries[pos].state != empty)
+        pos = (pos + 1) & (entries.size() - 1);
+      entries[pos] = *it;
+    }
+  }
+}
+
+
 class Evaluator;
 
 
+// An element of the rhs without an equal element on the lhs. The flags tell whether the element
+// has been compared with tags, geometry, and meta data.
+template< typename With_Context >
+struct Unmatched_Item
+{
+  Unmatched_Item(const With_Context& item_, bool has_tags_, bool has_geometry_, bool has_meta_)
+      : item(item_), has_tags(has_tags_), has_geometry(has_geometry_), has_meta(has_meta_) {}
+
+  With_Context item;
+  bool has_tags;
+  bool has_geometry;
+  bool has_meta;
+};
+
+
 class Set_Comparison
 {
 public:
   Set_Comparison(Transaction& transaction, const Set& lhs_set, uint64 lhs_timestamp)
-      : final_target(0), lhs_set_(lhs_set), lhs_timestamp_(lhs_timestamp) {}
+      : final_target(0), pass(all_elements), lhs_set_(lhs_set), lhs_timestamp_(lhs_timestamp) {}
 
   Diff_Set compare_to_lhs(Resource_Manager& rman, const Statement& stmt, const Set& input_set,
       double south, double north, double west, double east, bool add_deletion_information);
@@ -97,6 +224,11 @@ private:
                     const std::vector< std::pair< std::string, std::string > >* tags,
                     const OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type >* meta,
                     const std::map< uint32, std::string >* users);
+  void print_way(Extra_Data_For_Diff& extra_data, Way_Bbox_Geometry_Store* geometry_store,
+                    uint32 ll_upper, const Way_Skeleton& skel, uint64 timestamp,
+                    const std::vector< std::pair< std::string, std::string > >* tags,
+                    const OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type >* meta,
+                    const std::map< uint32, std::string >* users);
   void store_item(uint32 ll_upper, const Way_Skeleton& skel,
                             const std::vector< std::pair< std::string, std::string > >* tags,
                             const std::pair< Quad_Coord, Quad_Coord* >* bounds,
@@ -122,6 +254,11 @@ private:
                     const std::vector< std::pair< std::string, std::string > >* tags,
                     const OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type >* meta,
                     const std::map< uint32, std::string >* users);
+  void print_relation(Extra_Data_For_Diff& extra_data, Relation_Geometry_Store* geometry_store,
+                    uint32 ll_upper, const Relation_Skeleton& skel, uint64 timestamp,
+                    const std::vector< std::pair< std::string, std::string > >* tags,
+                    const OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type >* meta,
+                    const std::map< uint32, std::string >* users);
   void store_item(uint32 ll_upper, const Relation_Skeleton& skel,
                             const std::vector< std::pair< std::string, std::string > >* tags,
                             const std::pair< Quad_Coord, Quad_Coord* >* bounds,
@@ -139,12 +276,21 @@ private:
                             const Output_Handler::Feature_Action& action = Output_Handler::keep,
                             const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* new_meta = 0);
 
+  template< typename Id_Type >
+  bool join_fingerprint(Fingerprint_Table< Id_Type >& table, std::vector< Id_Type >& changed,
+      Id_Type id, uint64 hash);
+  template< typename Id_Type >
+  void collect_changed(Fingerprint_Table< Id_Type >& table, std::vector< Id_Type >& changed);
+
   void set_target(bool target);
 
   void clear_nodes(Resource_Manager& rman, bool add_deletion_information = false);
   void clear_ways(Resource_Manager& rman, bool add_deletion_information = false);
   void clear_relations(Resource_Manager& rman, bool add_deletion_information = false);
 
+  void collect_side(Resource_Manager& rman, Extra_Data_For_Diff& extra_data, const Set& set, uint64 timestamp);
+  void compare_unmatched(Resource_Manager& rman, bool add_deletion_information);
+
   void compute_deriveds(std::map< Uint31_Index, std::vector< Derived_Structure > > rhs_deriveds);
 
   const Set& lhs_set() const { return lhs_set_; }
@@ -171,6 +317,23 @@ private:
 
   bool final_target;
 
+  // Whether print_item collects fingerprints, full copies of the changed elements only, or full copies of all elements.
+  // With fingerprints, the rhs keeps full copies of its unmatched elements.
+  enum Pass { all_elements, fingerprints, changed_elements };
+  Pass pass;
+
+  Fingerprint_Table< Node_Skeleton::Id_Type > node_fingerprints;
+  Fingerprint_Table< Way_Skeleton::Id_Type > way_fingerprints;
+  Fingerprint_Table< Relation_Skeleton::Id_Type > relation_fingerprints;
+
+  std::vector< Node_Skeleton::Id_Type > changed_nodes;
+  std::vector< Way_Skeleton::Id_Type > changed_ways;
+  std::vector< Relation_Skeleton::Id_Type > changed_relations;
+
+  std::vector< Unmatched_Item< Node_With_Context > > unmatched_nodes;
+  std::vector< Unmatched_Item< Way_With_Context > > unmatched_ways;
+  std::vector< Unmatched_Item< Relation_With_Context > > unmatched_relations;
+
   std::vector< Node_With_Context > nodes;
   std::vector< Way_With_Context > ways;
   std::vector< Relation_With_Context > relations;
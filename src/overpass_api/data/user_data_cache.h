@@ -21,6 +21,7 @@
 
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -29,31 +30,42 @@
 #include "../core/datatypes.h"
 #include "../core/settings.h"
 
+
+/* The user names are stored by the index user_id & 0xffffff00.
+ * Thus the cache reads only the indexes of the user ids asked for and keeps them for later requests. */
 struct User_Data_Cache
 {
-  User_Data_Cache() : loaded(false) {}
-  const std::map< uint32, std::string >& users(Transaction& transaction);
+  // Returns the names of the given user ids and of all user ids resolved before
+  template< typename Iterator >
+  const std::map< uint32, std::string >& users(Transaction& transaction, Iterator begin, Iterator end);
 
 private:
   std::map< uint32, std::string > users_;
-  bool loaded;
+  std::set< Uint32_Index > loaded_idxs;
 };
 
 
-inline const std::map< uint32, std::string >& User_Data_Cache::users(
-    Transaction& transaction)
+template< typename Iterator >
+const std::map< uint32, std::string >& User_Data_Cache::users(
+    Transaction& transaction, Iterator begin, Iterator end)
 {
-  if (!loaded)
+  std::set< Uint32_Index > req;
+  for (Iterator it = begin; it != end; ++it)
   {
-    Block_Backend< Uint32_Index, User_Data > user_db
-        (transaction.data_index(meta_settings().USER_DATA));
-    for (Block_Backend< Uint32_Index, User_Data >::Flat_Iterator it = user_db.flat_begin();
-        !(it == user_db.flat_end()); ++it)
-      users_[it.object().id] = it.object().name;
-
-    loaded = true;
+    Uint32_Index idx(*it & 0xffffff00);
+    if (loaded_idxs.find(idx) == loaded_idxs.end())
+      req.insert(idx);
   }
+  if (req.empty())
+    return users_;
+
+  Block_Backend< Uint32_Index, User_Data > user_db
+      (transaction.data_index(meta_settings().USER_DATA));
+  for (Block_Backend< Uint32_Index, User_Data >::Discrete_Iterator it = user_db.discrete_begin(req.begin(), req.end());
+      !(it == user_db.discrete_end()); ++it)
+    users_[it.object().id] = it.object().name;
 
+  loaded_idxs.insert(req.begin(), req.end());
   return users_;
 }
 
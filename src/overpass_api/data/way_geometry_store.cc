@@ -33,8 +33,18 @@ std::set< std::pair< Uint32_Index, Uint32_Index > > small_way_nd_indices
   for (typename std::map< Uint31_Index, std::vector< Object > >::const_iterator
     it(ways_begin); it != ways_end; ++it)
   {
-    if (!(it->first.val() & 0x80000000) || ((it->first.val() & 0x1) != 0)) // Adapt 0x3
-      parents.push_back(it->first.val());
+    if ((it->first.val() & 0x80000000) && ((it->first.val() & 0x1) == 0)) // Adapt 0x3
+      continue;
+    // Ways stored with inline geometry don't need their nodes
+    for (typename std::vector< Object >::const_iterator it2(it->second.begin());
+        it2 != it->second.end(); ++it2)
+    {
+      if (it2->geometry.empty())
+      {
+        parents.push_back(it->first.val());
+        break;
+      }
+    }
   }
   sort(parents.begin(), parents.end());
   parents.erase(unique(parents.begin(), parents.end()), parents.end());
@@ -58,6 +68,8 @@ std::vector< Node::Id_Type > small_way_nd_ids(const std::map< Uint31_Index, std:
     for (typename std::vector< Object >::const_iterator it2(it->second.begin());
         it2 != it->second.end(); ++it2)
     {
+      if (!it2->geometry.empty())
+        continue;
       for (std::vector< Node::Id_Type >::const_iterator it3(it2->nds.begin());
           it3 != it2->nds.end(); ++it3)
         ids.push_back(*it3);
@@ -0,0 +1,229 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "worker_pool.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+  bool write_all(int fd, const std::string& buf)
+  {
+    std::string::size_type pos = 0;
+    while (pos < buf.size())
+    {
+      ssize_t written = write(fd, buf.data() + pos, buf.size() - pos);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        return false;
+      pos += written;
+    }
+    return true;
+  }
+
+
+  // Runs in the forked process. The return value is the exit status.
+  int run_worker(Worker_Task& task, uint num_workers, Resource_Manager& rman, int fd)
+  {
+    rman.become_worker(num_workers);
+
+    std::string result;
+    try
+    {
+      if (!task.run(rman, result))
+        return 1;
+    }
+    catch (...)
+    {
+      return 1;
+    }
+
+    return write_all(fd, result) ? 0 : 1;
+  }
+
+
+  struct Worker
+  {
+    pid_t pid;
+    int fd;
+    uint task_pos;
+  };
+
+
+  bool start_worker(Worker_Task& task, uint num_workers, Resource_Manager& rman, Worker& worker)
+  {
+    int fds[2];
+    if (pipe(fds) != 0)
+      return false;
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      close(fds[0]);
+      close(fds[1]);
+      return false;
+    }
+    if (pid == 0)
+    {
+      close(fds[0]);
+      // _exit() skips the destructors and buffered output inherited from the parent
+      _exit(run_worker(task, num_workers, rman, fds[1]));
+    }
+
+    close(fds[1]);
+    worker.pid = pid;
+    worker.fd = fds[0];
+    return true;
+  }
+
+
+  bool finish_worker(const Worker& worker, bool eof)
+  {
+    close(worker.fd);
+    int status = 0;
+    while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR)
+      ;
+    return eof && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+
+
+  class Statement_Monitor : public Worker_Monitor
+  {
+    public:
+      Statement_Monitor(Resource_Manager& rman_, const Statement& caller_) : rman(rman_), caller(caller_) {}
+
+      virtual void check(uint64 received) { rman.health_check(caller, 0, received); }
+
+    private:
+      Resource_Manager& rman;
+      const Statement& caller;
+  };
+}
+
+
+std::vector< bool > run_in_workers(const std::vector< Worker_Task* >& tasks, uint max_workers,
+    Resource_Manager& rman, const Statement& caller, std::vector< std::string >& results)
+{
+  Statement_Monitor monitor(rman, caller);
+  return run_in_workers(tasks, max_workers, rman, monitor, results);
+}
+
+
+std::vector< bool > run_in_workers(const std::vector< Worker_Task* >& tasks, uint max_workers,
+    Resource_Manager& rman, Worker_Monitor& monitor, std::vector< std::string >& results)
+{
+  std::vector< bool > delivered(tasks.size(), false);
+  results.clear();
+  results.resize(tasks.size());
+  if (rman.is_worker() || max_workers < 2)
+    return delivered;
+
+  uint num_workers = rman.grant_workers(std::min< uint >(max_workers, tasks.size()));
+  if (num_workers < 2)
+  {
+    if (num_workers > 0)
+      rman.grant_workers(0);
+    return delivered;
+  }
+
+  std::vector< Worker > active;
+  uint next = 0;
+  uint64 received = 0;
+
+  try
+  {
+    while (next < tasks.size() || !active.empty())
+    {
+      while (next < tasks.size() && active.size() < num_workers)
+      {
+        active.push_back(Worker());
+        active.back().task_pos = next;
+        if (!start_worker(*tasks[next], num_workers, rman, active.back()))
+          active.pop_back();
+        ++next;
+      }
+      if (active.empty())
+        break;
+
+      std::vector< pollfd > fds(active.size());
+      for (uint i = 0; i < active.size(); ++i)
+      {
+        fds[i].fd = active[i].fd;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+      }
+      if (poll(&fds[0], fds.size(), 1000) < 0 && errno != EINTR)
+      {
+        for (uint i = 0; i < active.size(); ++i)
+          kill(active[i].pid, SIGKILL);
+      }
+
+      for (uint i = active.size(); i-- > 0; )
+      {
+        if (!fds[i].revents)
+          continue;
+
+        char buf[64*1024];
+        ssize_t num_read = read(active[i].fd, buf, sizeof(buf));
+        if (num_read > 0)
+        {
+          results[active[i].task_pos].append(buf, num_read);
+          received += num_read;
+        }
+        else if (num_read == 0 || errno != EINTR)
+        {
+          delivered[active[i].task_pos] = finish_worker(active[i], num_read == 0);
+          if (!delivered[active[i].task_pos])
+            results[active[i].task_pos].clear();
+          active.erase(active.begin() + i);
+        }
+      }
+
+      monitor.check(received);
+    }
+  }
+  catch (...)
+  {
+    for (std::vector< Worker >::iterator it = active.begin(); it != active.end(); ++it)
+    {
+      kill(it->pid, SIGKILL);
+      close(it->fd);
+      waitpid(it->pid, 0, 0);
+    }
+    try
+    {
+      rman.grant_workers(0);
+    }
+    catch (...) {}
+    throw;
+  }
+
+  rman.grant_workers(0);
+  return delivered;
+}
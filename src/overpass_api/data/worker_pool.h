@@ -0,0 +1,164 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__DATA__WORKER_POOL_H
+#define DE__OSM3S___OVERPASS_API__DATA__WORKER_POOL_H
+
+#include "../core/datatypes.h"
+#include "../dispatch/resource_manager.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/* Runs tasks in forked worker processes.
+
+The workers inherit the transaction and its already loaded indexes copy-on-write,
+hence they see the same database state as the calling process.
+Processes are used instead of threads because neither the transaction nor the resource manager
+nor the block caches are thread-safe.
+
+The number of workers is granted by the dispatcher such that the workers count against
+the process limit and the rate limit of the client like further queries.
+Each worker gets an equal share of the space still available to the query,
+so that all workers together stay within the quota registered at the dispatcher.
+The calling process keeps pinging the watchdog and checks the time limit on behalf of caller.
+Tools that run without a statement pass a Worker_Monitor instead.
+*/
+
+class Worker_Task
+{
+  public:
+    virtual ~Worker_Task() {}
+
+    // Runs in the worker process. The result is passed back to the calling process.
+    // Returning false or throwing an exception lets the task fail.
+    virtual bool run(Resource_Manager& rman, std::string& result) = 0;
+};
+
+
+class Worker_Monitor
+{
+  public:
+    virtual ~Worker_Monitor() {}
+
+    // Called in the calling process at least once per second while the workers run.
+    // May throw to abort all workers.
+    virtual void check(uint64 received) = 0;
+};
+
+
+// Returns for every task whether it has completed in a worker and delivered a result into results.
+// The caller has to do the failed tasks itself.
+// Nothing is forked if rman is already a worker, so the number of processes never exceeds max_workers.
+std::vector< bool > run_in_workers(const std::vector< Worker_Task* >& tasks, uint max_workers,
+    Resource_Manager& rman, const Statement& caller, std::vector< std::string >& results);
+
+std::vector< bool > run_in_workers(const std::vector< Worker_Task* >& tasks, uint max_workers,
+    Resource_Manager& rman, Worker_Monitor& monitor, std::vector< std::string >& results);
+
+
+// Serialization of the index maps to pass them between the processes.
+// Each record is preceded by its size such that the reader needs no knowledge about the layout.
+
+inline void append_uint32(uint32 val, std::string& buf)
+{
+  buf.append((const char*)&val, sizeof(uint32));
+}
+
+
+template< typename Object >
+void append_record(const Object& obj, std::vector< uint64 >& scratch, std::string& buf)
+{
+  uint32 size = obj.size_of();
+  scratch.resize(size/8 + 1);
+  obj.to_data(&scratch[0]);
+  append_uint32(size, buf);
+  buf.append((const char*)&scratch[0], size);
+}
+
+
+template< typename Index, typename Object >
+void append_map(const std::map< Index, std::vector< Object > >& items, std::string& buf)
+{
+  std::vector< uint64 > scratch;
+  append_uint32(items.size(), buf);
+  for (typename std::map< Index, std::vector< Object > >::const_iterator it = items.begin(); it != items.end(); ++it)
+  {
+    append_record(it->first, scratch, buf);
+    append_uint32(it->second.size(), buf);
+    for (typename std::vector< Object >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+      append_record(*it2, scratch, buf);
+  }
+}
+
+
+inline bool read_uint32(const std::string& buf, std::string::size_type& pos, uint32& val)
+{
+  if (buf.size() < pos + sizeof(uint32))
+    return false;
+  memcpy(&val, buf.data() + pos, sizeof(uint32));
+  pos += sizeof(uint32);
+  return true;
+}
+
+
+// Copies the record to aligned memory before it is decoded.
+inline bool read_record(const std::string& buf, std::string::size_type& pos, std::vector< uint64 >& scratch)
+{
+  uint32 size = 0;
+  if (!read_uint32(buf, pos, size) || buf.size() < pos + size)
+    return false;
+  scratch.resize(size/8 + 1);
+  memcpy(&scratch[0], buf.data() + pos, size);
+  pos += size;
+  return true;
+}
+
+
+// Appends the objects to those already present in items.
+template< typename Index, typename Object >
+bool read_map(const std::string& buf, std::string::size_type& pos, std::map< Index, std::vector< Object > >& items)
+{
+  std::vector< uint64 > scratch;
+  uint32 num_indexes = 0;
+  if (!read_uint32(buf, pos, num_indexes))
+    return false;
+  for (uint32 i = 0; i < num_indexes; ++i)
+  {
+    uint32 num_objects = 0;
+    if (!read_record(buf, pos, scratch))
+      return false;
+    std::vector< Object >& objects = items[Index((void*)&scratch[0])];
+    if (!read_uint32(buf, pos, num_objects))
+      return false;
+    objects.reserve(objects.size() + num_objects);
+    for (uint32 j = 0; j < num_objects; ++j)
+    {
+      if (!read_record(buf, pos, scratch))
+        return false;
+      objects.push_back(Object((void*)&scratch[0]));
+    }
+  }
+  return true;
+}
+
+
+#endif
@@ -16,144 +16,772 @@
  * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "../../expat/expat_justparse_interface.h"
+#include "../../template_db/block_backend.h"
 #include "../../template_db/dispatcher.h"
+#include "../../template_db/file_blocks.h"
+#include "../../template_db/random_file.h"
+#include "../core/datatypes.h"
+#include "../core/settings.h"
+#include "../data/worker_pool.h"
 #include "../frontend/console_output.h"
-#include "../frontend/user_interface.h"
+#include "../osm-backend/clone_manifest.h"
 #include "../statements/statement.h"
 #include "resource_manager.h"
 #include "scripting_core.h"
 
 #include <errno.h>
 #include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/select.h>
+#include <stdio.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
-#include <fstream>
 #include <iostream>
+#include <list>
+#include <map>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
 
 
-template< class TIndex, class Id_Type >
-struct Flat_Meta_Collector
+/* Checks the blocks of the data files of the database.
+
+Every block is checked against its checksum if the index has checksums.
+Then it is decoded and its segments are checked to be well-formed and in index order.
+Each element is checked against the other files:
+nodes, ways and relations must be found in their map file at their index and must have meta data,
+every node of a way must exist, meta data must belong to an existing element,
+and the local and global tag files must contain the same tags.
+For the last check, each block contributes a digest of its tags.
+The digests of all local and all global blocks of an element type must add up to the same value.
+
+The blocks of each file are split into tasks that run in forked worker processes.
+With a checkpoint file, the digest, the checksum and the content hash of each flawless block are kept.
+If the index has checksums, a block with the same position, size and checksum as in the checkpoint
+is not read at all. Otherwise, a block with the same position and content hash is not decoded again.
+Hence a check with a recent checkpoint only decodes the blocks written since.
+Note that such a block is also not checked against changes in the other files.
+The digests of a group are only taken from the checkpoint if no file of the group has changed.
+Without checksums, a file counts as changed because its index cannot tell.
+*/
+
+
+namespace
 {
-  public:
-    Flat_Meta_Collector(Transaction& transaction, const File_Properties* meta_file_prop = 0);
+  // Number of index entries that one worker checks in a row
+  const uint32 BLOCKS_PER_TASK = 4096;
+
+
+  struct Block_State
+  {
+    Block_State() : pos(0), size(0), checksum(0), digest(0), flawless(false) {}
+
+    uint32 pos;
+    uint32 size;
+    uint32 checksum;
+    Block_Hash hash;
+    uint64 digest;
+    bool flawless;
+  };
 
-    void reset();
-    const OSM_Element_Metadata_Skeleton< Id_Type >* get(const TIndex& index, Id_Type ref);
 
-    ~Flat_Meta_Collector()
+  // Per file name, the flawless blocks by their position
+  typedef std::map< std::string, std::map< uint32, Block_State > > Checkpoint;
+
+
+  void append_uint64(uint64 val, std::string& buf)
+  {
+    buf.append((const char*)&val, sizeof(uint64));
+  }
+
+
+  bool read_uint64(const std::string& buf, std::string::size_type& pos, uint64& val)
+  {
+    if (buf.size() < pos + sizeof(uint64))
+      return false;
+    memcpy(&val, buf.data() + pos, sizeof(uint64));
+    pos += sizeof(uint64);
+    return true;
+  }
+
+
+  void append_block_state(const Block_State& state, std::string& buf)
+  {
+    append_uint32(state.pos, buf);
+    append_uint32(state.size, buf);
+    append_uint32(state.checksum, buf);
+    append_uint64(state.hash.first, buf);
+    append_uint64(state.hash.second, buf);
+    append_uint64(state.digest, buf);
+    append_uint32(state.flawless, buf);
+  }
+
+
+  bool read_block_state(const std::string& buf, std::string::size_type& pos, Block_State& state)
+  {
+    uint32 flawless = 0;
+    if (!read_uint32(buf, pos, state.pos) || !read_uint32(buf, pos, state.size)
+        || !read_uint32(buf, pos, state.checksum) || !read_uint64(buf, pos, state.hash.first) || !read_uint64(buf, pos, state.hash.second)
+        || !read_uint64(buf, pos, state.digest) || !read_uint32(buf, pos, flawless))
+      return false;
+    state.flawless = flawless;
+    return true;
+  }
+
+
+  // The checkpoint file has per file its name and the states of its flawless blocks
+  Checkpoint read_checkpoint(const std::string& file_name)
+  {
+    Checkpoint result;
+    if (!file_exists(file_name))
+      return result;
+
+    Raw_File file(file_name, O_RDONLY, S_666, "consistency_check::read_checkpoint::1");
+    std::string buf(file.size("consistency_check::read_checkpoint::2"), '\0');
+    if (!buf.empty())
+      file.read((uint8*)&buf[0], buf.size(), "consistency_check::read_checkpoint::3");
+
+    std::string::size_type pos = 0;
+    while (pos < buf.size())
     {
-      if (meta_db)
+      uint32 name_size = 0;
+      uint32 count = 0;
+      if (!read_uint32(buf, pos, name_size) || buf.size() < pos + name_size)
+        throw File_Error(EINVAL, file_name, "consistency_check::read_checkpoint::4");
+      std::map< uint32, Block_State >& blocks = result[buf.substr(pos, name_size)];
+      pos += name_size;
+      if (!read_uint32(buf, pos, count))
+        throw File_Error(EINVAL, file_name, "consistency_check::read_checkpoint::5");
+      for (uint32 i = 0; i < count; ++i)
       {
-	delete db_it;
-	delete meta_db;
+        Block_State state;
+        if (!read_block_state(buf, pos, state))
+          throw File_Error(EINVAL, file_name, "consistency_check::read_checkpoint::6");
+        blocks[state.pos] = state;
       }
     }
+    return result;
+  }
+
+
+  void write_checkpoint(const Checkpoint& checkpoint, const std::string& file_name)
+  {
+    std::string buf;
+    for (Checkpoint::const_iterator it = checkpoint.begin(); it != checkpoint.end(); ++it)
+    {
+      append_uint32(it->first.size(), buf);
+      buf.append(it->first);
+      append_uint32(it->second.size(), buf);
+      for (std::map< uint32, Block_State >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+        append_block_state(it2->second, buf);
+    }
+
+    {
+      Raw_File file(file_name + ".new", O_RDWR|O_CREAT|O_TRUNC, S_666, "consistency_check::write_checkpoint::1");
+      if (!buf.empty())
+        file.write((uint8*)buf.data(), buf.size(), "consistency_check::write_checkpoint::2");
+    }
+    if (rename((file_name + ".new").c_str(), file_name.c_str()))
+      throw File_Error(errno, file_name, "consistency_check::write_checkpoint::3");
+  }
+
+
+  std::string data_file_name(const File_Properties& file_prop)
+  {
+    return file_prop.get_file_name_trunk() + file_prop.get_data_suffix();
+  }
+
+
+  bool data_file_present(Transaction& transaction, const File_Properties& file_prop)
+  {
+    return file_exists(transaction.get_db_dir() + data_file_name(file_prop));
+  }
+
+
+  // Order independent digest of a tag of an element
+  uint64 tag_digest(uint32 idx, const std::string& key, const std::string& value, uint64 id)
+  {
+    std::string buf;
+    append_uint32(idx & 0x7fffff00, buf);
+    append_uint64(id, buf);
+    append_uint32(key.size(), buf);
+    buf.append(key);
+    buf.append(value);
+    return block_hash((const uint8*)buf.data(), buf.size()).first;
+  }
+
+
+  std::string hex(uint32 val)
+  {
+    std::ostringstream out;
+    out<<std::hex<<val;
+    return out.str();
+  }
+
+
+  // Collects the elements of a block and checks at the end of the block that they have meta data
+  template< typename Id_Type >
+  class Meta_Presence
+  {
+  public:
+    Meta_Presence(Transaction& transaction, const File_Properties& meta_file_prop)
+        : meta_db(data_file_present(transaction, meta_file_prop)
+            ? new Block_Backend< Uint31_Index, OSM_Element_Metadata_Skeleton< Id_Type > >
+                (transaction.data_index(&meta_file_prop)) : 0) {}
+    ~Meta_Presence() { delete meta_db; }
+
+    void expect(Uint31_Index idx, Id_Type id)
+    {
+      if (meta_db)
+        expected[idx].insert(id);
+    }
+
+    void check(const std::string& type, std::ostream& errors);
 
   private:
-    Block_Backend< TIndex, OSM_Element_Metadata_Skeleton< Id_Type > >* meta_db;
-    typename Block_Backend< TIndex, OSM_Element_Metadata_Skeleton< Id_Type > >::Flat_Iterator*
-      db_it;
-    TIndex* current_index;
-    std::map< OSM_Element_Metadata_Skeleton< Id_Type >, bool > current_objects;
-};
-
-/** Implementation --------------------------------------------------------- */
-
-template< class TIndex, class Id_Type >
-Flat_Meta_Collector< TIndex, Id_Type >::Flat_Meta_Collector
-    (Transaction& transaction, const File_Properties* meta_file_prop)
-  : meta_db(0), db_it(0), current_index(0)
-{
-  meta_db = new Block_Backend< TIndex, OSM_Element_Metadata_Skeleton< Id_Type > >
-      (transaction.data_index(meta_file_prop));
+    Block_Backend< Uint31_Index, OSM_Element_Metadata_Skeleton< Id_Type > >* meta_db;
+    std::map< Uint31_Index, std::set< Id_Type > > expected;
+  };
 
-  reset();
-}
 
-template< class TIndex, class Id_Type >
-void Flat_Meta_Collector< TIndex, Id_Type >::reset()
-{
-  if (!meta_db)
-    return;
+  template< typename Id_Type >
+  void Meta_Presence< Id_Type >::check(const std::string& type, std::ostream& errors)
+  {
+    if (expected.empty())
+      return;
+
+    std::set< Uint31_Index > req;
+    for (typename std::map< Uint31_Index, std::set< Id_Type > >::const_iterator it = expected.begin();
+        it != expected.end(); ++it)
+      req.insert(it->first);
+
+    for (typename Block_Backend< Uint31_Index, OSM_Element_Metadata_Skeleton< Id_Type > >::Discrete_Iterator
+        it(meta_db->discrete_begin(req.begin(), req.end())); !(it == meta_db->discrete_end()); ++it)
+    {
+      typename std::map< Uint31_Index, std::set< Id_Type > >::iterator it_idx = expected.find(it.index());
+      if (it_idx != expected.end())
+        it_idx->second.erase(it.object().ref);
+    }
 
-  if (db_it)
-    delete db_it;
-  if (current_index)
+    for (typename std::map< Uint31_Index, std::set< Id_Type > >::const_iterator it = expected.begin();
+        it != expected.end(); ++it)
+    {
+      for (typename std::set< Id_Type >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+        errors<<"Missing meta data of "<<type<<' '<<it2->val()<<" at "<<hex(it->first.val())<<'\n';
+    }
+    expected.clear();
+  }
+
+
+  // Collects the lookups in a map file and does them in ascending order when the block is complete,
+  // such that each part of the map file is read at most once per block
+  template< typename Id_Type, typename Map_Index >
+  class Map_Lookup
   {
-    delete current_index;
-    current_index = 0;
+  public:
+    Map_Lookup(Transaction& transaction, const File_Properties& file_prop)
+        : map(transaction.random_index(&file_prop)) {}
+
+    // The element id must be stored at idx
+    void expect_at(Id_Type id, uint32 idx) { located.push_back(std::make_pair(id, idx)); }
+    // The element id must exist because the element referrer at referrer_idx refers to it
+    void expect_referred(Id_Type id, uint64 referrer, uint32 referrer_idx)
+    { referred.push_back(std::make_pair(id, std::make_pair(referrer, referrer_idx))); }
+
+    void check(const std::string& located_type, const std::string& referrer_type, std::ostream& errors);
+
+  private:
+    Random_File< Id_Type, Map_Index > map;
+    std::vector< std::pair< Id_Type, uint32 > > located;
+    std::vector< std::pair< Id_Type, std::pair< uint64, uint32 > > > referred;
+  };
+
+
+  template< typename Id_Type, typename Map_Index >
+  void Map_Lookup< Id_Type, Map_Index >::check(
+      const std::string& located_type, const std::string& referrer_type, std::ostream& errors)
+  {
+    std::sort(located.begin(), located.end());
+    for (typename std::vector< std::pair< Id_Type, uint32 > >::const_iterator it = located.begin();
+        it != located.end(); ++it)
+    {
+      uint32 map_idx = map.get(it->first).val();
+      if (map_idx != it->second)
+        errors<<located_type<<' '<<it->first.val()<<" at "<<hex(it->second)
+            <<" has index "<<hex(map_idx)<<" in the map\n";
+    }
+    located.clear();
+
+    std::sort(referred.begin(), referred.end());
+    for (typename std::vector< std::pair< Id_Type, std::pair< uint64, uint32 > > >::const_iterator
+        it = referred.begin(); it != referred.end(); ++it)
+    {
+      if (map.get(it->first).val() == 0)
+        errors<<referrer_type<<' '<<it->second.first<<" at "<<hex(it->second.second)
+            <<" refers to missing "<<located_type<<' '<<it->first.val()<<'\n';
+    }
+    referred.clear();
   }
 
-  db_it = new typename Block_Backend< TIndex, OSM_Element_Metadata_Skeleton< Id_Type > >
-      ::Flat_Iterator(meta_db->flat_begin());
 
-  if (!(*db_it == meta_db->flat_end()))
-    current_index = new TIndex(db_it->index());
-  while (!(*db_it == meta_db->flat_end()) && (*current_index == db_it->index()))
+  /* A visitor gets each object of a block and may report errors when the block is complete.
+     Its digest is taken and reset after each block. */
+
+  struct Node_Visitor
   {
-    current_objects.insert(std::make_pair(db_it->object(), false));
-    ++(*db_it);
+    Node_Visitor(Transaction& transaction)
+        : digest(0), nodes_map(transaction, *osm_base_settings().NODES),
+          meta(transaction, *meta_settings().NODES_META) {}
+
+    void visit(const Uint32_Index& idx, const Node_Skeleton& node, std::ostream& errors)
+    {
+      nodes_map.expect_at(node.id, idx.val());
+      meta.expect(Uint31_Index(idx.val()), node.id);
+    }
+
+    void finish_block(std::ostream& errors)
+    {
+      nodes_map.check("Node", "", errors);
+      meta.check("node", errors);
+    }
+
+    uint64 digest;
+    Map_Lookup< Node_Skeleton::Id_Type, Uint32_Index > nodes_map;
+    Meta_Presence< Node_Skeleton::Id_Type > meta;
+  };
+
+
+  struct Way_Visitor
+  {
+    Way_Visitor(Transaction& transaction)
+        : digest(0), ways_map(transaction, *osm_base_settings().WAYS),
+          nodes_map(transaction, *osm_base_settings().NODES),
+          meta(transaction, *meta_settings().WAYS_META) {}
+
+    void visit(const Uint31_Index& idx, const Way_Skeleton& way, std::ostream& errors)
+    {
+      ways_map.expect_at(way.id, idx.val());
+      for (std::vector< Node::Id_Type >::const_iterator it = way.nds.begin(); it != way.nds.end(); ++it)
+        nodes_map.expect_referred(*it, way.id.val(), idx.val());
+      meta.expect(idx, way.id);
+    }
+
+    void finish_block(std::ostream& errors)
+    {
+      ways_map.check("Way", "", errors);
+      nodes_map.check("node", "Way", errors);
+      meta.check("way", errors);
+    }
+
+    uint64 digest;
+    Map_Lookup< Way_Skeleton::Id_Type, Uint31_Index > ways_map;
+    Map_Lookup< Node_Skeleton::Id_Type, Uint32_Index > nodes_map;
+    Meta_Presence< Way_Skeleton::Id_Type > meta;
+  };
+
+
+  struct Relation_Visitor
+  {
+    Relation_Visitor(Transaction& transaction)
+        : digest(0), relations_map(transaction, *osm_base_settings().RELATIONS),
+          meta(transaction, *meta_settings().RELATIONS_META) {}
+
+    void visit(const Uint31_Index& idx, const Relation_Skeleton& relation, std::ostream& errors)
+    {
+      relations_map.expect_at(relation.id, idx.val());
+      meta.expect(idx, relation.id);
+    }
+
+    void finish_block(std::ostream& errors)
+    {
+      relations_map.check("Relation", "", errors);
+      meta.check("relation", errors);
+    }
+
+    uint64 digest;
+    Map_Lookup< Relation_Skeleton::Id_Type, Uint31_Index > relations_map;
+    Meta_Presence< Relation_Skeleton::Id_Type > meta;
+  };
+
+
+  // Meta data must belong to an element that exists at the same index
+  template< typename Id_Type, typename Map_Index >
+  struct Meta_Visitor
+  {
+    Meta_Visitor(Transaction& transaction, const File_Properties& map_file_prop, const std::string& type_)
+        : digest(0), map(transaction, map_file_prop), type(type_) {}
+
+    void visit(const Uint31_Index& idx, const OSM_Element_Metadata_Skeleton< Id_Type >& meta, std::ostream& errors)
+    {
+      map.expect_at(meta.ref, idx.val());
+    }
+
+    void finish_block(std::ostream& errors) { map.check("Meta data of " + type, "", errors); }
+
+    uint64 digest;
+    Map_Lookup< Id_Type, Map_Index > map;
+    std::string type;
+  };
+
+
+  struct Node_Meta_Visitor : Meta_Visitor< Node_Skeleton::Id_Type, Uint32_Index >
+  {
+    Node_Meta_Visitor(Transaction& transaction)
+        : Meta_Visitor< Node_Skeleton::Id_Type, Uint32_Index >(transaction, *osm_base_settings().NODES, "node") {}
+  };
+
+
+  struct Way_Meta_Visitor : Meta_Visitor< Way_Skeleton::Id_Type, Uint31_Index >
+  {
+    Way_Meta_Visitor(Transaction& transaction)
+        : Meta_Visitor< Way_Skeleton::Id_Type, Uint31_Index >(transaction, *osm_base_settings().WAYS, "way") {}
+  };
+
+
+  struct Relation_Meta_Visitor : Meta_Visitor< Relation_Skeleton::Id_Type, Uint31_Index >
+  {
+    Relation_Meta_Visitor(Transaction& transaction)
+        : Meta_Visitor< Relation_Skeleton::Id_Type, Uint31_Index >
+          (transaction, *osm_base_settings().RELATIONS, "relation") {}
+  };
+
+
+  // The local tags count positive and the global tags negative, hence all blocks together sum up to zero
+  template< typename Id_Type >
+  struct Local_Tag_Visitor
+  {
+    Local_Tag_Visitor(Transaction& transaction) : digest(0) {}
+
+    void visit(const Tag_Index_Local& idx, const Id_Type& id, std::ostream& errors)
+    {
+      digest += tag_digest(idx.index, idx.key, idx.value, id.val());
+    }
+
+    void finish_block(std::ostream& errors) {}
+
+    uint64 digest;
+  };
+
+
+  template< typename Id_Type >
+  struct Global_Tag_Visitor
+  {
+    Global_Tag_Visitor(Transaction& transaction) : digest(0) {}
+
+    void visit(const Tag_Index_Global& idx, const Tag_Object_Global< Id_Type >& obj, std::ostream& errors)
+    {
+      digest -= tag_digest(obj.idx.val(), idx.key, idx.value, obj.id.val());
+    }
+
+    void finish_block(std::ostream& errors) {}
+
+    uint64 digest;
+  };
+
+
+  /* Checks a range of the index entries of a file.
+     The result has the number of block states, the block states and then the error messages. */
+  template< typename TIndex, typename TObject, typename Visitor >
+  class Block_Check_Task : public Worker_Task
+  {
+  public:
+    Block_Check_Task(const File_Properties& file_prop_, uint32 first_, uint32 count_,
+        const std::map< uint32, Block_State >& checkpoint_)
+        : file_prop(file_prop_), first(first_), count(count_), checkpoint(checkpoint_) {}
+
+    virtual bool run(Resource_Manager& rman, std::string& result);
+
+  private:
+    const File_Properties& file_prop;
+    uint32 first;
+    uint32 count;
+    const std::map< uint32, Block_State >& checkpoint;
+
+    void check_segments(const File_Blocks_Flat_Iterator< TIndex >& file_it, const uint8* buffer,
+        uint32 buffer_size, Visitor& visitor, std::ostream& errors);
+  };
+
+
+  template< typename TIndex, typename TObject, typename Visitor >
+  bool Block_Check_Task< TIndex, TObject, Visitor >::run(Resource_Manager& rman, std::string& result)
+  {
+    Transaction& transaction = *rman.get_transaction();
+    File_Blocks_Index< TIndex >* index = (File_Blocks_Index< TIndex >*)transaction.data_index(&file_prop);
+    File_Blocks< TIndex, typename std::set< TIndex >::const_iterator, Default_Range_Iterator< TIndex > >
+        blocks(index);
+    Raw_File data_file(index->get_data_file_name(), O_RDONLY, S_666, "Block_Check_Task::run::1");
+    Visitor visitor(transaction);
+
+    typedef typename std::list< File_Block_Index_Entry< TIndex > >::iterator Entry_Iterator;
+    Entry_Iterator it = index->get_blocks().begin();
+    for (uint32 i = 0; i < first && it != index->get_blocks().end(); ++i)
+      ++it;
+    Entry_Iterator end = it;
+    uint32 max_size = 1;
+    for (uint32 i = 0; i < count && end != index->get_blocks().end(); ++i)
+    {
+      max_size = std::max(max_size, end->size);
+      ++end;
+    }
+
+    uint32 block_size = index->get_block_size();
+    uint32 buffer_size = std::max(block_size * index->get_compression_factor(), block_size * max_size);
+    Void_Pointer< uint8 > raw(block_size * max_size);
+    Void_Pointer< uint8 > buffer(buffer_size);
+
+    std::vector< Block_State > states;
+    std::ostringstream errors;
+    for (; it != end; ++it)
+    {
+      Block_State state;
+      state.pos = it->pos;
+      state.size = it->size;
+      state.checksum = (index->has_checksums() ? it->checksum : 0);
+
+      std::map< uint32, Block_State >::const_iterator it_prev = checkpoint.find(it->pos);
+      bool known = (it_prev != checkpoint.end() && it_prev->second.size == it->size);
+      if (known && index->has_checksums() && it_prev->second.checksum == it->checksum)
+      {
+        states.push_back(it_prev->second);
+        continue;
+      }
+
+      std::ostringstream block_errors;
+      try
+      {
+        data_file.read_at(raw.ptr, (uint64)block_size * it->size, (uint64)it->pos * block_size,
+            "Block_Check_Task::run::2");
+        state.hash = block_hash(raw.ptr, (uint64)block_size * it->size);
+
+        if (index->has_checksums() && crc32c(raw.ptr, (uint64)block_size * it->size) != it->checksum)
+          block_errors<<"Checksum mismatch\n";
+        else
+        {
+          if (known && it_prev->second.hash == state.hash)
+          {
+            state = it_prev->second;
+            states.push_back(state);
+            continue;
+          }
+
+          File_Blocks_Flat_Iterator< TIndex > file_it(it, index->get_blocks().end());
+          blocks.read_block(file_it, buffer.ptr);
+          check_segments(file_it, buffer.ptr, buffer_size, visitor, block_errors);
+          visitor.finish_block(block_errors);
+        }
+      }
+      catch (const File_Error& e)
+      {
+        block_errors<<"File error "<<e.error_number<<' '<<strerror(e.error_number)<<' '<<e.origin<<'\n';
+      }
+      catch (const Zlib_Inflate::Error& e)
+      {
+        block_errors<<"Decompression failed with zlib error "<<e.error_code<<'\n';
+      }
+      catch (const LZ4_Inflate::Error& e)
+      {
+        block_errors<<"Decompression failed with lz4 error "<<e.error_code<<'\n';
+      }
+
+      state.digest = visitor.digest;
+      visitor.digest = 0;
+      state.flawless = block_errors.str().empty();
+      std::istringstream block_errors_in(block_errors.str());
+      std::string line;
+      while (std::getline(block_errors_in, line))
+        errors<<data_file_name(file_prop)<<", block at "<<it->pos<<": "<<line<<'\n';
+      states.push_back(state);
+    }
+
+    append_uint32(states.size(), result);
+    for (std::vector< Block_State >::const_iterator it = states.begin(); it != states.end(); ++it)
+      append_block_state(*it, result);
+    result.append(errors.str());
+    return true;
   }
-}
 
-template< class TIndex, class Id_Type >
-const OSM_Element_Metadata_Skeleton< Id_Type >* Flat_Meta_Collector< TIndex, Id_Type >::get
-    (const TIndex& index, Id_Type ref)
-{
-  if (!meta_db)
-    return 0;
 
-  if ((current_index) && (*current_index < index))
+  // The block consists of its used size and then segments of the end position, the index and the objects
+  template< typename TIndex, typename TObject, typename Visitor >
+  void Block_Check_Task< TIndex, TObject, Visitor >::check_segments(
+      const File_Blocks_Flat_Iterator< TIndex >& file_it, const uint8* buffer,
+      uint32 buffer_size, Visitor& visitor, std::ostream& errors)
+  {
+    File_Blocks_Flat_Iterator< TIndex > range_it(file_it);
+    uint32 used_size = *(const uint32*)buffer;
+    if (used_size > buffer_size)
+    {
+      errors<<"Used size "<<used_size<<" exceeds the block size\n";
+      return;
+    }
+
+    std::vector< TIndex > last_index;
+    uint32 pos = sizeof(uint32);
+    while (pos < used_size)
+    {
+      uint32 segment_end = *(const uint32*)(buffer + pos);
+      if (segment_end <= pos + sizeof(uint32) || segment_end > used_size)
+      {
+        errors<<"Segment at "<<pos<<" ends at "<<segment_end<<'\n';
+        return;
+      }
+
+      void* index_ptr = (void*)(buffer + pos + sizeof(uint32));
+      uint32 obj_pos = pos + sizeof(uint32) + TIndex::size_of(index_ptr);
+      if (obj_pos > segment_end)
+      {
+        errors<<"Index at "<<pos<<" exceeds its segment\n";
+        return;
+      }
+      TIndex index(index_ptr);
+      if (range_it.is_out_of_range(index))
+        errors<<"Segment at "<<pos<<" has an index out of the range of the block\n";
+      if (!last_index.empty() && !(last_index.back() < index))
+        errors<<"Segment at "<<pos<<" is not in index order\n";
+      last_index.assign(1, index);
+
+      while (obj_pos < segment_end)
+      {
+        uint32 obj_size = TObject::size_of((void*)(buffer + obj_pos));
+        if (obj_size == 0 || obj_pos + obj_size > segment_end)
+        {
+          errors<<"Object at "<<obj_pos<<" exceeds its segment\n";
+          return;
+        }
+        visitor.visit(index, TObject((void*)(buffer + obj_pos)), errors);
+        obj_pos += obj_size;
+      }
+      pos = segment_end;
+    }
+  }
+
+
+  struct Task_Info
+  {
+    Task_Info(const std::string& file_name_, const std::string& digest_group_)
+        : file_name(file_name_), digest_group(digest_group_) {}
+
+    std::string file_name;
+    std::string digest_group;
+  };
+
+
+  class Check_Plan
   {
-    for (typename std::map< OSM_Element_Metadata_Skeleton< Id_Type >, bool >::const_iterator
-        it = current_objects.begin(); it != current_objects.end(); ++it)
+  public:
+    Check_Plan(Transaction& transaction_, Checkpoint& checkpoint_)
+        : transaction(transaction_), checkpoint(checkpoint_) {}
+    ~Check_Plan()
     {
-      if (!it->second)
-        std::cout<<"Skipping meta data of "<<std::dec<<it->first.ref.val()
-            <<" at "<<std::hex<<current_index->val()<<'\n';
+      for (std::vector< Worker_Task* >::iterator it = tasks.begin(); it != tasks.end(); ++it)
+        delete *it;
     }
-    current_objects.clear();
 
-    while (!(*db_it == meta_db->flat_end()) && (db_it->index() < index))
+    template< typename TIndex, typename TObject, typename Visitor >
+    void add(const File_Properties& file_prop, const std::string& digest_group = "");
+
+    // Drops the checkpoint of all files of a digest group if one of them has changed.
+    // Must be called after all files have been added.
+    void invalidate_changed_groups();
+
+    std::vector< Worker_Task* > tasks;
+    std::vector< Task_Info > infos;
+
+  private:
+    Transaction& transaction;
+    Checkpoint& checkpoint;
+    std::set< std::string > changed_groups;
+  };
+
+
+  template< typename TIndex, typename TObject, typename Visitor >
+  void Check_Plan::add(const File_Properties& file_prop, const std::string& digest_group)
+  {
+    if (!data_file_present(transaction, file_prop))
+      return;
+
+    // Load the index before the workers are forked, such that they share it
+    File_Blocks_Index< TIndex >* index = (File_Blocks_Index< TIndex >*)transaction.data_index(&file_prop);
+    uint32 num_blocks = index->get_blocks().size();
+
+    std::string file_name = data_file_name(file_prop);
+    const std::map< uint32, Block_State >& file_checkpoint = checkpoint[file_name];
+
+    if (!digest_group.empty())
     {
-      std::cout<<"Skipping meta data of "<<std::dec<<db_it->object().ref.val()
-          <<" at "<<std::hex<<db_it->index().val()<<'\n';
-      ++(*db_it);
+      bool changed = (!index->has_checksums() || file_checkpoint.size() != num_blocks);
+      for (typename std::list< File_Block_Index_Entry< TIndex > >::const_iterator
+          it = index->get_blocks().begin(); !changed && it != index->get_blocks().end(); ++it)
+      {
+        std::map< uint32, Block_State >::const_iterator it_prev = file_checkpoint.find(it->pos);
+        changed = (it_prev == file_checkpoint.end() || it_prev->second.size != it->size
+            || it_prev->second.checksum != it->checksum);
+      }
+      if (changed)
+        changed_groups.insert(digest_group);
     }
-    if (!(*db_it == meta_db->flat_end()))
-      *current_index = db_it->index();
-    while (!(*db_it == meta_db->flat_end()) && (*current_index == db_it->index()))
+
+    for (uint32 first = 0; first < num_blocks; first += BLOCKS_PER_TASK)
     {
-      current_objects.insert(std::make_pair(db_it->object(), false));
-      ++(*db_it);
+      tasks.push_back(new Block_Check_Task< TIndex, TObject, Visitor >
+          (file_prop, first, BLOCKS_PER_TASK, file_checkpoint));
+      infos.push_back(Task_Info(file_name, digest_group));
     }
   }
 
-  typename std::map< OSM_Element_Metadata_Skeleton< Id_Type >, bool >::iterator it
-      = current_objects.find(OSM_Element_Metadata_Skeleton< Id_Type >(ref));
-  it->second = true;
-  if (it != current_objects.end())
-    return &it->first;
-  else
-    return 0;
+
+  void Check_Plan::invalidate_changed_groups()
+  {
+    for (std::vector< Task_Info >::const_iterator it = infos.begin(); it != infos.end(); ++it)
+    {
+      if (changed_groups.find(it->digest_group) != changed_groups.end())
+        checkpoint[it->file_name].clear();
+    }
+  }
+
+
+  // Keeps the read transaction alive while the workers run
+  class Check_Monitor : public Worker_Monitor
+  {
+  public:
+    Check_Monitor(Dispatcher_Stub& dispatcher_) : dispatcher(dispatcher_), last_ping(time(0)) {}
+
+    virtual void check(uint64 received)
+    {
+      if (time(0) - last_ping < 60)
+        return;
+      dispatcher.ping();
+      last_ping = time(0);
+    }
+
+  private:
+    Dispatcher_Stub& dispatcher;
+    time_t last_ping;
+  };
+
+
+  struct File_Stats
+  {
+    File_Stats() : blocks(0), decoded(0), flawed(0) {}
+
+    uint64 blocks;
+    uint64 decoded;
+    uint64 flawed;
+  };
 }
 
-//-----------------------------------------------------------------------------
 
 int main(int argc, char *argv[])
 {
   // read command line arguments
   std::string db_dir;
+  std::string checkpoint_file;
+  uint num_workers = 1;
   uint log_level = Error_Output::ASSISTING;
 
   int area_level = 0;
@@ -167,6 +795,10 @@ int main(int argc, char *argv[])
       if ((db_dir.size() > 0) && (db_dir[db_dir.size()-1] != '/'))
 	db_dir += '/';
     }
+    else if (!(strncmp(argv[argpos], "--workers=", 10)))
+      num_workers = std::max(1, atoi(argv[argpos] + 10));
+    else if (!(strncmp(argv[argpos], "--checkpoint=", 13)))
+      checkpoint_file = ((std::string)argv[argpos]).substr(13);
     else if (!(strcmp(argv[argpos], "--quiet")))
       log_level = Error_Output::QUIET;
     else if (!(strcmp(argv[argpos], "--concise")))
@@ -175,6 +807,16 @@ int main(int argc, char *argv[])
       log_level = Error_Output::PROGRESS;
     else if (!(strcmp(argv[argpos], "--verbose")))
       log_level = Error_Output::VERBOSE;
+    else
+    {
+      std::cerr<<"Usage: "<<argv[0]<<" [--db-dir=DIR] [--workers=N] [--checkpoint=FILE]"
+          " [--quiet|--concise|--progress|--verbose]\n"
+          "  Checks the blocks of the data files and the references between the files.\n"
+          "  --workers=N runs the checks in N processes.\n"
+          "  --checkpoint=FILE skips the blocks that have been found flawless in the run\n"
+          "    that wrote FILE and have not changed since, then updates FILE.\n";
+      return 1;
+    }
     ++argpos;
   }
 
@@ -189,79 +831,97 @@ int main(int argc, char *argv[])
     Dispatcher_Stub dispatcher(db_dir, error_output, "-- consistency check --\n", keep_meta, area_level,
 			       24*60*60, 1024*1024*1024, global_settings);
     Resource_Manager& rman = dispatcher.resource_manager();
-
-    // perform check
+    Transaction& transaction = *rman.get_transaction();
+
+    Checkpoint checkpoint;
+    if (!checkpoint_file.empty())
+      checkpoint = read_checkpoint(checkpoint_file);
+
+    Check_Plan plan(transaction, checkpoint);
+    plan.add< Uint32_Index, Node_Skeleton, Node_Visitor >(*osm_base_settings().NODES);
+    plan.add< Tag_Index_Local, Node_Skeleton::Id_Type, Local_Tag_Visitor< Node_Skeleton::Id_Type > >
+        (*osm_base_settings().NODE_TAGS_LOCAL, "node tags");
+    plan.add< Tag_Index_Global, Tag_Object_Global< Node_Skeleton::Id_Type >,
+        Global_Tag_Visitor< Node_Skeleton::Id_Type > >(*osm_base_settings().NODE_TAGS_GLOBAL, "node tags");
+    plan.add< Uint31_Index, Way_Skeleton, Way_Visitor >(*osm_base_settings().WAYS);
+    plan.add< Tag_Index_Local, Way_Skeleton::Id_Type, Local_Tag_Visitor< Way_Skeleton::Id_Type > >
+        (*osm_base_settings().WAY_TAGS_LOCAL, "way tags");
+    plan.add< Tag_Index_Global, Tag_Object_Global< Way_Skeleton::Id_Type >,
+        Global_Tag_Visitor< Way_Skeleton::Id_Type > >(*osm_base_settings().WAY_TAGS_GLOBAL, "way tags");
+    plan.add< Uint31_Index, Relation_Skeleton, Relation_Visitor >(*osm_base_settings().RELATIONS);
+    plan.add< Tag_Index_Local, Relation_Skeleton::Id_Type, Local_Tag_Visitor< Relation_Skeleton::Id_Type > >
+        (*osm_base_settings().RELATION_TAGS_LOCAL, "relation tags");
+    plan.add< Tag_Index_Global, Tag_Object_Global< Relation_Skeleton::Id_Type >,
+        Global_Tag_Visitor< Relation_Skeleton::Id_Type > >(*osm_base_settings().RELATION_TAGS_GLOBAL, "relation tags");
+    plan.add< Uint31_Index, OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type >, Node_Meta_Visitor >
+        (*meta_settings().NODES_META);
+    plan.add< Uint31_Index, OSM_Element_Metadata_Skeleton< Way_Skeleton::Id_Type >, Way_Meta_Visitor >
+        (*meta_settings().WAYS_META);
+    plan.add< Uint31_Index, OSM_Element_Metadata_Skeleton< Relation_Skeleton::Id_Type >, Relation_Meta_Visitor >
+        (*meta_settings().RELATIONS_META);
+    plan.invalidate_changed_groups();
+
+    Check_Monitor monitor(dispatcher);
+    std::vector< std::string > results;
+    std::vector< bool > delivered = run_in_workers(plan.tasks, num_workers, rman, monitor, results);
+
+    Checkpoint new_checkpoint;
+    std::map< std::string, uint64 > digests;
+    std::map< std::string, File_Stats > stats;
+    uint64 num_errors = 0;
+    for (uint i = 0; i < plan.tasks.size(); ++i)
     {
-      uint32 count = 0;
-      Flat_Meta_Collector< Uint32_Index, Node::Id_Type > meta_collector
-          (*rman.get_transaction(), meta_settings().NODES_META);
-      Block_Backend< Uint32_Index, Node_Skeleton > db
-          (rman.get_transaction()->data_index(osm_base_settings().NODES));
-      for (Block_Backend< Uint32_Index, Node_Skeleton >::Flat_Iterator
-          it(db.flat_begin()); !(it == db.flat_end()); ++it)
+      if (!delivered[i])
       {
-        if (++count >= 1000*1000)
-        {
-	  dispatcher.ping();
-          count = 0;
-          std::cout<<"Processed 1000000 nodes.\n";
-        }
-        if (!meta_collector.get(it.index(), it.object().id))
-	  std::cout<<"Missing meta data of "<<std::dec<<it.object().id.val()
-	      <<" at "<<std::hex<<it.index().val()<<'\n';
+        monitor.check(0);
+        results[i].clear();
+        plan.tasks[i]->run(rman, results[i]);
       }
-    }
 
-    {
-      uint32 count = 0;
-      File_Properties* props = meta_settings().WAYS_META;
-      File_Blocks_Index_Base* index_base = rman.get_transaction()->data_index(props);
-      std::cout<<"ways_meta address "<<index_base<<'\n';
-      File_Blocks_Index< Uint31_Index >* index = (File_Blocks_Index< Uint31_Index >*)index_base;
-      std::cout<<"ways_meta";
-      for (int i = 0; i < (int)index->get_void_blocks().size(); ++i)
-	std::cout<<' '<<index->get_void_blocks()[i].first<<' '<<index->get_void_blocks()[i].second;
-      std::cout<<'\n';
-      Flat_Meta_Collector< Uint31_Index, Way::Id_Type > meta_collector
-          (*rman.get_transaction(), props);
-      Block_Backend< Uint31_Index, Way_Skeleton > db
-          (rman.get_transaction()->data_index(osm_base_settings().WAYS));
-      for (Block_Backend< Uint31_Index, Way_Skeleton >::Flat_Iterator
-          it(db.flat_begin()); !(it == db.flat_end()); ++it)
+      const Task_Info& info = plan.infos[i];
+      File_Stats& file_stats = stats[info.file_name];
+      std::map< uint32, Block_State >& file_checkpoint = new_checkpoint[info.file_name];
+      const std::map< uint32, Block_State >& old_checkpoint = checkpoint[info.file_name];
+      std::string::size_type pos = 0;
+      uint32 num_states = 0;
+      if (!read_uint32(results[i], pos, num_states))
+        throw File_Error(EINVAL, info.file_name, "consistency_check::1");
+      for (uint32 j = 0; j < num_states; ++j)
       {
-        if (++count >= 100*1000)
-        {
-	  dispatcher.ping();
-	  count = 0;
-          std::cout<<"Processed 100000 ways.\n";
-        }
-        if (!meta_collector.get(it.index(), it.object().id))
-	  std::cout<<"Missing meta data of "<<std::dec<<it.object().id.val()
-	      <<" at "<<std::hex<<it.index().val()<<'\n';
+        Block_State state;
+        if (!read_block_state(results[i], pos, state))
+          throw File_Error(EINVAL, info.file_name, "consistency_check::2");
+        ++file_stats.blocks;
+        std::map< uint32, Block_State >::const_iterator it = old_checkpoint.find(state.pos);
+        if (it == old_checkpoint.end() || it->second.size != state.size || it->second.hash != state.hash)
+          ++file_stats.decoded;
+        if (state.flawless)
+          file_checkpoint[state.pos] = state;
+        else
+          ++file_stats.flawed;
+        digests[info.digest_group] += state.digest;
       }
+      std::cout<<results[i].substr(pos);
+      num_errors += file_stats.flawed;
     }
 
+    for (std::map< std::string, File_Stats >::const_iterator it = stats.begin(); it != stats.end(); ++it)
+      std::cout<<it->first<<": "<<it->second.blocks<<" blocks, "<<it->second.decoded<<" decoded, "
+          <<it->second.flawed<<" flawed\n";
+    for (std::map< std::string, uint64 >::const_iterator it = digests.begin(); it != digests.end(); ++it)
     {
-      uint32 count = 0;
-      Flat_Meta_Collector< Uint31_Index, Relation::Id_Type > meta_collector
-          (*rman.get_transaction(), meta_settings().RELATIONS_META);
-      Block_Backend< Uint31_Index, Relation_Skeleton > db
-          (rman.get_transaction()->data_index(osm_base_settings().RELATIONS));
-      for (Block_Backend< Uint31_Index, Relation_Skeleton >::Flat_Iterator
-          it(db.flat_begin()); !(it == db.flat_end()); ++it)
+      if (!it->first.empty() && it->second != 0)
       {
-        if (++count >= 100*1000)
-        {
-	  dispatcher.ping();
-	  count = 0;
-          std::cout<<"Processed 100000 relations.\n";
-        }
-        if (!meta_collector.get(it.index(), it.object().id))
-	  std::cout<<"Missing meta data of "<<std::dec<<it.object().id.val()
-	      <<" at "<<std::hex<<it.index().val()<<'\n';
+        std::cout<<"The local and global "<<it->first<<" differ\n";
+        ++num_errors;
       }
     }
 
+    if (!checkpoint_file.empty())
+      write_checkpoint(new_checkpoint, checkpoint_file);
+
+    if (num_errors > 0)
+      std::cout<<num_errors<<" errors found\n";
     std::cout<<"done\n";
 
     return 0;
@@ -385,6 +385,8 @@ int main(int argc, char* argv[])
     files_to_manage.push_back(osm_base_settings().RELATION_TAGS_LOCAL);
     files_to_manage.push_back(osm_base_settings().RELATION_TAGS_GLOBAL);
     files_to_manage.push_back(osm_base_settings().RELATION_KEYS);
+    files_to_manage.push_back(osm_base_settings().NODE_WAYS);
+    files_to_manage.push_back(osm_base_settings().MEMBER_RELATIONS);
 
     std::vector< File_Properties* >* file_target = (meta || attic) ? &files_to_manage : &files_to_avoid;
 
@@ -393,6 +395,10 @@ int main(int argc, char* argv[])
     file_target->push_back(meta_settings().RELATIONS_META);
     file_target->push_back(meta_settings().USER_DATA);
     file_target->push_back(meta_settings().USER_INDICES);
+    file_target->push_back(meta_settings().USER_NAMES);
+    file_target->push_back(meta_settings().USER_NODES);
+    file_target->push_back(meta_settings().USER_WAYS);
+    file_target->push_back(meta_settings().USER_RELATIONS);
 
     suspicious_files_present |= assure_files_absent(db_dir, files_to_avoid, "--meta");
     files_to_avoid.clear();
@@ -400,6 +406,7 @@ int main(int argc, char* argv[])
 
     file_target->push_back(attic_settings().NODES);
     file_target->push_back(attic_settings().NODES_UNDELETED);
+    file_target->push_back(attic_settings().NODES_NEWEST);
     file_target->push_back(attic_settings().NODE_IDX_LIST);
     file_target->push_back(attic_settings().NODE_TAGS_LOCAL);
     file_target->push_back(attic_settings().NODE_TAGS_GLOBAL);
@@ -407,6 +414,7 @@ int main(int argc, char* argv[])
     file_target->push_back(attic_settings().NODE_CHANGELOG);
     file_target->push_back(attic_settings().WAYS);
     file_target->push_back(attic_settings().WAYS_UNDELETED);
+    file_target->push_back(attic_settings().WAYS_NEWEST);
     file_target->push_back(attic_settings().WAY_IDX_LIST);
     file_target->push_back(attic_settings().WAY_TAGS_LOCAL);
     file_target->push_back(attic_settings().WAY_TAGS_GLOBAL);
@@ -414,6 +422,7 @@ int main(int argc, char* argv[])
     file_target->push_back(attic_settings().WAY_CHANGELOG);
     file_target->push_back(attic_settings().RELATIONS);
     file_target->push_back(attic_settings().RELATIONS_UNDELETED);
+    file_target->push_back(attic_settings().RELATIONS_NEWEST);
     file_target->push_back(attic_settings().RELATION_IDX_LIST);
     file_target->push_back(attic_settings().RELATION_TAGS_LOCAL);
     file_target->push_back(attic_settings().RELATION_TAGS_GLOBAL);
@@ -428,6 +437,7 @@ int main(int argc, char* argv[])
     files_to_manage.push_back(area_settings().AREA_BLOCKS);
     files_to_manage.push_back(area_settings().AREA_TAGS_LOCAL);
     files_to_manage.push_back(area_settings().AREA_TAGS_GLOBAL);
+    files_to_manage.push_back(area_settings().AREA_RASTERS);
   }
 
   if (suspicious_files_present)
@@ -137,6 +137,8 @@ Dispatcher_Stub::Dispatcher_Stub
     transaction->data_index(osm_base_settings().RELATION_TAGS_LOCAL);
     transaction->data_index(osm_base_settings().RELATION_TAGS_GLOBAL);
     transaction->data_index(osm_base_settings().RELATION_KEYS);
+    transaction->data_index(osm_base_settings().NODE_WAYS);
+    transaction->data_index(osm_base_settings().MEMBER_RELATIONS);
 
     if (meta == keep_meta || meta == keep_attic)
     {
@@ -145,12 +147,17 @@ Dispatcher_Stub::Dispatcher_Stub
       transaction->data_index(meta_settings().RELATIONS_META);
       transaction->data_index(meta_settings().USER_DATA);
       transaction->data_index(meta_settings().USER_INDICES);
+      transaction->data_index(meta_settings().USER_NAMES);
+      transaction->data_index(meta_settings().USER_NODES);
+      transaction->data_index(meta_settings().USER_WAYS);
+      transaction->data_index(meta_settings().USER_RELATIONS);
     }
 
     if (meta == keep_attic)
     {
       transaction->data_index(attic_settings().NODES);
       transaction->data_index(attic_settings().NODES_UNDELETED);
+      transaction->data_index(attic_settings().NODES_NEWEST);
       transaction->data_index(attic_settings().NODE_IDX_LIST);
       transaction->data_index(attic_settings().NODE_TAGS_LOCAL);
       transaction->data_index(attic_settings().NODE_TAGS_GLOBAL);
@@ -158,6 +165,7 @@ Dispatcher_Stub::Dispatcher_Stub
       transaction->data_index(attic_settings().NODE_CHANGELOG);
       transaction->data_index(attic_settings().WAYS);
       transaction->data_index(attic_settings().WAYS_UNDELETED);
+      transaction->data_index(attic_settings().WAYS_NEWEST);
       transaction->data_index(attic_settings().WAY_IDX_LIST);
       transaction->data_index(attic_settings().WAY_TAGS_LOCAL);
       transaction->data_index(attic_settings().WAY_TAGS_GLOBAL);
@@ -165,6 +173,7 @@ Dispatcher_Stub::Dispatcher_Stub
       transaction->data_index(attic_settings().WAY_CHANGELOG);
       transaction->data_index(attic_settings().RELATIONS);
       transaction->data_index(attic_settings().RELATIONS_UNDELETED);
+      transaction->data_index(attic_settings().RELATIONS_NEWEST);
       transaction->data_index(attic_settings().RELATION_IDX_LIST);
       transaction->data_index(attic_settings().RELATION_TAGS_LOCAL);
       transaction->data_index(attic_settings().RELATION_TAGS_GLOBAL);
@@ -250,6 +259,7 @@ Dispatcher_Stub::Dispatcher_Stub
       area_transaction->data_index(area_settings().AREA_BLOCKS);
       area_transaction->data_index(area_settings().AREA_TAGS_LOCAL);
       area_transaction->data_index(area_settings().AREA_TAGS_GLOBAL);
+      area_transaction->data_index(area_settings().AREA_RASTERS);
 
       if (area_level == 1)
       {
@@ -320,6 +330,14 @@ void Dispatcher_Stub::ping() const
 }
 
 
+uint Dispatcher_Stub::grant_workers(uint num_workers) const
+{
+  if (dispatcher_client)
+    return dispatcher_client->request_workers(num_workers);
+  return num_workers;
+}
+
+
 Dispatcher_Stub::~Dispatcher_Stub()
 {
   bool areas_written = (rman->area_updater() != 0);
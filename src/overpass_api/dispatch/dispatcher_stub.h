@@ -55,6 +55,9 @@ class Dispatcher_Stub : public Watchdog_Callback
     // Called once per minute from the resource manager
     virtual void ping() const;
 
+    // Asks the osm base dispatcher for worker processes
+    virtual uint grant_workers(uint num_workers) const;
+
     ~Dispatcher_Stub();
 
     std::string get_db_dir() { return (db_dir == "" ? dispatcher_client->get_db_dir() : db_dir); }
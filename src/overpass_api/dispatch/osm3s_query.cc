@@ -37,6 +37,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
@@ -55,6 +56,7 @@ int main(int argc, char *argv[])
   Debug_Level debug_level = parser_execute;
   Clone_Settings clone_settings;
   int area_level = 0;
+  bool clone_areas = false;
   bool respect_timeout = true;
 
   int argpos = 1;
@@ -79,6 +81,8 @@ int main(int argc, char *argv[])
       area_level = 2;
       respect_timeout = false;
     }
+    else if (!(strncmp(argv[argpos], "--area-workers=", 15)))
+      basic_settings().area_build_workers = std::max(1, atoi(((std::string)argv[argpos]).substr(15).c_str()));
     else if (!(strcmp(argv[argpos], "--dump-xml")))
       debug_level = parser_dump_xml;
     else if (!(strcmp(argv[argpos], "--dump-pretty-ql")))
@@ -93,6 +97,8 @@ int main(int argc, char *argv[])
       if ((clone_db_dir.size() > 0) && (clone_db_dir[clone_db_dir.size()-1] != '/'))
 	clone_db_dir += '/';
     }
+    else if (!(strcmp(argv[argpos], "--clone-areas")))
+      clone_areas = true;
     else if (!(strncmp(argv[argpos], "--clone-compression=", 20)))
     {
       if (std::string(argv[argpos]).substr(20) == "no")
@@ -150,9 +156,13 @@ int main(int argc, char *argv[])
       "  --dump-bbox-ql: Don't execute the query but only dump the query in a suitable form\n"
       "        for an OpenLayers slippy map.\n"
       "  --clone=$TARGET_DIR: Write a consistent copy of the entire database to the given $TARGET_DIR.\n"
+      "  --clone-areas: Clone also the area files. This needs a running area dispatcher\n"
+      "        unless --db-dir is given.\n"
       "  --clone-compression=$METHOD: Use a specific compression method $METHOD for clone bin files\n"
       "  --clone-map-compression=$METHOD: Use a specific compression method $METHOD for clone map files\n"
       "  --rules: Ignore all time limits and allow area creation by this query.\n"
+      "  --area-workers=$NUMBER: Build the areas of a foreach loop in rules mode\n"
+      "        with $NUMBER worker processes in parallel.\n"
       "  --quiet: Don't print anything on stderr.\n"
       "  --concise: Print concise information on stderr.\n"
       "  --progress: Print also progress information on stderr.\n"
@@ -175,12 +185,19 @@ int main(int argc, char *argv[])
     {
       // open read transaction and log this.
       area_level = determine_area_level(error_output, area_level);
+      if (clone_areas && area_level == 0)
+        area_level = 1;
       Dispatcher_Stub dispatcher(db_dir, error_output, "-- clone database --",
 				 get_uses_meta_data(), area_level, 24*60*60, 1024*1024*1024, global_settings);
       copy_file(dispatcher.resource_manager().get_transaction()->get_db_dir() + "/replicate_id",
 		clone_db_dir + "/replicate_id");
 
-      clone_database(*dispatcher.resource_manager().get_transaction(), clone_db_dir, clone_settings);
+      if (clone_areas)
+        copy_file(dispatcher.resource_manager().get_area_transaction()->get_db_dir() + "/area_version",
+            clone_db_dir + "/area_version");
+
+      clone_database(*dispatcher.resource_manager().get_transaction(),
+          clone_areas ? dispatcher.resource_manager().get_area_transaction() : 0, clone_db_dir, clone_settings);
 
       return 0;
     }
@@ -404,7 +404,7 @@ Resource_Manager::Resource_Manager(
         area_transaction(0), area_updater_(0),
         watchdog(watchdog_), global_settings(global_settings_), global_settings_owned(false),
 	start_time(time(NULL)), last_ping_time(0), last_report_time(0),
-	max_allowed_time(0), max_allowed_space(0)
+	max_allowed_time(0), max_allowed_space(0), worker(false)
 {
   if (!global_settings)
   {
@@ -423,7 +423,7 @@ Resource_Manager::Resource_Manager(
       area_transaction(&area_transaction_), area_updater_(area_updater__),
       watchdog(watchdog_), global_settings(&global_settings_), global_settings_owned(false),
       start_time(time(NULL)), last_ping_time(0), last_report_time(0),
-      max_allowed_time(0), max_allowed_space(0)
+      max_allowed_time(0), max_allowed_space(0), worker(false)
 {
   runtime_stack.push_back(new Runtime_Stack_Frame());
 }
@@ -627,6 +627,21 @@ void Resource_Manager::log_and_display_error(std::string message)
 }
 
 
+void Resource_Manager::become_worker(uint num_workers)
+{
+  watchdog = 0;
+  error_output = 0;
+  worker = true;
+
+  if (max_allowed_space > 0 && num_workers > 1)
+  {
+    uint64 used = runtime_stack.empty() ? 0 : runtime_stack.back()->total_size();
+    if (used < max_allowed_space)
+      max_allowed_space = used + (max_allowed_space - used)/num_workers;
+  }
+}
+
+
 void Resource_Manager::health_check(const Statement& stmt, uint32 extra_time, uint64 extra_space)
 {
   uint32 elapsed_time = 0;
@@ -33,6 +33,9 @@ class Statement;
 struct Watchdog_Callback
 {
   virtual void ping() const = 0;
+
+  // Returns how many of the requested worker processes the dispatcher grants
+  virtual uint grant_workers(uint num_workers) const = 0;
 };
 
 
@@ -165,6 +168,16 @@ public:
     max_allowed_space = max_allowed_space_;
   }
 
+  // To be called in a forked worker process. Detaches from the watchdog and the error output
+  // and restricts the space limit to a share of the remaining space such that all workers together
+  // stay within the space registered at the dispatcher.
+  void become_worker(uint num_workers);
+  bool is_worker() const { return worker; }
+
+  // Returns how many of the requested worker processes may be forked. The workers are counted
+  // at the dispatcher until the next call, hence call with zero after the workers have finished.
+  uint grant_workers(uint num_workers) { return watchdog ? watchdog->grant_workers(num_workers) : num_workers; }
+
   Transaction* get_transaction() { return transaction; }
   Transaction* get_area_transaction() { return area_transaction; }
 
@@ -179,7 +192,11 @@ public:
   void switch_diff_show_from(const std::string& diff_set_name);
   void switch_diff_show_to(const std::string& diff_set_name);
 
-  const std::map< uint32, std::string >& users() { return user_data_cache.users(*transaction); }
+  // Resolves only the names of the given users, see User_Data_Cache.
+  // Callers should pass all users of a chunk at once such that the names are read in one pass.
+  template< typename Iterator >
+  const std::map< uint32, std::string >& users(Iterator begin, Iterator end)
+  { return user_data_cache.users(*transaction, begin, end); }
 
   void start_cpu_timer(uint index);
   void stop_cpu_timer(uint index);
@@ -201,6 +218,7 @@ private:
   uint32 last_report_time;
   uint32 max_allowed_time;
   uint64 max_allowed_space;
+  bool worker;
 
   std::vector< clock_t > cpu_start_time;
   std::vector< uint64 > cpu_runtime;
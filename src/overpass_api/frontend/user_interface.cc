@@ -104,11 +104,44 @@ namespace
 
     return input;
   }
+
+
+  // Checks an Accept-Encoding header value for gzip without a quality of zero
+  bool gzip_accepted(const std::string& accept_encoding)
+  {
+    std::string::size_type pos = 0;
+    while (pos < accept_encoding.size())
+    {
+      std::string::size_type end = accept_encoding.find(',', pos);
+      if (end == std::string::npos)
+        end = accept_encoding.size();
+
+      std::string coding;
+      std::string params;
+      for (std::string::size_type i = pos; i < end; ++i)
+      {
+        if (isspace(accept_encoding[i]))
+          continue;
+        if (!params.empty() || accept_encoding[i] == ';')
+          params += accept_encoding[i];
+        else
+          coding += tolower(accept_encoding[i]);
+      }
+
+      if (coding == "gzip" || coding == "x-gzip")
+      {
+        std::string::size_type q_pos = params.find(";q=");
+        return q_pos == std::string::npos || atof(params.c_str() + q_pos + 3) > 0;
+      }
+      pos = end + 1;
+    }
+    return false;
+  }
 }
 
 std::map< std::string, std::string > get_xml_cgi(
     Error_Output* error_output, uint32 max_input_size,
-    Http_Methods& http_method, std::string& allow_header, bool& has_origin)
+    Http_Methods& http_method, std::string& allow_header, bool& has_origin, bool& accepts_gzip)
 {
   // Check for various HTTP headers
   char* method = getenv("REQUEST_METHOD");
@@ -123,6 +156,8 @@ std::map< std::string, std::string > get_xml_cgi(
   allow_header = ((allow_header_c) ? allow_header_c : "");
   char* origin = getenv("HTTP_ORIGIN");
   has_origin = ((origin) && strnlen(origin, 1) > 0);
+  char* accept_encoding = getenv("HTTP_ACCEPT_ENCODING");
+  accepts_gzip = ((accept_encoding) && gzip_accepted(accept_encoding));
 
   int line_number(1);
   // If there is nonempty input from GET method, use GET
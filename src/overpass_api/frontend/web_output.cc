@@ -16,6 +16,7 @@
  * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "../../template_db/zlib_wrapper.h"
 #include "output.h"
 #include "web_output.h"
 
@@ -169,10 +170,20 @@ void Web_Output::write_payload_header
     if (http_method == http_options)
       std::cout<<"Access-Control-Allow-Methods: GET, POST, OPTIONS\n"
             "Content-Length: 0\n";
+    bool compress = false;
     if (!output_handler || output_handler->write_http_headers())
+    {
+      compress = output_handler && accepts_gzip && (http_method == http_get || http_method == http_post);
+      if (compress)
+        std::cout<<"Content-Encoding: gzip\n";
+      if (output_handler)
+        std::cout<<"Vary: Accept-Encoding\n";
       std::cout<<'\n';
+    }
     if (http_method == http_options || http_method == http_head)
       return;
+    if (compress)
+      start_gzip();
   }
 
   if (output_handler)
@@ -276,6 +287,28 @@ void Web_Output::write_footer()
     output_handler->write_footer();
 
   header_written = final;
+  finish_gzip();
+}
+
+
+// Level 1 is several times faster than the default level and still gets most of the size reduction
+void Web_Output::start_gzip()
+{
+  std::cout.flush();
+  gzip_buf = new Gzip_Streambuf(std::cout.rdbuf(), 1);
+  plain_buf = std::cout.rdbuf(gzip_buf);
+}
+
+
+void Web_Output::finish_gzip()
+{
+  if (!gzip_buf)
+    return;
+  std::cout.flush();
+  gzip_buf->finish();
+  std::cout.rdbuf(plain_buf);
+  delete gzip_buf;
+  gzip_buf = 0;
 }
 
 
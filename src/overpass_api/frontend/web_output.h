@@ -24,12 +24,16 @@
 #include "basic_formats.h"
 #include "output_handler.h"
 
+#include <streambuf>
+
+
+class Gzip_Streambuf;
 
 struct Web_Output : public Error_Output
 {
-  Web_Output(uint log_level_) : http_method(http_get), has_origin(false), header_written(not_yet),
-      encoding_errors(false), parse_errors(false), static_errors(false), log_level(log_level_),
-      output_handler(0) {}
+  Web_Output(uint log_level_) : http_method(http_get), has_origin(false), accepts_gzip(false),
+      header_written(not_yet), encoding_errors(false), parse_errors(false), static_errors(false),
+      log_level(log_level_), output_handler(0), gzip_buf(0), plain_buf(0) {}
 
   ~Web_Output() { write_footer(); }
 
@@ -67,6 +71,7 @@ public:
   Http_Methods http_method;
   std::string allow_headers;
   bool has_origin;
+  bool accepts_gzip;
 
 private:
   enum { not_yet, payload, html, final } header_written;
@@ -77,7 +82,11 @@ private:
   std::string messages;
 
   Output_Handler* output_handler;
+  Gzip_Streambuf* gzip_buf;
+  std::streambuf* plain_buf;
 
+  void start_gzip();
+  void finish_gzip();
   void display_remark(const std::string& text);
   void display_error(const std::string& text, uint write_mime);
 };
@@ -31,12 +31,12 @@
 
 
 Area_Updater::Area_Updater(Transaction& transaction_)
-  : transaction(&transaction_), external_transaction(true),
+  : transaction(&transaction_), external_transaction(true), collecting(false),
     total_area_blocks_count(0)
 {}
 
 Area_Updater::Area_Updater(std::string db_dir_)
-  : transaction(0), external_transaction(false),
+  : transaction(0), external_transaction(false), collecting(false),
     db_dir(db_dir_), total_area_blocks_count(0)
 {}
 
@@ -53,6 +53,18 @@ void Area_Updater::add_blocks
   }
 }
 
+void Area_Updater::add_rasters
+    (const std::map< Uint31_Index, std::vector< Area_Raster > >& area_rasters_)
+{
+  for (std::map< Uint31_Index, std::vector< Area_Raster > >::const_iterator
+    it(area_rasters_.begin()); it != area_rasters_.end(); ++it)
+  {
+    for (std::vector< Area_Raster >::const_iterator it2(it->second.begin());
+    it2 != it->second.end(); ++it2)
+    area_rasters[it->first].push_back(*it2);
+  }
+}
+
 void Area_Updater::update()
 {
   if (!external_transaction)
@@ -62,8 +74,9 @@ void Area_Updater::update()
 
   std::map< Uint31_Index, std::set< Area_Skeleton > > locations_to_delete;
   std::map< Uint31_Index, std::set< Area_Block > > blocks_to_delete;
-  update_area_ids(locations_to_delete, blocks_to_delete);
-  update_members(locations_to_delete, blocks_to_delete);
+  std::map< Uint31_Index, std::set< Area_Raster > > rasters_to_delete;
+  update_area_ids(locations_to_delete, blocks_to_delete, rasters_to_delete);
+  update_members(locations_to_delete, blocks_to_delete, rasters_to_delete);
 
   std::vector< Tag_Entry< uint32 > > tags_to_delete;
   prepare_delete_tags(tags_to_delete, locations_to_delete);
@@ -73,6 +86,7 @@ void Area_Updater::update()
   ids_to_modify.clear();
   areas_to_insert.clear();
   area_blocks.clear();
+  area_rasters.clear();
   total_area_blocks_count = 0;
 
   if (!external_transaction)
@@ -81,23 +95,61 @@ void Area_Updater::update()
 
 void Area_Updater::update_area_ids
     (std::map< Uint31_Index, std::set< Area_Skeleton > >& locations_to_delete,
-     std::map< Uint31_Index, std::set< Area_Block > >& blocks_to_delete)
+     std::map< Uint31_Index, std::set< Area_Block > >& blocks_to_delete,
+     std::map< Uint31_Index, std::set< Area_Raster > >& rasters_to_delete)
 {
   std::set< Uint31_Index > blocks_req;
 
   // process the areas themselves
+  Random_File_Index* random_index = transaction->random_index(area_settings().AREAS);
+  Random_File< Area_Skeleton::Id_Type, Uint31_Index > random(random_index);
   Block_Backend< Uint31_Index, Area_Skeleton > area_locations_db
       (transaction->data_index(area_settings().AREAS));
-  for (Block_Backend< Uint31_Index, Area_Skeleton >::Flat_Iterator
-      it(area_locations_db.flat_begin());
-      !(it == area_locations_db.flat_end()); ++it)
+  if (random_index->get_blocks().empty())
   {
-    if (ids_to_modify.find(it.object().id) != ids_to_modify.end())
+    // The database predates the id map. Scan all areas once and fill the map on the way.
+    std::vector< std::pair< Area_Skeleton::Id_Type, Uint31_Index > > id_idxs;
+    for (Block_Backend< Uint31_Index, Area_Skeleton >::Flat_Iterator
+        it(area_locations_db.flat_begin());
+        !(it == area_locations_db.flat_end()); ++it)
     {
-      for (std::vector< uint32 >::const_iterator it2(it.object().used_indices.begin());
-          it2 != it.object().used_indices.end(); ++it2)
-        blocks_req.insert(*it2);
-      locations_to_delete[it.index().val()].insert(it.object());
+      id_idxs.push_back(std::make_pair(it.object().id, it.index()));
+      if (ids_to_modify.find(it.object().id) != ids_to_modify.end())
+      {
+        for (std::vector< uint32 >::const_iterator it2(it.object().used_indices.begin());
+            it2 != it.object().used_indices.end(); ++it2)
+          blocks_req.insert(*it2);
+        locations_to_delete[it.index().val()].insert(it.object());
+      }
+    }
+
+    // Writing in id order keeps the map cache from switching blocks on every entry
+    std::sort(id_idxs.begin(), id_idxs.end());
+    for (std::vector< std::pair< Area_Skeleton::Id_Type, Uint31_Index > >::const_iterator
+        it = id_idxs.begin(); it != id_idxs.end(); ++it)
+      random.put(it->first, it->second);
+  }
+  else
+  {
+    std::set< Uint31_Index > req;
+    for (std::set< Area::Id_Type >::const_iterator it = ids_to_modify.begin(); it != ids_to_modify.end(); ++it)
+    {
+      Uint31_Index idx = random.get(*it);
+      if (idx.val() > 0)
+        req.insert(idx);
+    }
+
+    for (Block_Backend< Uint31_Index, Area_Skeleton >::Discrete_Iterator
+        it(area_locations_db.discrete_begin(req.begin(), req.end()));
+        !(it == area_locations_db.discrete_end()); ++it)
+    {
+      if (ids_to_modify.find(it.object().id) != ids_to_modify.end())
+      {
+        for (std::vector< uint32 >::const_iterator it2(it.object().used_indices.begin());
+            it2 != it.object().used_indices.end(); ++it2)
+          blocks_req.insert(*it2);
+        locations_to_delete[it.index().val()].insert(it.object());
+      }
     }
   }
 
@@ -110,11 +162,22 @@ void Area_Updater::update_area_ids
     if (ids_to_modify.find(it.object().id) != ids_to_modify.end())
       blocks_to_delete[it.index()].insert(it.object());
   }
+
+  Block_Backend< Uint31_Index, Area_Raster > area_rasters_db
+      (transaction->data_index(area_settings().AREA_RASTERS));
+  for (Block_Backend< Uint31_Index, Area_Raster >::Discrete_Iterator
+      it(area_rasters_db.discrete_begin(blocks_req.begin(), blocks_req.end()));
+      !(it == area_rasters_db.discrete_end()); ++it)
+  {
+    if (ids_to_modify.find(it.object().id) != ids_to_modify.end())
+      rasters_to_delete[it.index()].insert(it.object());
+  }
 }
 
 void Area_Updater::update_members
     (const std::map< Uint31_Index, std::set< Area_Skeleton > >& locations_to_delete,
-     const std::map< Uint31_Index, std::set< Area_Block > >& blocks_to_delete)
+     const std::map< Uint31_Index, std::set< Area_Block > >& blocks_to_delete,
+     const std::map< Uint31_Index, std::set< Area_Raster > >& rasters_to_delete)
 {
   std::map< Uint31_Index, std::set< Area_Skeleton > > locations_to_insert;
   for (std::vector< std::pair< Area_Location, Uint31_Index > >::const_iterator
@@ -125,6 +188,24 @@ void Area_Updater::update_members
       (transaction->data_index(area_settings().AREAS));
   area_locations.update(locations_to_delete, locations_to_insert);
 
+  // Keep the id map in sync: deleted areas map to zero unless they are inserted again
+  std::map< Area_Skeleton::Id_Type, Uint31_Index > new_idxs;
+  for (std::map< Uint31_Index, std::set< Area_Skeleton > >::const_iterator
+      it = locations_to_delete.begin(); it != locations_to_delete.end(); ++it)
+  {
+    for (std::set< Area_Skeleton >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+      new_idxs[it2->id] = Uint31_Index(uint32(0));
+  }
+  for (std::vector< std::pair< Area_Location, Uint31_Index > >::const_iterator
+      it(areas_to_insert.begin()); it != areas_to_insert.end(); ++it)
+    new_idxs[it->first.id] = it->second;
+
+  Random_File< Area_Skeleton::Id_Type, Uint31_Index > random
+      (transaction->random_index(area_settings().AREAS));
+  for (std::map< Area_Skeleton::Id_Type, Uint31_Index >::const_iterator
+      it = new_idxs.begin(); it != new_idxs.end(); ++it)
+    random.put(it->first, it->second);
+
   std::map< Uint31_Index, std::set< Area_Block > > blocks_to_insert;
   for (std::map< Uint31_Index, std::vector< Area_Block > >::const_iterator
       it(area_blocks.begin()); it != area_blocks.end(); ++it)
@@ -137,6 +218,19 @@ void Area_Updater::update_members
   Block_Backend< Uint31_Index, Area_Block > area_blocks_db
       (transaction->data_index(area_settings().AREA_BLOCKS));
   area_blocks_db.update(blocks_to_delete, blocks_to_insert);
+
+  std::map< Uint31_Index, std::set< Area_Raster > > rasters_to_insert;
+  for (std::map< Uint31_Index, std::vector< Area_Raster > >::const_iterator
+      it(area_rasters.begin()); it != area_rasters.end(); ++it)
+  {
+    for (std::vector< Area_Raster >::const_iterator it2(it->second.begin());
+        it2 != it->second.end(); ++it2)
+      rasters_to_insert[it->first].insert(*it2);
+  }
+
+  Block_Backend< Uint31_Index, Area_Raster > area_rasters_db
+      (transaction->data_index(area_settings().AREA_RASTERS));
+  area_rasters_db.update(rasters_to_delete, rasters_to_insert);
 }
 
 void Area_Updater::prepare_delete_tags
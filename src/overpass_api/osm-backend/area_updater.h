@@ -62,14 +62,24 @@ struct Area_Updater : public Area_Usage_Listener
        const std::set< uint32 >& used_indices);
   void set_area(const Uint31_Index& index, const Area_Location& area);
   void add_blocks(const std::map< Uint31_Index, std::vector< Area_Block > >& area_blocks_);
+  void add_rasters(const std::map< Uint31_Index, std::vector< Area_Raster > >& area_rasters_);
   void commit();
   virtual void flush();
 
+  // For a worker process that builds areas on behalf of the updater in its parent process:
+  // Drops the inherited pending changes and afterwards only collects the changes without writing them.
+  void collect_only();
+  const std::vector< std::pair< Area_Location, Uint31_Index > >& get_areas() const { return areas_to_insert; }
+  const std::map< Uint31_Index, std::vector< Area_Block > >& get_blocks() const { return area_blocks; }
+  const std::map< Uint31_Index, std::vector< Area_Raster > >& get_rasters() const { return area_rasters; }
+
 private:
   Transaction* transaction;
   bool external_transaction;
+  bool collecting;
   std::string db_dir;
   std::map< Uint31_Index, std::vector< Area_Block > > area_blocks;
+  std::map< Uint31_Index, std::vector< Area_Raster > > area_rasters;
   unsigned int total_area_blocks_count;
   std::set< Area::Id_Type > ids_to_modify;
   std::vector< std::pair< Area_Location, Uint31_Index > > areas_to_insert;
@@ -79,10 +89,12 @@ private:
   void update();
   void update_area_ids
       (std::map< Uint31_Index, std::set< Area_Skeleton > >& locations_to_delete,
-       std::map< Uint31_Index, std::set< Area_Block > >& blocks_to_delete);
+       std::map< Uint31_Index, std::set< Area_Block > >& blocks_to_delete,
+       std::map< Uint31_Index, std::set< Area_Raster > >& rasters_to_delete);
   void update_members
       (const std::map< Uint31_Index, std::set< Area_Skeleton > >& locations_to_delete,
-       const std::map< Uint31_Index, std::set< Area_Block > >& blocks_to_delete);
+       const std::map< Uint31_Index, std::set< Area_Block > >& blocks_to_delete,
+       const std::map< Uint31_Index, std::set< Area_Raster > >& rasters_to_delete);
   void prepare_delete_tags
       (std::vector< Tag_Entry< uint32 > >& tags_to_delete,
        const std::map< Uint31_Index, std::set< Area_Skeleton > >& to_delete);
@@ -99,7 +111,7 @@ private:
 
 inline void Area_Updater::commit()
 {
-  if (total_area_blocks_count > 512*1024)
+  if (!collecting && total_area_blocks_count > 512*1024)
     update();
 }
 
@@ -107,9 +119,9 @@ inline void Area_Updater::flush()
 {
   try
   {
-    if ((!ids_to_modify.empty()) ||
+    if (!collecting && ((!ids_to_modify.empty()) ||
         (!areas_to_insert.empty()) ||
-        (!area_blocks.empty()))
+        (!area_blocks.empty())))
       update();
   }
   catch(File_Error e)
@@ -118,6 +130,16 @@ inline void Area_Updater::flush()
   }
 }
 
+inline void Area_Updater::collect_only()
+{
+  collecting = true;
+  ids_to_modify.clear();
+  areas_to_insert.clear();
+  area_blocks.clear();
+  area_rasters.clear();
+  total_area_blocks_count = 0;
+}
+
 inline void Area_Updater::set_area
     (uint32 id, const Uint31_Index& index,
      const std::vector< std::pair< std::string, std::string > >& tags,
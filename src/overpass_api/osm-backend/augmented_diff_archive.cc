@@ -0,0 +1,537 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../expat/escape_xml.h"
+#include "../../expat/expat_justparse_interface.h"
+#include "../../template_db/block_backend.h"
+#include "../../template_db/transaction.h"
+#include "../core/datatypes.h"
+#include "../core/index_computations.h"
+#include "../core/settings.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+
+/* Archive of augmented diffs
+
+The archive stores the actions of each augmented diff as they have been printed by the adiff query,
+keyed by the sequence number of the diff and by the one degree tiles the action touches.
+Hence any window of diffs, restricted to a bounding box or not, can be served without running the query again.
+The archive is written by a single process and is safe to read while it is written.
+It keeps a fixed number of the newest diffs, and a request may span only a bounded window of them.
+*/
+
+
+namespace
+{
+  const uint32 LARGE_TILE = 0xffffffff;
+  const uint32 MAX_TILES_PER_ACTION = 64;
+  // Longer actions are split into parts to fit into the blocks of the archive
+  const uint32 MAX_PART_SIZE = 256*1024;
+  const uint32 MAX_DIFFS_PER_REQUEST = 60;
+  // Beyond this number of index lookups the whole window is read and filtered instead
+  const uint32 MAX_TILE_REQUESTS = 1024;
+
+
+  // The bounding box is empty if south > north. Actions without coordinates have an empty bounding box.
+  struct Bbox
+  {
+    Bbox() : south(0xffffffff), north(0), west(1800000000), east(-1800000000) {}
+
+    uint32 south, north;
+    int32 west, east;
+
+    bool empty() const { return south > north; }
+
+    void extend(uint32 lat, int32 lon)
+    {
+      south = std::min(south, lat);
+      north = std::max(north, lat);
+      west = std::min(west, lon);
+      east = std::max(east, lon);
+    }
+
+    // The query box may cross the date line, i.e. have west > east
+    bool intersects_query(const Bbox& query) const
+    {
+      if (empty() || south > query.north || north < query.south)
+        return false;
+      if (query.west <= query.east)
+        return west <= query.east && east >= query.west;
+      return west <= query.east || east >= query.west;
+    }
+  };
+
+
+  struct Augmented_Diff_Action
+  {
+    typedef uint32 Id_Type;
+
+    uint32 pos;
+    uint32 part;
+    Bbox bbox;
+    std::string xml;
+
+    Augmented_Diff_Action(uint32 pos_, uint32 part_, const Bbox& bbox_, const std::string& xml_)
+        : pos(pos_), part(part_), bbox(bbox_), xml(xml_) {}
+
+    Augmented_Diff_Action(void* data)
+    {
+      pos = *(uint32*)data;
+      part = *((uint32*)data + 1);
+      bbox.south = *((uint32*)data + 2);
+      bbox.north = *((uint32*)data + 3);
+      bbox.west = *((int32*)data + 4);
+      bbox.east = *((int32*)data + 5);
+      xml.assign((const char*)data + 28, *((uint32*)data + 6));
+    }
+
+    uint32 size_of() const { return 28 + xml.size(); }
+    static uint32 size_of(void* data) { return 28 + *((uint32*)data + 6); }
+    static Id_Type get_id(void* data) { return *(uint32*)data; }
+
+    void to_data(void* data) const
+    {
+      *(uint32*)data = pos;
+      *((uint32*)data + 1) = part;
+      *((uint32*)data + 2) = bbox.south;
+      *((uint32*)data + 3) = bbox.north;
+      *((int32*)data + 4) = bbox.west;
+      *((int32*)data + 5) = bbox.east;
+      *((uint32*)data + 6) = xml.size();
+      memcpy((uint8*)data + 28, xml.data(), xml.size());
+    }
+
+    bool operator<(const Augmented_Diff_Action& rhs) const
+    {
+      return pos < rhs.pos || (pos == rhs.pos && part < rhs.part);
+    }
+    bool operator==(const Augmented_Diff_Action& rhs) const { return pos == rhs.pos && part == rhs.part; }
+  };
+
+
+  uint32 tile_lat(uint32 lat) { return lat / 10000000; }
+  uint32 tile_lon(int32 lon) { return ((int64)lon + 1800000000) / 10000000; }
+
+
+  void add_tiles(uint32 south, uint32 north, int32 west, int32 east, std::vector< uint32 >& tiles)
+  {
+    for (uint32 i = tile_lat(south); i <= tile_lat(north); ++i)
+    {
+      for (uint32 j = tile_lon(west); j <= tile_lon(east); ++j)
+        tiles.push_back((i<<16) | j);
+    }
+  }
+
+
+  std::vector< uint32 > tiles_of(const Bbox& bbox)
+  {
+    std::vector< uint32 > tiles;
+    if (bbox.empty())
+      return tiles;
+    if (bbox.west <= bbox.east)
+      add_tiles(bbox.south, bbox.north, bbox.west, bbox.east, tiles);
+    else
+    {
+      add_tiles(bbox.south, bbox.north, bbox.west, 1800000000, tiles);
+      add_tiles(bbox.south, bbox.north, -1800000000, bbox.east, tiles);
+    }
+    return tiles;
+  }
+
+
+  Uint64 archive_index(uint32 sequence, uint32 tile)
+  {
+    return Uint64(((uint64)sequence<<32) | tile);
+  }
+
+
+  //----------------------------------------------------------------------------
+  // Parsing an augmented diff
+
+  // Collects the text of each action with the indentation of Output_XML
+  struct Action_Collector
+  {
+    Action_Collector() : remark_present(false), depth(0), old_or_new_depth(0), tag_open(false) {}
+
+    std::vector< Augmented_Diff_Action > actions;
+    std::string meta;
+    // A remark tells that the query has been aborted, e.g. by a timeout
+    bool remark_present;
+
+    uint depth;
+    uint old_or_new_depth;
+    bool tag_open;
+    Bbox bbox;
+    std::string buf;
+  };
+
+  Action_Collector* collector = 0;
+
+
+  const char* attribute(const char** attr, const char* key)
+  {
+    for (uint i = 0; attr[i]; i += 2)
+    {
+      if (!strcmp(attr[i], key))
+        return attr[i+1];
+    }
+    return 0;
+  }
+
+
+  void extend_bbox(const char* lat, const char* lon, Bbox& bbox)
+  {
+    if (lat && lon)
+      bbox.extend(::ilat(atof(lat)), ::ilon(atof(lon)));
+  }
+
+
+  void start(const char* el, const char** attr)
+  {
+    Action_Collector& c = *collector;
+    ++c.depth;
+    if (c.depth == 2 && !strcmp(el, "meta"))
+    {
+      c.meta = "<meta";
+      for (uint i = 0; attr[i]; i += 2)
+      {
+        c.meta += std::string(" ") + attr[i] + "=\"";
+        escape_xml(attr[i+1], c.meta);
+        c.meta += "\"";
+      }
+      c.meta += "/>\n";
+    }
+    if (c.depth == 2 && !strcmp(el, "remark"))
+      c.remark_present = true;
+    if (c.depth < 2 || (c.depth == 2 && strcmp(el, "action")))
+      return;
+
+    if (c.tag_open)
+      c.buf += ">\n";
+    if (!strcmp(el, "old") || !strcmp(el, "new"))
+      c.old_or_new_depth = c.depth;
+    else if (c.depth > 2)
+      c.buf.append(2*(c.depth - 2 - (c.old_or_new_depth > 0 ? 1 : 0)), ' ');
+
+    c.buf += std::string("<") + el;
+    for (uint i = 0; attr[i]; i += 2)
+    {
+      c.buf += std::string(" ") + attr[i] + "=\"";
+      escape_xml(attr[i+1], c.buf);
+      c.buf += "\"";
+    }
+    c.tag_open = true;
+
+    extend_bbox(attribute(attr, "lat"), attribute(attr, "lon"), c.bbox);
+    if (!strcmp(el, "bounds"))
+    {
+      extend_bbox(attribute(attr, "minlat"), attribute(attr, "minlon"), c.bbox);
+      extend_bbox(attribute(attr, "maxlat"), attribute(attr, "maxlon"), c.bbox);
+    }
+  }
+
+
+  void end(const char* el)
+  {
+    Action_Collector& c = *collector;
+    if (c.depth >= 2 && !c.buf.empty())
+    {
+      if (c.tag_open)
+        c.buf += "/>\n";
+      else
+      {
+        if (c.depth > 2 && c.depth != c.old_or_new_depth)
+          c.buf.append(2*(c.depth - 2 - (c.old_or_new_depth > 0 ? 1 : 0)), ' ');
+        c.buf += std::string("</") + el + ">\n";
+      }
+      c.tag_open = false;
+      if (c.depth == c.old_or_new_depth)
+        c.old_or_new_depth = 0;
+
+      if (c.depth == 2)
+      {
+        uint32 pos = (c.actions.empty() ? 0 : c.actions.back().pos) + 1;
+        for (uint32 i = 0; i*MAX_PART_SIZE < c.buf.size(); ++i)
+          c.actions.push_back(Augmented_Diff_Action(pos, i, c.bbox, c.buf.substr(i*MAX_PART_SIZE, MAX_PART_SIZE)));
+        c.buf.clear();
+        c.bbox = Bbox();
+      }
+    }
+    --c.depth;
+  }
+
+
+  //----------------------------------------------------------------------------
+  // Reading and writing the archive
+
+  // Diffs older than the newest keep diffs are removed from the archive.
+  // Returns false and leaves the archive unchanged if the diff is incomplete.
+  bool add_diff(const std::string& archive_dir, uint32 sequence, uint32 keep, FILE* in)
+  {
+    Action_Collector c;
+    collector = &c;
+    parse(in, start, end);
+    collector = 0;
+    if (c.remark_present)
+      return false;
+
+    std::map< Uint64, std::set< Augmented_Diff_Action > > to_insert;
+    // The meta element of the diff is kept as action zero
+    to_insert[archive_index(sequence, LARGE_TILE)].insert(Augmented_Diff_Action(0, 0, Bbox(), c.meta));
+    for (std::vector< Augmented_Diff_Action >::const_iterator it = c.actions.begin(); it != c.actions.end(); ++it)
+    {
+      std::vector< uint32 > tiles = tiles_of(it->bbox);
+      if (tiles.empty() || tiles.size() > MAX_TILES_PER_ACTION)
+        to_insert[archive_index(sequence, LARGE_TILE)].insert(*it);
+      else
+      {
+        for (std::vector< uint32 >::const_iterator it2 = tiles.begin(); it2 != tiles.end(); ++it2)
+          to_insert[archive_index(sequence, *it2)].insert(*it);
+      }
+    }
+
+    // The changes go to a shadow index that replaces the index in one step.
+    // Readers therefore see either the old or the new state of the archive.
+    std::string index_file = archive_dir + augmented_diff_settings().ACTIONS->get_file_name_trunk()
+        + augmented_diff_settings().ACTIONS->get_data_suffix()
+        + augmented_diff_settings().ACTIONS->get_index_suffix();
+    if (file_exists(index_file))
+      copy_file(index_file, index_file + augmented_diff_settings().ACTIONS->get_shadow_suffix());
+
+    {
+      Nonsynced_Transaction transaction(true, true, archive_dir, "");
+      Block_Backend< Uint64, Augmented_Diff_Action > db
+          (transaction.data_index(augmented_diff_settings().ACTIONS));
+
+      // Adding a diff again replaces it
+      std::map< Uint64, std::set< Augmented_Diff_Action > > to_delete;
+      std::set< std::pair< Uint64, Uint64 > > range;
+      if (keep > 0 && sequence >= keep)
+        range.insert(std::make_pair(archive_index(0, 0), archive_index(sequence - keep + 1, 0)));
+      range.insert(std::make_pair(archive_index(sequence, 0), archive_index(sequence + 1, 0)));
+      for (Block_Backend< Uint64, Augmented_Diff_Action >::Range_Iterator
+          it = db.range_begin(Default_Range_Iterator< Uint64 >(range.begin()),
+              Default_Range_Iterator< Uint64 >(range.end()));
+          !(it == db.range_end()); ++it)
+        to_delete[it.index()].insert(it.object());
+
+      db.update(to_delete, to_insert);
+    }
+
+    rename((index_file + augmented_diff_settings().ACTIONS->get_shadow_suffix()).c_str(), index_file.c_str());
+    return true;
+  }
+
+
+  void print_actions(const std::map< std::pair< uint32, uint32 >, std::string >& actions)
+  {
+    for (std::map< std::pair< uint32, uint32 >, std::string >::const_iterator it = actions.begin();
+        it != actions.end(); ++it)
+    {
+      if (it->first.first > 0)
+        std::cout<<it->second;
+    }
+  }
+
+
+  template< typename Iterator >
+  void print_diffs(Iterator it, const Iterator& end, const Bbox* query)
+  {
+    uint32 sequence = 0;
+    std::map< std::pair< uint32, uint32 >, std::string > actions;
+    for (; !(it == end); ++it)
+    {
+      if ((it.index().val()>>32) != sequence)
+      {
+        print_actions(actions);
+        actions.clear();
+        sequence = it.index().val()>>32;
+      }
+      // An action that touches several tiles appears once per tile
+      if (!query || it.object().bbox.intersects_query(*query))
+        actions.insert(std::make_pair(std::make_pair(it.object().pos, it.object().part), it.object().xml));
+    }
+    print_actions(actions);
+  }
+
+
+  void extract_diffs(const std::string& archive_dir, uint32 from, uint32 to, const Bbox* query)
+  {
+    Nonsynced_Transaction transaction(false, false, archive_dir, "");
+    Block_Backend< Uint64, Augmented_Diff_Action > db
+        (transaction.data_index(augmented_diff_settings().ACTIONS));
+
+    std::string meta;
+    std::set< Uint64 > meta_req;
+    meta_req.insert(archive_index(to, LARGE_TILE));
+    for (Block_Backend< Uint64, Augmented_Diff_Action >::Discrete_Iterator
+        it = db.discrete_begin(meta_req.begin(), meta_req.end()); !(it == db.discrete_end()); ++it)
+    {
+      if (it.object().pos == 0)
+        meta = it.object().xml;
+    }
+
+    std::cout<<
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<osm version=\"0.6\""
+        " generator=\"Overpass API "<<basic_settings().version<<" "<<basic_settings().source_hash.substr(0, 8)<<"\">\n"
+        "<note>The data included in this document is from www.openstreetmap.org. "
+        "The data is made available under ODbL.</note>\n"
+        <<meta<<"\n";
+
+    std::vector< uint32 > tiles;
+    if (query)
+    {
+      tiles = tiles_of(*query);
+      tiles.push_back(LARGE_TILE);
+    }
+
+    if (!query || (uint64)tiles.size() * (to - from + 1) > MAX_TILE_REQUESTS)
+    {
+      std::set< std::pair< Uint64, Uint64 > > range;
+      range.insert(std::make_pair(archive_index(from, 0), Uint64(((uint64)to + 1)<<32)));
+      print_diffs(db.range_begin(Default_Range_Iterator< Uint64 >(range.begin()),
+          Default_Range_Iterator< Uint64 >(range.end())), db.range_end(), query);
+    }
+    else
+    {
+      std::set< Uint64 > req;
+      for (uint64 sequence = from; sequence <= to; ++sequence)
+      {
+        for (std::vector< uint32 >::const_iterator it = tiles.begin(); it != tiles.end(); ++it)
+          req.insert(archive_index(sequence, *it));
+      }
+      print_diffs(db.discrete_begin(req.begin(), req.end()), db.discrete_end(), query);
+    }
+
+    std::cout<<"\n</osm>\n";
+  }
+
+
+  // Accepts the bounding box in the order west,south,east,north as the bbox parameter of the interpreter
+  bool parse_bbox(const std::string& s, Bbox& bbox)
+  {
+    double west, south, east, north;
+    if (sscanf(s.c_str(), "%lf,%lf,%lf,%lf", &west, &south, &east, &north) != 4
+        || south < -90. || north > 90. || south > north
+        || west < -180. || west > 180. || east < -180. || east > 180.)
+      return false;
+    bbox.south = ::ilat(south);
+    bbox.north = ::ilat(north);
+    bbox.west = ::ilon(west);
+    bbox.east = ::ilon(east);
+    return true;
+  }
+}
+
+
+int main(int argc, char* argv[])
+{
+  std::string archive_dir;
+  uint32 add = 0;
+  uint32 keep = 0;
+  uint32 from = 0;
+  uint32 to = 0;
+  Bbox query;
+  bool bbox_given = false;
+  bool abort = false;
+
+  int argpos = 1;
+  while (argpos < argc)
+  {
+    if (!(strncmp(argv[argpos], "--archive-dir=", 14)))
+    {
+      archive_dir = ((std::string)argv[argpos]).substr(14);
+      if ((archive_dir.size() > 0) && (archive_dir[archive_dir.size()-1] != '/'))
+        archive_dir += '/';
+    }
+    else if (!(strncmp(argv[argpos], "--add=", 6)))
+      add = atol(argv[argpos] + 6);
+    else if (!(strncmp(argv[argpos], "--keep=", 7)))
+      keep = atol(argv[argpos] + 7);
+    else if (!(strncmp(argv[argpos], "--from=", 7)))
+      from = atol(argv[argpos] + 7);
+    else if (!(strncmp(argv[argpos], "--to=", 5)))
+      to = atol(argv[argpos] + 5);
+    else if (!(strncmp(argv[argpos], "--bbox=", 7)))
+    {
+      bbox_given = true;
+      if (!parse_bbox(argv[argpos] + 7, query))
+      {
+        std::cerr<<"For --bbox, please use west,south,east,north in degrees.\n";
+        abort = true;
+      }
+    }
+    else
+    {
+      std::cerr<<"Unknown argument: "<<argv[argpos]<<'\n';
+      abort = true;
+    }
+    ++argpos;
+  }
+  if (to == 0)
+    to = from;
+  if (archive_dir.empty() || (add == 0 && from == 0) || (add > 0 && from > 0) || to < from)
+    abort = true;
+  if (to >= from && to - from >= MAX_DIFFS_PER_REQUEST)
+  {
+    std::cerr<<"At most "<<MAX_DIFFS_PER_REQUEST<<" diffs can be requested at once.\n";
+    abort = true;
+  }
+  if (abort)
+  {
+    std::cerr<<"Usage: "<<argv[0]<<" --archive-dir=DIR --add=ID [--keep=N]\n"
+        "         stores the augmented diff ID read from stdin in the archive\n"
+        "         and removes all but the newest N diffs.\n"
+        "         Fails without storing anything if the diff has a remark.\n"
+        "       "<<argv[0]<<" --archive-dir=DIR --from=ID [--to=ID] [--bbox=WEST,SOUTH,EAST,NORTH]\n"
+        "         prints the actions of the augmented diffs from ID to ID touching the bounding box\n";
+    return 1;
+  }
+
+  try
+  {
+    if (add > 0)
+    {
+      if (!add_diff(archive_dir, add, keep, stdin))
+      {
+        std::cerr<<"The diff "<<add<<" has a remark, hence it is incomplete and has not been stored.\n";
+        return 1;
+      }
+    }
+    else
+      extract_diffs(archive_dir, from, to, bbox_given ? &query : 0);
+  }
+  catch (const File_Error& e)
+  {
+    std::cerr<<"File error caught: "<<e.error_number<<' '<<strerror(e.error_number)
+        <<' '<<e.filename<<' '<<e.origin<<'\n';
+    return 1;
+  }
+
+  return 0;
+}
@@ -20,6 +20,7 @@
 #define DE__OSM3S___OVERPASS_API__OSM_BACKEND__BASIC_UPDATER_H
 
 #include <algorithm>
+#include <iterator>
 #include <map>
 #include <set>
 #include <vector>
@@ -493,6 +494,39 @@ std::vector< std::pair< typename Element_Skeleton::Id_Type, Uint31_Index > > new
 }
 
 
+/* Adds the ids of all elements written by the update. These are the elements from the input
+ * and the elements that have changed implicitly because one of their members has moved. */
+template< typename Element_Skeleton >
+void add_changed_ids(const Data_By_Id< Element_Skeleton >& new_data,
+    const std::map< Uint31_Index, std::set< Element_Skeleton > >& attic_skeletons,
+    const std::map< Uint31_Index, std::set< Element_Skeleton > >& new_skeletons,
+    std::vector< typename Element_Skeleton::Id_Type >& changed_ids)
+{
+  for (typename std::vector< typename Data_By_Id< Element_Skeleton >::Entry >::const_iterator
+      it = new_data.data.begin(); it != new_data.data.end(); ++it)
+    changed_ids.push_back(it->elem.id);
+
+  for (typename std::map< Uint31_Index, std::set< Element_Skeleton > >::const_iterator
+      it = attic_skeletons.begin(); it != attic_skeletons.end(); ++it)
+  {
+    for (typename std::set< Element_Skeleton >::const_iterator it2 = it->second.begin();
+        it2 != it->second.end(); ++it2)
+      changed_ids.push_back(it2->id);
+  }
+
+  for (typename std::map< Uint31_Index, std::set< Element_Skeleton > >::const_iterator
+      it = new_skeletons.begin(); it != new_skeletons.end(); ++it)
+  {
+    for (typename std::set< Element_Skeleton >::const_iterator it2 = it->second.begin();
+        it2 != it->second.end(); ++it2)
+      changed_ids.push_back(it2->id);
+  }
+
+  std::sort(changed_ids.begin(), changed_ids.end());
+  changed_ids.erase(std::unique(changed_ids.begin(), changed_ids.end()), changed_ids.end());
+}
+
+
 template< typename Id_Type >
 void update_map_positions
     (std::vector< std::pair< Id_Type, Uint31_Index > > new_idx_positions,
@@ -517,6 +551,106 @@ void update_elements
 }
 
 
+/* Attic ways and relations are stored as deltas against the next newer version. To bound the chain
+ * a historic query has to expand, a version valid at the begin of a checkpoint period is stored in full. */
+const int ATTIC_CHECKPOINT_MONTHS = 3;
+
+inline bool attic_checkpoint_due(uint64 valid_since, uint64 valid_until)
+{
+  return (Timestamp::year(valid_since)*12 + Timestamp::month(valid_since) - 1)/ATTIC_CHECKPOINT_MONTHS
+      != (Timestamp::year(valid_until)*12 + Timestamp::month(valid_until) - 1)/ATTIC_CHECKPOINT_MONTHS;
+}
+
+
+/* A file derived from the file of some objects, like a reverse file, is only complete if it has been updated
+ * ever since that file got its first block. Hence it is only started together with that file,
+ * and databases from before stay without it. Index must be the index type of the objects file. */
+template< typename Index >
+bool derived_file_kept
+    (Transaction& transaction, const File_Properties& objects_properties, const File_Properties& derived_properties)
+{
+  return file_exists(transaction.get_db_dir()
+          + derived_properties.get_file_name_trunk() + derived_properties.get_data_suffix())
+      || ((File_Blocks_Index< Index >*)transaction.data_index(&objects_properties))->get_blocks().empty();
+}
+
+
+/* Keeps for every index the timestamp of the newest attic element.
+ * Date queries use it to skip the attic data of indexes that have not changed since the requested date. */
+template< typename Index, typename Object >
+void update_attic_newest_timestamps
+    (const std::map< Index, std::set< Object > >& new_attic_objects,
+     Transaction& transaction, const File_Properties& file_properties)
+{
+  std::map< Index, uint64 > newest;
+  for (typename std::map< Index, std::set< Object > >::const_iterator it = new_attic_objects.begin();
+       it != new_attic_objects.end(); ++it)
+  {
+    for (typename std::set< Object >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+    {
+      uint64& timestamp = newest[it->first];
+      timestamp = std::max(timestamp, it2->timestamp);
+    }
+  }
+
+  std::set< Index > req;
+  for (typename std::map< Index, uint64 >::const_iterator it = newest.begin(); it != newest.end(); ++it)
+    req.insert(it->first);
+
+  std::map< Index, std::set< Timestamp > > to_delete;
+  std::map< Index, std::set< Timestamp > > to_insert;
+  Block_Backend< Index, Timestamp, typename std::set< Index >::const_iterator >
+      db(transaction.data_index(&file_properties));
+  for (typename Block_Backend< Index, Timestamp, typename std::set< Index >::const_iterator >::Discrete_Iterator
+      it(db.discrete_begin(req.begin(), req.end())); !(it == db.discrete_end()); ++it)
+  {
+    uint64& timestamp = newest[it.index()];
+    if (it.object().timestamp < timestamp)
+      to_delete[it.index()].insert(it.object());
+    else
+      timestamp = 0;
+  }
+
+  for (typename std::map< Index, uint64 >::const_iterator it = newest.begin(); it != newest.end(); ++it)
+  {
+    if (it->second != 0)
+      to_insert[it->first].insert(Timestamp(it->second));
+  }
+  db.update(to_delete, to_insert);
+}
+
+
+// Removes the entries that would be deleted and inserted again, e.g. those of objects that have only moved.
+template< typename Index, typename Object >
+void cancel_out_equal_entries
+    (std::map< Index, std::set< Object > >& attic_objects, std::map< Index, std::set< Object > >& new_objects)
+{
+  typename std::map< Index, std::set< Object > >::iterator it = new_objects.begin();
+  while (it != new_objects.end())
+  {
+    typename std::map< Index, std::set< Object > >::iterator attic_it = attic_objects.find(it->first);
+    if (attic_it != attic_objects.end())
+    {
+      std::vector< Object > common;
+      std::set_intersection(it->second.begin(), it->second.end(), attic_it->second.begin(), attic_it->second.end(),
+          std::back_inserter(common));
+      for (typename std::vector< Object >::const_iterator it2 = common.begin(); it2 != common.end(); ++it2)
+      {
+        it->second.erase(*it2);
+        attic_it->second.erase(*it2);
+      }
+      if (attic_it->second.empty())
+        attic_objects.erase(attic_it);
+    }
+
+    if (it->second.empty())
+      new_objects.erase(it++);
+    else
+      ++it;
+  }
+}
+
+
 template< typename Id_Type >
 std::map< Id_Type, std::set< Uint31_Index > > get_existing_idx_lists
     (const std::vector< Id_Type >& ids,
@@ -0,0 +1,366 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "clone_manifest.h"
+#include "database_files.h"
+#include "../core/datatypes.h"
+#include "../core/settings.h"
+#include "../frontend/output.h"
+#include "../../template_db/block_backend.h"
+#include "../../template_db/dispatcher_client.h"
+#include "../../template_db/file_blocks.h"
+#include "../../template_db/transaction.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include <iostream>
+#include <list>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/* Verifies the checksums of the blocks of all data files and repairs bad blocks from a clone.
+
+The checksums are stored in the index of each data file, see File_Blocks_Index.
+A bad block is only replaced by a block of the clone that has the checksum from the local index.
+Hence the clone must have the very same block, as it is the case for a replica and the clone it stems from.
+The clone's index tells where to find the block, even if the clone has stored it at another position.
+*/
+
+
+namespace
+{
+  template< class TIndex >
+  struct Remote_Entry
+  {
+    Remote_Entry(const TIndex& index_, uint32 pos_, uint32 size_, uint32 checksum_)
+        : index(index_), pos(pos_), size(size_), checksum(checksum_) {}
+
+    TIndex index;
+    uint32 pos;
+    uint32 size;
+    uint32 checksum;
+  };
+
+
+  // Parses an index file in the format written by File_Blocks_Index
+  template< class TIndex >
+  void parse_remote_index(const std::string& data, const std::string& origin,
+      uint64& block_size, bool& checksums, std::vector< Remote_Entry< TIndex > >& entries)
+  {
+    const uint8* buf = (const uint8*)data.data();
+    if (data.size() < 8)
+      throw File_Error(EINVAL, origin, "block_checksums::parse_remote_index::1");
+    int32 version = *(const int32*)buf;
+    if (version != File_Blocks_Index< TIndex >::FILE_FORMAT_VERSION
+        && version != File_Blocks_Index< TIndex >::FILE_FORMAT_VERSION_CHECKSUMS)
+      throw File_Error(EINVAL, origin, "block_checksums::parse_remote_index::2");
+    block_size = 1ull<<*(buf + 4);
+    checksums = (version == File_Blocks_Index< TIndex >::FILE_FORMAT_VERSION_CHECKSUMS);
+
+    uint32 entry_head_size = (checksums ? 16 : 12);
+    uint64 pos = 8;
+    while (pos < data.size())
+    {
+      if (pos + entry_head_size + 4 > data.size()
+          || pos + entry_head_size + TIndex::size_of((void*)(buf + pos + entry_head_size)) > data.size())
+        throw File_Error(EINVAL, origin, "block_checksums::parse_remote_index::3");
+      entries.push_back(Remote_Entry< TIndex >(TIndex((void*)(buf + pos + entry_head_size)),
+          *(const uint32*)(buf + pos), *(const uint32*)(buf + pos + 4),
+          checksums ? *(const uint32*)(buf + pos + 12) : 0));
+      pos += entry_head_size + TIndex::size_of((void*)(buf + pos + entry_head_size));
+    }
+  }
+
+
+  struct Checksum_Run
+  {
+    Checksum_Run(Transaction& transaction_, bool add_, const Clone_Source* source_)
+        : transaction(transaction_), add(add_), source(source_), bad_blocks(0), repaired_blocks(0) {}
+
+    template< class TIndex >
+    void bin_file(const File_Properties& file_prop, bool derived);
+
+    // Map files have no checksums
+    template< typename Key, class TIndex >
+    void map_file(const File_Properties& file_prop) {}
+
+    Transaction& transaction;
+    bool add;
+    const Clone_Source* source;
+    uint64 bad_blocks;
+    uint64 repaired_blocks;
+
+  private:
+    template< class TIndex >
+    uint32 repair(const std::string& file_name, uint64 block_size,
+        const std::vector< File_Block_Index_Entry< TIndex > >& bad);
+  };
+
+
+  template< class TIndex >
+  void Checksum_Run::bin_file(const File_Properties& file_prop, bool derived)
+  {
+    std::string file_name = file_prop.get_file_name_trunk() + file_prop.get_data_suffix();
+    // Derived files and the files of other meta modes may be absent,
+    // and opening them writeable would create them
+    if (!file_exists(transaction.get_db_dir() + file_name))
+      return;
+
+    File_Blocks_Index< TIndex >& index = *(File_Blocks_Index< TIndex >*)transaction.data_index(&file_prop);
+    if (!index.has_checksums())
+    {
+      if (add)
+      {
+        File_Blocks< TIndex, typename std::set< TIndex >::const_iterator, Default_Range_Iterator< TIndex > >
+            blocks(&index);
+        std::cout<<file_name<<": added checksums to "<<blocks.add_checksums()<<" blocks\n";
+      }
+      else
+        std::cout<<file_name<<": no checksums\n";
+      return;
+    }
+
+    uint64 block_size = index.get_block_size();
+    Raw_File data_file(transaction.get_db_dir() + file_name, O_RDONLY, S_666, "Checksum_Run::process::1");
+    Void_Pointer< uint8 > buf(0);
+    uint32 buf_size = 0;
+    std::vector< File_Block_Index_Entry< TIndex > > bad;
+    for (typename std::list< File_Block_Index_Entry< TIndex > >::const_iterator it = index.get_blocks().begin();
+        it != index.get_blocks().end(); ++it)
+    {
+      if (buf_size < block_size * it->size)
+      {
+        buf_size = block_size * it->size;
+        buf.resize(buf_size);
+      }
+      data_file.read_at(buf.ptr, block_size * it->size, it->pos * block_size, "Checksum_Run::process::2");
+      if (crc32c(buf.ptr, block_size * it->size) != it->checksum)
+      {
+        std::cout<<file_name<<": bad block at "<<it->pos<<'\n';
+        bad.push_back(*it);
+      }
+    }
+
+    bad_blocks += bad.size();
+    uint32 repaired = 0;
+    if (source && !bad.empty())
+      repaired = repair(file_name, block_size, bad);
+    repaired_blocks += repaired;
+
+    std::cout<<file_name<<": "<<index.get_blocks().size()<<" blocks, "<<bad.size()<<" bad";
+    if (source)
+      std::cout<<", "<<repaired<<" repaired";
+    std::cout<<'\n';
+  }
+
+
+  template< class TIndex >
+  uint32 Checksum_Run::repair(const std::string& file_name, uint64 block_size,
+      const std::vector< File_Block_Index_Entry< TIndex > >& bad)
+  {
+    uint64 remote_block_size = 0;
+    bool remote_checksums = false;
+    std::vector< Remote_Entry< TIndex > > remote;
+    parse_remote_index(source->fetch(file_name + ".idx"), file_name + ".idx",
+        remote_block_size, remote_checksums, remote);
+    if (remote_block_size != block_size)
+    {
+      std::cout<<file_name<<": the clone has a different block size\n";
+      return 0;
+    }
+
+    // Without checksums in the clone's index, the blocks with the same index are candidates
+    std::multimap< uint32, const Remote_Entry< TIndex >* > remote_by_checksum;
+    std::multimap< TIndex, const Remote_Entry< TIndex >* > remote_by_index;
+    for (typename std::vector< Remote_Entry< TIndex > >::const_iterator it = remote.begin(); it != remote.end(); ++it)
+    {
+      if (remote_checksums)
+        remote_by_checksum.insert(std::make_pair(it->checksum, &*it));
+      else
+        remote_by_index.insert(std::make_pair(it->index, &*it));
+    }
+
+    Raw_File data_file(transaction.get_db_dir() + file_name, O_RDWR, S_666, "Checksum_Run::repair::1");
+    uint32 repaired = 0;
+    for (typename std::vector< File_Block_Index_Entry< TIndex > >::const_iterator it = bad.begin();
+        it != bad.end(); ++it)
+    {
+      std::vector< const Remote_Entry< TIndex >* > candidates;
+      if (remote_checksums)
+      {
+        std::pair< typename std::multimap< uint32, const Remote_Entry< TIndex >* >::const_iterator,
+            typename std::multimap< uint32, const Remote_Entry< TIndex >* >::const_iterator >
+            range = remote_by_checksum.equal_range(it->checksum);
+        for (; range.first != range.second; ++range.first)
+          candidates.push_back(range.first->second);
+      }
+      else
+      {
+        std::pair< typename std::multimap< TIndex, const Remote_Entry< TIndex >* >::const_iterator,
+            typename std::multimap< TIndex, const Remote_Entry< TIndex >* >::const_iterator >
+            range = remote_by_index.equal_range(it->index);
+        for (; range.first != range.second; ++range.first)
+          candidates.push_back(range.first->second);
+      }
+
+      bool found = false;
+      for (typename std::vector< const Remote_Entry< TIndex >* >::const_iterator it_cand = candidates.begin();
+          !found && it_cand != candidates.end(); ++it_cand)
+      {
+        const Remote_Entry< TIndex >* it_remote = *it_cand;
+        if (it_remote->size != it->size)
+          continue;
+
+        std::string data = source->fetch(file_name, it_remote->pos * block_size, it->size * block_size);
+        if (crc32c(data.data(), data.size()) != it->checksum)
+          continue;
+
+        data_file.seek(it->pos * block_size, "Checksum_Run::repair::2");
+        data_file.write((uint8*)data.data(), data.size(), "Checksum_Run::repair::3");
+        std::cout<<file_name<<": repaired block at "<<it->pos<<'\n';
+        found = true;
+      }
+
+      if (found)
+        ++repaired;
+      else
+        std::cout<<file_name<<": block at "<<it->pos<<" not found in the clone\n";
+    }
+    return repaired;
+  }
+
+
+  void process_files(Checksum_Run& run, bool areas)
+  {
+    if (areas)
+      visit_area_files(run);
+    else
+      visit_osm_files(run);
+  }
+}
+
+
+int main(int argc, char* argv[])
+{
+  std::string db_dir;
+  std::string source;
+  bool add = false;
+  bool areas = false;
+  bool abort = false;
+
+  int argpos = 1;
+  while (argpos < argc)
+  {
+    if (!(strncmp(argv[argpos], "--db-dir=", 9)))
+    {
+      db_dir = ((std::string)argv[argpos]).substr(9);
+      if ((db_dir.size() > 0) && (db_dir[db_dir.size()-1] != '/'))
+        db_dir += '/';
+    }
+    else if (!(strcmp(argv[argpos], "--add")))
+      add = true;
+    else if (!(strncmp(argv[argpos], "--repair-from=", 14)))
+      source = ((std::string)argv[argpos]).substr(14);
+    else if (!(strcmp(argv[argpos], "--areas")))
+      areas = true;
+    else
+    {
+      std::cerr<<"Unknown argument: "<<argv[argpos]<<'\n';
+      abort = true;
+    }
+    ++argpos;
+  }
+  if (abort)
+  {
+    std::cerr<<"Usage: "<<argv[0]<<" [--db-dir=DIR] [--add] [--repair-from=(DIR|URL)] [--areas]\n"
+        "  Verifies the checksums of the blocks of all data files.\n"
+        "  --add adds checksums to the files that have none yet.\n"
+        "  --repair-from replaces bad blocks by the same blocks of the clone at DIR or URL.\n"
+        "  --areas processes the area files instead of the other data files.\n"
+        "  Without --db-dir, it runs as a write transaction through the dispatcher.\n";
+    return 1;
+  }
+
+  try
+  {
+    Owner< Clone_Source > clone_source(source.empty() ? 0 : new Clone_Source(source));
+    uint64 unrepaired = 0;
+
+    const std::string& shared_name =
+        areas ? area_settings().shared_name : osm_base_settings().shared_name;
+    if (db_dir.empty())
+    {
+      Dispatcher_Client dispatcher_client(shared_name);
+      Logger logger(dispatcher_client.get_db_dir());
+      logger.annotated_log("write_start() start block checksums");
+      dispatcher_client.write_start();
+      logger.annotated_log("write_start() end");
+      try
+      {
+        Nonsynced_Transaction transaction(true, true, dispatcher_client.get_db_dir(), "");
+        Checksum_Run run(transaction, add, clone_source ? &*clone_source : 0);
+        process_files(run, areas);
+        unrepaired = run.bad_blocks - run.repaired_blocks;
+      }
+      catch (...)
+      {
+        logger.annotated_log("write_rollback() start");
+        dispatcher_client.write_rollback();
+        logger.annotated_log("write_rollback() end");
+        throw;
+      }
+      logger.annotated_log("write_commit() start");
+      dispatcher_client.write_commit();
+      logger.annotated_log("write_commit() end");
+    }
+    else
+    {
+      if (file_present(db_dir + shared_name))
+        throw Context_Error("File " + db_dir + shared_name + " present, "
+            "which indicates a running dispatcher. Delete file if no dispatcher is running.");
+      Nonsynced_Transaction transaction(add, false, db_dir, "");
+      Checksum_Run run(transaction, add, clone_source ? &*clone_source : 0);
+      process_files(run, areas);
+      unrepaired = run.bad_blocks - run.repaired_blocks;
+    }
+
+    if (unrepaired > 0)
+    {
+      std::cerr<<unrepaired<<" bad blocks remain.\n";
+      return 4;
+    }
+  }
+  catch(Context_Error e)
+  {
+    std::cerr<<"Context error: "<<e.message<<'\n';
+    return 3;
+  }
+  catch (File_Error e)
+  {
+    report_file_error(e);
+    return 2;
+  }
+
+  return 0;
+}
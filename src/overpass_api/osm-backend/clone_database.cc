@@ -17,6 +17,8 @@
  */
 
 #include "clone_database.h"
+#include "clone_manifest.h"
+#include "database_files.h"
 #include "../core/datatypes.h"
 #include "../core/settings.h"
 #include "../../template_db/block_backend.h"
@@ -55,6 +57,9 @@ void clone_bin_file(const File_Properties& src_file_prop, const File_Properties&
 
     File_Blocks_Index< TIndex > dest_idx(dest_file_prop, true, false, dest_db_dir, "",
         clone_settings.compression_method);
+    // The clone has checksums if the source has, since it is still empty
+    if (src_idx.has_checksums())
+      dest_idx.enable_checksums();
     File_Blocks< TIndex, typename std::set< TIndex >::const_iterator, Default_Range_Iterator< TIndex > >
 	dest_file(&dest_idx);
 
@@ -74,6 +79,9 @@ void clone_bin_file(const File_Properties& src_file_prop, const File_Properties&
       ++src_it;
       dest_it = dest_file.discrete_end();
     }
+
+    write_clone_manifest(dest_db_dir + dest_file_prop.get_file_name_trunk() + dest_file_prop.get_data_suffix(),
+        dest_idx.get_block_size());
   }
   catch (File_Error e)
   {
@@ -82,6 +90,16 @@ void clone_bin_file(const File_Properties& src_file_prop, const File_Properties&
 }
 
 
+// A clone must lack a derived file if the source lacks it, see derived_file_kept()
+template< class TIndex >
+void clone_bin_file_if_kept(const File_Properties& file_prop,
+    Transaction& transaction, std::string dest_db_dir, const Clone_Settings& clone_settings)
+{
+  if (file_exists(transaction.get_db_dir() + file_prop.get_file_name_trunk() + file_prop.get_data_suffix()))
+    clone_bin_file< TIndex >(file_prop, file_prop, transaction, dest_db_dir, clone_settings);
+}
+
+
 template< typename Key, typename TIndex >
 void clone_map_file(const File_Properties& file_prop, Transaction& transaction, std::string dest_db_dir, Clone_Settings clone_settings)
 {
@@ -91,21 +109,27 @@ void clone_map_file(const File_Properties& file_prop, Transaction& transaction,
     Random_File< Key, TIndex > src_file(&src_idx);
 
     Random_File_Index dest_idx(file_prop, true, false, dest_db_dir, "", clone_settings.map_compression_method);
-    Random_File< Key, TIndex > dest_file(&dest_idx);
-
-    for (std::vector< uint32 >::size_type i = 0; i < src_idx.get_blocks().size(); ++i)
     {
-      if (src_idx.get_blocks()[i].pos != src_idx.npos)
+      Random_File< Key, TIndex > dest_file(&dest_idx);
+
+      for (std::vector< uint32 >::size_type i = 0; i < src_idx.get_blocks().size(); ++i)
       {
-	for (uint32 j = 0; j < src_idx.get_block_size()*src_idx.get_compression_factor()/TIndex::max_size_of(); ++j)
-	{
-	  TIndex val =
-	      src_file.get(i*(src_idx.get_block_size()*src_idx.get_compression_factor()/TIndex::max_size_of()) + j);
-	  if (!(val == TIndex(uint32(0))))
-	    dest_file.put(i*(src_idx.get_block_size()*src_idx.get_compression_factor()/TIndex::max_size_of()) + j, val);
-	}
+        if (src_idx.get_blocks()[i].pos != src_idx.npos)
+        {
+          for (uint32 j = 0; j < src_idx.get_block_size()*src_idx.get_compression_factor()/TIndex::max_size_of(); ++j)
+          {
+            TIndex val =
+                src_file.get(i*(src_idx.get_block_size()*src_idx.get_compression_factor()/TIndex::max_size_of()) + j);
+            if (!(val == TIndex(uint32(0))))
+              dest_file.put(i*(src_idx.get_block_size()*src_idx.get_compression_factor()/TIndex::max_size_of()) + j, val);
+          }
+        }
       }
     }
+
+    // The map is written when dest_file is destroyed
+    write_clone_manifest(dest_db_dir + file_prop.get_file_name_trunk() + file_prop.get_id_suffix(),
+        dest_idx.get_block_size());
   }
   catch (File_Error e)
   {
@@ -114,103 +138,44 @@ void clone_map_file(const File_Properties& file_prop, Transaction& transaction,
 }
 
 
-void clone_database(Transaction& transaction, const std::string& dest_db_dir, const Clone_Settings& clone_settings)
+namespace
+{
+  struct Clone_Visitor
+  {
+    Clone_Visitor(Transaction& transaction_, const std::string& dest_db_dir_, const Clone_Settings& clone_settings_)
+        : transaction(transaction_), dest_db_dir(dest_db_dir_), clone_settings(clone_settings_) {}
+
+    template< class TIndex >
+    void bin_file(const File_Properties& file_prop, bool derived)
+    {
+      if (derived)
+        clone_bin_file_if_kept< TIndex >(file_prop, transaction, dest_db_dir, clone_settings);
+      else
+        clone_bin_file< TIndex >(file_prop, file_prop, transaction, dest_db_dir, clone_settings);
+    }
+
+    template< typename Key, class TIndex >
+    void map_file(const File_Properties& file_prop)
+    {
+      clone_map_file< Key, TIndex >(file_prop, transaction, dest_db_dir, clone_settings);
+    }
+
+    Transaction& transaction;
+    const std::string& dest_db_dir;
+    const Clone_Settings& clone_settings;
+  };
+}
+
+
+void clone_database(Transaction& transaction, Transaction* area_transaction,
+    const std::string& dest_db_dir, const Clone_Settings& clone_settings)
 {
-  clone_bin_file< Uint32_Index >(*osm_base_settings().NODES, *osm_base_settings().NODES,
-				 transaction, dest_db_dir, clone_settings);
-  clone_map_file< Node_Skeleton::Id_Type, Uint32_Index >(*osm_base_settings().NODES, transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Tag_Index_Local >(*osm_base_settings().NODE_TAGS_LOCAL, *osm_base_settings().NODE_TAGS_LOCAL,
-				    transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Tag_Index_Global >(*osm_base_settings().NODE_TAGS_GLOBAL, *osm_base_settings().NODE_TAGS_GLOBAL,
-				     transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Uint32_Index >(*osm_base_settings().NODE_KEYS, *osm_base_settings().NODE_KEYS,
-				 transaction, dest_db_dir, clone_settings);
-
-  clone_bin_file< Uint31_Index >(*osm_base_settings().WAYS, *osm_base_settings().WAYS,
-				 transaction, dest_db_dir, clone_settings);
-  clone_map_file< Way_Skeleton::Id_Type, Uint31_Index >(*osm_base_settings().WAYS, transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Tag_Index_Local >(*osm_base_settings().WAY_TAGS_LOCAL, *osm_base_settings().WAY_TAGS_LOCAL,
-				    transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Tag_Index_Global >(*osm_base_settings().WAY_TAGS_GLOBAL, *osm_base_settings().WAY_TAGS_GLOBAL,
-				     transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Uint32_Index >(*osm_base_settings().WAY_KEYS, *osm_base_settings().WAY_KEYS,
-				 transaction, dest_db_dir, clone_settings);
-
-  clone_bin_file< Uint31_Index >(*osm_base_settings().RELATIONS, *osm_base_settings().RELATIONS,
-				 transaction, dest_db_dir, clone_settings);
-  clone_map_file< Relation_Skeleton::Id_Type, Uint31_Index >(
-      *osm_base_settings().RELATIONS, transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Uint32_Index >(*osm_base_settings().RELATION_ROLES, *osm_base_settings().RELATION_ROLES,
-				 transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Tag_Index_Local >(
-      *osm_base_settings().RELATION_TAGS_LOCAL, *osm_base_settings().RELATION_TAGS_LOCAL,
-      transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Tag_Index_Global >(
-      *osm_base_settings().RELATION_TAGS_GLOBAL, *osm_base_settings().RELATION_TAGS_GLOBAL,
-      transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Uint32_Index >(*osm_base_settings().RELATION_KEYS, *osm_base_settings().RELATION_KEYS,
-				 transaction, dest_db_dir, clone_settings);
-
-  clone_bin_file< Uint31_Index >(*meta_settings().NODES_META, *meta_settings().NODES_META,
-				 transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Uint31_Index >(*meta_settings().WAYS_META, *meta_settings().WAYS_META,
-				 transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Uint31_Index >(*meta_settings().RELATIONS_META, *meta_settings().RELATIONS_META,
-				 transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Uint32_Index >(*meta_settings().USER_DATA, *meta_settings().USER_DATA,
-				 transaction, dest_db_dir, clone_settings);
-  clone_bin_file< Uint32_Index >(*meta_settings().USER_INDICES, *meta_settings().USER_INDICES,
-				 transaction, dest_db_dir, clone_settings);
+  Clone_Visitor visitor(transaction, dest_db_dir, clone_settings);
+  visit_osm_files(visitor);
 
+  if (area_transaction)
   {
-    clone_bin_file< Uint31_Index >(*attic_settings().NODES, *attic_settings().NODES,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_map_file< Node_Skeleton::Id_Type, Uint31_Index >(*attic_settings().NODES, transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Uint31_Index >(*attic_settings().NODES_UNDELETED, *attic_settings().NODES_UNDELETED,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Node::Id_Type >(*attic_settings().NODE_IDX_LIST, *attic_settings().NODE_IDX_LIST,
-                                    transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Tag_Index_Local >(*attic_settings().NODE_TAGS_LOCAL, *attic_settings().NODE_TAGS_LOCAL,
-                                      transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Tag_Index_Global >(*attic_settings().NODE_TAGS_GLOBAL, *attic_settings().NODE_TAGS_GLOBAL,
-                                       transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Uint31_Index >(*attic_settings().NODES_META, *attic_settings().NODES_META,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Timestamp >(*attic_settings().NODE_CHANGELOG, *attic_settings().NODE_CHANGELOG,
-                                transaction, dest_db_dir, clone_settings);
-
-    clone_bin_file< Uint31_Index >(*attic_settings().WAYS, *attic_settings().WAYS,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_map_file< Way_Skeleton::Id_Type, Uint31_Index >(*attic_settings().WAYS, transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Uint31_Index >(*attic_settings().WAYS_UNDELETED, *attic_settings().WAYS_UNDELETED,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Way::Id_Type >(*attic_settings().WAY_IDX_LIST, *attic_settings().WAY_IDX_LIST,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Tag_Index_Local >(*attic_settings().WAY_TAGS_LOCAL, *attic_settings().WAY_TAGS_LOCAL,
-                                      transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Tag_Index_Global >(*attic_settings().WAY_TAGS_GLOBAL, *attic_settings().WAY_TAGS_GLOBAL,
-                                       transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Uint31_Index >(*attic_settings().WAYS_META, *attic_settings().WAYS_META,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Timestamp >(*attic_settings().WAY_CHANGELOG, *attic_settings().WAY_CHANGELOG,
-                                transaction, dest_db_dir, clone_settings);
-
-    clone_bin_file< Uint31_Index >(*attic_settings().RELATIONS, *attic_settings().RELATIONS,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_map_file< Relation_Skeleton::Id_Type, Uint31_Index >(*attic_settings().RELATIONS, transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Uint31_Index >(*attic_settings().RELATIONS_UNDELETED, *attic_settings().RELATIONS_UNDELETED,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Relation::Id_Type >(*attic_settings().RELATION_IDX_LIST, *attic_settings().RELATION_IDX_LIST,
-                                        transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Tag_Index_Local >(
-        *attic_settings().RELATION_TAGS_LOCAL, *attic_settings().RELATION_TAGS_LOCAL,
-        transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Tag_Index_Global >(
-        *attic_settings().RELATION_TAGS_GLOBAL, *attic_settings().RELATION_TAGS_GLOBAL,
-        transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Uint31_Index >(*attic_settings().RELATIONS_META, *attic_settings().RELATIONS_META,
-                                   transaction, dest_db_dir, clone_settings);
-    clone_bin_file< Timestamp >(*attic_settings().RELATION_CHANGELOG, *attic_settings().RELATION_CHANGELOG,
-                                transaction, dest_db_dir, clone_settings);
+    Clone_Visitor area_visitor(*area_transaction, dest_db_dir, clone_settings);
+    visit_area_files(area_visitor);
   }
 }
@@ -25,7 +25,9 @@
 #include <string>
 
 
-void clone_database(Transaction& transaction, const std::string& dest_db_dir, const Clone_Settings& clone_settings);
+// The area files are cloned only if area_transaction is given
+void clone_database(Transaction& transaction, Transaction* area_transaction,
+    const std::string& dest_db_dir, const Clone_Settings& clone_settings);
 
 
 #endif
@@ -0,0 +1,192 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "clone_manifest.h"
+#include "../../template_db/types.h"
+#include "../core/datatypes.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/* Brings a file of a local replica to the state of a clone
+
+The clone has next to each data and map file a manifest with the hashes of the file's blocks.
+Every block of the clone that is found in the local copy of the file is taken from there,
+and only the other blocks are fetched from the clone, either from a directory or by HTTP range requests.
+The new file is assembled beside the local copy and replaces it when it is complete.
+*/
+
+
+namespace
+{
+  // Larger runs of missing blocks are fetched in several requests
+  const uint64 MAX_FETCH_SIZE = 64*1024*1024;
+
+
+  struct Delta_Stats
+  {
+    Delta_Stats() : blocks(0), fetched_blocks(0), fetched_bytes(0) {}
+
+    uint64 blocks;
+    uint64 fetched_blocks;
+    uint64 fetched_bytes;
+  };
+
+
+  void write_at(const Raw_File& file, const uint8* data, uint64 size, uint64 pos)
+  {
+    file.seek(pos, "clone_delta::write_at::1");
+    file.write((uint8*)data, size, "clone_delta::write_at::2");
+  }
+
+
+  Delta_Stats update_file(const std::string& db_dir, const std::string& file_name, const Clone_Source& source)
+  {
+    Clone_Manifest manifest;
+    manifest.read(source.fetch(file_name + ".manifest"), file_name + ".manifest");
+
+    // Index the blocks of the local copy by their hashes
+    std::string local_file_name = db_dir + file_name;
+    Clone_Manifest local = Clone_Manifest::of_file(local_file_name, manifest.block_size);
+    std::map< Block_Hash, uint64 > local_blocks;
+    for (uint64 i = 0; i < local.hashes.size(); ++i)
+      local_blocks.insert(std::make_pair(local.hashes[i], i));
+
+    Delta_Stats stats;
+    stats.blocks = manifest.hashes.size();
+    try
+    {
+      Raw_File dest(local_file_name + ".delta", O_RDWR|O_CREAT|O_TRUNC, S_666, "clone_delta::update_file::1");
+      Void_Pointer< uint8 > buf(manifest.block_size);
+      Owner< Raw_File > local_file(local.hashes.empty() ? 0
+          : new Raw_File(local_file_name, O_RDONLY, S_666, "clone_delta::update_file::2"));
+
+      uint64 i = 0;
+      while (i < manifest.hashes.size())
+      {
+        uint64 pos = i * manifest.block_size;
+        std::map< Block_Hash, uint64 >::const_iterator it = local_blocks.find(manifest.hashes[i]);
+        if (it != local_blocks.end())
+        {
+          uint64 size = std::min(manifest.block_size, local.file_size - it->second * manifest.block_size);
+          local_file->read_at(buf.ptr, size, it->second * manifest.block_size, "clone_delta::update_file::3");
+          write_at(dest, buf.ptr, size, pos);
+          ++i;
+          continue;
+        }
+
+        // Fetch the whole run of missing blocks at once
+        uint64 end = i + 1;
+        while (end < manifest.hashes.size() && (end - i) * manifest.block_size < MAX_FETCH_SIZE
+            && local_blocks.find(manifest.hashes[end]) == local_blocks.end())
+          ++end;
+        uint64 size = std::min(end * manifest.block_size, manifest.file_size) - pos;
+        std::string data = source.fetch(file_name, pos, size);
+        for (uint64 j = 0; j < end - i; ++j)
+        {
+          uint64 offset = j * manifest.block_size;
+          if (block_hash((const uint8*)data.data() + offset, std::min(manifest.block_size, size - offset))
+              != manifest.hashes[i + j])
+            throw File_Error(EIO, file_name, "clone_delta::update_file::4");
+        }
+        write_at(dest, (const uint8*)data.data(), size, pos);
+
+        stats.fetched_blocks += end - i;
+        stats.fetched_bytes += size;
+        i = end;
+      }
+    }
+    catch (...)
+    {
+      // Leave no partial file behind, whatever went wrong
+      remove((local_file_name + ".delta").c_str());
+      throw;
+    }
+
+    if (rename((local_file_name + ".delta").c_str(), local_file_name.c_str()))
+      throw File_Error(errno, local_file_name, "clone_delta::update_file::5");
+    return stats;
+  }
+}
+
+
+int main(int argc, char* argv[])
+{
+  std::string db_dir;
+  std::string source;
+  std::vector< std::string > files;
+
+  int argpos = 1;
+  while (argpos < argc)
+  {
+    if (!(strncmp(argv[argpos], "--db-dir=", 9)))
+    {
+      db_dir = ((std::string)argv[argpos]).substr(9);
+      if ((db_dir.size() > 0) && (db_dir[db_dir.size()-1] != '/'))
+        db_dir += '/';
+    }
+    else if (!(strncmp(argv[argpos], "--source=", 9)))
+      source = ((std::string)argv[argpos]).substr(9);
+    else if (!(strncmp(argv[argpos], "--file=", 7)))
+      files.push_back(((std::string)argv[argpos]).substr(7));
+    else
+    {
+      std::cerr<<"Unknown argument: "<<argv[argpos]<<'\n';
+      files.clear();
+      break;
+    }
+    ++argpos;
+  }
+
+  if (db_dir.empty() || source.empty() || files.empty())
+  {
+    std::cerr<<"Usage: "<<argv[0]<<" --db-dir=DIR --source=(DIR|URL) --file=FILE [--file=FILE ..]\n"
+        "  Updates the given data and map files in DIR to the state of the clone at DIR or URL.\n"
+        "  Only blocks that are not already present in the local files are fetched.\n";
+    return 1;
+  }
+
+  Clone_Source clone_source(source);
+  for (std::vector< std::string >::const_iterator it = files.begin(); it != files.end(); ++it)
+  {
+    try
+    {
+      Delta_Stats stats = update_file(db_dir, *it, clone_source);
+      std::cout<<*it<<": fetched "<<stats.fetched_blocks<<" of "<<stats.blocks<<" blocks, "
+          <<stats.fetched_bytes<<" bytes\n";
+    }
+    catch (const File_Error& e)
+    {
+      std::cerr<<"File error caught: "<<e.error_number<<' '<<strerror(e.error_number)
+          <<' '<<e.filename<<' '<<e.origin<<'\n';
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,194 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "clone_manifest.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+  uint64 rotl(uint64 x, int r) { return (x<<r) | (x>>(64-r)); }
+
+  uint64 final_mix(uint64 h)
+  {
+    h ^= h>>33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h>>33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h>>33;
+    return h;
+  }
+}
+
+
+// Two independent lanes of a multiply-rotate hash over 64 bit words
+Block_Hash block_hash(const uint8* data, uint64 size)
+{
+  uint64 h1 = 0x9e3779b97f4a7c15ull ^ size;
+  uint64 h2 = 0xc2b2ae3d27d4eb4full ^ size;
+  uint64 i = 0;
+  for (; i + 8 <= size; i += 8)
+  {
+    uint64 word;
+    memcpy(&word, data + i, 8);
+    h1 = rotl(h1 ^ (word * 0x87c37b91114253d5ull), 31) * 0x4cf5ad432745937full;
+    h2 = rotl(h2 ^ (word * 0x52dce729da3ed7f1ull), 29) * 0x38495ab5ff51afd7ull;
+  }
+  if (i < size)
+  {
+    uint64 word = 0;
+    memcpy(&word, data + i, size - i);
+    h1 = rotl(h1 ^ (word * 0x87c37b91114253d5ull), 31) * 0x4cf5ad432745937full;
+    h2 = rotl(h2 ^ (word * 0x52dce729da3ed7f1ull), 29) * 0x38495ab5ff51afd7ull;
+  }
+  return Block_Hash(final_mix(h1 + h2), final_mix(h2 ^ rotl(h1, 17)));
+}
+
+
+Clone_Manifest Clone_Manifest::of_file(const std::string& file_name, uint64 block_size)
+{
+  Clone_Manifest result;
+  result.block_size = block_size;
+  if (!file_exists(file_name))
+    return result;
+
+  Raw_File file(file_name, O_RDONLY, S_666, "Clone_Manifest::of_file::1");
+  result.file_size = file.size("Clone_Manifest::of_file::2");
+  result.hashes.reserve((result.file_size + block_size - 1) / block_size);
+
+  // Read many blocks at once to keep the number of system calls low on large files
+  uint64 chunk_size = std::max(block_size, (uint64)(16*1024*1024) / block_size * block_size);
+  Void_Pointer< uint8 > buf(chunk_size);
+  for (uint64 pos = 0; pos < result.file_size; pos += chunk_size)
+  {
+    uint64 size = std::min(chunk_size, result.file_size - pos);
+    file.read_at(buf.ptr, size, pos, "Clone_Manifest::of_file::3");
+    for (uint64 i = 0; i < size; i += block_size)
+      result.hashes.push_back(block_hash(buf.ptr + i, std::min(block_size, size - i)));
+  }
+
+  return result;
+}
+
+
+void Clone_Manifest::write(const std::string& file_name) const
+{
+  std::vector< uint64 > buf;
+  buf.reserve(2 + 2*hashes.size());
+  buf.push_back(block_size);
+  buf.push_back(file_size);
+  for (std::vector< Block_Hash >::const_iterator it = hashes.begin(); it != hashes.end(); ++it)
+  {
+    buf.push_back(it->first);
+    buf.push_back(it->second);
+  }
+
+  Raw_File file(file_name, O_RDWR|O_CREAT|O_TRUNC, S_666, "Clone_Manifest::write::1");
+  file.write((uint8*)&buf[0], buf.size()*sizeof(uint64), "Clone_Manifest::write::2");
+}
+
+
+void Clone_Manifest::read(const std::string& data, const std::string& origin)
+{
+  const uint64* buf = (const uint64*)data.data();
+  if (data.size() < 2*sizeof(uint64) || data.size() % (2*sizeof(uint64)) != 0 || buf[0] == 0
+      || (buf[1] + buf[0] - 1) / buf[0] != data.size() / (2*sizeof(uint64)) - 1)
+    throw File_Error(EINVAL, origin, "Clone_Manifest::read::1");
+
+  block_size = buf[0];
+  file_size = buf[1];
+  hashes.clear();
+  hashes.reserve(data.size() / (2*sizeof(uint64)) - 1);
+  for (uint64 i = 2; i < data.size() / sizeof(uint64); i += 2)
+    hashes.push_back(Block_Hash(buf[i], buf[i+1]));
+}
+
+
+void write_clone_manifest(const std::string& file_name, uint64 block_size)
+{
+  Clone_Manifest::of_file(file_name, block_size).write(file_name + ".manifest");
+}
+
+
+std::string Clone_Source::fetch(const std::string& file_name) const
+{
+  if (remote)
+    return fetch_by_curl(file_name, "");
+
+  Raw_File file(base + file_name, O_RDONLY, S_666, "Clone_Source::fetch::1");
+  std::string result(file.size("Clone_Source::fetch::2"), '\0');
+  if (!result.empty())
+    file.read((uint8*)&result[0], result.size(), "Clone_Source::fetch::3");
+  return result;
+}
+
+
+std::string Clone_Source::fetch(const std::string& file_name, uint64 pos, uint64 size) const
+{
+  std::string result;
+  if (remote)
+  {
+    char range[64];
+    snprintf(range, sizeof(range), "%llu-%llu", (unsigned long long)pos, (unsigned long long)(pos + size - 1));
+    result = fetch_by_curl(file_name, range);
+  }
+  else
+  {
+    Raw_File file(base + file_name, O_RDONLY, S_666, "Clone_Source::fetch::4");
+    result.assign(size, '\0');
+    file.read_at((uint8*)&result[0], size, pos, "Clone_Source::fetch::5");
+  }
+
+  if (result.size() != size)
+    throw File_Error(EIO, base + file_name, "Clone_Source::fetch::6");
+  return result;
+}
+
+
+std::string Clone_Source::fetch_by_curl(const std::string& file_name, const std::string& range) const
+{
+  if ((base + file_name).find('\'') != std::string::npos)
+    throw File_Error(EINVAL, base + file_name, "Clone_Source::fetch_by_curl::1");
+
+  std::string command = "curl -sf ";
+  if (!range.empty())
+    command += "-r " + range + " ";
+  command += "'" + base + file_name + "'";
+
+  FILE* pipe = popen(command.c_str(), "r");
+  if (!pipe)
+    throw File_Error(errno, base + file_name, "Clone_Source::fetch_by_curl::2");
+
+  std::string result;
+  char buf[64*1024];
+  size_t size = 0;
+  while ((size = fread(buf, 1, sizeof(buf), pipe)) > 0)
+    result.append(buf, size);
+  if (pclose(pipe) != 0)
+    throw File_Error(EIO, base + file_name, "Clone_Source::fetch_by_curl::3");
+
+  return result;
+}
@@ -0,0 +1,84 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__OSM_BACKEND__CLONE_MANIFEST_H
+#define DE__OSM3S___OVERPASS_API__OSM_BACKEND__CLONE_MANIFEST_H
+
+#include "../../template_db/types.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+typedef std::pair< uint64, uint64 > Block_Hash;
+
+Block_Hash block_hash(const uint8* data, uint64 size);
+
+
+/* The manifest of a cloned file has the hash of each block of the file.
+ * All blocks of the data and map files start at multiples of the block size of the file.
+ * Hence a replica can find any block of the clone that it already has in its own copy,
+ * even if the block has moved because a block before it has grown or shrunk.
+ *
+ * The manifest is stored next to the file with the suffix ".manifest" as
+ * the block size, the file size and then the hashes, all as 64 bit integers. */
+struct Clone_Manifest
+{
+  Clone_Manifest() : block_size(0), file_size(0) {}
+
+  uint64 block_size;
+  uint64 file_size;
+  std::vector< Block_Hash > hashes;
+
+  // Computes the manifest of an existing file. A missing file has an empty manifest.
+  static Clone_Manifest of_file(const std::string& file_name, uint64 block_size);
+
+  void write(const std::string& file_name) const;
+  // Throws a File_Error if the data is not a valid manifest
+  void read(const std::string& data, const std::string& origin);
+};
+
+
+// Writes the manifest of the given file to file_name + ".manifest"
+void write_clone_manifest(const std::string& file_name, uint64 block_size);
+
+
+// Fetches files or parts of files of a clone, either from a directory or by HTTP (range) requests with curl.
+class Clone_Source
+{
+public:
+  Clone_Source(const std::string& base_) : base(base_)
+  {
+    if (!base.empty() && base[base.size()-1] != '/')
+      base += '/';
+    remote = (base.substr(0, 7) == "http://" || base.substr(0, 8) == "https://");
+  }
+
+  std::string fetch(const std::string& file_name) const;
+  std::string fetch(const std::string& file_name, uint64 pos, uint64 size) const;
+
+private:
+  std::string base;
+  bool remote;
+
+  std::string fetch_by_curl(const std::string& file_name, const std::string& range) const;
+};
+
+
+#endif
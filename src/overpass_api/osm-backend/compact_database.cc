@@ -0,0 +1,253 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database_files.h"
+#include "../core/datatypes.h"
+#include "../core/settings.h"
+#include "../frontend/output.h"
+#include "../../template_db/block_backend.h"
+#include "../../template_db/dispatcher_client.h"
+#include "../../template_db/file_blocks.h"
+#include "../../template_db/transaction.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+
+
+/* Rewrites the data files of the database such that their blocks are stored in index order.
+
+Each batch is a write transaction of its own. Readers keep their snapshot,
+because a batch writes only into space that no reader refers to.
+Blocks that are in the way are moved to the end of the file in one batch
+and the space they leave is filled in a later batch.
+*/
+
+
+namespace
+{
+  // Pause before a batch if the previous one could not move anything
+  const unsigned int IDLE_PAUSE = 10;
+  const unsigned int MAX_IDLE_BATCHES = 60;
+
+
+  struct Compaction_Batch
+  {
+    Compaction_Batch(Transaction& transaction_, uint64 max_bytes_, std::set< std::string >& completed_)
+        : transaction(transaction_), max_bytes(max_bytes_), written(0), complete(true),
+          completed(completed_) {}
+
+    template< class TIndex >
+    void bin_file(const File_Properties& file_prop, bool derived);
+
+    // Map files store their blocks by id, hence they are in order already
+    template< typename Key, class TIndex >
+    void map_file(const File_Properties& file_prop) {}
+
+    Transaction& transaction;
+    uint64 max_bytes;
+    uint64 written;
+    bool complete;
+    std::set< std::string >& completed;
+  };
+
+
+  template< class TIndex >
+  void Compaction_Batch::bin_file(const File_Properties& file_prop, bool derived)
+  {
+    std::string file_name = file_prop.get_file_name_trunk() + file_prop.get_data_suffix();
+    if (completed.find(file_name) != completed.end())
+      return;
+    if (written >= max_bytes)
+    {
+      complete = false;
+      return;
+    }
+    // Derived files and the files of other meta modes may be absent,
+    // and opening them writeable would create them
+    if (!file_exists(transaction.get_db_dir() + file_name))
+    {
+      completed.insert(file_name);
+      return;
+    }
+
+    File_Blocks< TIndex, typename std::set< TIndex >::const_iterator, Default_Range_Iterator< TIndex > >
+        blocks(transaction.data_index(&file_prop));
+    bool file_complete = false;
+    uint64 file_written = blocks.compact(max_bytes - written, file_complete);
+    written += file_written;
+
+    if (file_written > 0)
+      std::cout<<file_name<<": moved "<<file_written<<" bytes\n";
+    if (file_complete)
+    {
+      completed.insert(file_name);
+      std::cout<<file_name<<": compacted\n";
+    }
+    else
+      complete = false;
+  }
+
+
+  void compact_files(Compaction_Batch& batch, bool areas)
+  {
+    if (areas)
+      visit_area_files(batch);
+    else
+      visit_osm_files(batch);
+  }
+
+
+  // Returns the number of written bytes
+  uint64 run_batch(Dispatcher_Client* dispatcher_client, const std::string& db_dir, bool areas,
+      uint64 batch_size, std::set< std::string >& completed, bool& complete)
+  {
+    if (!dispatcher_client)
+    {
+      Nonsynced_Transaction transaction(true, false, db_dir, "");
+      Compaction_Batch batch(transaction, batch_size, completed);
+      compact_files(batch, areas);
+      complete = batch.complete;
+      return batch.written;
+    }
+
+    Logger logger(dispatcher_client->get_db_dir());
+    logger.annotated_log("write_start() start compaction");
+    dispatcher_client->write_start();
+    logger.annotated_log("write_start() end");
+
+    uint64 written = 0;
+    try
+    {
+      Nonsynced_Transaction transaction(true, true, dispatcher_client->get_db_dir(), "");
+      Compaction_Batch batch(transaction, batch_size, completed);
+      compact_files(batch, areas);
+      written = batch.written;
+      complete = batch.complete;
+    }
+    catch (...)
+    {
+      logger.annotated_log("write_rollback() start");
+      dispatcher_client->write_rollback();
+      logger.annotated_log("write_rollback() end");
+      throw;
+    }
+
+    std::ostringstream out;
+    out<<"write_commit() start "<<written;
+    logger.annotated_log(out.str());
+    dispatcher_client->write_commit();
+    logger.annotated_log("write_commit() end");
+
+    return written;
+  }
+}
+
+
+int main(int argc, char* argv[])
+{
+  std::string db_dir;
+  uint64 batch_size = 64ull*1024*1024;
+  bool areas = false;
+  bool abort = false;
+
+  int argpos = 1;
+  while (argpos < argc)
+  {
+    if (!(strncmp(argv[argpos], "--db-dir=", 9)))
+    {
+      db_dir = ((std::string)argv[argpos]).substr(9);
+      if ((db_dir.size() > 0) && (db_dir[db_dir.size()-1] != '/'))
+        db_dir += '/';
+    }
+    else if (!(strncmp(argv[argpos], "--batch-size=", 13)))
+    {
+      batch_size = atoll(std::string(argv[argpos]).substr(13).c_str()) *1024*1024;
+      if (batch_size == 0)
+        abort = true;
+    }
+    else if (!(strcmp(argv[argpos], "--areas")))
+      areas = true;
+    else
+    {
+      std::cerr<<"Unknown argument: "<<argv[argpos]<<'\n';
+      abort = true;
+    }
+    ++argpos;
+  }
+  if (abort)
+  {
+    std::cerr<<"Usage: "<<argv[0]<<" [--db-dir=DIR] [--batch-size=MB] [--areas]\n"
+        "  Stores the blocks of all data files in index order.\n"
+        "  --areas processes the area files instead of the other data files.\n"
+        "  Without --db-dir, it runs as write transactions through the dispatcher\n"
+        "  and writes at most MB megabytes per transaction (default 64).\n";
+    return 1;
+  }
+
+  try
+  {
+    const std::string& shared_name =
+        areas ? area_settings().shared_name : osm_base_settings().shared_name;
+    Dispatcher_Client* dispatcher_client = 0;
+    if (db_dir.empty())
+      dispatcher_client = new Dispatcher_Client(shared_name);
+    else if (file_present(db_dir + shared_name))
+      throw Context_Error("File " + db_dir + shared_name + " present, "
+          "which indicates a running dispatcher. Delete file if no dispatcher is running.");
+
+    std::set< std::string > completed;
+    bool complete = false;
+    unsigned int idle_batches = 0;
+    while (!complete && idle_batches < MAX_IDLE_BATCHES)
+    {
+      if (run_batch(dispatcher_client, db_dir, areas, batch_size, completed, complete) > 0)
+        idle_batches = 0;
+      else if (!complete)
+      {
+        // Readers still use the space that the last batch has cleared
+        ++idle_batches;
+        sleep(IDLE_PAUSE);
+      }
+    }
+
+    delete dispatcher_client;
+    if (!complete)
+    {
+      std::cerr<<"Compaction incomplete because space is still in use. Please run again later.\n";
+      return 4;
+    }
+  }
+  catch(Context_Error e)
+  {
+    std::cerr<<"Context error: "<<e.message<<'\n';
+    return 3;
+  }
+  catch (File_Error e)
+  {
+    report_file_error(e);
+    return 2;
+  }
+
+  return 0;
+}
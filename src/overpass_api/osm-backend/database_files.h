@@ -0,0 +1,141 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__OSM_BACKEND__DATABASE_FILES_H
+#define DE__OSM3S___OVERPASS_API__OSM_BACKEND__DATABASE_FILES_H
+
+#include "../core/datatypes.h"
+#include "../core/settings.h"
+#include "../../template_db/types.h"
+
+
+/* The files of the database for the tools that process all of them.
+
+A visitor must provide the members
+
+  template< typename TIndex >
+  void bin_file(const File_Properties& file_prop, bool derived);
+
+  template< typename Key, typename TIndex >
+  void map_file(const File_Properties& file_prop);
+
+Each map file is visited right after the bin file it indexes.
+Derived files may be absent, see derived_file_kept(). The same applies to
+the area rasters, since area databases from before their introduction lack them.
+*/
+
+
+template< typename Visitor >
+void visit_osm_base_files(Visitor& visitor)
+{
+  visitor.template bin_file< Uint32_Index >(*osm_base_settings().NODES, false);
+  visitor.template map_file< Node_Skeleton::Id_Type, Uint32_Index >(*osm_base_settings().NODES);
+  visitor.template bin_file< Tag_Index_Local >(*osm_base_settings().NODE_TAGS_LOCAL, false);
+  visitor.template bin_file< Tag_Index_Global >(*osm_base_settings().NODE_TAGS_GLOBAL, false);
+  visitor.template bin_file< Uint32_Index >(*osm_base_settings().NODE_KEYS, false);
+
+  visitor.template bin_file< Uint31_Index >(*osm_base_settings().WAYS, false);
+  visitor.template map_file< Way_Skeleton::Id_Type, Uint31_Index >(*osm_base_settings().WAYS);
+  visitor.template bin_file< Tag_Index_Local >(*osm_base_settings().WAY_TAGS_LOCAL, false);
+  visitor.template bin_file< Tag_Index_Global >(*osm_base_settings().WAY_TAGS_GLOBAL, false);
+  visitor.template bin_file< Uint32_Index >(*osm_base_settings().WAY_KEYS, false);
+
+  visitor.template bin_file< Uint31_Index >(*osm_base_settings().RELATIONS, false);
+  visitor.template map_file< Relation_Skeleton::Id_Type, Uint31_Index >(*osm_base_settings().RELATIONS);
+  visitor.template bin_file< Uint32_Index >(*osm_base_settings().RELATION_ROLES, false);
+  visitor.template bin_file< Tag_Index_Local >(*osm_base_settings().RELATION_TAGS_LOCAL, false);
+  visitor.template bin_file< Tag_Index_Global >(*osm_base_settings().RELATION_TAGS_GLOBAL, false);
+  visitor.template bin_file< Uint32_Index >(*osm_base_settings().RELATION_KEYS, false);
+
+  visitor.template bin_file< Node::Id_Type >(*osm_base_settings().NODE_WAYS, true);
+  visitor.template bin_file< Uint64 >(*osm_base_settings().MEMBER_RELATIONS, true);
+}
+
+
+template< typename Visitor >
+void visit_meta_files(Visitor& visitor)
+{
+  visitor.template bin_file< Uint31_Index >(*meta_settings().NODES_META, false);
+  visitor.template bin_file< Uint31_Index >(*meta_settings().WAYS_META, false);
+  visitor.template bin_file< Uint31_Index >(*meta_settings().RELATIONS_META, false);
+  visitor.template bin_file< Uint32_Index >(*meta_settings().USER_DATA, false);
+  visitor.template bin_file< Uint32_Index >(*meta_settings().USER_INDICES, false);
+  visitor.template bin_file< Uint32_Index >(*meta_settings().USER_NAMES, true);
+  visitor.template bin_file< Uint32_Index >(*meta_settings().USER_NODES, true);
+  visitor.template bin_file< Uint32_Index >(*meta_settings().USER_WAYS, true);
+  visitor.template bin_file< Uint32_Index >(*meta_settings().USER_RELATIONS, true);
+}
+
+
+template< typename Visitor >
+void visit_attic_files(Visitor& visitor)
+{
+  visitor.template bin_file< Uint31_Index >(*attic_settings().NODES, false);
+  visitor.template map_file< Node_Skeleton::Id_Type, Uint31_Index >(*attic_settings().NODES);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().NODES_UNDELETED, false);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().NODES_NEWEST, true);
+  visitor.template bin_file< Node::Id_Type >(*attic_settings().NODE_IDX_LIST, false);
+  visitor.template bin_file< Tag_Index_Local >(*attic_settings().NODE_TAGS_LOCAL, false);
+  visitor.template bin_file< Tag_Index_Global >(*attic_settings().NODE_TAGS_GLOBAL, false);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().NODES_META, false);
+  visitor.template bin_file< Timestamp >(*attic_settings().NODE_CHANGELOG, false);
+
+  visitor.template bin_file< Uint31_Index >(*attic_settings().WAYS, false);
+  visitor.template map_file< Way_Skeleton::Id_Type, Uint31_Index >(*attic_settings().WAYS);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().WAYS_UNDELETED, false);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().WAYS_NEWEST, true);
+  visitor.template bin_file< Way::Id_Type >(*attic_settings().WAY_IDX_LIST, false);
+  visitor.template bin_file< Tag_Index_Local >(*attic_settings().WAY_TAGS_LOCAL, false);
+  visitor.template bin_file< Tag_Index_Global >(*attic_settings().WAY_TAGS_GLOBAL, false);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().WAYS_META, false);
+  visitor.template bin_file< Timestamp >(*attic_settings().WAY_CHANGELOG, false);
+
+  visitor.template bin_file< Uint31_Index >(*attic_settings().RELATIONS, false);
+  visitor.template map_file< Relation_Skeleton::Id_Type, Uint31_Index >(*attic_settings().RELATIONS);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().RELATIONS_UNDELETED, false);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().RELATIONS_NEWEST, true);
+  visitor.template bin_file< Relation::Id_Type >(*attic_settings().RELATION_IDX_LIST, false);
+  visitor.template bin_file< Tag_Index_Local >(*attic_settings().RELATION_TAGS_LOCAL, false);
+  visitor.template bin_file< Tag_Index_Global >(*attic_settings().RELATION_TAGS_GLOBAL, false);
+  visitor.template bin_file< Uint31_Index >(*attic_settings().RELATIONS_META, false);
+  visitor.template bin_file< Timestamp >(*attic_settings().RELATION_CHANGELOG, false);
+}
+
+
+// The area files belong to the area dispatcher, hence they need a transaction of their own
+template< typename Visitor >
+void visit_area_files(Visitor& visitor)
+{
+  visitor.template bin_file< Uint31_Index >(*area_settings().AREAS, false);
+  visitor.template bin_file< Uint31_Index >(*area_settings().AREA_BLOCKS, false);
+  visitor.template bin_file< Tag_Index_Local >(*area_settings().AREA_TAGS_LOCAL, false);
+  visitor.template bin_file< Tag_Index_Global >(*area_settings().AREA_TAGS_GLOBAL, false);
+  visitor.template bin_file< Uint31_Index >(*area_settings().AREA_RASTERS, true);
+}
+
+
+template< typename Visitor >
+void visit_osm_files(Visitor& visitor)
+{
+  visit_osm_base_files(visitor);
+  visit_meta_files(visitor);
+  visit_attic_files(visitor);
+}
+
+
+#endif
@@ -28,13 +28,61 @@
 #include "../../template_db/random_file.h"
 #include "../core/datatypes.h"
 #include "../core/settings.h"
+#include "basic_updater.h"
 #include "meta_updater.h"
 
 
 
+// Moves the entries of new and renamed users in the file of user names, indexed by user_name_hash()
+void update_user_names(Transaction& transaction, const std::map< uint32, std::string >& user_by_id)
+{
+  std::set< Uint32_Index > req;
+  for (std::map< uint32, std::string >::const_iterator it = user_by_id.begin();
+      it != user_by_id.end(); ++it)
+    req.insert(Uint32_Index(it->first & 0xffffff00));
+
+  std::map< Uint32_Index, std::set< User_Data > > db_to_delete;
+  std::map< Uint32_Index, std::set< User_Data > > db_to_insert;
+  std::set< uint32 > unchanged;
+
+  Block_Backend< Uint32_Index, User_Data > user_db
+      (transaction.data_index(meta_settings().USER_DATA));
+  for (Block_Backend< Uint32_Index, User_Data >::Discrete_Iterator it = user_db.discrete_begin(req.begin(), req.end());
+      !(it == user_db.discrete_end()); ++it)
+  {
+    std::map< uint32, std::string >::const_iterator name_it = user_by_id.find(it.object().id);
+    if (name_it == user_by_id.end())
+      continue;
+    if (name_it->second == it.object().name)
+      unchanged.insert(it.object().id);
+    else
+      db_to_delete[Uint32_Index(user_name_hash(it.object().name))].insert(it.object());
+  }
+
+  for (std::map< uint32, std::string >::const_iterator it = user_by_id.begin();
+      it != user_by_id.end(); ++it)
+  {
+    if (unchanged.find(it->first) != unchanged.end())
+      continue;
+    User_Data user_data;
+    user_data.id = it->first;
+    user_data.name = it->second;
+    db_to_insert[Uint32_Index(user_name_hash(it->second))].insert(user_data);
+  }
+
+  Block_Backend< Uint32_Index, User_Data > names_db
+      (transaction.data_index(meta_settings().USER_NAMES));
+  names_db.update(db_to_delete, db_to_insert);
+}
+
+
 void process_user_data(Transaction& transaction, std::map< uint32, std::string >& user_by_id,
 		       std::map< uint32, std::vector< uint32 > >& idxs_by_user_id)
 {
+  // The old names must be read before the user data is overwritten
+  if (derived_file_kept< Uint32_Index >(transaction, *meta_settings().USER_DATA, *meta_settings().USER_NAMES))
+    update_user_names(transaction, user_by_id);
+
   {
     std::map< Uint32_Index, std::set< User_Data > > db_to_delete;
     std::map< Uint32_Index, std::set< User_Data > > db_to_insert;
@@ -154,6 +154,34 @@ void process_user_data(Transaction& transaction, std::map< uint32, std::string >
    std::map< uint32, std::vector< uint32 > >& idxs_by_user_id);
 
 
+template< typename Index, typename Id_Type >
+void copy_ids_by_user
+    (const std::map< Index, std::set< OSM_Element_Metadata_Skeleton< Id_Type > > >& new_meta,
+     std::map< Uint32_Index, std::set< Id_Type > >& ids_by_user)
+{
+  for (typename std::map< Index, std::set< OSM_Element_Metadata_Skeleton< Id_Type > > >::const_iterator
+      it = new_meta.begin(); it != new_meta.end(); ++it)
+  {
+    for (typename std::set< OSM_Element_Metadata_Skeleton< Id_Type > >::const_iterator it2 = it->second.begin();
+        it2 != it->second.end(); ++it2)
+      ids_by_user[Uint32_Index(it2->user_id)].insert(it2->ref);
+  }
+}
+
+
+/* Like the user indices, the elements per user are only ever added.
+ * Hence they are the superset of all elements that the user has ever edited. */
+template< typename Id_Type >
+void process_user_elements
+    (Transaction& transaction, const std::map< Uint32_Index, std::set< Id_Type > >& ids_by_user,
+     const File_Properties& file_properties)
+{
+  // The entries are deleted before they are inserted to avoid duplicates
+  Block_Backend< Uint32_Index, Id_Type > user_db(transaction.data_index(&file_properties));
+  user_db.update(ids_by_user, ids_by_user);
+}
+
+
 template< typename Id_Type >
 void collect_old_meta_data
   (File_Blocks_Index_Base& file_blocks_index,
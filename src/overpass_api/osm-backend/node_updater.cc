@@ -552,6 +552,8 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
   callback->update_coords_finished();
 
   // Update meta
+  bool user_elements_kept = meta
+      && derived_file_kept< Uint31_Index >(*transaction, *meta_settings().NODES_META, *meta_settings().USER_NODES);
   if (meta)
     update_elements(attic_meta, new_meta, *transaction, *meta_settings().NODES_META);
 
@@ -564,6 +566,7 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
   callback->tags_global_finished();
 
   std::map< uint32, std::vector< uint32 > > idxs_by_id;
+  std::map< Uint32_Index, std::set< Node_Skeleton::Id_Type > > ids_by_user;
 
   if (meta == keep_attic)
   {
@@ -614,6 +617,8 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
 
     // Prepare user indices
     copy_idxs_by_id(attic_meta, idxs_by_id);
+    if (user_elements_kept)
+      copy_ids_by_user(attic_meta, ids_by_user);
 
     // Update id indexes
     update_map_positions(new_attic_map_positions, *transaction, *attic_settings().NODES);
@@ -622,6 +627,10 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
     update_elements(existing_idx_lists, new_attic_idx_lists,
                     *transaction, *attic_settings().NODE_IDX_LIST);
 
+    // Update the newest timestamps per index before the attic elements make the file non-empty
+    if (derived_file_kept< Uint31_Index >(*transaction, *attic_settings().NODES, *attic_settings().NODES_NEWEST))
+      update_attic_newest_timestamps(new_attic_skeletons, *transaction, *attic_settings().NODES_NEWEST);
+
     // Add attic elements
     update_elements(std::map< Uint31_Index, std::set< Attic< Node_Skeleton > > >(), new_attic_skeletons,
                     *transaction, *attic_settings().NODES);
@@ -651,6 +660,11 @@ void Node_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_sto
   {
     copy_idxs_by_id(new_meta, idxs_by_id);
     process_user_data(*transaction, user_by_id, idxs_by_id);
+    if (user_elements_kept)
+    {
+      copy_ids_by_user(new_meta, ids_by_user);
+      process_user_elements(*transaction, ids_by_user, *meta_settings().USER_NODES);
+    }
   }
   callback->update_finished();
 
@@ -25,6 +25,7 @@
 #include "../../template_db/dispatcher_client.h"
 #include "../../template_db/random_file.h"
 #include "../../template_db/transaction.h"
+#include "../../template_db/zlib_wrapper.h"
 #include "../core/settings.h"
 #include "../data/abstract_processing.h"
 #include "../data/collect_members.h"
@@ -32,10 +33,18 @@
 #include "../frontend/output.h"
 
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/file.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdio>
+#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -71,6 +80,245 @@ namespace
 
   std::string data_version;
 
+  // Elements that the parser process has seen before the start tag of the current element
+  uint32 elements_before_start = 0;
+
+  // Record types of the stream from the parser process to the writer process
+  const uint8 NODE_CHANGE = 'n';
+  const uint8 WAY_CHANGE = 'w';
+  const uint8 RELATION_CHANGE = 'r';
+  const uint8 END_OF_CHANGES = 'e';
+
+
+  template< typename T >
+  void put(std::string& buf, const T& val)
+  {
+    buf.append((const char*)&val, sizeof(T));
+  }
+
+
+  void put_string(std::string& buf, const std::string& val)
+  {
+    put(buf, (uint32)val.size());
+    buf.append(val);
+  }
+
+
+  // Collects the parsed elements in batches and keeps up to max_size bytes of batches
+  // while the writer process is still busy
+  class Change_Queue
+  {
+  public:
+    Change_Queue(int fd_, uint64 max_size_) : fd(fd_), max_size(max_size_), queued_size(0), front_written(0)
+    {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    void push_node(const Node& node, const OSM_Element_Metadata* meta, bool deleted);
+    void push_way(const Way& way, const OSM_Element_Metadata* meta, bool deleted);
+    void push_relation(const Relation& relation, const std::vector< std::string >& roles,
+        const OSM_Element_Metadata* meta, bool deleted);
+    void finish();
+
+  private:
+    static const uint32 BATCH_SIZE = 1024*1024;
+
+    int fd;
+    uint64 max_size;
+    uint64 queued_size;
+    std::string batch;
+    std::deque< std::string > queue;
+    uint64 front_written;
+
+    void put_head(uint8 type, const std::vector< std::pair< std::string, std::string > >& tags,
+        const OSM_Element_Metadata* meta, bool deleted);
+    void push_batch();
+    void drain(uint64 limit);
+  };
+
+
+  void Change_Queue::put_head(uint8 type, const std::vector< std::pair< std::string, std::string > >& tags,
+      const OSM_Element_Metadata* meta, bool deleted)
+  {
+    put(batch, type);
+    // The writer process flushes after the same number of parsed elements as a single process would do
+    put(batch, elements_before_start);
+    put(batch, osm_element_count);
+    elements_before_start = 0;
+    osm_element_count = 0;
+    put(batch, (uint8)deleted);
+    if (meta)
+    {
+      put(batch, meta->version);
+      put(batch, meta->timestamp);
+      put(batch, meta->changeset);
+      put(batch, meta->user_id);
+      put_string(batch, meta->user_name);
+    }
+    put(batch, (uint32)tags.size());
+    for (std::vector< std::pair< std::string, std::string > >::const_iterator it = tags.begin();
+        it != tags.end(); ++it)
+    {
+      put_string(batch, it->first);
+      put_string(batch, it->second);
+    }
+  }
+
+
+  void Change_Queue::push_node(const Node& node, const OSM_Element_Metadata* meta, bool deleted)
+  {
+    put_head(NODE_CHANGE, node.tags, meta, deleted);
+    put(batch, node.id.val());
+    put(batch, node.index);
+    put(batch, node.ll_lower_);
+    if (batch.size() >= BATCH_SIZE)
+      push_batch();
+  }
+
+
+  void Change_Queue::push_way(const Way& way, const OSM_Element_Metadata* meta, bool deleted)
+  {
+    put_head(WAY_CHANGE, way.tags, meta, deleted);
+    put(batch, way.id.val());
+    put(batch, (uint32)way.nds.size());
+    for (std::vector< Node::Id_Type >::const_iterator it = way.nds.begin(); it != way.nds.end(); ++it)
+      put(batch, it->val());
+    if (batch.size() >= BATCH_SIZE)
+      push_batch();
+  }
+
+
+  void Change_Queue::push_relation(const Relation& relation, const std::vector< std::string >& roles,
+      const OSM_Element_Metadata* meta, bool deleted)
+  {
+    put_head(RELATION_CHANGE, relation.tags, meta, deleted);
+    put(batch, relation.id.val());
+    put(batch, (uint32)relation.members.size());
+    for (uint32 i = 0; i < relation.members.size(); ++i)
+    {
+      put(batch, relation.members[i].ref.val());
+      put(batch, relation.members[i].type);
+      put_string(batch, roles[i]);
+    }
+    if (batch.size() >= BATCH_SIZE)
+      push_batch();
+  }
+
+
+  void Change_Queue::finish()
+  {
+    put(batch, END_OF_CHANGES);
+    push_batch();
+    drain(0);
+  }
+
+
+  void Change_Queue::push_batch()
+  {
+    queued_size += batch.size();
+    queue.push_back(std::string());
+    queue.back().swap(batch);
+    drain(max_size);
+  }
+
+
+  // Writes as much as the pipe takes without waiting,
+  // but waits for the writer process as long as more than limit bytes are queued
+  void Change_Queue::drain(uint64 limit)
+  {
+    while (!queue.empty())
+    {
+      ssize_t written = write(fd, queue.front().data() + front_written, queue.front().size() - front_written);
+      if (written < 0)
+      {
+        if (errno != EAGAIN && errno != EINTR)
+          throw File_Error(errno, "[pipe]", "Change_Queue::drain::1");
+        if (queued_size <= limit)
+          return;
+        pollfd poll_fd = { fd, POLLOUT, 0 };
+        poll(&poll_fd, 1, -1);
+        continue;
+      }
+
+      front_written += written;
+      if (front_written == queue.front().size())
+      {
+        queued_size -= queue.front().size();
+        queue.pop_front();
+        front_written = 0;
+      }
+    }
+  }
+
+
+  // Reads the stream of the parser process in the writer process
+  class Change_Reader
+  {
+  public:
+    Change_Reader(int fd_) : fd(fd_), buf(64*1024), pos(0), end(0) {}
+
+    template< typename T >
+    T get()
+    {
+      T result;
+      read((char*)&result, sizeof(T));
+      return result;
+    }
+
+    std::string get_string()
+    {
+      std::string result(get< uint32 >(), ' ');
+      if (!result.empty())
+        read(&result[0], result.size());
+      return result;
+    }
+
+  private:
+    int fd;
+    std::vector< char > buf;
+    uint32 pos;
+    uint32 end;
+
+    void read(char* target, uint32 size);
+  };
+
+
+  void Change_Reader::read(char* target, uint32 size)
+  {
+    while (size > 0)
+    {
+      if (pos == end)
+      {
+        ssize_t count = ::read(fd, &buf[0], buf.size());
+        if (count < 0 && errno == EINTR)
+          continue;
+        if (count < 0)
+          throw File_Error(errno, "[pipe]", "Change_Reader::read::1");
+        if (count == 0)
+          throw Context_Error("The parser process has stopped before the end of the changes.");
+        pos = 0;
+        end = count;
+      }
+      uint32 chunk = std::min(size, end - pos);
+      memcpy(target, &buf[pos], chunk);
+      target += chunk;
+      pos += chunk;
+      size -= chunk;
+    }
+  }
+
+
+  // Only set in the parser process of a pipelined update
+  Change_Queue* change_queue(0);
+  std::vector< std::string > current_roles;
+
+
+  inline void count_elements_before_start()
+  {
+    elements_before_start = osm_element_count;
+    osm_element_count = 0;
+  }
+
   inline void tag_start(const char **attr)
   {
     std::string key(""), value("");
@@ -128,7 +376,10 @@ namespace
 	entry.type = Relation_Entry::WAY;
       else if (type == "relation")
 	entry.type = Relation_Entry::RELATION;
-      entry.role = relation_updater->get_role_id(role);
+      if (change_queue)
+        current_roles.push_back(role);
+      else
+        entry.role = relation_updater->get_role_id(role);
       current_relation.members.push_back(entry);
     }
   }
@@ -136,7 +387,9 @@ namespace
 
   inline void node_start(const char **attr)
   {
-    if (state == 0)
+    if (change_queue)
+      count_elements_before_start();
+    else if (state == 0)
       state = IN_NODES;
     if (meta)
       *meta = OSM_Element_Metadata();
@@ -180,6 +433,12 @@ namespace
 
   inline void node_end()
   {
+    if (change_queue)
+    {
+      change_queue->push_node(current_node, meta, modify_mode == DELETE);
+      current_node.id = Node::Id_Type();
+      return;
+    }
     if (modify_mode == DELETE)
       node_updater->set_id_deleted(current_node.id, meta);
     else
@@ -195,7 +454,7 @@ namespace
   }
 
 
-  inline void way_start(const char **attr)
+  inline void begin_ways()
   {
     if (state == IN_NODES)
     {
@@ -208,6 +467,15 @@ namespace
     }
     else if (state == 0)
       state = IN_WAYS;
+  }
+
+
+  inline void way_start(const char **attr)
+  {
+    if (change_queue)
+      count_elements_before_start();
+    else
+      begin_ways();
     if (meta)
       *meta = OSM_Element_Metadata();
 
@@ -241,6 +509,12 @@ namespace
 
   inline void way_end()
   {
+    if (change_queue)
+    {
+      change_queue->push_way(current_way, meta, modify_mode == DELETE);
+      current_way.id = 0u;
+      return;
+    }
     if (modify_mode == DELETE)
       way_updater->set_id_deleted(current_way.id, meta);
     else
@@ -260,6 +534,13 @@ namespace
 
   inline void relation_end()
   {
+    if (change_queue)
+    {
+      change_queue->push_relation(current_relation, current_roles, meta, modify_mode == DELETE);
+      current_roles.clear();
+      current_relation.id = 0u;
+      return;
+    }
     if (modify_mode == DELETE)
       relation_updater->set_id_deleted(current_relation.id, meta);
     else
@@ -279,7 +560,7 @@ namespace
   }
 
 
-  inline void relation_start(const char **attr)
+  inline void begin_relations()
   {
     if (state == IN_NODES)
     {
@@ -305,6 +586,15 @@ namespace
     }
     else if (state == 0)
       state = IN_RELATIONS;
+  }
+
+
+  inline void relation_start(const char **attr)
+  {
+    if (change_queue)
+      count_elements_before_start();
+    else
+      begin_relations();
     if (meta)
       *meta = OSM_Element_Metadata();
 
@@ -334,6 +624,46 @@ namespace
     }
     current_relation = Relation(id.val());
   }
+
+
+  // The rules loop takes the file away when it processes it, hence we always append
+  void append_area_changes(const std::string& db_dir,
+      const std::vector< Way::Id_Type >& way_ids, const std::vector< Relation::Id_Type >& relation_ids)
+  {
+    if (way_ids.empty() && relation_ids.empty())
+      return;
+
+    std::ostringstream out;
+    for (std::vector< Way::Id_Type >::const_iterator it = way_ids.begin(); it != way_ids.end(); ++it)
+      out<<"way "<<it->val()<<'\n';
+    for (std::vector< Relation::Id_Type >::const_iterator it = relation_ids.begin();
+        it != relation_ids.end(); ++it)
+      out<<"relation "<<it->val()<<'\n';
+    std::string data = out.str();
+
+    // rules_changes_loop.sh moves the file aside under the same lock,
+    // hence the ids never go to a copy that is already being processed
+    int lock_fd = open((db_dir + "area_changes.lock").c_str(), O_RDWR|O_CREAT, S_666);
+    if (lock_fd < 0)
+      throw File_Error(errno, db_dir + "area_changes.lock", "append_area_changes:1");
+    if (flock(lock_fd, LOCK_EX) != 0)
+    {
+      close(lock_fd);
+      throw File_Error(errno, db_dir + "area_changes.lock", "append_area_changes:2");
+    }
+
+    int fd = open((db_dir + "area_changes").c_str(), O_WRONLY|O_APPEND|O_CREAT, S_666);
+    if (fd < 0)
+    {
+      close(lock_fd);
+      throw File_Error(errno, db_dir + "area_changes", "append_area_changes:3");
+    }
+    ssize_t written = write(fd, data.data(), data.size());
+    close(fd);
+    close(lock_fd);
+    if (written != (ssize_t)data.size())
+      throw File_Error(errno, db_dir + "area_changes", "append_area_changes:4");
+  }
 }
 
 
@@ -498,6 +828,201 @@ void parse_relations_only(FILE* in)
   parse(in, relation_start, relation_end);
 }
 
+
+FILE* open_osc_file(const std::string& file_name)
+{
+  FILE* in = 0;
+  if (file_name.size() > 3 && file_name.substr(file_name.size() - 3) == ".gz")
+    in = fopen_gzip(file_name);
+  else
+    in = fopen(file_name.c_str(), "r");
+  if (!in)
+    throw File_Error(errno, file_name, "open_osc_file:1");
+  return in;
+}
+
+
+void close_osc_file(FILE* in, const std::string& file_name)
+{
+  if (file_name.size() > 3 && file_name.substr(file_name.size() - 3) == ".gz")
+  {
+    if (fclose(in) != 0)
+      throw File_Error(0, file_name, "close_osc_file:1");
+  }
+  else
+    fclose(in);
+}
+
+
+namespace
+{
+  void parse_files(const std::vector< std::string >& file_names,
+      void (*start)(const char*, const char**), void (*end)(const char*))
+  {
+    for (std::vector< std::string >::const_iterator it = file_names.begin(); it != file_names.end(); ++it)
+    {
+      FILE* in = open_osc_file(*it);
+      parse(in, start, end);
+      close_osc_file(in, *it);
+    }
+  }
+
+
+  void read_head(Change_Reader& reader, uint32& elements_within)
+  {
+    osm_element_count += reader.get< uint32 >();
+    elements_within = reader.get< uint32 >();
+    modify_mode = (reader.get< uint8 >() ? DELETE : 0);
+    if (meta)
+    {
+      meta->version = reader.get< uint32 >();
+      meta->timestamp = reader.get< uint64 >();
+      meta->changeset = reader.get< uint32 >();
+      meta->user_id = reader.get< uint32 >();
+      meta->user_name = reader.get_string();
+    }
+  }
+
+
+  void read_tags(Change_Reader& reader, std::vector< std::pair< std::string, std::string > >& tags)
+  {
+    uint32 count = reader.get< uint32 >();
+    for (uint32 i = 0; i < count; ++i)
+    {
+      std::string key = reader.get_string();
+      tags.push_back(std::make_pair(key, reader.get_string()));
+    }
+  }
+
+
+  // Applies the changes in the same order and with the same flushes as the parser callbacks would do
+  void apply_changes(Change_Reader& reader)
+  {
+    uint8 type = reader.get< uint8 >();
+    while (type != END_OF_CHANGES)
+    {
+      uint32 elements_within = 0;
+      read_head(reader, elements_within);
+      if (type == NODE_CHANGE)
+      {
+        if (state == 0)
+          state = IN_NODES;
+        osm_element_count += elements_within;
+        std::vector< std::pair< std::string, std::string > > tags;
+        read_tags(reader, tags);
+        Node::Id_Type id = reader.get< uint64 >();
+        uint32 ll_upper = reader.get< uint32 >();
+        current_node = Node(id, ll_upper, reader.get< uint32 >());
+        current_node.tags.swap(tags);
+        node_end();
+      }
+      else if (type == WAY_CHANGE)
+      {
+        begin_ways();
+        osm_element_count += elements_within;
+        std::vector< std::pair< std::string, std::string > > tags;
+        read_tags(reader, tags);
+        current_way = Way(reader.get< uint32 >());
+        current_way.tags.swap(tags);
+        uint32 count = reader.get< uint32 >();
+        for (uint32 i = 0; i < count; ++i)
+          current_way.nds.push_back(reader.get< uint64 >());
+        way_end();
+      }
+      else if (type == RELATION_CHANGE)
+      {
+        begin_relations();
+        osm_element_count += elements_within;
+        std::vector< std::pair< std::string, std::string > > tags;
+        read_tags(reader, tags);
+        current_relation = Relation(reader.get< uint32 >());
+        current_relation.tags.swap(tags);
+        uint32 count = reader.get< uint32 >();
+        for (uint32 i = 0; i < count; ++i)
+        {
+          Relation_Entry entry;
+          entry.ref = reader.get< uint64 >();
+          entry.type = reader.get< uint32 >();
+          entry.role = relation_updater->get_role_id(reader.get_string());
+          current_relation.members.push_back(entry);
+        }
+        relation_end();
+      }
+      else
+        throw Context_Error("Unexpected record in the stream of the parser process.");
+      type = reader.get< uint8 >();
+    }
+    modify_mode = 0;
+  }
+}
+
+
+void Osm_Updater::parse_files_pipelined(const std::vector< std::string >& file_names, uint64 queue_size)
+{
+  int fds[2];
+  if (pipe(fds) == -1)
+    throw File_Error(errno, "[pipe]", "Osm_Updater::parse_files_pipelined::1");
+
+  pid_t pid = fork();
+  if (pid == -1)
+    throw File_Error(errno, "[fork]", "Osm_Updater::parse_files_pipelined::2");
+  if (pid == 0)
+  {
+    // The parser process must leave the transaction to the writer process, hence no destructors
+    close(fds[0]);
+    try
+    {
+      Change_Queue queue(fds[1], queue_size);
+      change_queue = &queue;
+      parse_files(file_names, node_start, node_end);
+      parse_files(file_names, way_start, way_end);
+      parse_files(file_names, relation_start, relation_end);
+      queue.finish();
+    }
+    catch (const File_Error& e)
+    {
+      report_file_error(e);
+      _exit(1);
+    }
+    catch (const Context_Error& e)
+    {
+      std::cerr<<"Parser process: "<<e.message<<'\n';
+      _exit(1);
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr<<"Parser process: "<<e.what()<<'\n';
+      _exit(1);
+    }
+    catch (...)
+    {
+      std::cerr<<"Parser process: unknown exception\n";
+      _exit(1);
+    }
+    _exit(0);
+  }
+
+  close(fds[1]);
+  try
+  {
+    Change_Reader reader(fds[0]);
+    apply_changes(reader);
+  }
+  catch (...)
+  {
+    // The parser process gets a broken pipe if it is still running
+    close(fds[0]);
+    waitpid(pid, 0, 0);
+    throw;
+  }
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    throw Context_Error("The parser process has failed.");
+}
+
 Osm_Updater::Osm_Updater(Osm_Backend_Callback* callback_, const std::string& data_version_,
 			 meta_modes meta_, unsigned int flush_limit_)
   : dispatcher_client(0), meta(meta_)
@@ -567,6 +1092,9 @@ Osm_Updater::Osm_Updater
 
 void Osm_Updater::flush()
 {
+  std::vector< Way::Id_Type > changed_ways = way_updater_->get_changed_ids();
+  std::vector< Relation::Id_Type > changed_relations = relation_updater_->get_changed_ids();
+
   delete node_updater_;
   node_updater_ = new Node_Updater(db_dir_, meta ? keep_meta : only_data);
   delete way_updater_;
@@ -593,10 +1121,15 @@ void Osm_Updater::flush()
     rename((dispatcher_client->get_db_dir() + "osm_base_version.shadow").c_str(),
 	   (dispatcher_client->get_db_dir() + "osm_base_version").c_str());
 
+    if (basic_settings().record_area_changes)
+      append_area_changes(dispatcher_client->get_db_dir(), changed_ways, changed_relations);
+
     logger.annotated_log("write_commit() end");
     delete dispatcher_client;
     dispatcher_client = 0;
   }
+  else if (basic_settings().record_area_changes)
+    append_area_changes(db_dir_, changed_ways, changed_relations);
 }
 
 Osm_Updater::~Osm_Updater()
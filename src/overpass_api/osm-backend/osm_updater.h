@@ -41,6 +41,9 @@ class Osm_Updater
 
     void finish_updater();
     void parse_file_completely(FILE* in);
+    // Parses the files in a separate process while this process writes the already parsed changes.
+    // The parser process buffers up to queue_size bytes of parsed changes.
+    void parse_files_pipelined(const std::vector< std::string >& file_names, uint64 queue_size);
 
   private:
     Nonsynced_Transaction* transaction;
@@ -58,4 +61,8 @@ void parse_nodes_only(FILE* in);
 void parse_ways_only(FILE* in);
 void parse_relations_only(FILE* in);
 
+// Decompresses files with the suffix .gz on the fly
+FILE* open_osc_file(const std::string& file_name);
+void close_osc_file(FILE* in, const std::string& file_name);
+
 #endif
@@ -634,7 +634,11 @@ Relation_Skeleton add_intermediate_versions
     Uint31_Index reference_idx;
     Relation_Skeleton reference_skel = reference;
     compute_idx_and_geometry(reference_idx, reference_skel, new_timestamp + 1, nodes_by_id, ways_by_id);
-    if (idx == reference_idx)
+    uint64 valid_since = old_timestamp;
+    for (std::vector< uint64 >::const_iterator it = relevant_timestamps.begin();
+        it != relevant_timestamps.end() && *it < new_timestamp; ++it)
+      valid_since = *it;
+    if (idx == reference_idx && !attic_checkpoint_due(valid_since, new_timestamp))
       full_attic[idx].insert(Attic< Relation_Delta >(
           Relation_Delta(reference_skel, cur_skeleton), new_timestamp));
     else
@@ -663,7 +667,8 @@ Relation_Skeleton add_intermediate_versions
     Relation_Skeleton cur_skeleton = skeleton;
     if (idx.val() == 0 || it != relevant_timestamps.begin())
       compute_idx_and_geometry(idx, cur_skeleton, *it, nodes_by_id, ways_by_id);
-    if (last_idx == idx)
+    if (last_idx == idx
+        && !attic_checkpoint_due(it == relevant_timestamps.begin() ? old_timestamp : *(it-1), *it))
       full_attic[idx].insert(Attic< Relation_Delta >(
           Relation_Delta(last_skeleton, cur_skeleton), *it));
     else
@@ -788,7 +793,8 @@ void adapt_newest_existing_attic
      std::map< Uint31_Index, std::set< Attic< Relation_Delta > > >& attic_skeletons_to_delete,
      std::map< Uint31_Index, std::set< Attic< Relation_Delta > > >& full_attic)
 {
-  Relation_Delta new_delta(old_idx == new_idx ? new_reference : Relation_Skeleton(),
+  // A checkpoint stays a full delta
+  Relation_Delta new_delta(old_idx == new_idx && !existing_delta.full ? new_reference : Relation_Skeleton(),
 			   existing_delta.expand(existing_reference));
   if (new_delta.members_added != existing_delta.members_added
       || new_delta.members_removed != existing_delta.members_removed
@@ -953,6 +959,21 @@ void compute_new_attic_skeletons
 }
 
 
+void add_member_relations(const std::map< Uint31_Index, std::set< Relation_Skeleton > >& skeletons,
+    std::map< Uint64, std::set< Relation::Id_Type > >& member_relations)
+{
+  for (std::map< Uint31_Index, std::set< Relation_Skeleton > >::const_iterator it = skeletons.begin();
+      it != skeletons.end(); ++it)
+  {
+    for (std::set< Relation_Skeleton >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+    {
+      for (std::vector< Relation_Entry >::const_iterator it3 = it2->members.begin(); it3 != it2->members.end(); ++it3)
+        member_relations[member_relations_key(it3->ref, it3->type)].insert(it2->id);
+    }
+  }
+}
+
+
 /* Compares the new data and the already existing skeletons to determine those that have
  * moved. This information is used to prepare the std::set of elements to store to attic.
  * We use that in attic_skeletons can only appear elements with ids that exist also in new_data. */
@@ -1180,11 +1201,25 @@ void Relation_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu
   update_map_positions(new_positions, *transaction, *osm_base_settings().RELATIONS);
   callback->update_ids_finished();
 
+  // Update the reverse file from members to relations
+  if (derived_file_kept< Uint31_Index >(*transaction, *osm_base_settings().RELATIONS, *osm_base_settings().MEMBER_RELATIONS))
+  {
+    std::map< Uint64, std::set< Relation::Id_Type > > attic_member_relations;
+    std::map< Uint64, std::set< Relation::Id_Type > > new_member_relations;
+    add_member_relations(attic_skeletons, attic_member_relations);
+    add_member_relations(new_skeletons, new_member_relations);
+    cancel_out_equal_entries(attic_member_relations, new_member_relations);
+    update_elements(attic_member_relations, new_member_relations,
+        *transaction, *osm_base_settings().MEMBER_RELATIONS);
+  }
+
   // Update skeletons
   update_elements(attic_skeletons, new_skeletons, *transaction, *osm_base_settings().RELATIONS);
   callback->update_coords_finished();
 
   // Update meta
+  bool user_elements_kept = meta
+      && derived_file_kept< Uint31_Index >(*transaction, *meta_settings().RELATIONS_META, *meta_settings().USER_RELATIONS);
   if (meta)
     update_elements(attic_meta, new_meta, *transaction, *meta_settings().RELATIONS_META);
 
@@ -1200,6 +1235,7 @@ void Relation_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu
   callback->flush_roles_finished();
 
   std::map< uint32, std::vector< uint32 > > idxs_by_id;
+  std::map< Uint32_Index, std::set< Relation_Skeleton::Id_Type > > ids_by_user;
 
   if (meta == keep_attic)
   {
@@ -1265,6 +1301,8 @@ void Relation_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu
 
     // Prepare user indices
     copy_idxs_by_id(new_attic_meta, idxs_by_id);
+    if (user_elements_kept)
+      copy_ids_by_user(new_attic_meta, ids_by_user);
 
     // Update id indexes
     update_map_positions(new_attic_map_positions, *transaction, *attic_settings().RELATIONS);
@@ -1273,6 +1311,10 @@ void Relation_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu
     update_elements(existing_idx_lists, new_attic_idx_lists,
                     *transaction, *attic_settings().RELATION_IDX_LIST);
 
+    // Update the newest timestamps per index before the attic elements make the file non-empty
+    if (derived_file_kept< Uint31_Index >(*transaction, *attic_settings().RELATIONS, *attic_settings().RELATIONS_NEWEST))
+      update_attic_newest_timestamps(new_attic_skeletons, *transaction, *attic_settings().RELATIONS_NEWEST);
+
     // Add attic elements
     update_elements(attic_skeletons_to_delete, new_attic_skeletons,
                     *transaction, *attic_settings().RELATIONS);
@@ -1304,9 +1346,17 @@ void Relation_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu
   {
     copy_idxs_by_id(new_meta, idxs_by_id);
     process_user_data(*transaction, user_by_id, idxs_by_id);
+    if (user_elements_kept)
+    {
+      copy_ids_by_user(new_meta, ids_by_user);
+      process_user_elements(*transaction, ids_by_user, *meta_settings().USER_RELATIONS);
+    }
   }
   callback->update_finished();
 
+  if (basic_settings().record_area_changes)
+    add_changed_ids(new_data, attic_skeletons, new_skeletons, changed_ids);
+
   new_data.data.clear();
 //   rels_meta_to_delete.clear();
 //   rels_meta_to_insert.clear();
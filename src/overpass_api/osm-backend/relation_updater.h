@@ -72,6 +72,8 @@ struct Relation_Updater
       user_by_id[meta->user_id] = meta->user_name;
   }
 
+  const std::vector< Relation::Id_Type >& get_changed_ids() const { return changed_ids; }
+
   uint32 get_role_id(const std::string& s);
   std::vector< std::string > get_roles();
 
@@ -91,6 +93,7 @@ private:
   uint32 max_role_id;
   uint32 max_written_role_id;
   std::vector< std::pair< Relation::Id_Type, Uint31_Index > > moved_relations;
+  std::vector< Relation::Id_Type > changed_ids;
   std::string db_dir;
 
   Data_By_Id< Relation_Skeleton > new_data;
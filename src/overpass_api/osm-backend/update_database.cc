@@ -56,6 +56,14 @@ int main(int argc, char* argv[])
       meta = keep_meta;
     else if (!(strncmp(argv[argpos], "--keep-attic", 12)))
       meta = keep_attic;
+    else if (!(strncmp(argv[argpos], "--inline-way-geometry", 21)))
+      basic_settings().inline_way_geometry = true;
+    else if (!(strncmp(argv[argpos], "--record-area-changes", 21)))
+      basic_settings().record_area_changes = true;
+    else if (!(strncmp(argv[argpos], "--block-checksums", 17)))
+      basic_settings().block_checksums = true;
+    else if (!(strncmp(argv[argpos], "--checksum-interval=", 20)))
+      checksum_verification_interval() = atoll(std::string(argv[argpos]).substr(20).c_str());
     else if (!(strncmp(argv[argpos], "--flush-size=", 13)))
     {
       flush_limit = atoll(std::string(argv[argpos]).substr(13).c_str()) *1024*1024;
@@ -113,10 +121,10 @@ int main(int argc, char* argv[])
   {
 #ifdef HAVE_LZ4
     std::cerr<<"Usage: "<<argv[0]<<" [--db-dir=DIR] [--version=VER] [--meta|--keep-attic] [--flush_size=FLUSH_SIZE]"
-        " [--compression-method=(no|gz|lz4)] [--map-compression-method=(no|gz|lz4)]\n";
+        " [--inline-way-geometry] [--record-area-changes] [--block-checksums] [--checksum-interval=N] [--compression-method=(no|gz|lz4)] [--map-compression-method=(no|gz|lz4)]\n";
 #else
     std::cerr<<"Usage: "<<argv[0]<<" [--db-dir=DIR] [--version=VER] [--meta|--keep-attic] [--flush_size=FLUSH_SIZE]"
-        " [--compression-method=(no|gz)] [--map-compression-method=(no|gz)]\n";
+        " [--inline-way-geometry] [--record-area-changes] [--block-checksums] [--checksum-interval=N] [--compression-method=(no|gz)] [--map-compression-method=(no|gz)]\n";
 #endif
     return 1;
   }
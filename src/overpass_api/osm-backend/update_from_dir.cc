@@ -67,16 +67,10 @@ void process_source_files(const std::string& source_dir,
       ++it;
       continue;
     }
-    FILE* osc_file(fopen((source_dir + *it).c_str(), "r"));
-    if (osc_file)
-    {
-      //reading the main document
-      Caller::parse(osc_file);
-
-      fclose(osc_file);
-    }
-    else
-      throw File_Error(errno, (source_dir + *it), "update_from_dir:1");
+    FILE* osc_file = open_osc_file(source_dir + *it);
+    //reading the main document
+    Caller::parse(osc_file);
+    close_osc_file(osc_file, source_dir + *it);
     ++it;
   }
 };
@@ -89,6 +83,7 @@ int main(int argc, char* argv[])
   meta_modes meta = only_data;
   bool abort = false;
   unsigned int flush_limit = 16*1024*1024;
+  uint64 parse_ahead = 256ull*1024*1024;
 
   int argpos(1);
   while (argpos < argc)
@@ -111,12 +106,18 @@ int main(int argc, char* argv[])
       meta = keep_meta;
     else if (!(strncmp(argv[argpos], "--keep-attic", 12)))
       meta = keep_attic;
+    else if (!(strncmp(argv[argpos], "--inline-way-geometry", 21)))
+      basic_settings().inline_way_geometry = true;
+    else if (!(strncmp(argv[argpos], "--record-area-changes", 21)))
+      basic_settings().record_area_changes = true;
     else if (!(strncmp(argv[argpos], "--flush-size=", 13)))
     {
       flush_limit = atoll(std::string(argv[argpos]).substr(13).c_str()) *1024*1024;
       if (flush_limit == 0)
         flush_limit = std::numeric_limits< unsigned int >::max();
     }
+    else if (!(strncmp(argv[argpos], "--parse-ahead=", 14)))
+      parse_ahead = atoll(std::string(argv[argpos]).substr(14).c_str()) *1024*1024;
     else
     {
       std::cerr<<"Unkown argument: "<<argv[argpos]<<'\n';
@@ -127,7 +128,11 @@ int main(int argc, char* argv[])
   if (abort)
   {
     std::cerr<<"Usage: "<<argv[0]<<" --osc-dir=DIR"
-          " [--db-dir=DIR] [--version=VER] [--meta|--keep-attic] [--flush-size=FLUSH_SIZE]\n";
+          " [--db-dir=DIR] [--version=VER] [--meta|--keep-attic] [--flush-size=FLUSH_SIZE]"
+          " [--parse-ahead=MB] [--inline-way-geometry] [--record-area-changes]\n"
+          "  Files with the suffix .gz are decompressed on the fly.\n"
+          "  A separate process parses the files ahead of the writes and buffers up to MB megabytes"
+          " of parsed changes (default 256). 0 parses and writes in turns in a single process.\n";
     return -1;
   }
 
@@ -149,6 +154,14 @@ int main(int argc, char* argv[])
   }
   std::sort(source_file_names.begin(), source_file_names.end());
 
+  std::vector< std::string > source_paths;
+  for (std::vector< std::string >::const_iterator it = source_file_names.begin();
+      it != source_file_names.end(); ++it)
+  {
+    if (*it != "." && *it != "..")
+      source_paths.push_back(source_dir + *it);
+  }
+
   try
   {
     if (db_dir == "")
@@ -156,9 +169,14 @@ int main(int argc, char* argv[])
       Osm_Updater osm_updater(get_verbatim_callback(), data_version, meta, flush_limit);
       get_verbatim_callback()->parser_started();
 
-      process_source_files< Node_Caller >(source_dir, source_file_names);
-      process_source_files< Way_Caller >(source_dir, source_file_names);
-      process_source_files< Relation_Caller >(source_dir, source_file_names);
+      if (parse_ahead > 0)
+        osm_updater.parse_files_pipelined(source_paths, parse_ahead);
+      else
+      {
+        process_source_files< Node_Caller >(source_dir, source_file_names);
+        process_source_files< Way_Caller >(source_dir, source_file_names);
+        process_source_files< Relation_Caller >(source_dir, source_file_names);
+      }
 
       osm_updater.finish_updater();
     }
@@ -167,9 +185,14 @@ int main(int argc, char* argv[])
       Osm_Updater osm_updater(get_verbatim_callback(), db_dir, data_version, meta, flush_limit);
       get_verbatim_callback()->parser_started();
 
-      process_source_files< Node_Caller >(source_dir, source_file_names);
-      process_source_files< Way_Caller >(source_dir, source_file_names);
-      process_source_files< Relation_Caller >(source_dir, source_file_names);
+      if (parse_ahead > 0)
+        osm_updater.parse_files_pipelined(source_paths, parse_ahead);
+      else
+      {
+        process_source_files< Node_Caller >(source_dir, source_file_names);
+        process_source_files< Way_Caller >(source_dir, source_file_names);
+        process_source_files< Relation_Caller >(source_dir, source_file_names);
+      }
 
       osm_updater.finish_updater();
     }
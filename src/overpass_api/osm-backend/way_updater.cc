@@ -60,6 +60,12 @@ bool geometrically_equal(const Way_Skeleton& a, const Way_Skeleton& b)
 }
 
 
+bool stores_geometry(Uint31_Index idx)
+{
+  return basic_settings().inline_way_geometry || Way::indicates_geometry(idx);
+}
+
+
 void compute_idx_and_geometry
     (Uint31_Index& idx, Way_Skeleton& skeleton,
      uint64 expiration_timestamp,
@@ -94,7 +100,7 @@ void compute_idx_and_geometry
 
   idx = Way::calc_index(nd_idxs);
 
-  if (Way::indicates_geometry(idx))
+  if (stores_geometry(idx))
     skeleton.geometry.swap(geometry);
   else
     skeleton.geometry.clear();
@@ -150,7 +156,11 @@ Way_Skeleton add_intermediate_versions
     Uint31_Index reference_idx;
     Way_Skeleton reference_skel = reference;
     compute_idx_and_geometry(reference_idx, reference_skel, new_timestamp + 1, nodes_by_id);
-    if (idx == reference_idx)
+    uint64 valid_since = old_timestamp;
+    for (std::vector< uint64 >::const_iterator it = relevant_timestamps.begin();
+        it != relevant_timestamps.end() && *it < new_timestamp; ++it)
+      valid_since = *it;
+    if (idx == reference_idx && !attic_checkpoint_due(valid_since, new_timestamp))
       full_attic[idx].insert(Attic< Way_Delta >(
           Way_Delta(reference_skel, cur_skeleton), new_timestamp));
     else
@@ -179,7 +189,8 @@ Way_Skeleton add_intermediate_versions
     Way_Skeleton cur_skeleton = skeleton;
     if (idx.val() == 0 || it != relevant_timestamps.begin())
       compute_idx_and_geometry(idx, cur_skeleton, *it, nodes_by_id);
-    if (last_idx == idx)
+    if (last_idx == idx
+        && !attic_checkpoint_due(it == relevant_timestamps.begin() ? old_timestamp : *(it-1), *it))
       full_attic[idx].insert(Attic< Way_Delta >(
           Way_Delta(last_skeleton, cur_skeleton), *it));
     else
@@ -277,7 +288,8 @@ void adapt_newest_existing_attic
      std::map< Uint31_Index, std::set< Attic< Way_Delta > > >& attic_skeletons_to_delete,
      std::map< Uint31_Index, std::set< Attic< Way_Delta > > >& full_attic)
 {
-  Way_Delta new_delta(old_idx == new_idx ? new_reference : Way_Skeleton(),
+  // A checkpoint stays a full delta
+  Way_Delta new_delta(old_idx == new_idx && !existing_delta.full ? new_reference : Way_Skeleton(),
 		      existing_delta.expand(existing_reference));
   if (!(new_delta.id == existing_delta.id)
       || new_delta.full != existing_delta.full
@@ -612,7 +624,7 @@ void compute_geometry
 
     it->elem.geometry.clear();
 
-    if (Way::indicates_geometry(index))
+    if (stores_geometry(index))
     {
       for (std::vector< Node::Id_Type >::const_iterator nit = it->elem.nds.begin();
            nit != it->elem.nds.end(); ++nit)
@@ -670,7 +682,7 @@ void new_implicit_skeletons
       Way_Skeleton new_skeleton = *it2;
       new_skeleton.geometry.clear();
 
-      if (Way::indicates_geometry(index))
+      if (stores_geometry(index))
       {
         for (std::vector< Node::Id_Type >::const_iterator nit = it2->nds.begin(); nit != it2->nds.end(); ++nit)
         {
@@ -694,6 +706,21 @@ void new_implicit_skeletons
 }
 
 
+void add_node_ways(const std::map< Uint31_Index, std::set< Way_Skeleton > >& skeletons,
+    std::map< Node::Id_Type, std::set< Way::Id_Type > >& node_ways)
+{
+  for (std::map< Uint31_Index, std::set< Way_Skeleton > >::const_iterator it = skeletons.begin();
+      it != skeletons.end(); ++it)
+  {
+    for (std::set< Way_Skeleton >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+    {
+      for (std::vector< Node::Id_Type >::const_iterator it3 = it2->nds.begin(); it3 != it2->nds.end(); ++it3)
+        node_ways[*it3].insert(it2->id);
+    }
+  }
+}
+
+
 /* Compares the new data and the already existing skeletons to determine those that have
  * moved. This information is used to prepare the std::set of elements to store to attic.
  * We use that in attic_skeletons can only appear elements with ids that exist also in new_data. */
@@ -904,11 +931,24 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
   update_map_positions(new_positions, *transaction, *osm_base_settings().WAYS);
   callback->update_ids_finished();
 
+  // Update the reverse file from nodes to ways
+  if (derived_file_kept< Uint31_Index >(*transaction, *osm_base_settings().WAYS, *osm_base_settings().NODE_WAYS))
+  {
+    std::map< Node::Id_Type, std::set< Way::Id_Type > > attic_node_ways;
+    std::map< Node::Id_Type, std::set< Way::Id_Type > > new_node_ways;
+    add_node_ways(attic_skeletons, attic_node_ways);
+    add_node_ways(new_skeletons, new_node_ways);
+    cancel_out_equal_entries(attic_node_ways, new_node_ways);
+    update_elements(attic_node_ways, new_node_ways, *transaction, *osm_base_settings().NODE_WAYS);
+  }
+
   // Update skeletons
   update_elements(attic_skeletons, new_skeletons, *transaction, *osm_base_settings().WAYS);
   callback->update_coords_finished();
 
   // Update meta
+  bool user_elements_kept = meta
+      && derived_file_kept< Uint31_Index >(*transaction, *meta_settings().WAYS_META, *meta_settings().USER_WAYS);
   if (meta)
     update_elements(attic_meta, new_meta, *transaction, *meta_settings().WAYS_META);
 
@@ -921,6 +961,7 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
   callback->tags_global_finished();
 
   std::map< uint32, std::vector< uint32 > > idxs_by_id;
+  std::map< Uint32_Index, std::set< Way_Skeleton::Id_Type > > ids_by_user;
 
   if (meta == keep_attic)
   {
@@ -984,6 +1025,8 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
 
     // Prepare user indices
     copy_idxs_by_id(new_attic_meta, idxs_by_id);
+    if (user_elements_kept)
+      copy_ids_by_user(new_attic_meta, ids_by_user);
 
     // Update id indexes
     update_map_positions(new_attic_map_positions, *transaction, *attic_settings().WAYS);
@@ -992,6 +1035,10 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
     update_elements(existing_idx_lists, new_attic_idx_lists,
                     *transaction, *attic_settings().WAY_IDX_LIST);
 
+    // Update the newest timestamps per index before the attic elements make the file non-empty
+    if (derived_file_kept< Uint31_Index >(*transaction, *attic_settings().WAYS, *attic_settings().WAYS_NEWEST))
+      update_attic_newest_timestamps(new_attic_skeletons, *transaction, *attic_settings().WAYS_NEWEST);
+
     // Add attic elements
     update_elements(attic_skeletons_to_delete, new_attic_skeletons,
                     *transaction, *attic_settings().WAYS);
@@ -1021,9 +1068,17 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
   {
     copy_idxs_by_id(new_meta, idxs_by_id);
     process_user_data(*transaction, user_by_id, idxs_by_id);
+    if (user_elements_kept)
+    {
+      copy_ids_by_user(new_meta, ids_by_user);
+      process_user_elements(*transaction, ids_by_user, *meta_settings().USER_WAYS);
+    }
   }
   callback->update_finished();
 
+  if (basic_settings().record_area_changes)
+    add_changed_ids(new_data, attic_skeletons, new_skeletons, changed_ids);
+
   new_data.data.clear();
 //   ways_meta_to_insert.clear();
 //   ways_meta_to_delete.clear();
@@ -1074,6 +1129,7 @@ void Way_Updater::update(Osm_Backend_Callback* callback, Cpu_Stopwatch* cpu_stop
     std::string to(".0a");
     to[2] += update_counter % 16;
     rename_referred_file(db_dir, "", to, *osm_base_settings().WAYS);
+    rename_referred_file(db_dir, "", to, *osm_base_settings().NODE_WAYS);
     rename_referred_file(db_dir, "", to, *osm_base_settings().WAY_TAGS_LOCAL);
     rename_referred_file(db_dir, "", to, *osm_base_settings().WAY_TAGS_GLOBAL);
     if (meta)
@@ -1124,6 +1180,8 @@ void Way_Updater::merge_files(const std::vector< std::string >& froms, std::stri
   Nonsynced_Transaction into_transaction(true, false, db_dir, into);
   ::merge_files< Uint31_Index, Way_Skeleton >
       (from_transactions, into_transaction, *osm_base_settings().WAYS);
+  ::merge_files< Node::Id_Type, Way::Id_Type >
+      (from_transactions, into_transaction, *osm_base_settings().NODE_WAYS);
   ::merge_files< Tag_Index_Local, Way::Id_Type >
       (from_transactions, into_transaction, *osm_base_settings().WAY_TAGS_LOCAL);
   ::merge_files< Tag_Index_Global, Tag_Object_Global< Way::Id_Type > >
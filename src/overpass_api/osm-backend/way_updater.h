@@ -82,6 +82,8 @@ struct Way_Updater
     return moved_ways;
   }
 
+  const std::vector< Way::Id_Type >& get_changed_ids() const { return changed_ids; }
+
   const std::map< Uint31_Index, std::set< Way_Skeleton > > get_new_skeletons() const
       { return new_skeletons; }
   const std::map< Uint31_Index, std::set< Way_Skeleton > > get_attic_skeletons() const
@@ -95,6 +97,7 @@ private:
   bool external_transaction;
   bool partial_possible;
   std::vector< std::pair< Way::Id_Type, Uint31_Index > > moved_ways;
+  std::vector< Way::Id_Type > changed_ids;
   std::string db_dir;
 
   Data_By_Id< Way_Skeleton > new_data;
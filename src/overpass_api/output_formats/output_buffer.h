@@ -0,0 +1,150 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__OUTPUT_FORMATS__OUTPUT_BUFFER_H
+#define DE__OSM3S___OVERPASS_API__OUTPUT_FORMATS__OUTPUT_BUFFER_H
+
+
+#include "../../expat/escape_json.h"
+#include "../../expat/escape_xml.h"
+#include "../core/basic_types.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+
+struct Fixed_7
+{
+  explicit Fixed_7(double value_) : value(value_) {}
+  double value;
+};
+
+
+struct Json_Escaped
+{
+  explicit Json_Escaped(const std::string& s_) : s(s_) {}
+  const std::string& s;
+};
+
+
+struct Xml_Escaped
+{
+  explicit Xml_Escaped(const std::string& s_) : s(s_) {}
+  const std::string& s;
+};
+
+
+/* Collects the text of one printed element and writes it to std::cout in a single call.
+ * Numbers are formatted by hand instead of through the stream state and locale of std::cout,
+ * and strings are escaped directly into the buffer. The buffer keeps its capacity between elements. */
+class Output_Buffer
+{
+public:
+  Output_Buffer() { buf.reserve(64*1024); }
+
+  Output_Buffer& operator<<(const char* s) { buf.append(s); return *this; }
+  Output_Buffer& operator<<(const std::string& s) { buf.append(s); return *this; }
+  Output_Buffer& operator<<(char c) { buf.push_back(c); return *this; }
+
+  Output_Buffer& operator<<(uint64 value) { append_unsigned(value); return *this; }
+  Output_Buffer& operator<<(uint32 value) { append_unsigned(value); return *this; }
+  Output_Buffer& operator<<(int64 value);
+  Output_Buffer& operator<<(int32 value) { return *this<<(int64)value; }
+
+  // Equivalent to std::fixed<<std::setprecision(7)<<value
+  Output_Buffer& operator<<(Fixed_7 value);
+
+  Output_Buffer& operator<<(Json_Escaped s) { escape_cstr(s.s, buf); return *this; }
+  Output_Buffer& operator<<(Xml_Escaped s) { escape_xml(s.s, buf); return *this; }
+
+  void flush()
+  {
+    std::cout.write(buf.data(), buf.size());
+    buf.clear();
+  }
+
+private:
+  std::string buf;
+
+  void append_unsigned(uint64 value);
+};
+
+
+inline void Output_Buffer::append_unsigned(uint64 value)
+{
+  char digits[20];
+  char* pos = digits + sizeof(digits);
+  do
+  {
+    *--pos = '0' + value % 10;
+    value /= 10;
+  }
+  while (value > 0);
+  buf.append(pos, digits + sizeof(digits));
+}
+
+
+inline Output_Buffer& Output_Buffer::operator<<(int64 value)
+{
+  if (value < 0)
+  {
+    buf.push_back('-');
+    append_unsigned(-(uint64)value);
+  }
+  else
+    append_unsigned(value);
+  return *this;
+}
+
+
+inline Output_Buffer& Output_Buffer::operator<<(Fixed_7 value)
+{
+  // Coordinates are multiples of 1e-7 up to rounding errors, hence the scaled value is close to an integer.
+  // Values close to half-way and all special cases are left to printf to get the same rounding as iostreams.
+  double scaled = value.value * 1e7;
+  if (scaled > -9e15 && scaled < 9e15)
+  {
+    int64 rounded = (int64)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    double remainder = scaled - rounded;
+    if (rounded != 0 && remainder < 0.499 && remainder > -0.499)
+    {
+      uint64 abs_rounded = rounded < 0 ? -(uint64)rounded : rounded;
+      if (rounded < 0)
+        buf.push_back('-');
+      append_unsigned(abs_rounded / 10000000);
+      char fraction[8] = { '.', '0', '0', '0', '0', '0', '0', '0' };
+      uint64 frac = abs_rounded % 10000000;
+      for (int i = 7; i > 0; --i)
+      {
+        fraction[i] = '0' + frac % 10;
+        frac /= 10;
+      }
+      buf.append(fraction, 8);
+      return *this;
+    }
+  }
+
+  char fallback[384];
+  snprintf(fallback, sizeof(fallback), "%.7f", value.value);
+  buf.append(fallback);
+  return *this;
+}
+
+
+#endif
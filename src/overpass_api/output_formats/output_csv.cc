@@ -28,31 +28,22 @@ bool Output_CSV::write_http_headers()
 
 
 // Escape CSV output according to RFC 4180
-std::string escape_csv(const std::string& input)
+void print_escaped_csv(Output_Buffer& out, const std::string& input)
 {
-  std::string result;
-  bool quotes_needed = false;
-
-  for (int i = input.size() - 1; i >= 0; --i)
+  if (input.find_first_of("\n,\"") == std::string::npos)
   {
-    if (input[i] == '\n' || input[i] == ',')
-      quotes_needed = true;
-    else if (input[i] == '\"')
-    {
-      quotes_needed = true;
-      if (result.empty())
-        result = input.substr(0, i) + "\"" + input.substr(i);
-      else
-        result = result.substr(0, i) + "\"" + result.substr(i);
-    }
+    out<<input;
+    return;
   }
 
-  if (!quotes_needed)
-    return input;
-  else if (result.empty())
-    return std::string("\"") + input + "\"";
-  else
-    return std::string("\"") + result + "\"";
+  out<<'\"';
+  for (std::string::size_type i = 0; i < input.size(); ++i)
+  {
+    if (input[i] == '\"')
+      out<<'\"';
+    out<<input[i];
+  }
+  out<<'\"';
 }
 
 
@@ -64,11 +55,13 @@ void Output_CSV::write_payload_header
     for (std::vector< std::pair< std::string, bool > >::const_iterator it = csv_settings.keyfields.begin();
         it != csv_settings.keyfields.end(); ++it)
     {
-      std::cout<<(it->second ? "@" : "")<<escape_csv(it->first);
+      out<<(it->second ? "@" : "");
+      print_escaped_csv(out, it->first);
       if (it + 1 != csv_settings.keyfields.end())
-        std::cout<<csv_settings.separator;
+        out<<csv_settings.separator;
     }
-    std::cout<<'\n';
+    out<<'\n';
+    out.flush();
   }
 }
 
@@ -118,28 +111,28 @@ std::string Output_CSV::dump_config() const
 
 
 template< typename OSM_Element_Metadata_Skeleton >
-void print_meta(const std::string& keyfield,
+void print_meta(Output_Buffer& out, const std::string& keyfield,
     const OSM_Element_Metadata_Skeleton& meta, const std::map< uint32, std::string >* users)
 {
   if (keyfield == "version")
-    std::cout<<meta.version;
+    out<<meta.version;
   else if (keyfield == "timestamp")
-    std::cout<<Timestamp(meta.timestamp).str();
+    out<<Timestamp(meta.timestamp).str();
   else if (keyfield == "changeset")
-    std::cout<<meta.changeset;
+    out<<meta.changeset;
   else if (keyfield == "uid")
-    std::cout<<meta.user_id;
+    out<<meta.user_id;
   else if (users && keyfield == "user")
   {
     std::map< uint32, std::string >::const_iterator uit = users->find(meta.user_id);
     if (uit != users->end())
-      std::cout<<uit->second;
+      out<<uit->second;
   }
 }
 
 
 template< >
-void print_meta< int >(const std::string& keyfield,
+void print_meta< int >(Output_Buffer& out, const std::string& keyfield,
     const int& meta, const std::map< uint32, std::string >* users) {}
 
 std::string get_count_tag(const std::vector< std::pair< std::string, std::string> >* tags, std::string tag)
@@ -154,7 +147,7 @@ std::string get_count_tag(const std::vector< std::pair< std::string, std::string
 
 
 template< typename Id_Type, typename OSM_Element_Metadata_Skeleton >
-void process_csv_line(int otype, const std::string& type, Id_Type id, const Opaque_Geometry& geometry,
+void process_csv_line(Output_Buffer& out, int otype, const std::string& type, Id_Type id, const Opaque_Geometry& geometry,
     const OSM_Element_Metadata_Skeleton* meta,
     const std::vector< std::pair< std::string, std::string> >* tags,
     const std::map< uint32, std::string >* users,
@@ -173,7 +166,7 @@ void process_csv_line(int otype, const std::string& type, Id_Type id, const Opaq
 	{
 	  if (it_tags->first == it->first)
 	  {
-	    std::cout<<escape_csv(it_tags->second);
+	    print_escaped_csv(out, it_tags->second);
 	    break;
 	  }
 	}
@@ -182,49 +175,50 @@ void process_csv_line(int otype, const std::string& type, Id_Type id, const Opaq
     else
     {
       if (meta)
-        print_meta(it->first, *meta, users);
+        print_meta(out, it->first, *meta, users);
 
       if (it->first == "id")
       {
         if (mode.mode & Output_Mode::ID)
-          std::cout<<id.val();
+          out<<id.val();
       }
       else if (it->first == "otype")
-        std::cout<<otype;
+        out<<otype;
       else if (it->first == "type")
-	std::cout<<type;
+	out<<type;
       else if (it->first == "lat")
       {
         if ((mode.mode & (Output_Mode::COORDS | Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER))
 	    && geometry.has_center())
-          std::cout<<std::fixed<<std::setprecision(7)<<geometry.center_lat();
+          out<<Fixed_7(geometry.center_lat());
       }
       else if (it->first == "lon")
       {
         if ((mode.mode & (Output_Mode::COORDS | Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER))
 	    && geometry.has_center())
-          std::cout<<std::fixed<<std::setprecision(7)<<geometry.center_lon();
+          out<<Fixed_7(geometry.center_lon());
       }
       if (type == "count")
       {
         if (it->first == "count")
-          std::cout << get_count_tag(tags, "total");
+          out << get_count_tag(tags, "total");
         else if (it->first == "count:nodes")
-          std::cout << get_count_tag(tags, "nodes");
+          out << get_count_tag(tags, "nodes");
         else if (it->first == "count:ways")
-          std::cout << get_count_tag(tags, "ways");
+          out << get_count_tag(tags, "ways");
         else if (it->first == "count:relations")
-          std::cout << get_count_tag(tags, "relations");
+          out << get_count_tag(tags, "relations");
         else if (it->first == "count:areas")
-          std::cout << get_count_tag(tags, "areas");
+          out << get_count_tag(tags, "areas");
       }
     }
 
     if (++it == csv_settings.keyfields.end())
       break;
-    std::cout<<csv_settings.separator;
+    out<<csv_settings.separator;
   }
-  std::cout<<"\n";
+  out<<"\n";
+  out.flush();
 }
 
 
@@ -240,7 +234,7 @@ void Output_CSV::print_item(const Node_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Node::Id_Type >* new_meta)
 {
-  process_csv_line(1, "node", skel.id, geometry, meta, tags, users, csv_settings, mode);
+  process_csv_line(out, 1, "node", skel.id, geometry, meta, tags, users, csv_settings, mode);
 }
 
 
@@ -256,7 +250,7 @@ void Output_CSV::print_item(const Way_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Way::Id_Type >* new_meta)
 {
-  process_csv_line(2, "way", skel.id, geometry, meta, tags, users, csv_settings, mode);
+  process_csv_line(out, 2, "way", skel.id, geometry, meta, tags, users, csv_settings, mode);
 }
 
 
@@ -273,7 +267,7 @@ void Output_CSV::print_item(const Relation_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* new_meta)
 {
-  process_csv_line(3, "relation", skel.id, geometry, meta, tags, users, csv_settings, mode);
+  process_csv_line(out, 3, "relation", skel.id, geometry, meta, tags, users, csv_settings, mode);
 }
 
 
@@ -284,5 +278,5 @@ void Output_CSV::print_item(const Derived_Skeleton& skel,
       const Feature_Action& action)
 {
   process_csv_line< Derived_Skeleton::Id_Type, int >(
-      4, skel.type_name, skel.id, geometry, 0, tags, 0, csv_settings, mode);
+      out, 4, skel.type_name, skel.id, geometry, 0, tags, 0, csv_settings, mode);
 }
@@ -23,6 +23,7 @@
 #include "../core/datatypes.h"
 #include "../core/geometry.h"
 #include "../frontend/output_handler.h"
+#include "output_buffer.h"
 
 #include <string>
 #include <vector>
@@ -97,6 +98,7 @@ public:
 
 private:
   Csv_Settings csv_settings;
+  Output_Buffer out;
 };
 
 
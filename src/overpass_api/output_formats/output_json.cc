@@ -69,38 +69,38 @@ void Output_JSON::display_error(const std::string& text)
 }
 
 
-void handle_first_elem(bool& first_elem)
+void handle_first_elem(Output_Buffer& out, bool& first_elem)
 {
   if (!first_elem)
-    std::cout<<",\n";
+    out<<",\n";
   first_elem = false;
 }
 
 
 template< typename Id_Type >
-void print_meta_json(const OSM_Element_Metadata_Skeleton< Id_Type >& meta,
+void print_meta_json(Output_Buffer& out, const OSM_Element_Metadata_Skeleton< Id_Type >& meta,
 		    const std::map< uint32, std::string >& users)
 {
-  std::cout<<",\n  \"timestamp\": \""<<iso_string(meta.timestamp)<<"\""
+  out<<",\n  \"timestamp\": \""<<iso_string(meta.timestamp)<<"\""
         ",\n  \"version\": "<<meta.version<<
 	",\n  \"changeset\": "<<meta.changeset;
   std::map< uint32, std::string >::const_iterator it = users.find(meta.user_id);
   if (it != users.end())
-    std::cout<<",\n  \"user\": \""<<escape_cstr(it->second)<<"\"";
-  std::cout<<",\n  \"uid\": "<<meta.user_id;
+    out<<",\n  \"user\": \""<<Json_Escaped(it->second)<<"\"";
+  out<<",\n  \"uid\": "<<meta.user_id;
 }
 
 
-void print_tags(const std::vector< std::pair< std::string, std::string > >* tags)
+void print_tags(Output_Buffer& out, const std::vector< std::pair< std::string, std::string > >* tags)
 {
   if (tags != 0 && !tags->empty())
   {
     std::vector< std::pair< std::string, std::string > >::const_iterator it = tags->begin();
-    std::cout<<",\n  \"tags\": {"
-           "\n    \""<<escape_cstr(it->first)<<"\": \""<<escape_cstr(it->second)<<"\"";
+    out<<",\n  \"tags\": {"
+           "\n    \""<<Json_Escaped(it->first)<<"\": \""<<Json_Escaped(it->second)<<"\"";
     for (++it; it != tags->end(); ++it)
-      std::cout<<",\n    \""<<escape_cstr(it->first)<<"\": \""<<escape_cstr(it->second)<<"\"";
-    std::cout<<"\n  }";
+      out<<",\n    \""<<Json_Escaped(it->first)<<"\": \""<<Json_Escaped(it->second)<<"\"";
+    out<<"\n  }";
   }
 }
 
@@ -117,36 +117,37 @@ void Output_JSON::print_item(const Node_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Node::Id_Type >* new_meta)
 {
-  handle_first_elem(first_elem);
-  std::cout<<"{\n"
+  handle_first_elem(out, first_elem);
+  out<<"{\n"
         "  \"type\": \"node\"";
   if (mode.mode & Output_Mode::ID)
-    std::cout<<",\n  \"id\": "<<skel.id.val();
+    out<<",\n  \"id\": "<<skel.id.val();
 
   if (mode.mode & (Output_Mode::COORDS | Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER))
-    std::cout<<",\n  \"lat\": "<<std::fixed<<std::setprecision(7)<<geometry.center_lat()
-        <<",\n  \"lon\": "<<std::fixed<<std::setprecision(7)<<geometry.center_lon();
+    out<<",\n  \"lat\": "<<Fixed_7(geometry.center_lat())
+        <<",\n  \"lon\": "<<Fixed_7(geometry.center_lon());
   if (meta)
-    print_meta_json(*meta, *users);
+    print_meta_json(out, *meta, *users);
 
-  print_tags(tags);
-  std::cout<<"\n}";
+  print_tags(out, tags);
+  out<<"\n}";
+  out.flush();
 }
 
 
-void print_bounds(const Opaque_Geometry& geometry, Output_Mode mode)
+void print_bounds(Output_Buffer& out, const Opaque_Geometry& geometry, Output_Mode mode)
 {
   if ((mode.mode & Output_Mode::BOUNDS) && geometry.has_bbox())
-    std::cout<<",\n  \"bounds\": {\n"
-        "    \"minlat\": "<<std::fixed<<std::setprecision(7)<<geometry.south()<<",\n"
-        "    \"minlon\": "<<std::fixed<<std::setprecision(7)<<geometry.west()<<",\n"
-        "    \"maxlat\": "<<std::fixed<<std::setprecision(7)<<geometry.north()<<",\n"
-        "    \"maxlon\": "<<std::fixed<<std::setprecision(7)<<geometry.east()<<"\n"
+    out<<",\n  \"bounds\": {\n"
+        "    \"minlat\": "<<Fixed_7(geometry.south())<<",\n"
+        "    \"minlon\": "<<Fixed_7(geometry.west())<<",\n"
+        "    \"maxlat\": "<<Fixed_7(geometry.north())<<",\n"
+        "    \"maxlon\": "<<Fixed_7(geometry.east())<<"\n"
         "  }";
   else if ((mode.mode & Output_Mode::CENTER) && geometry.has_center())
-    std::cout<<",\n  \"center\": {\n"
-        "    \"lat\": "<<std::fixed<<std::setprecision(7)<<geometry.center_lat()<<",\n"
-        "    \"lon\": "<<std::fixed<<std::setprecision(7)<<geometry.center_lon()<<"\n"
+    out<<",\n  \"center\": {\n"
+        "    \"lat\": "<<Fixed_7(geometry.center_lat())<<",\n"
+        "    \"lon\": "<<Fixed_7(geometry.center_lon())<<"\n"
         "  }";
 }
 
@@ -163,48 +164,47 @@ void Output_JSON::print_item(const Way_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Way::Id_Type >* new_meta)
 {
-  handle_first_elem(first_elem);
-  std::cout<<"{\n"
+  handle_first_elem(out, first_elem);
+  out<<"{\n"
         "  \"type\": \"way\"";
   if (mode.mode & Output_Mode::ID)
-    std::cout<<",\n  \"id\": "<<skel.id.val();
+    out<<",\n  \"id\": "<<skel.id.val();
 
   if (meta)
-    print_meta_json(*meta, *users);
+    print_meta_json(out, *meta, *users);
 
-  print_bounds(geometry, mode);
+  print_bounds(out, geometry, mode);
 
   if ((mode.mode & Output_Mode::NDS) != 0 && !skel.nds.empty())
   {
     std::vector< Node::Id_Type >::const_iterator it = skel.nds.begin();
-    std::cout<<",\n  \"nodes\": ["
+    out<<",\n  \"nodes\": ["
            "\n    "<<it->val();
     for (++it; it != skel.nds.end(); ++it)
-      std::cout<<",\n    "<<it->val();
-    std::cout<<"\n  ]";
+      out<<",\n    "<<it->val();
+    out<<"\n  ]";
   }
 
   if ((mode.mode & Output_Mode::GEOMETRY) != 0 && geometry.has_faithful_way_geometry())
   {
-    std::cout<<",\n  \"geometry\": [";
+    out<<",\n  \"geometry\": [";
     for (uint i = 0; i < geometry.way_size(); ++i)
     {
       if (geometry.way_pos_is_valid(i))
-        std::cout<<"\n    { \"lat\": "<<std::fixed<<std::setprecision(7)
-            <<geometry.way_pos_lat(i)
-            <<", \"lon\": "<<std::fixed<<std::setprecision(7)
-            <<geometry.way_pos_lon(i)<<" }";
+        out<<"\n    { \"lat\": "<<Fixed_7(geometry.way_pos_lat(i))
+            <<", \"lon\": "<<Fixed_7(geometry.way_pos_lon(i))<<" }";
       else
-        std::cout<<"\n    null";
+        out<<"\n    null";
 
       if (i < geometry.way_size() - 1)
-        std::cout << ",";
+        out << ",";
     }
-    std::cout<<"\n  ]";
+    out<<"\n  ]";
   }
 
-  print_tags(tags);
-  std::cout<<"\n}";
+  print_tags(out, tags);
+  out<<"\n}";
+  out.flush();
 }
 
 
@@ -221,61 +221,60 @@ void Output_JSON::print_item(const Relation_Skeleton& skel,
       const std::vector< std::pair< std::string, std::string > >* new_tags,
       const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* new_meta)
 {
-  handle_first_elem(first_elem);
-  std::cout<<"{\n"
+  handle_first_elem(out, first_elem);
+  out<<"{\n"
         "  \"type\": \"relation\"";
   if (mode.mode & Output_Mode::ID)
-    std::cout<<",\n  \"id\": "<<skel.id.val();
+    out<<",\n  \"id\": "<<skel.id.val();
 
   if (meta)
-    print_meta_json(*meta, *users);
+    print_meta_json(out, *meta, *users);
 
-  print_bounds(geometry, mode);
+  print_bounds(out, geometry, mode);
 
   if (roles && (mode.mode & Output_Mode::MEMBERS) != 0 && !skel.members.empty())
   {
-    std::cout<<",\n  \"members\": [";
+    out<<",\n  \"members\": [";
     for (uint i = 0; i < skel.members.size(); i++)
     {
       std::map< uint32, std::string >::const_iterator rit = roles->find(skel.members[i].role);
-      std::cout<< (i == 0 ? "" : ",");
-      std::cout <<"\n    {"
+      out<< (i == 0 ? "" : ",");
+      out <<"\n    {"
             "\n      \"type\": \""<<member_type_name(skel.members[i].type)<<
             "\",\n      \"ref\": "<<skel.members[i].ref.val()<<
-            ",\n      \"role\": \""<<escape_cstr(rit != roles->end() ? rit->second : "???") << "\"";
+            ",\n      \"role\": \""<<Json_Escaped(rit != roles->end() ? rit->second : "???") << "\"";
 
       if (skel.members[i].type == Relation_Entry::NODE &&
           geometry.has_faithful_relation_geometry() && geometry.relation_pos_is_valid(i))
-        std::cout<<",\n      \"lat\": "<<std::fixed<<std::setprecision(7)<<geometry.relation_pos_lat(i)
-            <<",\n      \"lon\": "<<std::fixed<<std::setprecision(7)<<geometry.relation_pos_lon(i);
+        out<<",\n      \"lat\": "<<Fixed_7(geometry.relation_pos_lat(i))
+            <<",\n      \"lon\": "<<Fixed_7(geometry.relation_pos_lon(i));
 
       if (skel.members[i].type == Relation_Entry::WAY && geometry.has_faithful_relation_geometry())
       {
-        std::cout<<",\n      \"geometry\": [";
+        out<<",\n      \"geometry\": [";
         for (uint j = 0; j < geometry.relation_way_size(i); ++j)
         {
           if (geometry.relation_pos_is_valid(i, j))
           {
-            std::cout<<"\n         { \"lat\": "<<std::fixed<<std::setprecision(7)
-                <<geometry.relation_pos_lat(i, j)
-                <<", \"lon\": "<<std::fixed<<std::setprecision(7)
-                <<geometry.relation_pos_lon(i, j)<<" }";
+            out<<"\n         { \"lat\": "<<Fixed_7(geometry.relation_pos_lat(i, j))
+                <<", \"lon\": "<<Fixed_7(geometry.relation_pos_lon(i, j))<<" }";
           }
           else
-            std::cout<<"\n         null";
+            out<<"\n         null";
           if (j < geometry.relation_way_size(i) - 1)
-            std::cout << ",";
+            out << ",";
         }
-        std::cout<<"\n      ]";
+        out<<"\n      ]";
       }
 
-      std::cout<<"\n    }";
+      out<<"\n    }";
     }
-    std::cout<<"\n  ]";
+    out<<"\n  ]";
   }
 
-  print_tags(tags);
-  std::cout<<"\n}";
+  print_tags(out, tags);
+  out<<"\n}";
+  out.flush();
 }
 
 
@@ -285,12 +284,13 @@ void Output_JSON::print_item(const Derived_Skeleton& skel,
       Output_Mode mode,
       const Feature_Action& action)
 {
-  handle_first_elem(first_elem);
-  std::cout<<"{\n"
+  handle_first_elem(out, first_elem);
+  out<<"{\n"
         "  \"type\": \""<<skel.type_name<<"\"";
   if (mode.mode & Output_Mode::ID)
-    std::cout<<",\n  \"id\": "<<skel.id.val();
+    out<<",\n  \"id\": "<<skel.id.val();
 
-  print_tags(tags);
-  std::cout<<"\n}";
+  print_tags(out, tags);
+  out<<"\n}";
+  out.flush();
 }
@@ -23,6 +23,7 @@
 #include "../core/datatypes.h"
 #include "../core/geometry.h"
 #include "../frontend/output_handler.h"
+#include "output_buffer.h"
 
 #include <string>
 #include <vector>
@@ -89,6 +90,7 @@ private:
   std::string padding;
   std::string messages;
   mutable bool first_elem;
+  Output_Buffer out;
 };
 
 
@@ -0,0 +1,480 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../template_db/zlib_wrapper.h"
+#include "../core/settings.h"
+#include "output_pbf.h"
+
+#include <iostream>
+#include <vector>
+
+
+const uint32 PBF_BLOCK_SIZE = 8000;
+const uint32 PBF_BLOCK_BYTES = 8*1024*1024;
+
+// Index 0 of the string table ends the tags of a dense node, hence even the empty string gets its own index
+const std::string reserved_string;
+
+
+namespace
+{
+  enum Wire_Type { varint = 0, length_delimited = 2 };
+
+
+  void append_varint(std::string& buf, uint64 value)
+  {
+    while (value >= 0x80)
+    {
+      buf.push_back((char)((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    buf.push_back((char)value);
+  }
+
+
+  uint64 zigzag(int64 value)
+  {
+    return ((uint64)value << 1) ^ (uint64)(value >> 63);
+  }
+
+
+  void append_varint_field(std::string& buf, uint32 field, uint64 value)
+  {
+    append_varint(buf, (field<<3) | varint);
+    append_varint(buf, value);
+  }
+
+
+  void append_bytes_field(std::string& buf, uint32 field, const std::string& bytes)
+  {
+    append_varint(buf, (field<<3) | length_delimited);
+    append_varint(buf, bytes.size());
+    buf.append(bytes);
+  }
+
+
+  void append_packed_field(std::string& buf, uint32 field, const std::string& packed)
+  {
+    if (!packed.empty())
+      append_bytes_field(buf, field, packed);
+  }
+
+
+  // Coordinates in units of the default granularity of 100 nanodegrees
+  int64 pbf_coord(double value)
+  {
+    double scaled = value * 1e7;
+    return (int64)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+  }
+
+
+  // Seconds since 1970-01-01, the unit of the default date granularity of 1000 milliseconds
+  int64 epoch_seconds(const Timestamp& timestamp)
+  {
+    int64 year = timestamp.year() - (timestamp.month() <= 2 ? 1 : 0);
+    int64 era = (year >= 0 ? year : year - 399) / 400;
+    int64 year_of_era = year - era * 400;
+    int64 day_of_year = (153 * (timestamp.month() + (timestamp.month() > 2 ? -3 : 9)) + 2) / 5
+        + timestamp.day() - 1;
+    int64 day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    int64 days = era * 146097 + day_of_era - 719468;
+    return days * 86400 + timestamp.hour() * 3600 + timestamp.minute() * 60 + timestamp.second();
+  }
+
+
+  void write_blob(const std::string& type, const std::string& data)
+  {
+    std::vector< char > compressed(data.size() + data.size() / 64 + 1024);
+    int compressed_size = Zlib_Deflate(Z_DEFAULT_COMPRESSION).compress(
+        data.data(), data.size(), &compressed[0], compressed.size());
+
+    std::string blob;
+    append_varint_field(blob, 2, data.size());
+    append_bytes_field(blob, 3, std::string(&compressed[0], compressed_size));
+
+    std::string blob_header;
+    append_bytes_field(blob_header, 1, type);
+    append_varint_field(blob_header, 3, blob.size());
+
+    char size[4] = { (char)(blob_header.size()>>24), (char)(blob_header.size()>>16),
+        (char)(blob_header.size()>>8), (char)blob_header.size() };
+    std::cout.write(size, 4);
+    std::cout.write(blob_header.data(), blob_header.size());
+    std::cout.write(blob.data(), blob.size());
+  }
+}
+
+
+bool Output_PBF::write_http_headers()
+{
+  std::cout<<"Content-type: application/x-protobuf\n";
+  return true;
+}
+
+
+void Output_PBF::write_payload_header
+    (const std::string& db_dir, const std::string& timestamp, const std::string& area_timestamp)
+{
+  std::string header;
+  append_bytes_field(header, 4, "OsmSchema-V0.6");
+  append_bytes_field(header, 4, "DenseNodes");
+  append_bytes_field(header, 16, "Overpass API " + basic_settings().version + " "
+      + basic_settings().source_hash.substr(0, 8));
+  if (!timestamp.empty() && Timestamp(timestamp).timestamp != 0)
+    append_varint_field(header, 32, epoch_seconds(Timestamp(timestamp)));
+  write_blob("OSMHeader", header);
+}
+
+
+void Output_PBF::write_footer()
+{
+  flush_block();
+}
+
+
+void Output_PBF::display_remark(const std::string& text)
+{
+  // Intentionally empty
+}
+
+
+void Output_PBF::display_error(const std::string& text)
+{
+  // Intentionally empty
+}
+
+
+uint32 Output_PBF::string_id(const std::string& s)
+{
+  std::map< std::string, uint32 >::iterator it = string_ids.find(s);
+  if (it != string_ids.end())
+    return it->second;
+
+  it = string_ids.insert(std::make_pair(s, (uint32)strings.size())).first;
+  strings.push_back(&it->first);
+  return it->second;
+}
+
+
+void Output_PBF::start_group(Group_Type type)
+{
+  if (group_type != type || group_size >= PBF_BLOCK_SIZE
+      || dense_ids.size() + dense_keys_vals.size() + group.size() >= PBF_BLOCK_BYTES)
+    flush_block();
+  group_type = type;
+  ++group_size;
+}
+
+
+void Output_PBF::clear_block()
+{
+  group_type = none;
+  group_size = 0;
+  string_ids.clear();
+  strings.assign(1, &reserved_string);
+
+  dense_ids.clear();
+  dense_lats.clear();
+  dense_lons.clear();
+  dense_keys_vals.clear();
+  dense_versions.clear();
+  dense_timestamps.clear();
+  dense_changesets.clear();
+  dense_uids.clear();
+  dense_user_sids.clear();
+  dense_has_meta = false;
+  last_id = 0;
+  last_lat = 0;
+  last_lon = 0;
+  last_timestamp = 0;
+  last_changeset = 0;
+  last_uid = 0;
+  last_user_sid = 0;
+
+  group.clear();
+}
+
+
+void Output_PBF::flush_block()
+{
+  if (group_type == none)
+    return;
+
+  std::string primitive_group;
+  if (group_type == nodes)
+  {
+    std::string dense;
+    append_packed_field(dense, 1, dense_ids);
+    if (dense_has_meta)
+    {
+      std::string dense_info;
+      append_packed_field(dense_info, 1, dense_versions);
+      append_packed_field(dense_info, 2, dense_timestamps);
+      append_packed_field(dense_info, 3, dense_changesets);
+      append_packed_field(dense_info, 4, dense_uids);
+      append_packed_field(dense_info, 5, dense_user_sids);
+      append_bytes_field(dense, 5, dense_info);
+    }
+    append_packed_field(dense, 8, dense_lats);
+    append_packed_field(dense, 9, dense_lons);
+    append_packed_field(dense, 10, dense_keys_vals);
+    append_bytes_field(primitive_group, 2, dense);
+  }
+  else
+    primitive_group.swap(group);
+
+  std::string string_table;
+  for (std::vector< const std::string* >::const_iterator it = strings.begin(); it != strings.end(); ++it)
+    append_bytes_field(string_table, 1, **it);
+
+  std::string block;
+  append_bytes_field(block, 1, string_table);
+  append_bytes_field(block, 2, primitive_group);
+  write_blob("OSMData", block);
+
+  clear_block();
+}
+
+
+template< typename Id_Type >
+void Output_PBF::append_info(std::string& message, const OSM_Element_Metadata_Skeleton< Id_Type >* meta,
+    const std::map< uint32, std::string >* users)
+{
+  if (!meta)
+    return;
+
+  std::string info;
+  append_varint_field(info, 1, meta->version);
+  append_varint_field(info, 2, epoch_seconds(Timestamp(meta->timestamp)));
+  append_varint_field(info, 3, meta->changeset);
+  append_varint_field(info, 4, meta->user_id);
+  if (users)
+  {
+    std::map< uint32, std::string >::const_iterator it = users->find(meta->user_id);
+    if (it != users->end())
+      append_varint_field(info, 5, string_id(it->second));
+  }
+  append_bytes_field(message, 4, info);
+}
+
+
+void Output_PBF::append_tags(std::string& message,
+    const std::vector< std::pair< std::string, std::string > >* tags)
+{
+  if (!tags || tags->empty())
+    return;
+
+  std::string keys;
+  std::string vals;
+  for (std::vector< std::pair< std::string, std::string > >::const_iterator it = tags->begin();
+      it != tags->end(); ++it)
+  {
+    append_varint(keys, string_id(it->first));
+    append_varint(vals, string_id(it->second));
+  }
+  append_bytes_field(message, 2, keys);
+  append_bytes_field(message, 3, vals);
+}
+
+
+void Output_PBF::print_item(const Node_Skeleton& skel,
+      const Opaque_Geometry& geometry,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const OSM_Element_Metadata_Skeleton< Node::Id_Type >* meta,
+      const std::map< uint32, std::string >* users,
+      Output_Mode mode,
+      const Feature_Action& action,
+      const Node_Skeleton* new_skel,
+      const Opaque_Geometry* new_geometry,
+      const std::vector< std::pair< std::string, std::string > >* new_tags,
+      const OSM_Element_Metadata_Skeleton< Node::Id_Type >* new_meta)
+{
+  start_group(nodes);
+
+  int64 id = skel.id.val();
+  append_varint(dense_ids, zigzag(id - last_id));
+  last_id = id;
+
+  // Dense nodes always carry coordinates, hence the position is written even for out ids or out tags
+  int64 lat = geometry.has_center() ? pbf_coord(geometry.center_lat()) : 0;
+  int64 lon = geometry.has_center() ? pbf_coord(geometry.center_lon()) : 0;
+  append_varint(dense_lats, zigzag(lat - last_lat));
+  append_varint(dense_lons, zigzag(lon - last_lon));
+  last_lat = lat;
+  last_lon = lon;
+
+  if (tags)
+  {
+    for (std::vector< std::pair< std::string, std::string > >::const_iterator it = tags->begin();
+        it != tags->end(); ++it)
+    {
+      append_varint(dense_keys_vals, string_id(it->first));
+      append_varint(dense_keys_vals, string_id(it->second));
+    }
+  }
+  append_varint(dense_keys_vals, 0);
+
+  // Dense info needs an entry for every node once any node of the block has meta data
+  if (meta && !dense_has_meta)
+  {
+    for (uint32 i = 1; i < group_size; ++i)
+    {
+      append_varint(dense_versions, 0);
+      append_varint(dense_timestamps, 0);
+      append_varint(dense_changesets, 0);
+      append_varint(dense_uids, 0);
+      append_varint(dense_user_sids, 0);
+    }
+    dense_has_meta = true;
+  }
+  if (dense_has_meta)
+  {
+    int64 timestamp = meta ? epoch_seconds(Timestamp(meta->timestamp)) : last_timestamp;
+    int64 changeset = meta ? meta->changeset : last_changeset;
+    int64 uid = meta ? meta->user_id : last_uid;
+    int64 user_sid = last_user_sid;
+    if (meta)
+    {
+      std::map< uint32, std::string >::const_iterator it;
+      user_sid = users && (it = users->find(meta->user_id)) != users->end() ? string_id(it->second) : 0;
+    }
+
+    append_varint(dense_versions, meta ? meta->version : 0);
+    append_varint(dense_timestamps, zigzag(timestamp - last_timestamp));
+    append_varint(dense_changesets, zigzag(changeset - last_changeset));
+    append_varint(dense_uids, zigzag(uid - last_uid));
+    append_varint(dense_user_sids, zigzag(user_sid - last_user_sid));
+    last_timestamp = timestamp;
+    last_changeset = changeset;
+    last_uid = uid;
+    last_user_sid = user_sid;
+  }
+}
+
+
+void Output_PBF::print_item(const Way_Skeleton& skel,
+      const Opaque_Geometry& geometry,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const OSM_Element_Metadata_Skeleton< Way::Id_Type >* meta,
+      const std::map< uint32, std::string >* users,
+      Output_Mode mode,
+      const Feature_Action& action,
+      const Way_Skeleton* new_skel,
+      const Opaque_Geometry* new_geometry,
+      const std::vector< std::pair< std::string, std::string > >* new_tags,
+      const OSM_Element_Metadata_Skeleton< Way::Id_Type >* new_meta)
+{
+  start_group(ways);
+
+  std::string way;
+  append_varint_field(way, 1, skel.id.val());
+  append_tags(way, tags);
+  append_info(way, meta, users);
+
+  if ((mode.mode & Output_Mode::NDS) && !skel.nds.empty())
+  {
+    std::string refs;
+    int64 last_ref = 0;
+    for (std::vector< Node::Id_Type >::const_iterator it = skel.nds.begin(); it != skel.nds.end(); ++it)
+    {
+      append_varint(refs, zigzag((int64)it->val() - last_ref));
+      last_ref = it->val();
+    }
+    append_bytes_field(way, 8, refs);
+
+    // Node locations on ways, as written by osmium with the LocationsOnWays feature
+    bool all_positions_valid = (mode.mode & Output_Mode::GEOMETRY) && geometry.has_faithful_way_geometry()
+        && geometry.way_size() == skel.nds.size();
+    for (uint i = 0; all_positions_valid && i < skel.nds.size(); ++i)
+      all_positions_valid = geometry.way_pos_is_valid(i);
+    if (all_positions_valid)
+    {
+      std::string lats;
+      std::string lons;
+      int64 last_lat = 0;
+      int64 last_lon = 0;
+      for (uint i = 0; i < skel.nds.size(); ++i)
+      {
+        int64 lat = pbf_coord(geometry.way_pos_lat(i));
+        int64 lon = pbf_coord(geometry.way_pos_lon(i));
+        append_varint(lats, zigzag(lat - last_lat));
+        append_varint(lons, zigzag(lon - last_lon));
+        last_lat = lat;
+        last_lon = lon;
+      }
+      append_bytes_field(way, 9, lats);
+      append_bytes_field(way, 10, lons);
+    }
+  }
+
+  append_bytes_field(group, 3, way);
+}
+
+
+void Output_PBF::print_item(const Relation_Skeleton& skel,
+      const Opaque_Geometry& geometry,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* meta,
+      const std::map< uint32, std::string >* roles,
+      const std::map< uint32, std::string >* users,
+      Output_Mode mode,
+      const Feature_Action& action,
+      const Relation_Skeleton* new_skel,
+      const Opaque_Geometry* new_geometry,
+      const std::vector< std::pair< std::string, std::string > >* new_tags,
+      const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* new_meta)
+{
+  start_group(relations);
+
+  std::string relation;
+  append_varint_field(relation, 1, skel.id.val());
+  append_tags(relation, tags);
+  append_info(relation, meta, users);
+
+  if (roles && (mode.mode & Output_Mode::MEMBERS) && !skel.members.empty())
+  {
+    std::string roles_sid;
+    std::string memids;
+    std::string types;
+    int64 last_ref = 0;
+    for (std::vector< Relation_Entry >::const_iterator it = skel.members.begin(); it != skel.members.end(); ++it)
+    {
+      std::map< uint32, std::string >::const_iterator rit = roles->find(it->role);
+      append_varint(roles_sid, string_id(rit != roles->end() ? rit->second : "???"));
+      append_varint(memids, zigzag((int64)it->ref.val() - last_ref));
+      last_ref = it->ref.val();
+      // PBF enumerates node, way, relation from 0, Relation_Entry from 1
+      append_varint(types, it->type - Relation_Entry::NODE);
+    }
+    append_bytes_field(relation, 8, roles_sid);
+    append_bytes_field(relation, 9, memids);
+    append_bytes_field(relation, 10, types);
+  }
+
+  append_bytes_field(group, 4, relation);
+}
+
+
+void Output_PBF::print_item(const Derived_Skeleton& skel,
+      const Opaque_Geometry& geometry,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      Output_Mode mode,
+      const Feature_Action& action)
+{
+  // Intentionally empty
+}
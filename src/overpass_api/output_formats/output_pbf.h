@@ -0,0 +1,136 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__OUTPUT_FORMATS__OUTPUT_PBF_H
+#define DE__OSM3S___OVERPASS_API__OUTPUT_FORMATS__OUTPUT_PBF_H
+
+
+#include "../core/datatypes.h"
+#include "../core/geometry.h"
+#include "../frontend/output_handler.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+/* Writes the OSM PBF format: an OSMHeader blob followed by zlib compressed OSMData blobs.
+ * Each blob holds one primitive group of at most PBF_BLOCK_SIZE elements of a single type,
+ * nodes as dense nodes. Derived elements have no representation in PBF and are skipped. */
+class Output_PBF : public Output_Handler
+{
+public:
+  Output_PBF() : group_type(none), group_size(0) { clear_block(); }
+
+  virtual bool write_http_headers();
+  virtual void write_payload_header(const std::string& db_dir,
+				    const std::string& timestamp, const std::string& area_timestamp);
+  virtual void write_footer();
+  virtual void display_remark(const std::string& text);
+  virtual void display_error(const std::string& text);
+
+  virtual void print_global_bbox(const Bbox_Double& bbox) {}
+
+  virtual void print_item(const Node_Skeleton& skel,
+      const Opaque_Geometry& geometry,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const OSM_Element_Metadata_Skeleton< Node::Id_Type >* meta,
+      const std::map< uint32, std::string >* users,
+      Output_Mode mode,
+      const Feature_Action& action = keep,
+      const Node_Skeleton* new_skel = 0,
+      const Opaque_Geometry* new_geometry = 0,
+      const std::vector< std::pair< std::string, std::string > >* new_tags = 0,
+      const OSM_Element_Metadata_Skeleton< Node::Id_Type >* new_meta = 0);
+
+  virtual void print_item(const Way_Skeleton& skel,
+      const Opaque_Geometry& geometry,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const OSM_Element_Metadata_Skeleton< Way::Id_Type >* meta,
+      const std::map< uint32, std::string >* users,
+      Output_Mode mode,
+      const Feature_Action& action = keep,
+      const Way_Skeleton* new_skel = 0,
+      const Opaque_Geometry* new_geometry = 0,
+      const std::vector< std::pair< std::string, std::string > >* new_tags = 0,
+      const OSM_Element_Metadata_Skeleton< Way::Id_Type >* new_meta = 0);
+
+  virtual void print_item(const Relation_Skeleton& skel,
+      const Opaque_Geometry& geometry,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* meta,
+      const std::map< uint32, std::string >* roles,
+      const std::map< uint32, std::string >* users,
+      Output_Mode mode,
+      const Feature_Action& action = keep,
+      const Relation_Skeleton* new_skel = 0,
+      const Opaque_Geometry* new_geometry = 0,
+      const std::vector< std::pair< std::string, std::string > >* new_tags = 0,
+      const OSM_Element_Metadata_Skeleton< Relation::Id_Type >* new_meta = 0);
+
+  virtual void print_item(const Derived_Skeleton& skel,
+      const Opaque_Geometry& geometry,
+      const std::vector< std::pair< std::string, std::string > >* tags,
+      Output_Mode mode,
+      const Feature_Action& action = keep);
+
+private:
+  enum Group_Type { none, nodes, ways, relations };
+
+  Group_Type group_type;
+  uint32 group_size;
+
+  // The string table of the current block. Index 0 is reserved.
+  std::map< std::string, uint32 > string_ids;
+  std::vector< const std::string* > strings;
+
+  // The columns of the dense nodes of the current block, delta coded where PBF asks for it
+  std::string dense_ids;
+  std::string dense_lats;
+  std::string dense_lons;
+  std::string dense_keys_vals;
+  std::string dense_versions;
+  std::string dense_timestamps;
+  std::string dense_changesets;
+  std::string dense_uids;
+  std::string dense_user_sids;
+  bool dense_has_meta;
+  int64 last_id;
+  int64 last_lat;
+  int64 last_lon;
+  int64 last_timestamp;
+  int64 last_changeset;
+  int64 last_uid;
+  int64 last_user_sid;
+
+  // The serialized ways or relations of the current block
+  std::string group;
+
+  uint32 string_id(const std::string& s);
+  void start_group(Group_Type type);
+  void flush_block();
+  void clear_block();
+
+  template< typename Id_Type >
+  void append_info(std::string& message, const OSM_Element_Metadata_Skeleton< Id_Type >* meta,
+      const std::map< uint32, std::string >* users);
+  void append_tags(std::string& message, const std::vector< std::pair< std::string, std::string > >* tags);
+};
+
+
+#endif
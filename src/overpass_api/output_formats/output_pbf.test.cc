@@ -0,0 +1,521 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../template_db/types.h"
+#include "../../template_db/zlib_wrapper.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/* Decodes an OSM PBF file from stdin into one line per element on stdout.
+ * Problems with the encoding, in particular a string that appears twice in a string table,
+ * are reported on stderr. */
+
+
+struct Decode_Error
+{
+  Decode_Error(const std::string& message_) : message(message_) {}
+  std::string message;
+};
+
+
+class Message
+{
+  public:
+    Message(const std::string& data_) : data(data_), pos(0), wire_type(0) {}
+
+    bool next(uint32& field);
+    uint64 varint();
+    std::string bytes();
+    void skip();
+
+  private:
+    uint64 read_varint();
+
+    std::string data;
+    std::string::size_type pos;
+    uint32 wire_type;
+};
+
+
+uint64 Message::read_varint()
+{
+  uint64 result = 0;
+  for (uint32 shift = 0; shift < 64; shift += 7)
+  {
+    if (pos >= data.size())
+      throw Decode_Error("Varint exceeds the message.");
+    unsigned char c = data[pos++];
+    result |= (uint64)(c & 0x7f)<<shift;
+    if (!(c & 0x80))
+      return result;
+  }
+  throw Decode_Error("Varint is too long.");
+}
+
+
+bool Message::next(uint32& field)
+{
+  if (pos >= data.size())
+    return false;
+  uint64 key = read_varint();
+  field = key>>3;
+  wire_type = key & 0x7;
+  return true;
+}
+
+
+uint64 Message::varint()
+{
+  if (wire_type != 0)
+    throw Decode_Error("Varint expected.");
+  return read_varint();
+}
+
+
+std::string Message::bytes()
+{
+  if (wire_type != 2)
+    throw Decode_Error("Length delimited field expected.");
+  uint64 size = read_varint();
+  if (pos + size > data.size())
+    throw Decode_Error("Field exceeds the message.");
+  std::string result = data.substr(pos, size);
+  pos += size;
+  return result;
+}
+
+
+void Message::skip()
+{
+  if (wire_type == 0)
+    read_varint();
+  else if (wire_type == 2)
+    bytes();
+  else
+    throw Decode_Error("Unsupported wire type.");
+}
+
+
+std::vector< uint64 > packed(const std::string& data)
+{
+  std::vector< uint64 > result;
+  std::string::size_type pos = 0;
+  while (pos < data.size())
+  {
+    uint64 value = 0;
+    for (uint32 shift = 0; ; shift += 7)
+    {
+      if (pos >= data.size() || shift >= 64)
+        throw Decode_Error("Packed varint exceeds the field.");
+      unsigned char c = data[pos++];
+      value |= (uint64)(c & 0x7f)<<shift;
+      if (!(c & 0x80))
+        break;
+    }
+    result.push_back(value);
+  }
+  return result;
+}
+
+
+int64 unzigzag(uint64 value)
+{
+  return (int64)(value>>1) ^ -(int64)(value & 1);
+}
+
+
+std::vector< int64 > packed_delta(const std::string& data)
+{
+  std::vector< uint64 > raw = packed(data);
+  std::vector< int64 > result;
+  int64 last = 0;
+  for (std::vector< uint64 >::const_iterator it = raw.begin(); it != raw.end(); ++it)
+  {
+    last += unzigzag(*it);
+    result.push_back(last);
+  }
+  return result;
+}
+
+
+std::string coord(int64 value)
+{
+  std::ostringstream out;
+  if (value < 0)
+  {
+    out<<'-';
+    value = -value;
+  }
+  char fraction[8];
+  snprintf(fraction, sizeof(fraction), "%07d", (int)(value % 10000000));
+  out<<value / 10000000<<'.'<<fraction;
+  return out.str();
+}
+
+
+const std::string& lookup(const std::vector< std::string >& strings, uint64 index)
+{
+  if (index >= strings.size())
+    throw Decode_Error("String index out of range.");
+  return strings[index];
+}
+
+
+std::string info(const std::string& data, const std::vector< std::string >& strings)
+{
+  std::ostringstream out;
+  Message message(data);
+  uint32 field = 0;
+  while (message.next(field))
+  {
+    if (field == 1)
+      out<<" version="<<message.varint();
+    else if (field == 2)
+      out<<" timestamp="<<message.varint();
+    else if (field == 3)
+      out<<" changeset="<<message.varint();
+    else if (field == 4)
+      out<<" uid="<<message.varint();
+    else if (field == 5)
+      out<<" user="<<lookup(strings, message.varint());
+    else
+      message.skip();
+  }
+  return out.str();
+}
+
+
+std::string tags(const std::vector< uint64 >& keys, const std::vector< uint64 >& vals,
+    const std::vector< std::string >& strings)
+{
+  if (keys.size() != vals.size())
+    throw Decode_Error("Keys and values differ in number.");
+  std::ostringstream out;
+  for (uint32 i = 0; i < keys.size(); ++i)
+    out<<' '<<lookup(strings, keys[i])<<'='<<lookup(strings, vals[i]);
+  return out.str();
+}
+
+
+void print_dense(const std::string& data, const std::vector< std::string >& strings)
+{
+  std::vector< int64 > ids, lats, lons;
+  std::vector< uint64 > keys_vals;
+  std::vector< uint64 > versions;
+  std::vector< int64 > timestamps, changesets, uids, user_sids;
+
+  Message message(data);
+  uint32 field = 0;
+  while (message.next(field))
+  {
+    if (field == 1)
+      ids = packed_delta(message.bytes());
+    else if (field == 5)
+    {
+      Message dense_info(message.bytes());
+      while (dense_info.next(field))
+      {
+        if (field == 1)
+          versions = packed(dense_info.bytes());
+        else if (field == 2)
+          timestamps = packed_delta(dense_info.bytes());
+        else if (field == 3)
+          changesets = packed_delta(dense_info.bytes());
+        else if (field == 4)
+          uids = packed_delta(dense_info.bytes());
+        else if (field == 5)
+          user_sids = packed_delta(dense_info.bytes());
+        else
+          dense_info.skip();
+      }
+    }
+    else if (field == 8)
+      lats = packed_delta(message.bytes());
+    else if (field == 9)
+      lons = packed_delta(message.bytes());
+    else if (field == 10)
+      keys_vals = packed(message.bytes());
+    else
+      message.skip();
+  }
+
+  if (lats.size() != ids.size() || lons.size() != ids.size())
+    throw Decode_Error("Dense nodes without a position for every node.");
+  if (!versions.empty() && (versions.size() != ids.size() || timestamps.size() != ids.size()
+      || changesets.size() != ids.size() || uids.size() != ids.size() || user_sids.size() != ids.size()))
+    throw Decode_Error("Dense info without an entry for every node.");
+
+  std::vector< uint64 >::const_iterator kv_it = keys_vals.begin();
+  for (uint32 i = 0; i < ids.size(); ++i)
+  {
+    std::cout<<"node "<<ids[i]<<" lat="<<coord(lats[i])<<" lon="<<coord(lons[i]);
+    if (!versions.empty() && versions[i] > 0)
+      std::cout<<" version="<<versions[i]<<" timestamp="<<timestamps[i]<<" changeset="<<changesets[i]
+          <<" uid="<<uids[i]<<" user="<<lookup(strings, user_sids[i]);
+    std::vector< uint64 > keys, vals;
+    while (kv_it != keys_vals.end() && *kv_it != 0)
+    {
+      keys.push_back(*kv_it++);
+      if (kv_it == keys_vals.end())
+        throw Decode_Error("Dense key without value.");
+      vals.push_back(*kv_it++);
+    }
+    if (kv_it != keys_vals.end())
+      ++kv_it;
+    std::cout<<tags(keys, vals, strings)<<'\n';
+  }
+}
+
+
+void print_way(const std::string& data, const std::vector< std::string >& strings)
+{
+  uint64 id = 0;
+  std::vector< uint64 > keys, vals;
+  std::string meta;
+  std::vector< int64 > refs, lats, lons;
+
+  Message message(data);
+  uint32 field = 0;
+  while (message.next(field))
+  {
+    if (field == 1)
+      id = message.varint();
+    else if (field == 2)
+      keys = packed(message.bytes());
+    else if (field == 3)
+      vals = packed(message.bytes());
+    else if (field == 4)
+      meta = info(message.bytes(), strings);
+    else if (field == 8)
+      refs = packed_delta(message.bytes());
+    else if (field == 9)
+      lats = packed_delta(message.bytes());
+    else if (field == 10)
+      lons = packed_delta(message.bytes());
+    else
+      message.skip();
+  }
+
+  if ((!lats.empty() || !lons.empty()) && (lats.size() != refs.size() || lons.size() != refs.size()))
+    throw Decode_Error("Way locations do not match the node refs.");
+
+  std::cout<<"way "<<id<<meta<<tags(keys, vals, strings);
+  for (uint32 i = 0; i < refs.size(); ++i)
+  {
+    std::cout<<" nd="<<refs[i];
+    if (!lats.empty())
+      std::cout<<'('<<coord(lats[i])<<','<<coord(lons[i])<<')';
+  }
+  std::cout<<'\n';
+}
+
+
+void print_relation(const std::string& data, const std::vector< std::string >& strings)
+{
+  uint64 id = 0;
+  std::vector< uint64 > keys, vals, roles, types;
+  std::string meta;
+  std::vector< int64 > memids;
+
+  Message message(data);
+  uint32 field = 0;
+  while (message.next(field))
+  {
+    if (field == 1)
+      id = message.varint();
+    else if (field == 2)
+      keys = packed(message.bytes());
+    else if (field == 3)
+      vals = packed(message.bytes());
+    else if (field == 4)
+      meta = info(message.bytes(), strings);
+    else if (field == 8)
+      roles = packed(message.bytes());
+    else if (field == 9)
+      memids = packed_delta(message.bytes());
+    else if (field == 10)
+      types = packed(message.bytes());
+    else
+      message.skip();
+  }
+
+  if (roles.size() != memids.size() || types.size() != memids.size())
+    throw Decode_Error("Relation members are incomplete.");
+
+  static const char* type_names[] = { "node", "way", "relation" };
+  std::cout<<"relation "<<id<<meta<<tags(keys, vals, strings);
+  for (uint32 i = 0; i < memids.size(); ++i)
+  {
+    if (types[i] > 2)
+      throw Decode_Error("Unknown member type.");
+    std::cout<<" member="<<type_names[types[i]]<<' '<<memids[i]<<' '<<lookup(strings, roles[i]);
+  }
+  std::cout<<'\n';
+}
+
+
+void print_block(const std::string& data)
+{
+  std::vector< std::string > strings;
+  std::vector< std::string > groups;
+
+  Message message(data);
+  uint32 field = 0;
+  while (message.next(field))
+  {
+    if (field == 1)
+    {
+      Message string_table(message.bytes());
+      while (string_table.next(field))
+      {
+        if (field == 1)
+          strings.push_back(string_table.bytes());
+        else
+          string_table.skip();
+      }
+    }
+    else if (field == 2)
+      groups.push_back(message.bytes());
+    else
+      message.skip();
+  }
+
+  // Index 0 is reserved, hence only the remaining strings must be unique
+  std::set< std::string > unique_strings(strings.begin() + std::min((std::string::size_type)1, strings.size()),
+      strings.end());
+  if (unique_strings.size() + 1 != strings.size())
+    std::cerr<<"String table with "<<strings.size() - 1 - unique_strings.size()<<" duplicate entries.\n";
+  std::cout<<"block strings="<<strings.size()<<'\n';
+
+  for (std::vector< std::string >::const_iterator it = groups.begin(); it != groups.end(); ++it)
+  {
+    Message group(*it);
+    while (group.next(field))
+    {
+      if (field == 2)
+        print_dense(group.bytes(), strings);
+      else if (field == 3)
+        print_way(group.bytes(), strings);
+      else if (field == 4)
+        print_relation(group.bytes(), strings);
+      else
+        throw Decode_Error("Unexpected element type in primitive group.");
+    }
+  }
+}
+
+
+void print_header(const std::string& data)
+{
+  Message message(data);
+  uint32 field = 0;
+  while (message.next(field))
+  {
+    if (field == 4)
+      std::cout<<"required_feature="<<message.bytes()<<'\n';
+    else
+      message.skip();
+  }
+}
+
+
+bool read_exactly(std::string& buf, uint64 size)
+{
+  buf.resize(size);
+  return size == 0 || fread(&buf[0], 1, size, stdin) == size;
+}
+
+
+int main(int argc, char* args[])
+{
+  try
+  {
+    std::string size_buf;
+    while (read_exactly(size_buf, 4))
+    {
+      uint32 header_size = ((unsigned char)size_buf[0]<<24) | ((unsigned char)size_buf[1]<<16)
+          | ((unsigned char)size_buf[2]<<8) | (unsigned char)size_buf[3];
+      std::string header_buf;
+      if (!read_exactly(header_buf, header_size))
+        throw Decode_Error("Truncated blob header.");
+
+      std::string type;
+      uint64 blob_size = 0;
+      Message blob_header(header_buf);
+      uint32 field = 0;
+      while (blob_header.next(field))
+      {
+        if (field == 1)
+          type = blob_header.bytes();
+        else if (field == 3)
+          blob_size = blob_header.varint();
+        else
+          blob_header.skip();
+      }
+
+      std::string blob_buf;
+      if (!read_exactly(blob_buf, blob_size))
+        throw Decode_Error("Truncated blob.");
+
+      uint64 raw_size = 0;
+      std::string zlib_data;
+      Message blob(blob_buf);
+      while (blob.next(field))
+      {
+        if (field == 2)
+          raw_size = blob.varint();
+        else if (field == 3)
+          zlib_data = blob.bytes();
+        else
+          blob.skip();
+      }
+
+      std::string data(raw_size, '\0');
+      if (raw_size > 0 && Zlib_Inflate().decompress(zlib_data.data(), zlib_data.size(), &data[0], raw_size)
+          != (int)raw_size)
+        throw Decode_Error("Blob does not decompress to its raw size.");
+
+      if (type == "OSMHeader")
+        print_header(data);
+      else if (type == "OSMData")
+        print_block(data);
+      else
+        throw Decode_Error("Unknown blob type \"" + type + "\".");
+    }
+  }
+  catch (const Decode_Error& e)
+  {
+    std::cerr<<e.message<<'\n';
+    return 1;
+  }
+  catch (const Zlib_Inflate::Error& e)
+  {
+    std::cerr<<"Zlib error "<<e.error_code<<'\n';
+    return 1;
+  }
+
+  return 0;
+}
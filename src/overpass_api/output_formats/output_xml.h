@@ -23,6 +23,7 @@
 #include "../core/datatypes.h"
 #include "../core/geometry.h"
 #include "../frontend/output_handler.h"
+#include "output_buffer.h"
 
 #include <string>
 #include <vector>
@@ -94,6 +95,9 @@ public:
       const std::vector< std::pair< std::string, std::string > >* tags,
       Output_Mode mode,
       const Feature_Action& action = keep);
+
+private:
+  Output_Buffer out;
 };
 
 
@@ -355,6 +355,74 @@ bool Area_Constraint::delivers_data(Resource_Manager& rman)
 }
 
 
+// Reads the rasters of the area blocks tile by tile alongside the area blocks themselves.
+class Area_Raster_Reader
+{
+public:
+  Area_Raster_Reader(const std::set< Uint31_Index >& req, Resource_Manager& rman);
+  ~Area_Raster_Reader();
+
+  // Collects the rasters of the areas in area_id for the tile current_idx.
+  void collect(uint32 current_idx, const std::vector< Area_Skeleton::Id_Type >& area_id);
+  // Areas without a raster have only boundary cells.
+  uint8 cell_state(Area_Skeleton::Id_Type id, uint32 node_idx) const;
+
+private:
+  Block_Backend< Uint31_Index, Area_Raster >* db;
+  Block_Backend< Uint31_Index, Area_Raster >::Discrete_Iterator* it;
+  std::map< Area_Skeleton::Id_Type, Area_Raster > rasters;
+};
+
+
+Area_Raster_Reader::Area_Raster_Reader(const std::set< Uint31_Index >& req, Resource_Manager& rman)
+    : db(0), it(0)
+{
+  // Area databases from before the introduction of rasters lack the file.
+  // Then all cells are boundary cells.
+  File_Blocks_Index< Uint31_Index >* index = (File_Blocks_Index< Uint31_Index >*)
+      rman.get_area_transaction()->data_index(area_settings().AREA_RASTERS);
+  if (!file_exists(index->get_data_file_name()))
+    return;
+
+  db = new Block_Backend< Uint31_Index, Area_Raster >(index);
+  it = new Block_Backend< Uint31_Index, Area_Raster >::Discrete_Iterator(
+      db->discrete_begin(req.begin(), req.end()));
+}
+
+
+Area_Raster_Reader::~Area_Raster_Reader()
+{
+  delete it;
+  delete db;
+}
+
+
+void Area_Raster_Reader::collect(uint32 current_idx, const std::vector< Area_Skeleton::Id_Type >& area_id)
+{
+  rasters.clear();
+  if (!db)
+    return;
+
+  while (!(*it == db->discrete_end()) && it->index().val() < current_idx)
+    ++(*it);
+  while (!(*it == db->discrete_end()) && it->index().val() == current_idx)
+  {
+    if (binary_search(area_id.begin(), area_id.end(), it->object().id))
+      rasters[it->object().id] = it->object();
+    ++(*it);
+  }
+}
+
+
+uint8 Area_Raster_Reader::cell_state(Area_Skeleton::Id_Type id, uint32 node_idx) const
+{
+  std::map< Area_Skeleton::Id_Type, Area_Raster >::const_iterator rit = rasters.find(id);
+  if (rit == rasters.end())
+    return Area_Raster::BOUNDARY;
+  return rit->second.cell_state(node_idx);
+}
+
+
 void Area_Query_Statement::collect_nodes
     (const std::set< std::pair< Uint32_Index, Uint32_Index > >& nodes_req,
      const std::set< Uint31_Index >& req,
@@ -368,6 +436,7 @@ void Area_Query_Statement::collect_nodes
       (rman.get_transaction()->data_index(osm_base_settings().NODES));
   Block_Backend< Uint31_Index, Area_Block >::Discrete_Iterator
       area_it(area_blocks_db.discrete_begin(req.begin(), req.end()));
+  Area_Raster_Reader area_rasters(req, rman);
   Block_Backend< Uint32_Index, Node_Skeleton >::Range_Iterator
       nodes_it(nodes_db.range_begin(nodes_req.begin(), nodes_req.end()));
   uint32 current_idx(0);
@@ -385,6 +454,8 @@ void Area_Query_Statement::collect_nodes
 	areas[area_it.object().id].push_back(area_it.object());
       ++area_it;
     }
+    area_rasters.collect(current_idx, area_id);
+
     while ((!(nodes_it == nodes_db.range_end())) &&
         ((nodes_it.index().val() & 0xffffff00) == current_idx))
     {
@@ -403,9 +474,12 @@ void Area_Query_Statement::collect_nodes
       for (std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >::const_iterator it = areas.begin();
 	   it != areas.end(); ++it)
       {
-        int inside = 0;
-        for (std::vector< Area_Block >::const_iterator it2 = it->second.begin(); it2 != it->second.end();
-	     ++it2)
+        uint8 cell_state = area_rasters.cell_state(it->first, nodes_it.index().val());
+        if (cell_state == Area_Raster::OUTSIDE)
+          continue;
+        int inside = (cell_state == Area_Raster::INSIDE);
+        for (std::vector< Area_Block >::const_iterator it2 = it->second.begin();
+             cell_state == Area_Raster::BOUNDARY && it2 != it->second.end(); ++it2)
         {
 	  int check(Coord_Query_Statement::check_area_block(current_idx, *it2, ilat, ilon));
 	  if (check == Coord_Query_Statement::HIT)
@@ -439,6 +513,7 @@ void Area_Query_Statement::collect_nodes
       (rman.get_area_transaction()->data_index(area_settings().AREA_BLOCKS));
   Block_Backend< Uint31_Index, Area_Block >::Discrete_Iterator
       area_it(area_blocks_db.discrete_begin(req.begin(), req.end()));
+  Area_Raster_Reader area_rasters(req, rman);
 
   typename std::map< Uint32_Index, std::vector< Node_Skeleton > >::iterator nodes_it = nodes.begin();
 
@@ -461,6 +536,7 @@ void Area_Query_Statement::collect_nodes
 	areas[area_it.object().id].push_back(area_it.object());
       ++area_it;
     }
+    area_rasters.collect(current_idx, area_id);
 
     while (nodes_it != nodes.end() && nodes_it->first.val() < current_idx)
     {
@@ -481,9 +557,12 @@ void Area_Query_Statement::collect_nodes
         for (std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >::const_iterator it = areas.begin();
 	     it != areas.end(); ++it)
         {
-          int inside = 0;
-          for (std::vector< Area_Block >::const_iterator it2 = it->second.begin(); it2 != it->second.end();
-	       ++it2)
+          uint8 cell_state = area_rasters.cell_state(it->first, nodes_it->first.val());
+          if (cell_state == Area_Raster::OUTSIDE)
+            continue;
+          int inside = (cell_state == Area_Raster::INSIDE);
+          for (std::vector< Area_Block >::const_iterator it2 = it->second.begin();
+               cell_state == Area_Raster::BOUNDARY && it2 != it->second.end(); ++it2)
           {
             ++loop_count;
 
@@ -701,6 +780,7 @@ void Area_Query_Statement::collect_ways
       (rman.get_area_transaction()->data_index(area_settings().AREA_BLOCKS));
   Block_Backend< Uint31_Index, Area_Block >::Discrete_Iterator
       area_it(area_blocks_db.discrete_begin(req.begin(), req.end()));
+  Area_Raster_Reader area_rasters(req, rman);
 
   std::map< Way::Id_Type, bool > ways_inside;
 
@@ -744,6 +824,7 @@ void Area_Query_Statement::collect_ways
 	areas[area_it.object().id].push_back(area_it.object());
       ++area_it;
     }
+    area_rasters.collect(current_idx, area_id);
 
     // check nodes
     while (nodes_it != way_coords_to_id.end() && nodes_it->first < current_idx)
@@ -760,6 +841,14 @@ void Area_Query_Statement::collect_ways
         for (std::map< Area_Skeleton::Id_Type, std::vector< Area_Block > >::const_iterator it = areas.begin();
 	     it != areas.end(); ++it)
         {
+          uint8 cell_state = area_rasters.cell_state(it->first, nodes_it->first);
+          if (cell_state == Area_Raster::OUTSIDE)
+            continue;
+          else if (cell_state == Area_Raster::INSIDE)
+          {
+            ways_inside[iit->second] = true;
+            continue;
+          }
           int inside = 0;
           for (std::vector< Area_Block >::const_iterator it2 = it->second.begin(); it2 != it->second.end();
 	       ++it2)
@@ -0,0 +1,210 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../core/datatypes.h"
+#include "../core/index_computations.h"
+#include "../data/collect_members.h"
+#include "coord_query.h"
+#include "make_area.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/* Checks the rasters of make-area against the exact point-in-area test of area-query.
+
+Every cell that the raster marks as inside or outside must get the same result from the exact test
+at all of its sample points, and no segment of the polygon may run through it.
+Each polygon must have cells of all three states.
+*/
+
+
+const uint32 AREA_ID = 1;
+
+
+struct Test_Area
+{
+  Test_Area(const std::string& name_) : name(name_) {}
+
+  // Adds a closed ring given as pairs of latitude and longitude
+  Test_Area& ring(const double* lat_lon, unsigned int size)
+  {
+    std::vector< Quad_Coord > coords;
+    std::vector< std::pair< uint32, int32 > > points;
+    for (unsigned int i = 0; i <= size; ++i)
+    {
+      double lat = lat_lon[2*(i % size)];
+      double lon = lat_lon[2*(i % size) + 1];
+      coords.push_back(Quad_Coord(::ll_upper_(lat, lon), ::ll_lower(lat, lon)));
+      points.push_back(std::make_pair(::ilat(lat), ::ilon(lon)));
+    }
+    add_way_to_area_blocks(coords, AREA_ID, blocks);
+    rings.push_back(points);
+    return *this;
+  }
+
+  std::string name;
+  std::map< Uint31_Index, std::vector< Area_Block > > blocks;
+  std::vector< std::vector< std::pair< uint32, int32 > > > rings;
+};
+
+
+// Evaluates the area blocks of the tile like Area_Query_Statement does for nodes
+bool exact_inside(uint32 tile, const std::vector< Area_Block >& blocks, uint32 lat, int32 lon, bool& on_border)
+{
+  int inside = 0;
+  on_border = false;
+  for (std::vector< Area_Block >::const_iterator it = blocks.begin(); it != blocks.end(); ++it)
+  {
+    if (it->coors.empty())
+      continue;
+    int check = Coord_Query_Statement::check_area_block(tile, *it, lat, lon);
+    if (check == Coord_Query_Statement::HIT)
+    {
+      on_border = true;
+      return true;
+    }
+    inside ^= check;
+  }
+  return inside;
+}
+
+
+uint8 raster_state(const std::map< Uint31_Index, std::vector< Area_Raster > >& rasters,
+    uint32 tile, uint32 lat, int32 lon)
+{
+  std::map< Uint31_Index, std::vector< Area_Raster > >::const_iterator it = rasters.find(Uint31_Index(tile));
+  if (it == rasters.end() || it->second.empty())
+    return Area_Raster::BOUNDARY;
+  return it->second.front().cell_state(::ll_upper(lat, lon));
+}
+
+
+void check(Test_Area& area)
+{
+  Make_Area_Statement::add_segment_blocks(area.blocks, AREA_ID);
+  std::map< Uint31_Index, std::vector< Area_Raster > > rasters;
+  Make_Area_Statement::create_area_rasters(rasters, area.blocks, AREA_ID);
+
+  unsigned int counts[3] = { 0, 0, 0 };
+  unsigned int mismatches = 0;
+  for (std::map< Uint31_Index, std::vector< Area_Block > >::const_iterator it = area.blocks.begin();
+      it != area.blocks.end(); ++it)
+  {
+    uint32 tile = it->first.val();
+    uint32 tile_south = ::ilat(tile, 0);
+    int32 tile_west = ::ilon(tile, 0);
+    for (uint32 row = 0; row < 16; ++row)
+    {
+      for (int32 col = 0; col < 16; ++col)
+      {
+        uint32 south = tile_south + row*0x10000;
+        int32 west = tile_west + col*0x10000;
+        uint8 state = raster_state(rasters, tile, south, west);
+        ++counts[state];
+        if (state == Area_Raster::BOUNDARY)
+          continue;
+
+        // The corners, the edges and the interior of the cell
+        for (uint32 i = 0; i <= 4; ++i)
+        {
+          for (uint32 j = 0; j <= 4; ++j)
+          {
+            bool on_border = false;
+            bool inside = exact_inside(tile, it->second, south + i*0xffff/4, west + j*0xffff/4, on_border);
+            if (on_border || inside != (state == Area_Raster::INSIDE))
+            {
+              if (mismatches++ < 10)
+                std::cout<<area.name<<": cell at "<<::lat(south)<<' '<<::lon(west)
+                    <<" is marked "<<(state == Area_Raster::INSIDE ? "inside" : "outside")
+                    <<" but the exact test gives "<<(on_border ? "border" : inside ? "inside" : "outside")<<'\n';
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Walk along the segments in steps shorter than a cell
+  for (std::vector< std::vector< std::pair< uint32, int32 > > >::const_iterator rit = area.rings.begin();
+      rit != area.rings.end(); ++rit)
+  {
+    for (unsigned int i = 1; i < rit->size(); ++i)
+    {
+      int64 d_lat = (int64)(*rit)[i].first - (*rit)[i-1].first;
+      int64 d_lon = (int64)(*rit)[i].second - (*rit)[i-1].second;
+      int64 steps = std::max(d_lat < 0 ? -d_lat : d_lat, d_lon < 0 ? -d_lon : d_lon)/0x4000 + 1;
+      for (int64 j = 0; j <= steps; ++j)
+      {
+        uint32 lat = (*rit)[i-1].first + d_lat*j/steps;
+        int32 lon = (*rit)[i-1].second + d_lon*j/steps;
+        uint32 tile = ::ll_upper_(lat, lon) & 0xffffff00;
+        if (raster_state(rasters, tile, lat, lon) != Area_Raster::BOUNDARY)
+        {
+          if (mismatches++ < 10)
+            std::cout<<area.name<<": the border at "<<::lat(lat)<<' '<<::lon(lon)
+                <<" lies in a cell that is not a boundary cell\n";
+        }
+      }
+    }
+  }
+
+  std::cout<<area.name<<": "<<counts[Area_Raster::INSIDE]<<" inside, "<<counts[Area_Raster::OUTSIDE]<<" outside, "
+      <<counts[Area_Raster::BOUNDARY]<<" boundary cells: ";
+  if (mismatches == 0 && counts[Area_Raster::INSIDE] > 0 && counts[Area_Raster::OUTSIDE] > 0
+      && counts[Area_Raster::BOUNDARY] > 0)
+    std::cout<<"OK\n";
+  else
+    std::cout<<"failed, "<<mismatches<<" mismatches\n";
+}
+
+
+int main(int argc, char* args[])
+{
+  {
+    const double square[] = { 51.0, 7.0,  51.0, 7.3,  51.3, 7.3,  51.3, 7.0 };
+    Test_Area area("square");
+    check(area.ring(square, 4));
+  }
+  {
+    const double triangle[] = { 51.0, 7.0,  51.05, 7.4,  51.35, 7.1 };
+    Test_Area area("triangle");
+    check(area.ring(triangle, 3));
+  }
+  {
+    const double outer[] = { 51.0, 7.0,  51.0, 7.3,  51.3, 7.3,  51.3, 7.0 };
+    const double inner[] = { 51.1, 7.1,  51.2, 7.1,  51.2, 7.2,  51.1, 7.2 };
+    Test_Area area("square with hole");
+    check(area.ring(outer, 4).ring(inner, 4));
+  }
+  {
+    const double concave[] = { 51.0, 7.0,  51.0, 7.4,  51.4, 7.4,  51.1, 7.2,  51.4, 7.0 };
+    Test_Area area("concave");
+    check(area.ring(concave, 5));
+  }
+  {
+    const double crossing[] = { -0.2, -0.2,  -0.2, 0.2,  0.2, 0.2,  0.2, -0.2 };
+    Test_Area area("around the origin");
+    check(area.ring(crossing, 4));
+  }
+
+  return 0;
+}
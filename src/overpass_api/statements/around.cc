@@ -369,17 +369,22 @@ template< typename Node_Skeleton >
 void filter_nodes_expensive(const Around_Statement& around,
                             std::map< Uint32_Index, std::vector< Node_Skeleton > >& nodes)
 {
+  Cartesian_Batch coords;
+  std::vector< char > inside;
   for (typename std::map< Uint32_Index, std::vector< Node_Skeleton > >::iterator it = nodes.begin();
       it != nodes.end(); ++it)
   {
-    std::vector< Node_Skeleton > local_into;
+    coords.clear();
     for (typename std::vector< Node_Skeleton >::const_iterator iit = it->second.begin();
         iit != it->second.end(); ++iit)
+      coords.push_back(::lat(it->first.val(), iit->ll_lower), ::lon(it->first.val(), iit->ll_lower));
+    around.is_inside(it->first, coords, inside);
+
+    std::vector< Node_Skeleton > local_into;
+    for (unsigned int i = 0; i < inside.size(); ++i)
     {
-      double lat(::lat(it->first.val(), iit->ll_lower));
-      double lon(::lon(it->first.val(), iit->ll_lower));
-      if (around.is_inside(lat, lon))
-	local_into.push_back(*iit);
+      if (inside[i])
+	local_into.push_back(it->second[i]);
     }
     it->second.swap(local_into);
   }
@@ -676,79 +681,17 @@ Around_Statement::~Around_Statement()
 }
 
 
-std::vector< double > cartesian(double lat, double lon)
-{
-  std::vector< double > result(3);
-
-  result[0] = sin(lat/90.0*acos(0));
-  result[1] = cos(lat/90.0*acos(0))*sin(lon/90.0*acos(0));
-  result[2] = cos(lat/90.0*acos(0))*cos(lon/90.0*acos(0));
-
-  return result;
-}
-
-
-void rescale(double a, std::vector< double >& v)
-{
-  v[0] *= a;
-  v[1] *= a;
-  v[2] *= a;
-}
-
-
-std::vector< double > sum(const std::vector< double >& v, const std::vector< double >& w)
-{
-  std::vector< double > result(3);
-
-  result[0] = v[0] + w[0];
-  result[1] = v[1] + w[1];
-  result[2] = v[2] + w[2];
-
-  return result;
-}
-
-
-double scalar_prod(const std::vector< double >& v, const std::vector< double >& w)
-{
-  return v[0]*w[0] + v[1]*w[1] + v[2]*w[2];
-}
-
-
-std::vector< double > cross_prod(const std::vector< double >& v, const std::vector< double >& w)
-{
-  std::vector< double > result(3);
-
-  result[0] = v[1]*w[2] - v[2]*w[1];
-  result[1] = v[2]*w[0] - v[0]*w[2];
-  result[2] = v[0]*w[1] - v[1]*w[0];
-
-  return result;
-}
-
-
-
 Prepared_Segment::Prepared_Segment
   (double first_lat_, double first_lon_, double second_lat_, double second_lon_)
-  : first_lat(first_lat_), first_lon(first_lon_), second_lat(second_lat_), second_lon(second_lon_)
-{
-  first_cartesian = cartesian(first_lat, first_lon);
-  second_cartesian = cartesian(second_lat, second_lon);
-  norm = cross_prod(first_cartesian, second_cartesian);
-}
-
-
-Prepared_Point::Prepared_Point
-  (double lat_, double lon_)
-  : lat(lat_), lon(lon_)
-{
-  cartesian = ::cartesian(lat, lon);
-}
+  : first_lat(first_lat_), first_lon(first_lon_), second_lat(second_lat_), second_lon(second_lon_),
+    first_cartesian(first_lat, first_lon), second_cartesian(second_lat, second_lon),
+    norm(first_cartesian.cross_prod(second_cartesian))
+{}
 
 
-double great_circle_line_dist(const Prepared_Segment& segment, const std::vector< double >& cartesian)
+double great_circle_line_dist(const Prepared_Segment& segment, const Cartesian& cartesian)
 {
-  double scalar_prod_ = std::abs(scalar_prod(cartesian, segment.norm))
-      /sqrt(scalar_prod(segment.norm, segment.norm));
+  double scalar_prod_ = std::abs(cartesian.scalar_prod(segment.norm))/segment.norm.norm();
 
   if (scalar_prod_ > 1)
     scalar_prod_ = 1;
@@ -760,50 +703,28 @@ double great_circle_line_dist(const Prepared_Segment& segment, const std::vector
 double great_circle_line_dist(double llat1, double llon1, double llat2, double llon2,
                               double plat, double plon)
 {
-  std::vector< double > norm = cross_prod(cartesian(llat1, llon1), cartesian(llat2, llon2));
-
-  double scalar_prod_ = std::abs(scalar_prod(cartesian(plat, plon), norm))
-      /sqrt(scalar_prod(norm, norm));
-
-  if (scalar_prod_ > 1)
-    scalar_prod_ = 1;
-
-  return asin(scalar_prod_)*(10*1000*1000/acos(0));
+  return great_circle_line_dist(Prepared_Segment(llat1, llon1, llat2, llon2), Cartesian(plat, plon));
 }
 
 
 bool intersect(const Prepared_Segment& segment_a,
                const Prepared_Segment& segment_b)
 {
-  std::vector< double > intersection_pt = cross_prod(segment_a.norm, segment_b.norm);
-  rescale(1.0/sqrt(scalar_prod(intersection_pt, intersection_pt)), intersection_pt);
+  Cartesian intersection_pt = segment_a.norm.cross_prod(segment_b.norm);
+  intersection_pt = intersection_pt.scaled(1.0/intersection_pt.norm());
 
-  std::vector< double > asum = sum(segment_a.first_cartesian, segment_a.second_cartesian);
-  std::vector< double > bsum = sum(segment_b.first_cartesian, segment_b.second_cartesian);
+  Cartesian asum = segment_a.first_cartesian + segment_a.second_cartesian;
+  Cartesian bsum = segment_b.first_cartesian + segment_b.second_cartesian;
 
-  return (std::abs(scalar_prod(asum, intersection_pt)) >= scalar_prod(asum, segment_a.first_cartesian)
-      && std::abs(scalar_prod(bsum, intersection_pt)) >= scalar_prod(bsum, segment_b.first_cartesian));
+  return (std::abs(asum.scalar_prod(intersection_pt)) >= asum.scalar_prod(segment_a.first_cartesian)
+      && std::abs(bsum.scalar_prod(intersection_pt)) >= bsum.scalar_prod(segment_b.first_cartesian));
 }
 
 
 bool intersect(double alat1, double alon1, double alat2, double alon2,
 	       double blat1, double blon1, double blat2, double blon2)
 {
-  std::vector< double > a1 = cartesian(alat1, alon1);
-  std::vector< double > a2 = cartesian(alat2, alon2);
-  std::vector< double > norm_a = cross_prod(a1, a2);
-  std::vector< double > b1 = cartesian(blat1, blon1);
-  std::vector< double > b2 = cartesian(blat2, blon2);
-  std::vector< double > norm_b = cross_prod(b1, b2);
-
-  std::vector< double > intersection_pt = cross_prod(norm_a, norm_b);
-  rescale(1.0/sqrt(scalar_prod(intersection_pt, intersection_pt)), intersection_pt);
-
-  std::vector< double > asum = sum(a1, a2);
-  std::vector< double > bsum = sum(b1, b2);
-
-  return (std::abs(scalar_prod(asum, intersection_pt)) >= scalar_prod(asum, a1)
-      && std::abs(scalar_prod(bsum, intersection_pt)) >= scalar_prod(bsum, b1));
+  return intersect(Prepared_Segment(alat1, alon1, alat2, alon2), Prepared_Segment(blat1, blon1, blat2, blon2));
 }
 
 
@@ -839,7 +760,7 @@ std::set< std::pair< Uint32_Index, Uint32_Index > > Around_Statement::calc_range
 
 void add_coord(double lat, double lon, double radius,
                std::map< Uint32_Index, std::vector< Point_Double > >& radius_lat_lons,
-	       std::vector< Prepared_Point >& simple_lat_lons)
+	       Cartesian_Batch& simple_lat_lons)
 {
   double south = lat - radius*(360.0/(40000.0*1000.0));
   double north = lat + radius*(360.0/(40000.0*1000.0));
@@ -849,7 +770,7 @@ void add_coord(double lat, double lon, double radius,
   double west = lon - radius*(360.0/(40000.0*1000.0))/cos(scale_lat/90.0*acos(0));
   double east = lon + radius*(360.0/(40000.0*1000.0))/cos(scale_lat/90.0*acos(0));
 
-  simple_lat_lons.push_back(Prepared_Point(lat, lon));
+  simple_lat_lons.push_back(lat, lon);
 
   std::vector< std::pair< uint32, uint32 > > uint_ranges
       (calc_ranges(south, north, west, east));
@@ -865,7 +786,7 @@ void add_coord(double lat, double lon, double radius,
 
 void add_node(Uint32_Index idx, const Node_Skeleton& node, double radius,
               std::map< Uint32_Index, std::vector< Point_Double > >& radius_lat_lons,
-              std::vector< Prepared_Point >& simple_lat_lons)
+              Cartesian_Batch& simple_lat_lons)
 {
   add_coord(::lat(idx.val(), node.ll_lower), ::lon(idx.val(), node.ll_lower),
             radius, radius_lat_lons, simple_lat_lons);
@@ -874,7 +795,7 @@ void add_node(Uint32_Index idx, const Node_Skeleton& node, double radius,
 
 void add_way(const std::vector< Quad_Coord >& way_geometry, double radius,
              std::map< Uint32_Index, std::vector< Point_Double > >& radius_lat_lons,
-             std::vector< Prepared_Point >& simple_lat_lons,
+             Cartesian_Batch& simple_lat_lons,
              std::vector< Prepared_Segment >& simple_segments)
 {
   // add nodes
@@ -907,7 +828,7 @@ void add_way(const std::vector< Quad_Coord >& way_geometry, double radius,
 
 void add_way(const std::vector< Point_Double >& points, double radius,
              std::map< Uint32_Index, std::vector< Point_Double > >& radius_lat_lons,
-             std::vector< Prepared_Point >& simple_lat_lons,
+             Cartesian_Batch& simple_lat_lons,
              std::vector< Prepared_Segment >& simple_segments)
 {
   // add nodes
@@ -1089,7 +1010,7 @@ bool Around_Statement::is_inside(double lat, double lon) const
     }
   }
 
-  std::vector< double > coord_cartesian = cartesian(lat, lon);
+  Cartesian coord_cartesian(lat, lon);
   for (std::vector< Prepared_Segment >::const_iterator
       it = simple_segments.begin(); it != simple_segments.end(); ++it)
   {
@@ -1107,22 +1028,62 @@ bool Around_Statement::is_inside(double lat, double lon) const
   return false;
 }
 
+
+void Around_Statement::is_inside(
+    Uint32_Index idx, const Cartesian_Batch& coords, std::vector< char >& inside) const
+{
+  inside.assign(coords.size(), false);
+
+  std::map< Uint32_Index, std::vector< Point_Double > >::const_iterator mit = radius_lat_lons.find(idx);
+  if (mit != radius_lat_lons.end())
+  {
+    for (std::vector< Point_Double >::const_iterator cit = mit->second.begin();
+        cit != mit->second.end(); ++cit)
+    {
+      if (radius > 0)
+        mark_within_dist(Cartesian(cit->lat, cit->lon), coords, radius, inside);
+      for (unsigned int i = 0; i < coords.size(); ++i)
+        inside[i] |= (std::abs(cit->lat - coords.lat[i]) < 1e-7 && std::abs(cit->lon - coords.lon[i]) < 1e-7);
+    }
+  }
+
+  std::vector< char > near_line;
+  for (std::vector< Prepared_Segment >::const_iterator
+      it = simple_segments.begin(); it != simple_segments.end(); ++it)
+  {
+    near_line.assign(coords.size(), false);
+    mark_within_line_dist(it->norm, coords, radius, near_line);
+
+    double gcdist = great_circle_dist
+        (it->first_lat, it->first_lon, it->second_lat, it->second_lon);
+    double limit = sqrt(gcdist*gcdist + radius*radius);
+    for (unsigned int i = 0; i < coords.size(); ++i)
+    {
+      if (near_line[i] && !inside[i]
+          && great_circle_dist(coords.lat[i], coords.lon[i], it->first_lat, it->first_lon) <= limit
+          && great_circle_dist(coords.lat[i], coords.lon[i], it->second_lat, it->second_lon) <= limit)
+        inside[i] = true;
+    }
+  }
+}
+
+
 bool Around_Statement::is_inside
     (double first_lat, double first_lon, double second_lat, double second_lon) const
 {
   Prepared_Segment segment(first_lat, first_lon, second_lat, second_lon);
 
-  for (std::vector< Prepared_Point >::const_iterator cit = simple_lat_lons.begin();
-      cit != simple_lat_lons.end(); ++cit)
+  std::vector< char > near_line(simple_lat_lons.size(), false);
+  mark_within_line_dist(segment.norm, simple_lat_lons, radius, near_line);
+
+  double gcdist = great_circle_dist(first_lat, first_lon, second_lat, second_lon);
+  double limit = sqrt(gcdist*gcdist + radius*radius);
+  for (unsigned int i = 0; i < simple_lat_lons.size(); ++i)
   {
-    if (great_circle_line_dist(segment, cit->cartesian) <= radius)
-    {
-      double gcdist = great_circle_dist(first_lat, first_lon, second_lat, second_lon);
-      double limit = sqrt(gcdist*gcdist + radius*radius);
-      if (great_circle_dist(cit->lat, cit->lon, first_lat, first_lon) <= limit &&
-	  great_circle_dist(cit->lat, cit->lon, second_lat, second_lon) <= limit)
-        return true;
-    }
+    if (near_line[i]
+        && great_circle_dist(simple_lat_lons.lat[i], simple_lat_lons.lon[i], first_lat, first_lon) <= limit
+        && great_circle_dist(simple_lat_lons.lat[i], simple_lat_lons.lon[i], second_lat, second_lon) <= limit)
+      return true;
   }
 
   for (std::vector< Prepared_Segment >::const_iterator
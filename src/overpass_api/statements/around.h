@@ -23,6 +23,7 @@
 #include <set>
 #include <string>
 #include <vector>
+#include "../core/great_circle.h"
 #include "../data/collect_members.h"
 #include "../data/utils.h"
 #include "../data/way_geometry_store.h"
@@ -35,30 +36,21 @@ struct Prepared_Segment
   double first_lon;
   double second_lat;
   double second_lon;
-  std::vector< double > first_cartesian;
-  std::vector< double > second_cartesian;
-  std::vector< double > norm;
+  Cartesian first_cartesian;
+  Cartesian second_cartesian;
+  Cartesian norm;
 
   Prepared_Segment(double first_lat, double first_lon, double second_lat, double second_lon);
 };
 
 
-struct Prepared_Point
-{
-  double lat;
-  double lon;
-  std::vector< double > cartesian;
-
-  Prepared_Point(double lat, double lon);
-};
-
-
 class Around_Statement : public Output_Statement
 {
   public:
     Around_Statement(int line_number_, const std::map< std::string, std::string >& attributes,
                      Parsed_Query& global_settings);
     virtual std::string get_name() const { return "around"; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual void execute(Resource_Manager& rman);
     virtual ~Around_Statement();
 
@@ -88,6 +80,9 @@ class Around_Statement : public Output_Statement
     void calc_lat_lons(const Set& input_nodes, Statement& query, Resource_Manager& rman);
 
     bool is_inside(double lat, double lon) const;
+    // Sets inside[i] to true for every coordinate that is inside.
+    // All coordinates must have ll_upper index idx.
+    void is_inside(Uint32_Index idx, const Cartesian_Batch& coords, std::vector< char >& inside) const;
     bool is_inside(double first_lat, double first_lon, double second_lat, double second_lon) const;
     bool is_inside(const std::vector< Quad_Coord >& way_geometry) const;
 
@@ -139,7 +134,7 @@ class Around_Statement : public Output_Statement
     std::vector< Point_Double > points;
 
     std::map< Uint32_Index, std::vector< Point_Double > > radius_lat_lons;
-    std::vector< Prepared_Point > simple_lat_lons;
+    Cartesian_Batch simple_lat_lons;
     std::vector< Prepared_Segment > simple_segments;
     std::vector< Query_Constraint* > constraints;
 };
@@ -33,6 +33,8 @@ class Bbox_Query_Statement : public Output_Statement
                          Parsed_Query& global_settings);
     Bbox_Query_Statement(const Bbox_Double& bbox);
     virtual std::string get_name() const { return "bbox-query"; }
+    virtual bool is_self_contained() const { return true; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual void execute(Resource_Manager& rman);
     virtual ~Bbox_Query_Statement();
 
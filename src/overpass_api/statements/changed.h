@@ -33,6 +33,7 @@ class Changed_Statement : public Output_Statement
     Changed_Statement(int line_number_, const std::map< std::string, std::string >& attributes,
                        Parsed_Query& global_settings);
     virtual std::string get_name() const { return "changed"; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual void execute(Resource_Manager& rman);
     virtual ~Changed_Statement();
 
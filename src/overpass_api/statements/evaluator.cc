@@ -20,6 +20,9 @@
 #include "../data/utils.h"
 #include "evaluator.h"
 
+#include <algorithm>
+#include <vector>
+
 
 const uint Set_Usage::SKELETON = 1;
 const uint Set_Usage::TAGS = 2;
@@ -200,6 +203,69 @@ void Set_With_Context::prefetch(uint usage, const Set& set, const Statement& stm
 }
 
 
+namespace
+{
+  template< typename Index, typename Object >
+  void collect_user_ids(const std::map< Index, std::vector< Object > >& items,
+      Meta_Collector< Index, typename Object::Id_Type >& meta_collector, std::vector< uint32 >& user_ids)
+  {
+    for (typename std::map< Index, std::vector< Object > >::const_iterator it = items.begin();
+        it != items.end(); ++it)
+    {
+      for (typename std::vector< Object >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+      {
+        const OSM_Element_Metadata_Skeleton< typename Object::Id_Type >* meta
+            = meta_collector.get(it->first, it2->id);
+        if (meta)
+          user_ids.push_back(meta->user_id);
+      }
+    }
+    meta_collector.reset();
+  }
+
+
+  template< typename Index, typename Object >
+  void collect_user_ids(const std::map< Index, std::vector< Attic< Object > > >& items,
+      Attic_Meta_Collector< Index, Object >& meta_collector, std::vector< uint32 >& user_ids)
+  {
+    for (typename std::map< Index, std::vector< Attic< Object > > >::const_iterator it = items.begin();
+        it != items.end(); ++it)
+    {
+      for (typename std::vector< Attic< Object > >::const_iterator it2 = it->second.begin();
+          it2 != it->second.end(); ++it2)
+      {
+        const OSM_Element_Metadata_Skeleton< typename Object::Id_Type >* meta
+            = meta_collector.get(it->first, it2->id, it2->timestamp);
+        if (meta)
+          user_ids.push_back(meta->user_id);
+      }
+    }
+    meta_collector.reset();
+  }
+}
+
+
+void Set_With_Context::collect_user_ids(std::vector< uint32 >& user_ids)
+{
+  if (!base)
+    return;
+
+  // The collectors are forward-only, hence they are rewound for the evaluation afterwards
+  if (meta_collector_nodes)
+    ::collect_user_ids(base->nodes, *meta_collector_nodes, user_ids);
+  if (meta_collector_attic_nodes)
+    ::collect_user_ids(base->attic_nodes, *meta_collector_attic_nodes, user_ids);
+  if (meta_collector_ways)
+    ::collect_user_ids(base->ways, *meta_collector_ways, user_ids);
+  if (meta_collector_attic_ways)
+    ::collect_user_ids(base->attic_ways, *meta_collector_attic_ways, user_ids);
+  if (meta_collector_relations)
+    ::collect_user_ids(base->relations, *meta_collector_relations, user_ids);
+  if (meta_collector_attic_relations)
+    ::collect_user_ids(base->attic_relations, *meta_collector_attic_relations, user_ids);
+}
+
+
 Element_With_Context< Node_Skeleton > Set_With_Context::get_context(
     const Uint32_Index& index, const Node_Skeleton& elem)
 {
@@ -448,7 +514,15 @@ Prepare_Task_Context::Prepare_Task_Context(
     relation_member_roles_ = &relation_member_roles(*rman.get_transaction());
 
   if (requested.user_names_requested)
-    users = &rman.users();
+  {
+    // Resolve the users of all input sets in one read instead of per element
+    std::vector< uint32 > user_ids;
+    for (uint i = 0; i < contexts.size(); ++i)
+      contexts[i].collect_user_ids(user_ids);
+    std::sort(user_ids.begin(), user_ids.end());
+    user_ids.erase(std::unique(user_ids.begin(), user_ids.end()), user_ids.end());
+    users = &rman.users(user_ids.begin(), user_ids.end());
+  }
 }
 
 
@@ -143,6 +143,8 @@ public:
   Element_With_Context< Derived_Skeleton > get_context(const Uint31_Index& index, const Derived_Structure& elem);
 
   void prefetch(uint usage, const Set& set, const Statement& query, Resource_Manager& rman);
+  // Appends the user ids of all elements of the set if the set has been prefetched with META
+  void collect_user_ids(std::vector< uint32 >& user_ids);
 
   std::string name;
   const Set* base;
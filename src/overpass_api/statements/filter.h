@@ -53,6 +53,7 @@ class Filter_Statement : public Output_Statement
     Filter_Statement(int line_number_, const std::map< std::string, std::string >& attributes,
                          Parsed_Query& global_settings);
     virtual std::string get_name() const { return "filter"; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual void add_statement(Statement* statement, std::string text);
     virtual void execute(Resource_Manager& rman);
     virtual ~Filter_Statement();
@@ -16,6 +16,7 @@
  * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cctype>
 #include <iostream>
 #include <map>
@@ -25,6 +26,9 @@
 #include <stdlib.h>
 #include <vector>
 
+#include "../core/settings.h"
+#include "../data/worker_pool.h"
+#include "../osm-backend/area_updater.h"
 #include "foreach.h"
 
 
@@ -102,6 +106,331 @@ void loop_over_elements(const std::map< Index, std::vector< Object > >& source,
 }
 
 
+void loop_over_set(const Set& source, Resource_Manager& rman,
+    std::vector< Statement* >& substatements, const std::string& input, const std::string& result_name)
+{
+  loop_over_elements(source.nodes, rman, substatements, input, result_name);
+  loop_over_elements(source.attic_nodes, rman, substatements, input, result_name);
+  loop_over_elements(source.ways, rman, substatements, input, result_name);
+  loop_over_elements(source.attic_ways, rman, substatements, input, result_name);
+  loop_over_elements(source.relations, rman, substatements, input, result_name);
+  loop_over_elements(source.attic_relations, rman, substatements, input, result_name);
+  loop_over_elements(source.areas, rman, substatements, input, result_name);
+  loop_over_elements(source.deriveds, rman, substatements, input, result_name);
+}
+
+
+/* Parallel area build
+
+In rules mode, a loop whose body builds areas with make-area can run in worker processes, see worker_pool.h.
+Each worker loops over a chunk of the elements and sends back the areas it has collected in its copy of
+the area updater. The calling process passes them in the order of the chunks to its own area updater,
+such that the database receives the same changes as from the sequential loop.
+The last element is always processed by the calling process to leave the same sets behind as the sequential loop.
+*/
+
+namespace
+{
+  const uint ELEMENTS_PER_CHUNK = 256;
+  const uint CHUNKS_PER_WORKER_AND_ROUND = 16;
+
+
+  // Besides make-area, only statements whose whole statement tree is free of side effects
+  // may appear in the loop body.
+  bool builds_areas_in_workers(
+      const std::vector< Statement* >& substatements, const Set& base_set, Resource_Manager& rman)
+  {
+    if (basic_settings().area_build_workers < 2 || rman.is_worker()
+        || !dynamic_cast< Area_Updater* >(rman.area_updater())
+        || rman.get_desired_timestamp() != NOW || rman.get_desired_action() != Diff_Action::positive)
+      return false;
+
+    if (!base_set.attic_nodes.empty() || !base_set.attic_ways.empty() || !base_set.attic_relations.empty()
+        || !base_set.areas.empty() || !base_set.deriveds.empty())
+      return false;
+
+    bool make_area_present = false;
+    for (std::vector< Statement* >::const_iterator it = substatements.begin(); it != substatements.end(); ++it)
+    {
+      if ((*it)->get_name() == "make-area")
+        make_area_present = true;
+      else if (!(*it)->is_free_of_side_effects())
+        return false;
+    }
+    return make_area_present;
+  }
+
+
+  // Hands out the nodes, ways, and relations of a set in the order of the sequential loop.
+  class Element_Chunker
+  {
+    public:
+      Element_Chunker(const Set& source_)
+          : source(&source_), node_it(source_.nodes.begin()), way_it(source_.ways.begin()),
+          relation_it(source_.relations.begin()), node_pos(0), way_pos(0), relation_pos(0), remaining_(0)
+      {
+        remaining_ += count(source_.nodes) + count(source_.ways) + count(source_.relations);
+      }
+
+      uint64 remaining() const { return remaining_; }
+
+      void next_chunk(uint64 max_count, Set& chunk)
+      {
+        uint64 taken = take(source->nodes, node_it, node_pos, max_count, chunk.nodes);
+        taken += take(source->ways, way_it, way_pos, max_count - taken, chunk.ways);
+        taken += take(source->relations, relation_it, relation_pos, max_count - taken, chunk.relations);
+        remaining_ -= taken;
+      }
+
+    private:
+      const Set* source;
+      std::map< Uint32_Index, std::vector< Node_Skeleton > >::const_iterator node_it;
+      std::map< Uint31_Index, std::vector< Way_Skeleton > >::const_iterator way_it;
+      std::map< Uint31_Index, std::vector< Relation_Skeleton > >::const_iterator relation_it;
+      uint node_pos, way_pos, relation_pos;
+      uint64 remaining_;
+
+      template< typename Index, typename Object >
+      static uint64 count(const std::map< Index, std::vector< Object > >& elems)
+      {
+        uint64 result = 0;
+        for (typename std::map< Index, std::vector< Object > >::const_iterator it = elems.begin();
+            it != elems.end(); ++it)
+          result += it->second.size();
+        return result;
+      }
+
+      template< typename Index, typename Object >
+      static uint64 take(const std::map< Index, std::vector< Object > >& elems,
+          typename std::map< Index, std::vector< Object > >::const_iterator& it, uint& pos,
+          uint64 max_count, std::map< Index, std::vector< Object > >& target)
+      {
+        uint64 taken = 0;
+        while (taken < max_count && it != elems.end())
+        {
+          uint64 num = std::min< uint64 >(max_count - taken, it->second.size() - pos);
+          target[it->first].insert(target[it->first].end(),
+              it->second.begin() + pos, it->second.begin() + pos + num);
+          taken += num;
+          pos += num;
+          if (pos == it->second.size())
+          {
+            ++it;
+            pos = 0;
+          }
+        }
+        return taken;
+      }
+  };
+
+
+  // Keeps the runtime remarks such that the calling process can display them.
+  // Any error lets the task fail, hence the calling process repeats it to display the error itself.
+  struct Remark_Collecting_Error_Output : public Error_Output
+  {
+    Remark_Collecting_Error_Output() : errors_present(false) {}
+
+    virtual void add_encoding_error(const std::string& error) { errors_present = true; }
+    virtual void add_parse_error(const std::string& error, int line_number) { errors_present = true; }
+    virtual void add_static_error(const std::string& error, int line_number) { errors_present = true; }
+
+    virtual void add_encoding_remark(const std::string& error) { errors_present = true; }
+    virtual void add_parse_remark(const std::string& error, int line_number) { errors_present = true; }
+    virtual void add_static_remark(const std::string& error, int line_number) { errors_present = true; }
+
+    virtual void runtime_error(const std::string& error) { errors_present = true; }
+    virtual void runtime_remark(const std::string& error) { remarks.push_back(error); }
+
+    virtual void display_statement_progress
+        (uint timer, const std::string& name, int progress, int line_number,
+         const std::vector< std::pair< uint, uint > >& stack) {}
+
+    virtual bool display_encoding_errors() { return false; }
+    virtual bool display_parse_errors() { return false; }
+    virtual bool display_static_errors() { return false; }
+
+    bool errors_present;
+    std::vector< std::string > remarks;
+  };
+
+
+  void append_string(const std::string& s, std::string& buf)
+  {
+    append_uint32(s.size(), buf);
+    buf.append(s);
+  }
+
+
+  bool read_string(const std::string& buf, std::string::size_type& pos, std::string& s)
+  {
+    uint32 size = 0;
+    if (!read_uint32(buf, pos, size) || buf.size() < pos + size)
+      return false;
+    s.assign(buf, pos, size);
+    pos += size;
+    return true;
+  }
+
+
+  class Area_Build_Task : public Worker_Task
+  {
+    public:
+      Area_Build_Task(const Set& chunk_, std::vector< Statement* >& substatements_,
+          const std::string& input_, const std::string& result_name_)
+          : chunk(&chunk_), substatements(&substatements_), input(&input_), result_name(&result_name_) {}
+
+      virtual bool run(Resource_Manager& rman, std::string& result)
+      {
+        Remark_Collecting_Error_Output error_output;
+        Statement::set_error_output(&error_output);
+        Area_Updater* area_updater = dynamic_cast< Area_Updater* >(rman.area_updater());
+        area_updater->collect_only();
+
+        loop_over_set(*chunk, rman, *substatements, *input, *result_name);
+        if (error_output.errors_present)
+          return false;
+
+        append_uint32(error_output.remarks.size(), result);
+        for (std::vector< std::string >::const_iterator it = error_output.remarks.begin();
+            it != error_output.remarks.end(); ++it)
+          append_string(*it, result);
+
+        std::vector< uint64 > scratch;
+        const std::vector< std::pair< Area_Location, Uint31_Index > >& areas = area_updater->get_areas();
+        append_uint32(areas.size(), result);
+        for (std::vector< std::pair< Area_Location, Uint31_Index > >::const_iterator it = areas.begin();
+            it != areas.end(); ++it)
+        {
+          append_uint32(it->second.val(), result);
+          append_record(Area_Skeleton(it->first), scratch, result);
+          append_uint32(it->first.tags.size(), result);
+          for (std::vector< std::pair< std::string, std::string > >::const_iterator it2 = it->first.tags.begin();
+              it2 != it->first.tags.end(); ++it2)
+          {
+            append_string(it2->first, result);
+            append_string(it2->second, result);
+          }
+        }
+        append_map(area_updater->get_blocks(), result);
+        append_map(area_updater->get_rasters(), result);
+        return true;
+      }
+
+    private:
+      const Set* chunk;
+      std::vector< Statement* >* substatements;
+      const std::string* input;
+      const std::string* result_name;
+  };
+
+
+  struct Area_Build_Result
+  {
+    std::vector< std::string > remarks;
+    std::vector< std::pair< Area_Location, Uint31_Index > > areas;
+    std::map< Uint31_Index, std::vector< Area_Block > > blocks;
+    std::map< Uint31_Index, std::vector< Area_Raster > > rasters;
+  };
+
+
+  bool read_area_build_result(const std::string& buf, Area_Build_Result& result)
+  {
+    std::string::size_type pos = 0;
+    std::vector< uint64 > scratch;
+
+    uint32 num_remarks = 0;
+    if (!read_uint32(buf, pos, num_remarks))
+      return false;
+    result.remarks.resize(num_remarks);
+    for (uint32 i = 0; i < num_remarks; ++i)
+    {
+      if (!read_string(buf, pos, result.remarks[i]))
+        return false;
+    }
+
+    uint32 num_areas = 0;
+    if (!read_uint32(buf, pos, num_areas))
+      return false;
+    for (uint32 i = 0; i < num_areas; ++i)
+    {
+      uint32 index = 0;
+      uint32 num_tags = 0;
+      if (!read_uint32(buf, pos, index) || !read_record(buf, pos, scratch))
+        return false;
+      Area_Skeleton skel((void*)&scratch[0]);
+      result.areas.push_back(std::make_pair(Area_Location(skel.id.val(), skel.used_indices), Uint31_Index(index)));
+      if (!read_uint32(buf, pos, num_tags))
+        return false;
+      std::vector< std::pair< std::string, std::string > >& tags = result.areas.back().first.tags;
+      tags.resize(num_tags);
+      for (uint32 j = 0; j < num_tags; ++j)
+      {
+        if (!read_string(buf, pos, tags[j].first) || !read_string(buf, pos, tags[j].second))
+          return false;
+      }
+    }
+
+    return read_map(buf, pos, result.blocks) && read_map(buf, pos, result.rasters) && pos == buf.size();
+  }
+}
+
+
+void Foreach_Statement::loop_in_workers(const Set& base_set, Resource_Manager& rman)
+{
+  Area_Updater* area_updater = dynamic_cast< Area_Updater* >(rman.area_updater());
+  uint max_workers = basic_settings().area_build_workers;
+  Element_Chunker chunker(base_set);
+
+  while (chunker.remaining() > 1)
+  {
+    std::vector< Set > chunks;
+    std::vector< uint64 > chunk_sizes;
+    while (chunker.remaining() > 1 && chunks.size() < max_workers * CHUNKS_PER_WORKER_AND_ROUND)
+    {
+      chunk_sizes.push_back(std::min< uint64 >(ELEMENTS_PER_CHUNK, chunker.remaining() - 1));
+      chunks.push_back(Set());
+      chunker.next_chunk(chunk_sizes.back(), chunks.back());
+    }
+
+    std::vector< Area_Build_Task > tasks;
+    for (std::vector< Set >::const_iterator it = chunks.begin(); it != chunks.end(); ++it)
+      tasks.push_back(Area_Build_Task(*it, substatements, input, get_result_name()));
+    std::vector< Worker_Task* > task_ptrs;
+    for (std::vector< Area_Build_Task >::iterator it = tasks.begin(); it != tasks.end(); ++it)
+      task_ptrs.push_back(&*it);
+
+    std::vector< std::string > buffers;
+    std::vector< bool > delivered = run_in_workers(task_ptrs, max_workers, rman, *this, buffers);
+
+    for (uint i = 0; i < chunks.size(); ++i)
+    {
+      Area_Build_Result result;
+      if (!delivered[i] || !read_area_build_result(buffers[i], result))
+      {
+        loop_over_set(chunks[i], rman, substatements, input, get_result_name());
+        continue;
+      }
+      buffers[i].clear();
+
+      for (uint64 j = 0; j < chunk_sizes[i]; ++j)
+        rman.count_loop();
+      for (std::vector< std::string >::const_iterator it = result.remarks.begin(); it != result.remarks.end(); ++it)
+        runtime_remark(*it);
+      for (std::vector< std::pair< Area_Location, Uint31_Index > >::const_iterator it = result.areas.begin();
+          it != result.areas.end(); ++it)
+        area_updater->set_area(it->second, it->first);
+      area_updater->add_blocks(result.blocks);
+      area_updater->add_rasters(result.rasters);
+      area_updater->commit();
+    }
+  }
+
+  Set last;
+  chunker.next_chunk(1, last);
+  loop_over_set(last, rman, substatements, input, get_result_name());
+}
+
+
 void Foreach_Statement::execute(Resource_Manager& rman)
 {
   Set base_result_set;
@@ -113,14 +442,10 @@ void Foreach_Statement::execute(Resource_Manager& rman)
   if (!base_set)
     base_set = &base_result_set;
 
-  loop_over_elements(base_set->nodes, rman, substatements, input, get_result_name());
-  loop_over_elements(base_set->attic_nodes, rman, substatements, input, get_result_name());
-  loop_over_elements(base_set->ways, rman, substatements, input, get_result_name());
-  loop_over_elements(base_set->attic_ways, rman, substatements, input, get_result_name());
-  loop_over_elements(base_set->relations, rman, substatements, input, get_result_name());
-  loop_over_elements(base_set->attic_relations, rman, substatements, input, get_result_name());
-  loop_over_elements(base_set->areas, rman, substatements, input, get_result_name());
-  loop_over_elements(base_set->deriveds, rman, substatements, input, get_result_name());
+  if (builds_areas_in_workers(substatements, *base_set, rman))
+    loop_in_workers(*base_set, rman);
+  else
+    loop_over_set(*base_set, rman, substatements, input, get_result_name());
 
   rman.move_all_inward_except(get_result_name());
   rman.pop_stack_frame();
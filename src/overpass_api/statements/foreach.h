@@ -78,6 +78,8 @@ class Foreach_Statement : public Statement
   private:
     std::string input, output;
     std::vector< Statement* > substatements;
+
+    void loop_in_workers(const Set& base_set, Resource_Manager& rman);
 };
 
 #endif
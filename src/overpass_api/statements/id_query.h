@@ -32,6 +32,8 @@ class Id_Query_Statement : public Output_Statement
     Id_Query_Statement(int line_number_, const std::map< std::string, std::string >& attributes,
                        Parsed_Query& global_settings);
     virtual std::string get_name() const { return "id-query"; }
+    virtual bool is_self_contained() const { return true; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual void execute(Resource_Manager& rman);
     virtual ~Id_Query_Statement();
 
@@ -33,6 +33,7 @@ class Item_Statement : public Output_Statement
     Item_Statement(int line_number_, const std::map< std::string, std::string >& attributes,
                    Parsed_Query& global_settings);
     virtual std::string get_name() const { return "item"; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual void execute(Resource_Manager& rman);
     virtual ~Item_Statement();
 
@@ -31,6 +31,7 @@
 #include "../../template_db/random_file.h"
 #include "../data/collect_members.h"
 #include "../osm-backend/area_updater.h"
+#include "coord_query.h"
 #include "make_area.h"
 #include "print.h"
 
@@ -241,6 +242,160 @@ void Make_Area_Statement::add_segment_blocks
 }
 
 
+namespace
+{
+  struct Raster_Segment
+  {
+    uint32 last_lat;
+    int32 last_lon;
+    uint32 lat;
+    int32 lon;
+  };
+
+
+  // The latitude of the segment at coord_lon, computed exactly as in
+  // Coord_Query_Statement::check_area_block(). It is monotonous in coord_lon.
+  uint32 lat_at(const Raster_Segment& seg, int32 coord_lon)
+  {
+    if (coord_lon == seg.lon)
+      return seg.lat;
+    else if (coord_lon == seg.last_lon)
+      return seg.last_lat;
+    return seg.lat + ((int64)coord_lon - seg.lon)*((int64)seg.last_lat - seg.lat)/((int64)seg.last_lon - seg.lon);
+  }
+
+
+  // Returns true if the part of the segment between west and east lies entirely south of south
+  // or entirely north of north. The segment must overlap the interval [west, east].
+  bool avoids_cell(const Raster_Segment& seg, uint32 south, uint32 north, int32 west, int32 east)
+  {
+    uint32 lat_from = seg.last_lat;
+    uint32 lat_to = seg.lat;
+    if (seg.last_lon != seg.lon)
+    {
+      lat_from = lat_at(seg, std::max(std::min(seg.last_lon, seg.lon), west));
+      lat_to = lat_at(seg, std::min(std::max(seg.last_lon, seg.lon), east));
+    }
+    return ((lat_from < south && lat_to < south) || (lat_from > north && lat_to > north));
+  }
+}
+
+
+/* A cell gets a definite state if all its points get the same result from check_area_block().
+  This is the case if
+  - all segments that overlap the cell's longitude range are entirely south or entirely north
+    of the cell
+  - and for every longitude within the cell's longitude range an even number of chains ends
+    there not north of the cell,
+  because then every north-south line through the cell toggles the same parity south of the cell.
+  We evaluate that state at the south-west corner of the cell. */
+void Make_Area_Statement::create_area_rasters
+    (std::map< Uint31_Index, std::vector< Area_Raster > >& area_rasters,
+     const std::map< Uint31_Index, std::vector< Area_Block > >& area_blocks, uint32 id)
+{
+  for (std::map< Uint31_Index, std::vector< Area_Block > >::const_iterator
+      it = area_blocks.begin(); it != area_blocks.end(); ++it)
+  {
+    uint32 current_idx = it->first.val();
+
+    std::vector< Raster_Segment > segments;
+    std::vector< std::pair< int32, uint32 > > chain_ends;
+    for (std::vector< Area_Block >::const_iterator it2(it->second.begin());
+        it2 != it->second.end(); ++it2)
+    {
+      if (it2->coors.empty())
+        continue;
+
+      std::vector< uint64 >::const_iterator cit = it2->coors.begin();
+      Raster_Segment seg;
+      seg.lat = ::ilat(current_idx | (((*cit)>>32)&0xff), (*cit & 0xffffffff));
+      seg.lon = ::ilon(current_idx | (((*cit)>>32)&0xff), (*cit & 0xffffffff));
+      chain_ends.push_back(std::make_pair(seg.lon, seg.lat));
+      while (++cit != it2->coors.end())
+      {
+        seg.last_lat = seg.lat;
+        seg.last_lon = seg.lon;
+        seg.lat = ::ilat(current_idx | (((*cit)>>32)&0xff), (*cit & 0xffffffff));
+        seg.lon = ::ilon(current_idx | (((*cit)>>32)&0xff), (*cit & 0xffffffff));
+        segments.push_back(seg);
+      }
+      chain_ends.push_back(std::make_pair(seg.lon, seg.lat));
+    }
+
+    Area_Raster raster(id);
+    bool has_definite_cells = false;
+    uint32 tile_south = ::ilat(current_idx, 0);
+    int32 tile_west = ::ilon(current_idx, 0);
+    for (int32 col = 0; col < 16; ++col)
+    {
+      int32 west = tile_west + col*0x10000;
+      int32 east = west + 0xffff;
+
+      std::vector< const Raster_Segment* > in_column;
+      for (std::vector< Raster_Segment >::const_iterator sit = segments.begin(); sit != segments.end(); ++sit)
+      {
+        if (std::max(sit->last_lon, sit->lon) >= west && std::min(sit->last_lon, sit->lon) <= east)
+          in_column.push_back(&*sit);
+      }
+      std::vector< std::pair< int32, uint32 > > ends_in_column;
+      for (std::vector< std::pair< int32, uint32 > >::const_iterator eit = chain_ends.begin();
+          eit != chain_ends.end(); ++eit)
+      {
+        if (west <= eit->first && eit->first <= east)
+          ends_in_column.push_back(*eit);
+      }
+
+      for (uint32 row = 0; row < 16; ++row)
+      {
+        uint32 south = tile_south + row*0x10000;
+        uint32 north = south + 0xffff;
+
+        bool definite = true;
+        for (std::vector< const Raster_Segment* >::const_iterator sit = in_column.begin();
+            definite && sit != in_column.end(); ++sit)
+          definite &= avoids_cell(**sit, south, north, west, east);
+
+        std::set< int32 > odd_lons;
+        for (std::vector< std::pair< int32, uint32 > >::const_iterator eit = ends_in_column.begin();
+            definite && eit != ends_in_column.end(); ++eit)
+        {
+          if (eit->second <= north && !odd_lons.insert(eit->first).second)
+            odd_lons.erase(eit->first);
+        }
+        if (!definite || !odd_lons.empty())
+          continue;
+
+        int inside = 0;
+        for (std::vector< Area_Block >::const_iterator it2(it->second.begin());
+            it2 != it->second.end(); ++it2)
+        {
+          if (it2->coors.empty())
+            continue;
+          int check = Coord_Query_Statement::check_area_block(current_idx, *it2, south, west);
+          if (check == Coord_Query_Statement::HIT)
+          {
+            definite = false;
+            break;
+          }
+          inside ^= check;
+        }
+        if (!definite)
+          continue;
+
+        raster.set_cell_state(::ll_upper(south, west), inside ? Area_Raster::INSIDE : Area_Raster::OUTSIDE);
+        has_definite_cells = true;
+      }
+    }
+
+    if (has_definite_cells)
+    {
+      raster.summarize();
+      area_rasters[it->first].push_back(raster);
+    }
+  }
+}
+
+
 void add_south_pole_line
     (std::map< Uint31_Index, std::vector< Area_Block > >& area_blocks, uint32 id)
 {
@@ -412,9 +567,13 @@ void Make_Area_Statement::execute(Resource_Manager& rman)
 
   if (rman.area_updater())
   {
+    std::map< Uint31_Index, std::vector< Area_Raster > > area_rasters;
+    create_area_rasters(area_rasters, area_blocks, pivot_id);
+
     Area_Updater* area_updater = dynamic_cast< Area_Updater* >(rman.area_updater());
     area_updater->set_area(new_index, new_location);
     area_updater->add_blocks(area_blocks);
+    area_updater->add_rasters(area_rasters);
     area_updater->commit();
   }
 
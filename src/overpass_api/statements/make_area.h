@@ -46,6 +46,13 @@ class Make_Area_Statement : public Output_Statement
 
     static bool is_used() { return is_used_; }
 
+    // Public for the unit tests of the rasters
+    static void add_segment_blocks
+        (std::map< Uint31_Index, std::vector< Area_Block > >& areas, uint32 id);
+    static void create_area_rasters
+        (std::map< Uint31_Index, std::vector< Area_Raster > >& area_rasters,
+         const std::map< Uint31_Index, std::vector< Area_Block > >& area_blocks, uint32 id);
+
   private:
     std::string input, pivot;
     bool return_area;
@@ -57,8 +64,6 @@ class Make_Area_Statement : public Output_Statement
 	 uint32 id, const Set& pivot);
     static uint32 shifted_lat(uint32 ll_index, uint64 coord);
     static int32 lon_(uint32 ll_index, uint64 coord);
-    static void add_segment_blocks
-        (std::map< Uint31_Index, std::vector< Area_Block > >& areas, uint32 id);
 
     static bool is_used_;
 };
@@ -34,6 +34,8 @@ public:
   Newer_Statement(int line_number_, const std::map< std::string, std::string >& input_attributes,
                     Parsed_Query& global_settings);
   virtual std::string get_name() const { return "newer"; }
+  virtual bool is_self_contained() const { return true; }
+  virtual bool is_free_of_side_effects() const { return true; }
   virtual std::string get_result_name() const { return ""; }
   virtual void execute(Resource_Manager& rman);
   virtual ~Newer_Statement();
@@ -189,15 +189,79 @@ Print_Statement::Print_Statement
 }
 
 
+// Only ways and relations need the geometry of other elements
+template< typename Index, typename Object >
+bool has_geometry_store(const std::map< Index, std::vector< Object > >&) { return false; }
+bool has_geometry_store(const std::map< Uint31_Index, std::vector< Way_Skeleton > >&) { return true; }
+bool has_geometry_store(const std::map< Uint31_Index, std::vector< Attic< Way_Skeleton > > >&) { return true; }
+bool has_geometry_store(const std::map< Uint31_Index, std::vector< Relation_Skeleton > >&) { return true; }
+bool has_geometry_store(const std::map< Uint31_Index, std::vector< Attic< Relation_Skeleton > > >&) { return true; }
+
+
+template< typename Index, typename Object >
+struct Maybe_Attic_Ref
+{
+public:
+  Maybe_Attic_Ref(Index idx_, const Object* obj_, uint64 timestamp_)
+  : idx(idx_), obj(obj_), timestamp(timestamp_) {}
+
+  Index idx;
+  const Object* obj;
+  uint64 timestamp;
+
+  bool operator<(const Maybe_Attic_Ref& rhs) const { return obj->id < rhs.obj->id; }
+};
+
+
+template< typename Object >
+typename Object::Id_Type id_of(const std::pair< const Object*, uint32 >& item) { return item.first->id; }
+
+template< typename Index, typename Object >
+typename Object::Id_Type id_of(const Maybe_Attic_Ref< Index, Object >& item) { return item.obj->id; }
+
+
+// Returns the end of the chunk of about chunk_size elements starting at begin of the elements sorted by id.
+// A chunk never ends between elements of the same id, hence its id bounds cover exactly its elements.
+template< typename Item >
+uint32 chunk_end_by_id(const std::vector< Item >& items_by_id, uint32 begin, uint32 chunk_size)
+{
+  uint32 end = std::min(begin + chunk_size, (uint32)items_by_id.size());
+  while (end < items_by_id.size() && !(id_of(items_by_id[end-1]) < id_of(items_by_id[end])))
+    ++end;
+  return end;
+}
+
+
+/* The geometry of ways and relations is built per chunk of printed elements.
+ * Thus only the coordinates of one chunk are held in memory at a time. */
 struct Extra_Data
 {
   Extra_Data(
-      Resource_Manager& rman, const Statement& stmt, const Set& to_print,
+      Resource_Manager& rman, const Statement& stmt,
       unsigned int mode_, Output_Handler::Feature_Action action_,
       double south, double north, double west, double east);
   ~Extra_Data();
 
-  const std::map< uint32, std::string >* get_users() const;
+  // Resolves the names of the users of all metadata of a chunk in one read
+  void prepare_users(const std::vector< uint32 >& user_ids);
+
+  template< typename Id_Type >
+  const std::map< uint32, std::string >* get_users(const OSM_Element_Metadata_Skeleton< Id_Type >* meta) const
+  { return meta ? users : 0; }
+
+  // Prepares the chunk of about chunk_size elements starting at begin and returns its end
+  template< typename Index, typename Object >
+  typename std::map< Index, std::vector< Object > >::const_iterator prepare_chunk(
+      const std::map< Index, std::vector< Object > >& items,
+      typename std::map< Index, std::vector< Object > >::const_iterator begin, uint32 chunk_size);
+
+  // Prepares the chunk of the elements at positions begin to below end of the elements sorted by id
+  template< typename Index, typename Object >
+  void prepare_chunk(const std::vector< std::pair< const Object*, uint32 > >& items_by_id,
+      uint32 begin, uint32 end);
+  template< typename Index, typename Object >
+  void prepare_chunk(const std::vector< Maybe_Attic_Ref< Index, Object > >& items_by_id,
+      uint32 begin, uint32 end);
 
   unsigned int mode;
   Output_Handler::Feature_Action action;
@@ -207,55 +271,146 @@ struct Extra_Data
   Relation_Geometry_Store* attic_relation_geometry_store;
   const std::map< uint32, std::string >* roles;
   const std::map< uint32, std::string >* users;
+
+private:
+  Resource_Manager& rman;
+  const Statement& stmt;
+  double south;
+  double north;
+  double west;
+  double east;
+
+  bool needs_geometry() const
+  { return mode & (Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER); }
+
+  template< typename Index, typename Object >
+  void set_geometry(const std::map< Index, std::vector< Object > >&) {}
+  void set_geometry(const std::map< Uint31_Index, std::vector< Way_Skeleton > >& ways);
+  void set_geometry(const std::map< Uint31_Index, std::vector< Attic< Way_Skeleton > > >& ways);
+  void set_geometry(const std::map< Uint31_Index, std::vector< Relation_Skeleton > >& relations);
+  void set_geometry(const std::map< Uint31_Index, std::vector< Attic< Relation_Skeleton > > >& relations);
 };
 
 
 Extra_Data::Extra_Data(
-    Resource_Manager& rman, const Statement& stmt, const Set& to_print,
+    Resource_Manager& rman_, const Statement& stmt_,
     unsigned int mode_, Output_Handler::Feature_Action action_,
-    double south, double north, double west, double east)
+    double south_, double north_, double west_, double east_)
     : mode(mode_), action(action_), way_geometry_store(0), attic_way_geometry_store(0),
-    relation_geometry_store(0), attic_relation_geometry_store(0), roles(0), users(0)
+    relation_geometry_store(0), attic_relation_geometry_store(0), roles(0), users(0),
+    rman(rman_), stmt(stmt_), south(south_), north(north_), west(west_), east(east_)
 {
-  if (mode & (Output_Mode::GEOMETRY | Output_Mode::BOUNDS | Output_Mode::CENTER))
-  {
-    way_geometry_store = new Way_Bbox_Geometry_Store(to_print.ways, stmt, rman, south, north, west, east);
-    if (rman.get_desired_timestamp() < NOW)
-    {
-      attic_way_geometry_store = new Way_Bbox_Geometry_Store(
-          to_print.attic_ways, stmt, rman,
-          south, north, west, east);
-    }
+  roles = &relation_member_roles(*rman.get_transaction());
+}
 
-    relation_geometry_store = new Relation_Geometry_Store(
-        to_print.relations, stmt, rman, south, north, west, east);
-    if (rman.get_desired_timestamp() < NOW)
-    {
-      attic_relation_geometry_store = new Relation_Geometry_Store(
-          to_print.attic_relations, stmt, rman,
-          south, north, west, east);
-    }
+
+Extra_Data::~Extra_Data()
+{
+  delete way_geometry_store;
+  delete attic_way_geometry_store;
+  delete relation_geometry_store;
+  delete attic_relation_geometry_store;
+}
+
+
+template< typename Index, typename Object >
+typename std::map< Index, std::vector< Object > >::const_iterator Extra_Data::prepare_chunk(
+    const std::map< Index, std::vector< Object > >& items,
+    typename std::map< Index, std::vector< Object > >::const_iterator begin, uint32 chunk_size)
+{
+  typename std::map< Index, std::vector< Object > >::const_iterator end = begin;
+  for (uint32 size = 0; end != items.end() && size < chunk_size; ++end)
+    size += end->second.size();
+
+  if (needs_geometry() && has_geometry_store(items))
+    set_geometry(std::map< Index, std::vector< Object > >(begin, end));
+
+  return end;
+}
+
+
+template< typename Index, typename Object >
+void Extra_Data::prepare_chunk(const std::vector< std::pair< const Object*, uint32 > >& items_by_id,
+    uint32 begin, uint32 end)
+{
+  std::map< Index, std::vector< Object > > chunk;
+  if (!needs_geometry() || !has_geometry_store(chunk))
+    return;
+
+  for (uint32 i = begin; i < end; ++i)
+    chunk[Index(items_by_id[i].second)].push_back(*items_by_id[i].first);
+  set_geometry(chunk);
+}
+
+
+template< typename Index, typename Object >
+void Extra_Data::prepare_chunk(const std::vector< Maybe_Attic_Ref< Index, Object > >& items_by_id,
+    uint32 begin, uint32 end)
+{
+  std::map< Index, std::vector< Object > > chunk;
+  std::map< Index, std::vector< Attic< Object > > > attic_chunk;
+  if (!needs_geometry() || !has_geometry_store(chunk))
+    return;
+
+  for (uint32 i = begin; i < end; ++i)
+  {
+    if (items_by_id[i].timestamp == NOW)
+      chunk[items_by_id[i].idx].push_back(*items_by_id[i].obj);
+    else
+      attic_chunk[items_by_id[i].idx].push_back(Attic< Object >(*items_by_id[i].obj, items_by_id[i].timestamp));
   }
+  set_geometry(chunk);
+  set_geometry(attic_chunk);
+}
 
-  roles = &relation_member_roles(*rman.get_transaction());
 
+void Extra_Data::prepare_users(const std::vector< uint32 >& user_ids)
+{
   if (mode & Output_Mode::META)
-    users = &rman.users();
+    users = &rman.users(user_ids.begin(), user_ids.end());
 }
 
 
-const std::map< uint32, std::string >* Extra_Data::get_users() const
+template< typename Iterator >
+void append_user_ids(Iterator begin, Iterator end, std::vector< uint32 >& user_ids)
 {
-  return users;
+  for (; begin != end; ++begin)
+    user_ids.push_back(begin->user_id);
 }
 
 
-Extra_Data::~Extra_Data()
+void Extra_Data::set_geometry(const std::map< Uint31_Index, std::vector< Way_Skeleton > >& ways)
 {
   delete way_geometry_store;
-  delete attic_way_geometry_store;
+  way_geometry_store = new Way_Bbox_Geometry_Store(ways, stmt, rman, south, north, west, east);
+}
+
+
+void Extra_Data::set_geometry(const std::map< Uint31_Index, std::vector< Attic< Way_Skeleton > > >& ways)
+{
+  if (rman.get_desired_timestamp() < NOW)
+  {
+    delete attic_way_geometry_store;
+    attic_way_geometry_store = new Way_Bbox_Geometry_Store(ways, stmt, rman, south, north, west, east);
+  }
+}
+
+
+void Extra_Data::set_geometry(const std::map< Uint31_Index, std::vector< Relation_Skeleton > >& relations)
+{
   delete relation_geometry_store;
-  delete attic_relation_geometry_store;
+  relation_geometry_store = new Relation_Geometry_Store(relations, stmt, rman, south, north, west, east);
+}
+
+
+void Extra_Data::set_geometry(const std::map< Uint31_Index, std::vector< Attic< Relation_Skeleton > > >& relations)
+{
+  if (rman.get_desired_timestamp() < NOW)
+  {
+    delete attic_relation_geometry_store;
+    attic_relation_geometry_store = new Relation_Geometry_Store(
+        relations, stmt, rman, south, north, west, east);
+  }
 }
 
 
@@ -264,7 +419,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
                     const OSM_Element_Metadata_Skeleton< Node_Skeleton::Id_Type >* meta = 0)
 {
   output.print_item(skel, Point_Geometry(::lat(ll_upper, skel.ll_lower), ::lon(ll_upper, skel.ll_lower)),
-      tags, meta, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -275,7 +430,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
   Geometry_From_Quad_Coords broker;
   output.print_item(skel,
       broker.make_way_geom(skel, extra_data.mode, extra_data.way_geometry_store),
-      tags, meta, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -286,7 +441,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
   Geometry_From_Quad_Coords broker;
   output.print_item(skel,
       broker.make_way_geom(skel, extra_data.mode, extra_data.attic_way_geometry_store),
-      tags, meta, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -297,7 +452,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
   Geometry_From_Quad_Coords broker;
   output.print_item(skel,
       broker.make_relation_geom(skel, extra_data.mode, extra_data.relation_geometry_store),
-      tags, meta, extra_data.roles, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.roles, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -308,7 +463,7 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
   Geometry_From_Quad_Coords broker;
   output.print_item(skel,
       broker.make_relation_geom(skel, extra_data.mode, extra_data.attic_relation_geometry_store),
-      tags, meta, extra_data.roles, extra_data.get_users(), Output_Mode(extra_data.mode), extra_data.action);
+      tags, meta, extra_data.roles, extra_data.get_users(meta), Output_Mode(extra_data.mode), extra_data.action);
 }
 
 
@@ -335,21 +490,26 @@ void print_item(Extra_Data& extra_data, Output_Handler& output, uint32 ll_upper,
 template< class TIndex, class TObject >
 void quadtile_
     (const std::map< TIndex, std::vector< TObject > >& items, Output_Handler& output,
-     Transaction& transaction, Extra_Data& extra_data, uint32 limit, uint32& element_count)
+     Transaction& transaction, Extra_Data& extra_data, uint32 FLUSH_SIZE, uint32 limit, uint32& element_count)
 {
   typename std::map< TIndex, std::vector< TObject > >::const_iterator
       item_it(items.begin());
   // print the result
   while (item_it != items.end())
   {
-    for (typename std::vector< TObject >::const_iterator it2(item_it->second.begin());
-        it2 != item_it->second.end(); ++it2)
+    typename std::map< TIndex, std::vector< TObject > >::const_iterator
+        chunk_end = extra_data.prepare_chunk(items, item_it, FLUSH_SIZE);
+    for (; item_it != chunk_end; ++item_it)
     {
-      if (++element_count > limit)
-	return;
-      print_item(extra_data, output, item_it->first.val(), *it2);
+      for (typename std::vector< TObject >::const_iterator it2(item_it->second.begin());
+          it2 != item_it->second.end(); ++it2)
+      {
+        if (++element_count > limit)
+	  return;
+        print_item(extra_data, output, item_it->first.val(), *it2);
+      }
     }
-    ++item_it;
+    std::cout.flush();
   }
 }
 
@@ -357,7 +517,7 @@ void quadtile_
 template< class Index, class Object >
 void tags_quadtile_
     (Extra_Data& extra_data, const std::map< Index, std::vector< Object > >& items,
-     Output_Handler& output,
+     uint32 FLUSH_SIZE, Output_Handler& output,
      Resource_Manager& rman, Transaction& transaction, uint32 limit, uint32& element_count)
 {
   Tag_Store< Index, Object > tag_store(*rman.get_transaction());
@@ -372,15 +532,39 @@ void tags_quadtile_
   // print the result
   while (item_it != items.end())
   {
-    for (typename std::vector< Object >::const_iterator it2(item_it->second.begin());
-        it2 != item_it->second.end(); ++it2)
+    typename std::map< Index, std::vector< Object > >::const_iterator
+        chunk_end = extra_data.prepare_chunk(items, item_it, FLUSH_SIZE);
+
+    // The metadata is copied because the collector only keeps that of its current index
+    std::vector< OSM_Element_Metadata_Skeleton< typename Object::Id_Type > > metadata;
+    std::vector< bool > has_meta;
+    for (typename std::map< Index, std::vector< Object > >::const_iterator it = item_it; it != chunk_end; ++it)
     {
-      if (++element_count > limit)
-        return;
-      print_item(extra_data, output, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-          meta_printer.get(item_it->first, it2->id));
+      for (typename std::vector< Object >::const_iterator it2(it->second.begin()); it2 != it->second.end(); ++it2)
+      {
+        const OSM_Element_Metadata_Skeleton< typename Object::Id_Type >* meta = meta_printer.get(it->first, it2->id);
+        has_meta.push_back(meta != 0);
+        metadata.push_back(meta ? *meta : OSM_Element_Metadata_Skeleton< typename Object::Id_Type >());
+      }
+    }
+    std::vector< uint32 > user_ids;
+    append_user_ids(metadata.begin(), metadata.end(), user_ids);
+    extra_data.prepare_users(user_ids);
+
+    uint32 pos = 0;
+    for (; item_it != chunk_end; ++item_it)
+    {
+      for (typename std::vector< Object >::const_iterator it2(item_it->second.begin());
+          it2 != item_it->second.end(); ++it2)
+      {
+        if (++element_count > limit)
+          return;
+        print_item(extra_data, output, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
+            has_meta[pos] ? &metadata[pos] : 0);
+        ++pos;
+      }
     }
-    ++item_it;
+    std::cout.flush();
   }
 }
 
@@ -388,7 +572,7 @@ void tags_quadtile_
 template< class Index, class Object >
 void tags_quadtile_attic_
     (Extra_Data& extra_data, const std::map< Index, std::vector< Attic< Object > > >& items,
-     Output_Handler& output,
+     uint32 FLUSH_SIZE, Output_Handler& output,
      Resource_Manager& rman, Transaction& transaction, uint32 limit, uint32& element_count)
 {
   Tag_Store< Index, Object > tag_store(transaction);
@@ -400,15 +584,41 @@ void tags_quadtile_attic_
       item_it(items.begin());
   while (item_it != items.end())
   {
-    for (typename std::vector< Attic< Object > >::const_iterator it2(item_it->second.begin());
-        it2 != item_it->second.end(); ++it2)
+    typename std::map< Index, std::vector< Attic< Object > > >::const_iterator
+        chunk_end = extra_data.prepare_chunk(items, item_it, FLUSH_SIZE);
+
+    std::vector< OSM_Element_Metadata_Skeleton< typename Object::Id_Type > > metadata;
+    std::vector< bool > has_meta;
+    for (typename std::map< Index, std::vector< Attic< Object > > >::const_iterator it = item_it;
+        it != chunk_end; ++it)
     {
-      if (++element_count > limit)
-        return;
-      print_item(extra_data, output, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
-                 meta_printer.get(item_it->first, it2->id, it2->timestamp));
+      for (typename std::vector< Attic< Object > >::const_iterator it2(it->second.begin());
+          it2 != it->second.end(); ++it2)
+      {
+        const OSM_Element_Metadata_Skeleton< typename Object::Id_Type >* meta
+            = meta_printer.get(it->first, it2->id, it2->timestamp);
+        has_meta.push_back(meta != 0);
+        metadata.push_back(meta ? *meta : OSM_Element_Metadata_Skeleton< typename Object::Id_Type >());
+      }
     }
-    ++item_it;
+    std::vector< uint32 > user_ids;
+    append_user_ids(metadata.begin(), metadata.end(), user_ids);
+    extra_data.prepare_users(user_ids);
+
+    uint32 pos = 0;
+    for (; item_it != chunk_end; ++item_it)
+    {
+      for (typename std::vector< Attic< Object > >::const_iterator it2(item_it->second.begin());
+          it2 != item_it->second.end(); ++it2)
+      {
+        if (++element_count > limit)
+          return;
+        print_item(extra_data, output, item_it->first.val(), *it2, tag_store.get(item_it->first, *it2),
+                   has_meta[pos] ? &metadata[pos] : 0);
+        ++pos;
+      }
+    }
+    std::cout.flush();
   }
 }
 
@@ -423,21 +633,6 @@ struct Skeleton_Comparator_By_Id {
 };
 
 
-template< typename Index, typename Object >
-struct Maybe_Attic_Ref
-{
-public:
-  Maybe_Attic_Ref(Index idx_, const Object* obj_, uint64 timestamp_)
-  : idx(idx_), obj(obj_), timestamp(timestamp_) {}
-
-  Index idx;
-  const Object* obj;
-  uint64 timestamp;
-
-  bool operator<(const Maybe_Attic_Ref& rhs) const { return obj->id < rhs.obj->id; }
-};
-
-
 template< class Index, class Object >
 std::vector< std::pair< const Object*, uint32 > > collect_items_by_id(
     const std::map< Index, std::vector< Object > >& items)
@@ -505,21 +700,28 @@ template< class Index, class Object >
 void by_id
   (const std::map< Index, std::vector< Object > >& items,
    const std::map< Index, std::vector< Attic< Object > > >& attic_items,
-   Output_Handler& output,
+   uint32 FLUSH_SIZE, Output_Handler& output,
    Transaction& transaction, Extra_Data& extra_data, uint32 limit, uint32& element_count)
 {
   std::vector< Maybe_Attic_Ref< Index, Object > > items_by_id = collect_items_by_id(items, attic_items);
 
   // iterate over the result
-  for (uint32 i(0); i < items_by_id.size(); ++i)
+  for (uint32 id_pos = 0, end_pos = 0; id_pos < items_by_id.size(); id_pos = end_pos)
   {
-    if (++element_count > limit)
-      return;
-    if (items_by_id[i].timestamp == NOW)
-      print_item(extra_data, output, items_by_id[i].idx.val(), *items_by_id[i].obj);
-    else
-      print_item(extra_data, output, items_by_id[i].idx.val(),
-		      Attic< Object >(*items_by_id[i].obj, items_by_id[i].timestamp));
+    end_pos = chunk_end_by_id(items_by_id, id_pos, FLUSH_SIZE);
+    extra_data.prepare_chunk(items_by_id, id_pos, end_pos);
+
+    for (uint32 i = id_pos; i < end_pos; ++i)
+    {
+      if (++element_count > limit)
+        return;
+      if (items_by_id[i].timestamp == NOW)
+        print_item(extra_data, output, items_by_id[i].idx.val(), *items_by_id[i].obj);
+      else
+        print_item(extra_data, output, items_by_id[i].idx.val(),
+		        Attic< Object >(*items_by_id[i].obj, items_by_id[i].timestamp));
+    }
+    std::cout.flush();
   }
 }
 
@@ -600,22 +802,24 @@ void tags_by_id
   std::vector< std::pair< const Object*, uint32 > > items_by_id = collect_items_by_id(items);
 
   // iterate over the result
-  for (typename Object::Id_Type id_pos; id_pos < items_by_id.size(); id_pos += FLUSH_SIZE)
+  for (uint32 id_pos = 0, end_pos = 0; id_pos < items_by_id.size(); id_pos = end_pos)
   {
     // Disable health_check: This ensures that a result will be always printed completely
     //rman.health_check(*this);
 
-    typename Object::Id_Type lower_id_bound(items_by_id[id_pos.val()].first->id);
+    end_pos = chunk_end_by_id(items_by_id, id_pos, FLUSH_SIZE);
+    typename Object::Id_Type lower_id_bound(items_by_id[id_pos].first->id);
     typename Object::Id_Type upper_id_bound;
-    if (id_pos + FLUSH_SIZE < items_by_id.size())
-      upper_id_bound = items_by_id[(id_pos + FLUSH_SIZE).val()].first->id;
+    if (end_pos < items_by_id.size())
+      upper_id_bound = items_by_id[end_pos].first->id;
     else
     {
-      upper_id_bound = items_by_id[items_by_id.size()-1].first->id;
+      upper_id_bound = items_by_id[end_pos-1].first->id;
       ++upper_id_bound;
     }
 
     tag_store.prefetch_chunk(items, lower_id_bound, upper_id_bound);
+    extra_data.prepare_chunk< Index >(items_by_id, id_pos, end_pos);
 
     std::set< OSM_Element_Metadata_Skeleton< typename Object::Id_Type > > metadata;
     if (meta_printer)
@@ -623,22 +827,26 @@ void tags_by_id
       // collect metadata if required
       collect_metadata(metadata, items, lower_id_bound, upper_id_bound, *meta_printer);
       meta_printer->reset();
+
+      std::vector< uint32 > user_ids;
+      append_user_ids(metadata.begin(), metadata.end(), user_ids);
+      extra_data.prepare_users(user_ids);
     }
 
     // print the result
-    for (typename Object::Id_Type i(id_pos);
-         (i < id_pos + FLUSH_SIZE) && (i < items_by_id.size()); ++i)
+    for (uint32 i = id_pos; i < end_pos; ++i)
     {
       if (++element_count > limit)
 	return;
       typename std::set< OSM_Element_Metadata_Skeleton< typename Object::Id_Type > >::const_iterator meta_it
           = metadata.lower_bound(OSM_Element_Metadata_Skeleton< typename Object::Id_Type >
-              (items_by_id[i.val()].first->id));
-      print_item(extra_data, output, items_by_id[i.val()].second, *(items_by_id[i.val()].first),
-		 tag_store.get(Index(items_by_id[i.val()].second), *items_by_id[i.val()].first),
-		 (meta_it != metadata.end() && meta_it->ref == items_by_id[i.val()].first->id) ?
+              (items_by_id[i].first->id));
+      print_item(extra_data, output, items_by_id[i].second, *(items_by_id[i].first),
+		 tag_store.get(Index(items_by_id[i].second), *items_by_id[i].first),
+		 (meta_it != metadata.end() && meta_it->ref == items_by_id[i].first->id) ?
 		     &*meta_it : 0);
     }
+    std::cout.flush();
   }
 }
 
@@ -661,23 +869,25 @@ void tags_by_id_attic
       (current_items, transaction,
       (extra_data.mode & Output_Mode::META) ? current_meta_file_properties< Object >() : 0);
 
-  for (typename Object::Id_Type id_pos; id_pos < items_by_id.size(); id_pos += FLUSH_SIZE)
+  for (uint32 id_pos = 0, end_pos = 0; id_pos < items_by_id.size(); id_pos = end_pos)
   {
     // Disable health_check: This ensures that a result will be always printed completely
     //rman.health_check(*this);
 
-    typename Object::Id_Type lower_id_bound(items_by_id[id_pos.val()].obj->id);
+    end_pos = chunk_end_by_id(items_by_id, id_pos, FLUSH_SIZE);
+    typename Object::Id_Type lower_id_bound(items_by_id[id_pos].obj->id);
     typename Object::Id_Type upper_id_bound;
-    if (id_pos + FLUSH_SIZE < items_by_id.size())
-      upper_id_bound = items_by_id[(id_pos + FLUSH_SIZE).val()].obj->id;
+    if (end_pos < items_by_id.size())
+      upper_id_bound = items_by_id[end_pos].obj->id;
     else
     {
-      upper_id_bound = items_by_id[items_by_id.size()-1].obj->id;
+      upper_id_bound = items_by_id[end_pos-1].obj->id;
       ++upper_id_bound;
     }
 
     current_tag_store.prefetch_chunk(current_items, lower_id_bound, upper_id_bound);
     attic_tag_store.prefetch_chunk(attic_items, lower_id_bound, upper_id_bound);
+    extra_data.prepare_chunk(items_by_id, id_pos, end_pos);
 
     // collect metadata if required
     std::set< OSM_Element_Metadata_Skeleton< typename Object::Id_Type > > only_current_metadata;
@@ -689,33 +899,38 @@ void tags_by_id_attic
     std::set< OSM_Element_Metadata_Skeleton< typename Object::Id_Type > > attic_metadata;
     collect_metadata(attic_metadata, attic_items, lower_id_bound, upper_id_bound, meta_printer);
 
+    std::vector< uint32 > user_ids;
+    append_user_ids(only_current_metadata.begin(), only_current_metadata.end(), user_ids);
+    append_user_ids(attic_metadata.begin(), attic_metadata.end(), user_ids);
+    extra_data.prepare_users(user_ids);
+
     // print the result
-    for (typename Object::Id_Type i(id_pos);
-         (i < id_pos + FLUSH_SIZE) && (i < items_by_id.size()); ++i)
+    for (uint32 i = id_pos; i < end_pos; ++i)
     {
       if (++element_count > limit)
 	return;
-      if (items_by_id[i.val()].timestamp == NOW)
+      if (items_by_id[i].timestamp == NOW)
       {
         typename std::set< OSM_Element_Metadata_Skeleton< typename Object::Id_Type > >::const_iterator meta_it
             = only_current_metadata.lower_bound(OSM_Element_Metadata_Skeleton< typename Object::Id_Type >
-                (items_by_id[i.val()].obj->id));
-        print_item(extra_data, output, items_by_id[i.val()].idx.val(), *items_by_id[i.val()].obj,
-		 current_tag_store.get(items_by_id[i.val()].idx, *items_by_id[i.val()].obj),
-		 (meta_it != only_current_metadata.end() && meta_it->ref == items_by_id[i.val()].obj->id) ?
+                (items_by_id[i].obj->id));
+        print_item(extra_data, output, items_by_id[i].idx.val(), *items_by_id[i].obj,
+		 current_tag_store.get(items_by_id[i].idx, *items_by_id[i].obj),
+		 (meta_it != only_current_metadata.end() && meta_it->ref == items_by_id[i].obj->id) ?
 		     &*meta_it : 0);
       }
       else
       {
         typename std::set< OSM_Element_Metadata_Skeleton< typename Object::Id_Type > >::const_iterator meta_it
             = find_matching_metadata(attic_metadata,
-                  items_by_id[i.val()].obj->id, items_by_id[i.val()].timestamp);
-        print_item(extra_data, output, items_by_id[i.val()].idx.val(),
-		   Attic< Object >(*items_by_id[i.val()].obj, items_by_id[i.val()].timestamp),
-		 attic_tag_store.get(items_by_id[i.val()].idx, *items_by_id[i.val()].obj),
+                  items_by_id[i].obj->id, items_by_id[i].timestamp);
+        print_item(extra_data, output, items_by_id[i].idx.val(),
+		   Attic< Object >(*items_by_id[i].obj, items_by_id[i].timestamp),
+		 attic_tag_store.get(items_by_id[i].idx, *items_by_id[i].obj),
                  meta_it != attic_metadata.end() ? &*meta_it : 0);
       }
     }
+    std::cout.flush();
   }
 }
 
@@ -814,7 +1029,7 @@ void Print_Statement::execute(Resource_Manager& rman)
   else if (action == Diff_Action::show_new)
     feature_action = Output_Handler::show_to;
 
-  Extra_Data extra_data(rman, *this, *output_items, mode, feature_action, south, north, west, east);
+  Extra_Data extra_data(rman, *this, mode, feature_action, south, north, west, east);
   Output_Handler& output_handler = *rman.get_global_settings().get_output_handler();
   uint32 element_count = 0;
 
@@ -843,11 +1058,11 @@ void Print_Statement::execute(Resource_Manager& rman)
     }
     else
     {
-      by_id(output_items->nodes, output_items->attic_nodes,
+      by_id(output_items->nodes, output_items->attic_nodes, NODE_FLUSH_SIZE,
             output_handler, *rman.get_transaction(), extra_data, limit, element_count);
-      by_id(output_items->ways, output_items->attic_ways,
+      by_id(output_items->ways, output_items->attic_ways, WAY_FLUSH_SIZE,
             output_handler, *rman.get_transaction(), extra_data, limit, element_count);
-      by_id(output_items->relations, output_items->attic_relations,
+      by_id(output_items->relations, output_items->attic_relations, RELATION_FLUSH_SIZE,
             output_handler, *rman.get_transaction(), extra_data, limit, element_count);
       if (rman.get_area_transaction())
         by_id(output_items->areas, output_handler, *rman.get_area_transaction(), extra_data, limit, element_count);
@@ -858,49 +1073,57 @@ void Print_Statement::execute(Resource_Manager& rman)
   {
     if (mode & Output_Mode::TAGS)
     {
-      tags_quadtile_(extra_data, output_items->nodes,
+      tags_quadtile_(extra_data, output_items->nodes, NODE_FLUSH_SIZE,
 		    output_handler, rman, *rman.get_transaction(), limit, element_count);
 
       if (rman.get_desired_timestamp() != NOW)
-        tags_quadtile_attic_(extra_data, output_items->attic_nodes,
+        tags_quadtile_attic_(extra_data, output_items->attic_nodes, NODE_FLUSH_SIZE,
                       output_handler, rman, *rman.get_transaction(), limit, element_count);
 
-      tags_quadtile_(extra_data, output_items->ways,
+      tags_quadtile_(extra_data, output_items->ways, WAY_FLUSH_SIZE,
 		    output_handler, rman, *rman.get_transaction(), limit, element_count);
 
       if (rman.get_desired_timestamp() != NOW)
-        tags_quadtile_attic_(extra_data, output_items->attic_ways,
+        tags_quadtile_attic_(extra_data, output_items->attic_ways, WAY_FLUSH_SIZE,
                       output_handler, rman, *rman.get_transaction(), limit, element_count);
 
-      tags_quadtile_(extra_data, output_items->relations,
+      tags_quadtile_(extra_data, output_items->relations, RELATION_FLUSH_SIZE,
 		    output_handler, rman, *rman.get_transaction(), limit, element_count);
 
       if (rman.get_desired_timestamp() != NOW)
-        tags_quadtile_attic_(extra_data, output_items->attic_relations,
+        tags_quadtile_attic_(extra_data, output_items->attic_relations, RELATION_FLUSH_SIZE,
                       output_handler, rman, *rman.get_transaction(), limit, element_count);
 
       if (rman.get_area_transaction())
-        tags_quadtile_(extra_data, output_items->areas,
+        tags_quadtile_(extra_data, output_items->areas, AREA_FLUSH_SIZE,
 		      output_handler, rman, *rman.get_area_transaction(), limit, element_count);
 
-      tags_quadtile_(extra_data, output_items->deriveds,
+      tags_quadtile_(extra_data, output_items->deriveds, std::numeric_limits< uint32 >::max(),
                     output_handler, rman, *rman.get_transaction(), limit, element_count);
     }
     else
     {
-      quadtile_(output_items->nodes, output_handler, *rman.get_transaction(), extra_data, limit, element_count);
-      quadtile_(output_items->attic_nodes, output_handler, *rman.get_transaction(), extra_data, limit, element_count);
+      quadtile_(output_items->nodes, output_handler, *rman.get_transaction(), extra_data,
+          NODE_FLUSH_SIZE, limit, element_count);
+      quadtile_(output_items->attic_nodes, output_handler, *rman.get_transaction(), extra_data,
+          NODE_FLUSH_SIZE, limit, element_count);
 
-      quadtile_(output_items->ways, output_handler, *rman.get_transaction(), extra_data, limit, element_count);
-      quadtile_(output_items->attic_ways, output_handler, *rman.get_transaction(), extra_data, limit, element_count);
+      quadtile_(output_items->ways, output_handler, *rman.get_transaction(), extra_data,
+          WAY_FLUSH_SIZE, limit, element_count);
+      quadtile_(output_items->attic_ways, output_handler, *rman.get_transaction(), extra_data,
+          WAY_FLUSH_SIZE, limit, element_count);
 
-      quadtile_(output_items->relations, output_handler, *rman.get_transaction(), extra_data, limit, element_count);
-      quadtile_(output_items->attic_relations, output_handler, *rman.get_transaction(), extra_data, limit, element_count);
+      quadtile_(output_items->relations, output_handler, *rman.get_transaction(), extra_data,
+          RELATION_FLUSH_SIZE, limit, element_count);
+      quadtile_(output_items->attic_relations, output_handler, *rman.get_transaction(), extra_data,
+          RELATION_FLUSH_SIZE, limit, element_count);
 
       if (rman.get_area_transaction())
-        quadtile_(output_items->areas, output_handler, *rman.get_area_transaction(), extra_data, limit, element_count);
+        quadtile_(output_items->areas, output_handler, *rman.get_area_transaction(), extra_data,
+            AREA_FLUSH_SIZE, limit, element_count);
 
-      quadtile_(output_items->deriveds, output_handler, *rman.get_transaction(), extra_data, limit, element_count);
+      quadtile_(output_items->deriveds, output_handler, *rman.get_transaction(), extra_data,
+          std::numeric_limits< uint32 >::max(), limit, element_count);
     }
   }
 
@@ -915,8 +1138,10 @@ void Print_Statement::execute_comparison(Resource_Manager& rman)
   const Diff_Set* input_diff_set = rman.get_diff_set(input);
   if (input_diff_set)
   {
+    std::set< uint32 > user_ids = (mode & Output_Mode::META) ? input_diff_set->user_ids() : std::set< uint32 >();
     print_diff_set(*input_diff_set, mode, rman.get_global_settings().get_output_handler(),
-        rman.users(), relation_member_roles(*rman.get_transaction()), action == Diff_Action::collect_rhs_with_del);
+        rman.users(user_ids.begin(), user_ids.end()), relation_member_roles(*rman.get_transaction()),
+        action == Diff_Action::collect_rhs_with_del);
     return;
   }
 
@@ -946,8 +1171,10 @@ void Print_Statement::execute_comparison(Resource_Manager& rman)
     Diff_Set result = collection_print_target->compare_to_lhs(rman, *this, *input_set,
         south, north, west, east, action == Diff_Action::collect_rhs_with_del);
 
+    std::set< uint32 > user_ids = (mode & Output_Mode::META) ? result.user_ids() : std::set< uint32 >();
     print_diff_set(result, mode, rman.get_global_settings().get_output_handler(),
-        rman.users(), relation_member_roles(*rman.get_transaction()), action == Diff_Action::collect_rhs_with_del);
+        rman.users(user_ids.begin(), user_ids.end()), relation_member_roles(*rman.get_transaction()),
+        action == Diff_Action::collect_rhs_with_del);
   }
 
   rman.health_check(*this);
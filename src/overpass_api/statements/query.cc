@@ -186,14 +186,14 @@ void filter_id_list(
     std::vector< Id_Type >& new_ids, bool& filtered,
     Iterator begin, Iterator end, const Key_Regex& key_regex, const Val_Regex& val_regex)
 {
-  std::vector< Id_Type > old_ids;
-  old_ids.swap(new_ids);
+  Id_Bitmap old_ids(new_ids.begin(), new_ids.end());
+  new_ids.clear();
 
   for (Iterator it = begin; !(it == end); ++it)
   {
     if (key_regex.matches(it.index().key) && it.index().value != void_tag_value()
         && val_regex.matches(it.index().value) &&
-	(!filtered || binary_search(old_ids.begin(), old_ids.end(), it.object())))
+	(!filtered || old_ids.contains(it.object())))
       new_ids.push_back(it.object());
   }
 
@@ -1378,6 +1378,35 @@ std::set< std::pair< Index, Index > > intersect_ranges
 }
 
 
+bool Query_Statement::is_self_contained() const
+{
+  if (type & (QUERY_DERIVED | QUERY_AREA))
+    return false;
+
+  for (std::vector< Statement* >::const_iterator it = substatements.begin(); it != substatements.end(); ++it)
+  {
+    if (!*it || !(*it)->is_self_contained())
+      return false;
+  }
+  return true;
+}
+
+
+// Area queries are excluded because areas may be built while the statement runs
+bool Query_Statement::is_free_of_side_effects() const
+{
+  if (type & QUERY_AREA)
+    return false;
+
+  for (std::vector< Statement* >::const_iterator it = substatements.begin(); it != substatements.end(); ++it)
+  {
+    if (!*it || !(*it)->is_free_of_side_effects())
+      return false;
+  }
+  return true;
+}
+
+
 void Query_Statement::execute(Resource_Manager& rman)
 {
   Cpu_Timer cpu(rman, 1);
@@ -1449,10 +1478,12 @@ void Query_Statement::execute(Resource_Manager& rman)
     set_progress(2);
     rman.health_check(*this);
 
+    // Excluded ids from negated tag filters cannot be combined with the positive id lists
+    // of a constraint. The constraint then delivers its data by ranges instead.
     if (type & QUERY_NODE)
     {
       for (std::vector< Query_Constraint* >::iterator it = constraints.begin();
-          it != constraints.end() && node_answer_state < data_collected; ++it)
+          it != constraints.end() && node_answer_state < data_collected && !invert_ids; ++it)
       {
 	std::vector< Node::Id_Type > constraint_node_ids;
 	if ((*it)->get_node_ids(rman, constraint_node_ids))
@@ -1476,7 +1507,7 @@ void Query_Statement::execute(Resource_Manager& rman)
     if (type & QUERY_WAY)
     {
       for (std::vector< Query_Constraint* >::iterator it = constraints.begin();
-          it != constraints.end() && way_answer_state < data_collected; ++it)
+          it != constraints.end() && way_answer_state < data_collected && !invert_ids; ++it)
       {
 	std::vector< Way::Id_Type > constraint_way_ids;
 	if ((*it)->get_way_ids(rman, constraint_way_ids))
@@ -1500,7 +1531,7 @@ void Query_Statement::execute(Resource_Manager& rman)
     if (type & QUERY_RELATION)
     {
       for (std::vector< Query_Constraint* >::iterator it = constraints.begin();
-          it != constraints.end() && relation_answer_state < data_collected; ++it)
+          it != constraints.end() && relation_answer_state < data_collected && !invert_ids; ++it)
       {
 	std::vector< Relation::Id_Type > constraint_relation_ids;
 	if ((*it)->get_relation_ids(rman, constraint_relation_ids))
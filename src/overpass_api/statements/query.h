@@ -80,6 +80,8 @@ class Query_Statement : public Output_Statement
     virtual void add_statement(Statement* statement, std::string text);
     virtual std::string get_name() const { return "query"; }
     virtual void execute(Resource_Manager& rman);
+    virtual bool is_self_contained() const;
+    virtual bool is_free_of_side_effects() const;
 
     static Generic_Statement_Maker< Query_Statement > statement_maker;
 
@@ -234,6 +236,8 @@ class Has_Kv_Statement : public Statement
     Has_Kv_Statement(int line_number_, const std::map< std::string, std::string >& input_attributes,
                      Parsed_Query& global_settings);
     virtual std::string get_name() const { return "has-kv"; }
+    virtual bool is_self_contained() const { return true; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual std::string get_result_name() const { return ""; }
     virtual void execute(Resource_Manager& rman) {}
     virtual ~Has_Kv_Statement();
@@ -182,8 +182,8 @@ void collect_relations
   std::set< Uint31_Index > req = extract_parent_indices(sources);
   rman.health_check(stmt);
 
-  collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req,
-			 Get_Parent_Rels_Predicate(ids, source_type), result);
+  collect_parents(stmt, rman, member_relations_keys(ids, source_type), *osm_base_settings().MEMBER_RELATIONS,
+      &req, Get_Parent_Rels_Predicate(ids, source_type), result);
 }
 
 
@@ -198,8 +198,8 @@ void collect_relations
   std::set< Uint31_Index > req = extract_parent_indices(sources);
   rman.health_check(stmt);
 
-  collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req,
-                         Get_Parent_Rels_Role_Predicate(ids, source_type, role_id), result);
+  collect_parents(stmt, rman, member_relations_keys(ids, source_type), *osm_base_settings().MEMBER_RELATIONS,
+      &req, Get_Parent_Rels_Role_Predicate(ids, source_type, role_id), result);
 }
 
 
@@ -216,13 +216,15 @@ void collect_relations
   rman.health_check(stmt);
 
   if (!invert_ids)
-    collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req,
+    collect_parents(stmt, rman, member_relations_keys(children_ids, source_type),
+        *osm_base_settings().MEMBER_RELATIONS, &req,
         And_Predicate< Relation_Skeleton,
 	    Id_Predicate< Relation_Skeleton >, Get_Parent_Rels_Predicate >
 	    (Id_Predicate< Relation_Skeleton >(ids),
             Get_Parent_Rels_Predicate(children_ids, source_type)), result);
   else
-    collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req,
+    collect_parents(stmt, rman, member_relations_keys(children_ids, source_type),
+        *osm_base_settings().MEMBER_RELATIONS, &req,
         And_Predicate< Relation_Skeleton,
 	    Not_Predicate< Relation_Skeleton, Id_Predicate< Relation_Skeleton > >,
 	    Get_Parent_Rels_Predicate >
@@ -245,13 +247,15 @@ void collect_relations
   rman.health_check(stmt);
 
   if (!invert_ids)
-    collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req,
+    collect_parents(stmt, rman, member_relations_keys(children_ids, source_type),
+        *osm_base_settings().MEMBER_RELATIONS, &req,
         And_Predicate< Relation_Skeleton,
             Id_Predicate< Relation_Skeleton >, Get_Parent_Rels_Role_Predicate >
             (Id_Predicate< Relation_Skeleton >(ids),
             Get_Parent_Rels_Role_Predicate(children_ids, source_type, role_id)), result);
   else
-    collect_items_discrete(&stmt, rman, *osm_base_settings().RELATIONS, req,
+    collect_parents(stmt, rman, member_relations_keys(children_ids, source_type),
+        *osm_base_settings().MEMBER_RELATIONS, &req,
         And_Predicate< Relation_Skeleton,
             Not_Predicate< Relation_Skeleton, Id_Predicate< Relation_Skeleton > >,
             Get_Parent_Rels_Role_Predicate >
@@ -424,8 +428,8 @@ void collect_relations
   std::vector< Uint64 > ids = extract_children_ids< Uint31_Index, Relation_Skeleton, Uint64 >(sources);
   rman.health_check(stmt);
 
-  collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
-      Get_Parent_Rels_Predicate(ids, Relation_Entry::RELATION), result);
+  collect_parents(stmt, rman, member_relations_keys(ids, Relation_Entry::RELATION),
+      *osm_base_settings().MEMBER_RELATIONS, 0, Get_Parent_Rels_Predicate(ids, Relation_Entry::RELATION), result);
 }
 
 
@@ -437,7 +441,8 @@ void collect_relations
   std::vector< Uint64 > ids = extract_children_ids< Uint31_Index, Relation_Skeleton, Uint64 >(sources);
   rman.health_check(stmt);
 
-  collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+  collect_parents(stmt, rman, member_relations_keys(ids, Relation_Entry::RELATION),
+      *osm_base_settings().MEMBER_RELATIONS, 0,
       Get_Parent_Rels_Role_Predicate(ids, Relation_Entry::RELATION, role_id), result);
 }
 
@@ -452,14 +457,16 @@ void collect_relations
   rman.health_check(stmt);
 
   if (!invert_ids)
-    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+    collect_parents(stmt, rman, member_relations_keys(children_ids, Relation_Entry::RELATION),
+        *osm_base_settings().MEMBER_RELATIONS, 0,
         And_Predicate< Relation_Skeleton,
 	    Id_Predicate< Relation_Skeleton >, Get_Parent_Rels_Predicate >
 	    (Id_Predicate< Relation_Skeleton >(ids),
             Get_Parent_Rels_Predicate(children_ids, Relation_Entry::RELATION)),
         result);
   else
-    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+    collect_parents(stmt, rman, member_relations_keys(children_ids, Relation_Entry::RELATION),
+        *osm_base_settings().MEMBER_RELATIONS, 0,
         And_Predicate< Relation_Skeleton,
 	    Not_Predicate< Relation_Skeleton, Id_Predicate< Relation_Skeleton > >,
 	    Get_Parent_Rels_Predicate >
@@ -480,14 +487,16 @@ void collect_relations
   rman.health_check(stmt);
 
   if (!invert_ids)
-    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+    collect_parents(stmt, rman, member_relations_keys(children_ids, Relation_Entry::RELATION),
+        *osm_base_settings().MEMBER_RELATIONS, 0,
         And_Predicate< Relation_Skeleton,
             Id_Predicate< Relation_Skeleton >, Get_Parent_Rels_Role_Predicate >
             (Id_Predicate< Relation_Skeleton >(ids),
             Get_Parent_Rels_Role_Predicate(children_ids, Relation_Entry::RELATION, role_id)),
         result);
   else
-    collect_items_flat(stmt, rman, *osm_base_settings().RELATIONS,
+    collect_parents(stmt, rman, member_relations_keys(children_ids, Relation_Entry::RELATION),
+        *osm_base_settings().MEMBER_RELATIONS, 0,
         And_Predicate< Relation_Skeleton,
             Not_Predicate< Relation_Skeleton, Id_Predicate< Relation_Skeleton > >,
             Get_Parent_Rels_Role_Predicate >
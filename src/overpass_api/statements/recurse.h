@@ -35,6 +35,7 @@ class Recurse_Statement : public Output_Statement
     Recurse_Statement(int line_number_, const std::map< std::string, std::string >& input_attributes,
                       Parsed_Query& global_settings);
     virtual std::string get_name() const { return "recurse"; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual void execute(Resource_Manager& rman);
     virtual ~Recurse_Statement();
 
@@ -171,6 +171,14 @@ class Statement
     // object.
     virtual Query_Constraint* get_query_constraint() { return 0; }
 
+    // True if the statement neither reads nor writes any set except its own result
+    // and has no side effects beyond that. Such statements can run in a worker process.
+    virtual bool is_self_contained() const { return false; }
+
+    // True if the statement and all its substatements only set their result sets.
+    // Unlike self contained statements, they may read other sets.
+    virtual bool is_free_of_side_effects() const { return false; }
+
     virtual ~Statement() {}
 
     int get_progress() const { return progress; }
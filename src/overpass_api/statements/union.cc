@@ -24,9 +24,11 @@
 #include <string>
 #include <vector>
 
+#include "../core/settings.h"
 #include "../data/abstract_processing.h"
 #include "../data/utils.h"
 #include "union.h"
+#include "worker_processes.h"
 
 
 Generic_Statement_Maker< Union_Statement > Union_Statement::statement_maker("union");
@@ -63,15 +65,58 @@ void Union_Statement::add_statement(Statement* statement, std::string text)
 }
 
 
+// Self contained substatements can run in worker processes if there are at least two of them.
+// Area queries are excluded because the area updater must see their usage,
+// as are attic and diff queries that produce results the workers do not transfer.
+std::vector< Statement* > parallel_candidates(const std::vector< Statement* >& substatements, Resource_Manager& rman)
+{
+  std::vector< Statement* > result;
+  if (osm_base_settings().max_workers_per_query < 2 || rman.area_updater()
+      || rman.get_desired_timestamp() != NOW || rman.get_desired_action() != Diff_Action::positive)
+    return result;
+
+  for (std::vector< Statement* >::const_iterator it = substatements.begin(); it != substatements.end(); ++it)
+  {
+    if ((*it)->is_self_contained())
+      result.push_back(*it);
+  }
+  if (result.size() < 2)
+    result.clear();
+  return result;
+}
+
+
+bool Union_Statement::is_free_of_side_effects() const
+{
+  for (std::vector< Statement* >::const_iterator it = substatements.begin(); it != substatements.end(); ++it)
+  {
+    if (!*it || !(*it)->is_free_of_side_effects())
+      return false;
+  }
+  return true;
+}
+
+
 void Union_Statement::execute(Resource_Manager& rman)
 {
   rman.push_stack_frame();
   rman.move_outward(get_result_name(), get_result_name());
 
+  std::vector< Statement* > candidates = parallel_candidates(substatements, rman);
+  std::vector< Set > results;
+  std::vector< bool > delivered =
+      execute_in_workers(candidates, osm_base_settings().max_workers_per_query, rman, *this, results);
+
+  std::vector< Statement* >::const_iterator cand_it = candidates.begin();
   for (std::vector< Statement* >::iterator it(substatements.begin());
        it != substatements.end(); ++it)
   {
-    (*it)->execute(rman);
+    if (cand_it != candidates.end() && *cand_it == *it && delivered[cand_it - candidates.begin()])
+      rman.swap_set((*it)->get_result_name(), results[cand_it - candidates.begin()]);
+    else
+      (*it)->execute(rman);
+    if (cand_it != candidates.end() && *cand_it == *it)
+      ++cand_it;
     rman.union_inward((*it)->get_result_name(), get_result_name());
   }
 
@@ -33,6 +33,7 @@ class Union_Statement : public Output_Statement
                     Parsed_Query& global_settings);
     virtual void add_statement(Statement* statement, std::string text);
     virtual std::string get_name() const { return "union"; }
+    virtual bool is_free_of_side_effects() const;
     virtual void execute(Resource_Manager& rman);
     virtual ~Union_Statement() {}
 
@@ -35,17 +35,24 @@
 class User_Constraint : public Query_Constraint
 {
   public:
-    User_Constraint(User_Statement& user_) : user(&user_) {}
+    User_Constraint(User_Statement& user_)
+        : user(&user_), node_ids_delivered(false), way_ids_delivered(false), relation_ids_delivered(false) {}
 
     bool delivers_data(Resource_Manager& rman) { return false; }
 
     bool get_ranges(Resource_Manager& rman, std::set< std::pair< Uint31_Index, Uint31_Index > >& ranges);
     bool get_ranges(Resource_Manager& rman, std::set< std::pair< Uint32_Index, Uint32_Index > >& ranges);
+    bool get_node_ids(Resource_Manager& rman, std::vector< Node_Skeleton::Id_Type >& ids);
+    bool get_way_ids(Resource_Manager& rman, std::vector< Way_Skeleton::Id_Type >& ids);
+    bool get_relation_ids(Resource_Manager& rman, std::vector< Relation_Skeleton::Id_Type >& ids);
     void filter(const Statement& query, Resource_Manager& rman, Set& into);
     virtual ~User_Constraint() {}
 
   private:
     User_Statement* user;
+    bool node_ids_delivered;
+    bool way_ids_delivered;
+    bool relation_ids_delivered;
 };
 
 
@@ -110,10 +117,125 @@ void user_filter_map_attic
 }
 
 
+bool file_present(Transaction& transaction, const File_Properties& file_prop)
+{
+  return file_exists(transaction.get_db_dir() + file_prop.get_file_name_trunk() + file_prop.get_data_suffix());
+}
+
+
+// Users with more elements are found through their quadtiles instead,
+// because their element list would cost more memory than it saves reading.
+const uint32 MAX_USER_ELEMENT_IDS = 1024*1024;
+
+
+// Returns false if the database does not keep the elements per user
+// or if the users have more than MAX_USER_ELEMENT_IDS elements
+template< typename Id_Type >
+bool get_user_element_ids(const std::set< Uint32_Index >& user_ids, Transaction& transaction,
+    const File_Properties& file_prop, std::vector< Id_Type >& ids)
+{
+  if (!file_present(transaction, file_prop))
+    return false;
+
+  std::vector< Id_Type > user_element_ids;
+  Block_Backend< Uint32_Index, Id_Type > user_db(transaction.data_index(&file_prop));
+  for (typename Block_Backend< Uint32_Index, Id_Type >::Discrete_Iterator
+      it = user_db.discrete_begin(user_ids.begin(), user_ids.end()); !(it == user_db.discrete_end()); ++it)
+  {
+    if (user_element_ids.size() >= MAX_USER_ELEMENT_IDS)
+      return false;
+    user_element_ids.push_back(it.object());
+  }
+
+  std::sort(user_element_ids.begin(), user_element_ids.end());
+  user_element_ids.erase(std::unique(user_element_ids.begin(), user_element_ids.end()), user_element_ids.end());
+  ids.swap(user_element_ids);
+  return true;
+}
+
+
+// Removes the elements not in ids and the indexes that get empty, so that their meta data is never read
+template< typename TIndex, typename TObject >
+void user_filter_ids
+    (std::map< TIndex, std::vector< TObject > >& modify, const std::vector< typename TObject::Id_Type >& ids)
+{
+  for (typename std::map< TIndex, std::vector< TObject > >::iterator it = modify.begin(); it != modify.end(); )
+  {
+    std::vector< TObject > local_into;
+    for (typename std::vector< TObject >::const_iterator iit = it->second.begin();
+        iit != it->second.end(); ++iit)
+    {
+      if (std::binary_search(ids.begin(), ids.end(), iit->id))
+        local_into.push_back(*iit);
+    }
+    if (local_into.empty())
+      modify.erase(it++);
+    else
+    {
+      it->second.swap(local_into);
+      ++it;
+    }
+  }
+}
+
+
+template< typename TIndex, typename Skeleton >
+void user_filter_ids
+    (std::map< TIndex, std::vector< Skeleton > >& current,
+     std::map< TIndex, std::vector< Attic< Skeleton > > >& attic,
+     Resource_Manager& rman, const std::set< Uint32_Index >& user_ids, const File_Properties& file_prop,
+     bool ids_delivered)
+{
+  if (ids_delivered || (current.empty() && attic.empty()))
+    return;
+
+  std::vector< typename Skeleton::Id_Type > ids;
+  if (!get_user_element_ids(user_ids, *rman.get_transaction(), file_prop, ids))
+    return;
+
+  user_filter_ids(current, ids);
+  user_filter_ids(attic, ids);
+}
+
+
+// The elements per user are a superset of the elements to find.
+// Hence they narrow the lookup by id, and filter still checks the meta data.
+bool User_Constraint::get_node_ids(Resource_Manager& rman, std::vector< Node_Skeleton::Id_Type >& ids)
+{
+  node_ids_delivered = get_user_element_ids(
+      user->get_ids(*rman.get_transaction()), *rman.get_transaction(), *meta_settings().USER_NODES, ids);
+  return node_ids_delivered;
+}
+
+
+bool User_Constraint::get_way_ids(Resource_Manager& rman, std::vector< Way_Skeleton::Id_Type >& ids)
+{
+  way_ids_delivered = get_user_element_ids(
+      user->get_ids(*rman.get_transaction()), *rman.get_transaction(), *meta_settings().USER_WAYS, ids);
+  return way_ids_delivered;
+}
+
+
+bool User_Constraint::get_relation_ids(Resource_Manager& rman, std::vector< Relation_Skeleton::Id_Type >& ids)
+{
+  relation_ids_delivered = get_user_element_ids(
+      user->get_ids(*rman.get_transaction()), *rman.get_transaction(), *meta_settings().USER_RELATIONS, ids);
+  return relation_ids_delivered;
+}
+
+
 void User_Constraint::filter(const Statement& query, Resource_Manager& rman, Set& into)
 {
   std::set< Uint32_Index > user_ids = user->get_ids(*rman.get_transaction());
 
+  // Only needed if another constraint has delivered the elements
+  user_filter_ids(into.nodes, into.attic_nodes, rman, user_ids, *meta_settings().USER_NODES,
+      node_ids_delivered);
+  user_filter_ids(into.ways, into.attic_ways, rman, user_ids, *meta_settings().USER_WAYS,
+      way_ids_delivered);
+  user_filter_ids(into.relations, into.attic_relations, rman, user_ids, *meta_settings().USER_RELATIONS,
+      relation_ids_delivered);
+
   user_filter_map(into.nodes, rman, user_ids, meta_settings().NODES_META);
   user_filter_map(into.ways, rman, user_ids, meta_settings().WAYS_META);
   user_filter_map(into.relations, rman, user_ids, meta_settings().RELATIONS_META);
@@ -131,6 +253,9 @@ void User_Constraint::filter(const Statement& query, Resource_Manager& rman, Set
 			  meta_settings().RELATIONS_META, attic_settings().RELATIONS_META);
 
   into.areas.clear();
+  node_ids_delivered = false;
+  way_ids_delivered = false;
+  relation_ids_delivered = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -257,6 +382,23 @@ std::set< Uint32_Index > get_user_ids(const std::set< std::string >& user_names,
 {
   std::set< Uint32_Index > ids;
 
+  if (file_present(transaction, *meta_settings().USER_NAMES))
+  {
+    std::set< Uint32_Index > req;
+    for (std::set< std::string >::const_iterator it = user_names.begin(); it != user_names.end(); ++it)
+      req.insert(Uint32_Index(user_name_hash(*it)));
+
+    Block_Backend< Uint32_Index, User_Data > names_db
+        (transaction.data_index(meta_settings().USER_NAMES));
+    for (Block_Backend< Uint32_Index, User_Data >::Discrete_Iterator
+        names_it = names_db.discrete_begin(req.begin(), req.end()); !(names_it == names_db.discrete_end()); ++names_it)
+    {
+      if (user_names.find(names_it.object().name) != user_names.end())
+        ids.insert(names_it.object().id);
+    }
+    return ids;
+  }
+
   Block_Backend< Uint32_Index, User_Data > user_db
       (transaction.data_index(meta_settings().USER_DATA));
   for (Block_Backend< Uint32_Index, User_Data >::Flat_Iterator
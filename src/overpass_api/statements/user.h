@@ -35,6 +35,8 @@ class User_Statement : public Output_Statement
     User_Statement(int line_number_, const std::map< std::string, std::string >& input_attributes,
                    Parsed_Query& global_settings);
     virtual std::string get_name() const { return "user"; }
+    virtual bool is_self_contained() const { return true; }
+    virtual bool is_free_of_side_effects() const { return true; }
     virtual void execute(Resource_Manager& rman);
     virtual ~User_Statement();
 
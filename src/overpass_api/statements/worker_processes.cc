@@ -0,0 +1,116 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../data/worker_pool.h"
+#include "worker_processes.h"
+
+#include <string>
+#include <vector>
+
+
+namespace
+{
+  // Only records that a message would have been displayed.
+  struct Worker_Error_Output : public Error_Output
+  {
+    Worker_Error_Output() : messages_present(false) {}
+
+    virtual void add_encoding_error(const std::string& error) { messages_present = true; }
+    virtual void add_parse_error(const std::string& error, int line_number) { messages_present = true; }
+    virtual void add_static_error(const std::string& error, int line_number) { messages_present = true; }
+
+    virtual void add_encoding_remark(const std::string& error) { messages_present = true; }
+    virtual void add_parse_remark(const std::string& error, int line_number) { messages_present = true; }
+    virtual void add_static_remark(const std::string& error, int line_number) { messages_present = true; }
+
+    virtual void runtime_error(const std::string& error) { messages_present = true; }
+    virtual void runtime_remark(const std::string& error) { messages_present = true; }
+
+    virtual void display_statement_progress
+        (uint timer, const std::string& name, int progress, int line_number,
+         const std::vector< std::pair< uint, uint > >& stack) {}
+
+    virtual bool display_encoding_errors() { return false; }
+    virtual bool display_parse_errors() { return false; }
+    virtual bool display_static_errors() { return false; }
+
+    bool messages_present;
+  };
+
+
+  class Statement_Task : public Worker_Task
+  {
+    public:
+      Statement_Task(Statement& stmt_) : stmt(&stmt_) {}
+
+      virtual bool run(Resource_Manager& rman, std::string& result)
+      {
+        Worker_Error_Output error_output;
+        Statement::set_error_output(&error_output);
+        stmt->execute(rman);
+
+        Set empty;
+        const Set* into = rman.get_set(stmt->get_result_name());
+        if (!into)
+          into = &empty;
+        if (error_output.messages_present
+            || !into->attic_nodes.empty() || !into->attic_ways.empty() || !into->attic_relations.empty()
+            || !into->areas.empty() || !into->deriveds.empty())
+          return false;
+
+        append_map(into->nodes, result);
+        append_map(into->ways, result);
+        append_map(into->relations, result);
+        return true;
+      }
+
+    private:
+      Statement* stmt;
+  };
+}
+
+
+std::vector< bool > execute_in_workers(const std::vector< Statement* >& statements, uint max_workers,
+    Resource_Manager& rman, const Statement& caller, std::vector< Set >& results)
+{
+  std::vector< Statement_Task > tasks;
+  for (std::vector< Statement* >::const_iterator it = statements.begin(); it != statements.end(); ++it)
+    tasks.push_back(Statement_Task(**it));
+  std::vector< Worker_Task* > task_ptrs;
+  for (std::vector< Statement_Task >::iterator it = tasks.begin(); it != tasks.end(); ++it)
+    task_ptrs.push_back(&*it);
+
+  std::vector< std::string > buffers;
+  std::vector< bool > delivered = run_in_workers(task_ptrs, max_workers, rman, caller, buffers);
+
+  results.clear();
+  results.resize(statements.size());
+  for (uint i = 0; i < delivered.size(); ++i)
+  {
+    if (!delivered[i])
+      continue;
+
+    std::string::size_type pos = 0;
+    delivered[i] = read_map(buffers[i], pos, results[i].nodes) && read_map(buffers[i], pos, results[i].ways)
+        && read_map(buffers[i], pos, results[i].relations) && pos == buffers[i].size();
+    if (!delivered[i])
+      results[i].clear();
+  }
+
+  return delivered;
+}
@@ -0,0 +1,39 @@
+/** Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+ *
+ * This file is part of Overpass_API.
+ *
+ * Overpass_API is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * Overpass_API is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Overpass_API.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE__OSM3S___OVERPASS_API__STATEMENTS__WORKER_PROCESSES_H
+#define DE__OSM3S___OVERPASS_API__STATEMENTS__WORKER_PROCESSES_H
+
+#include <string>
+#include <vector>
+
+#include "statement.h"
+
+
+/* Executes self contained statements in worker processes, see worker_pool.h.
+
+Each worker executes one statement and sends back the set the statement has written to its result name.
+The function returns for every statement whether the worker has delivered a result into results.
+Statements that have failed in the worker for any reason, including runtime errors and remarks,
+are left to the caller to execute them sequentially such that their messages get displayed.
+*/
+std::vector< bool > execute_in_workers(const std::vector< Statement* >& statements, uint max_workers,
+    Resource_Manager& rman, const Statement& caller, std::vector< Set >& results);
+
+
+#endif
@@ -30,6 +30,7 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
@@ -136,7 +137,7 @@ int Global_Resource_Planner::probe(pid_t pid, uint32 client_token, uint32 time_u
     for (std::vector< Reader_Entry >::const_iterator it = active.begin(); it != active.end(); ++it)
     {
       if (it->client_token == client_token)
-	++token_count;
+	token_count += 1 + it->workers;
     }
     if (token_count >= rate_limit)
     {
@@ -210,6 +211,37 @@ int Global_Resource_Planner::probe(pid_t pid, uint32 client_token, uint32 time_u
 }
 
 
+uint32 Global_Resource_Planner::grant_workers(pid_t pid, uint32 num_workers)
+{
+  std::vector< Reader_Entry >::iterator entry = active.begin();
+  while (entry != active.end() && entry->client_pid != pid)
+    ++entry;
+  if (entry == active.end())
+    return 0;
+
+  global_used_workers -= entry->workers;
+  entry->workers = 0;
+
+  uint32 used_processes = active.size() + global_used_workers;
+  uint32 granted = (used_processes < global_available_processes ? global_available_processes - used_processes : 0);
+
+  if (rate_limit > 0 && entry->client_token > 0)
+  {
+    uint32 token_count = 0;
+    for (std::vector< Reader_Entry >::const_iterator it = active.begin(); it != active.end(); ++it)
+    {
+      if (it->client_token == entry->client_token)
+        token_count += 1 + it->workers;
+    }
+    granted = (token_count < rate_limit ? std::min(granted, rate_limit - token_count) : 0);
+  }
+
+  entry->workers = std::min(num_workers, granted);
+  global_used_workers += entry->workers;
+  return entry->workers;
+}
+
+
 void Global_Resource_Planner::remove_entry(std::vector< Reader_Entry >::iterator& it)
 {
   uint32 end_time = time(0);
@@ -254,6 +286,7 @@ void Global_Resource_Planner::remove_entry(std::vector< Reader_Entry >::iterator
   // Adjust global counters
   global_used_space -= it->max_space;
   global_used_time -= it->max_time;
+  global_used_workers -= it->workers;
 
   if (rate_limit > 0 && it->client_token > 0)
   {
@@ -375,7 +408,7 @@ Dispatcher::Dispatcher
       pending_commit(false),
       requests_started_counter(0),
       requests_finished_counter(0),
-      global_resource_planner(total_available_time_units_, total_available_space_, 0)
+      global_resource_planner(total_available_time_units_, total_available_space_, 0, max_num_reading_processes_)
 {
   signal(SIGPIPE, SIG_IGN);
 
@@ -662,6 +695,18 @@ void Dispatcher::standby_loop(uint64 milliseconds)
 
 	connection_per_pid.get(client_pid)->send_result(command);
       }
+      else if (command == REQUEST_WORKERS)
+      {
+	std::vector< uint32 > arguments = connection_per_pid.get(client_pid)->get_arguments(1);
+	if (arguments.size() < 1)
+	{
+	  connection_per_pid.get(client_pid)->send_result(0);
+	  continue;
+	}
+
+	connection_per_pid.get(client_pid)->send_result(
+	    global_resource_planner.grant_workers(client_pid, arguments[0]));
+      }
       else if (command == PURGE)
       {
 	std::vector< uint32 > arguments = connection_per_pid.get(client_pid)->get_arguments(1);
@@ -786,6 +831,7 @@ void Dispatcher::output_status()
         <<"Total available time units: "<<global_resource_planner.get_total_available_time()<<'\n'
         <<"Total claimed time units: "<<global_resource_planner.get_total_claimed_time()<<'\n'
         <<"Average claimed time units: "<<global_resource_planner.get_average_claimed_time()<<'\n'
+        <<"Total granted workers: "<<global_resource_planner.get_total_granted_workers()<<'\n'
         <<"Counter of started requests: "<<requests_started_counter<<'\n'
         <<"Counter of finished requests: "<<requests_finished_counter<<'\n';
 
@@ -51,13 +51,14 @@ struct Reader_Entry
 {
   Reader_Entry(uint32 client_pid_, uint64 max_space_, uint32 max_time_, uint32 client_token_, uint32 start_time_)
     : client_pid(client_pid_), max_space(max_space_), max_time(max_time_), start_time(start_time_),
-      client_token(client_token_) {}
+      client_token(client_token_), workers(0) {}
 
   pid_t client_pid;
   uint64 max_space;
   uint32 max_time;
   uint32 start_time;
   uint32 client_token;
+  uint32 workers;
 };
 
 
@@ -83,9 +84,11 @@ struct Pending_Client
 class Global_Resource_Planner
 {
 public:
-  Global_Resource_Planner(uint32 global_available_time_, uint64 global_available_space_, uint32 rate_limit_)
+  Global_Resource_Planner(uint32 global_available_time_, uint64 global_available_space_, uint32 rate_limit_,
+                          uint32 global_available_processes_)
       : global_used_time(0), global_available_time(global_available_time_),
         global_used_space(0), global_available_space(global_available_space_),
+        global_used_workers(0), global_available_processes(global_available_processes_),
         rate_limit(rate_limit_), recent_average_used_time(15), recent_average_used_space(15),
         last_update_time(0), last_used_time(0), last_used_space(0), last_counted(0),
         average_used_time(0), average_used_space(0) {}
@@ -94,6 +97,12 @@ public:
   // In this case it is registered as running
   int probe(pid_t pid, uint32 client_token, uint32 time_units, uint64 max_space);
 
+  // Returns how many of the requested worker processes the registered process pid may fork.
+  // Workers count like queries against the rate limit of the client token
+  // and against the total number of processes. A new request replaces the previous grant,
+  // hence requesting zero workers releases them.
+  uint32 grant_workers(pid_t pid, uint32 num_workers);
+
   // Unregisters the process
   void remove(pid_t pid);
 
@@ -110,6 +119,7 @@ public:
   uint32 get_total_available_time() const { return global_available_time; }
   uint64 get_total_claimed_space() const { return global_used_space; }
   uint64 get_total_available_space() const { return global_available_space; }
+  uint32 get_total_granted_workers() const { return global_used_workers; }
   uint32 get_rate_limit() const { return rate_limit; }
   uint32 get_average_claimed_time() const { return average_used_time; }
   uint64 get_average_claimed_space() const { return average_used_space; }
@@ -122,6 +132,8 @@ private:
   uint32 global_available_time;
   uint64 global_used_space;
   uint64 global_available_space;
+  uint32 global_used_workers;
+  uint32 global_available_processes;
   uint32 rate_limit;
 
   std::vector< uint32 > recent_average_used_time;
@@ -179,6 +191,7 @@ class Dispatcher
     static const uint32 PING = 18;
     static const uint32 UNREGISTER_PID = 19;
     static const uint32 QUERY_BY_TOKEN = 20;
+    static const uint32 REQUEST_WORKERS = 21;
 
     static const uint32 RATE_LIMITED = 31;
     static const uint32 QUERY_REJECTED = 32;
@@ -257,6 +257,15 @@ void Dispatcher_Client::read_finished()
 }
 
 
+uint32 Dispatcher_Client::request_workers(uint32 num_workers)
+{
+  send_message(Dispatcher::REQUEST_WORKERS, "Dispatcher_Client::request_workers::socket::1");
+  send_message(num_workers, "Dispatcher_Client::request_workers::socket::2");
+
+  return ack_arrived();
+}
+
+
 void Dispatcher_Client::purge(uint32 pid)
 {
 //   *(uint32*)(dispatcher_shm_ptr + 2*sizeof(uint32)) = 0;
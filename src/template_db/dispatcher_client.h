@@ -76,6 +76,10 @@ class Dispatcher_Client
     /** Unregisteres a reading process. */
     void read_finished();
 
+    /** Asks for the permission to fork num_workers worker processes and returns the granted number.
+    The grant replaces any previous grant of this process, hence zero releases all workers. */
+    uint32 request_workers(uint32 num_workers);
+
     /** Other operations: -------------------------------------------------- */
 
     /** Terminate another instance running in the standby_loop. */
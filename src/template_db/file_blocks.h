@@ -29,6 +29,7 @@
 #include <cerrno>
 #include <cstdlib>
 #include <list>
+#include <map>
 
 /** Declarations: -----------------------------------------------------------*/
 
@@ -199,6 +200,14 @@ public:
 
   const File_Blocks_Index< TIndex >& get_index() const { return *index; }
 
+  // Moves blocks such that they are stored in index order from the start of the file.
+  // Stops after max_bytes have been written. Returns the number of written bytes.
+  uint64 compact(uint64 max_bytes, bool& complete);
+
+  // Computes the checksums of all blocks and lets the index store them from now on.
+  // Returns the number of blocks.
+  uint32 add_checksums();
+
 private:
   File_Blocks_Index< TIndex >* index;
   uint32 block_size;
@@ -215,6 +224,10 @@ private:
   Void_Pointer< void > buffer;
 
   uint32 allocate_block(uint32 data_size);
+  void verify_checksum(const File_Block_Index_Entry< TIndex >& entry, const void* data) const;
+  uint32 block_checksum(const void* data, uint32 data_size) const
+  { return index->has_checksums() ? crc32c(data, block_size * data_size) : 0; }
+  void move_block(File_Block_Index_Entry< TIndex >& entry, uint32 pos);
 };
 
 
@@ -567,19 +580,26 @@ template< typename TIndex, typename TIterator, typename TRangeIterator >
 void* File_Blocks< TIndex, TIterator, TRangeIterator >::read_block
     (const File_Blocks_Basic_Iterator< TIndex >& it) const
 {
-  data_file.seek((int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::1");
   if (compression_method == File_Blocks_Index< TIndex >::NO_COMPRESSION)
-    data_file.read((uint8*)buffer.ptr, block_size * it.block_it->size, "File_Blocks::read_block::2");
+  {
+    data_file.read_at((uint8*)buffer.ptr, block_size * it.block_it->size,
+        (int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::2");
+    verify_checksum(*it.block_it, buffer.ptr);
+  }
   else if (compression_method == File_Blocks_Index< TIndex >::ZLIB_COMPRESSION)
   {
     Void_Pointer< void > input(block_size * it.block_it->size);
-    data_file.read((uint8*)input.ptr, block_size * it.block_it->size, "File_Blocks::read_block::2");
+    data_file.read_at((uint8*)input.ptr, block_size * it.block_it->size,
+        (int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::2");
+    verify_checksum(*it.block_it, input.ptr);
     Zlib_Inflate().decompress(input.ptr, block_size * it.block_it->size, buffer.ptr, block_size * compression_factor);
   }
   else if (compression_method == File_Blocks_Index< TIndex >::LZ4_COMPRESSION)
   {
     Void_Pointer< void > input(block_size * it.block_it->size);
-    data_file.read((uint8*)input.ptr, block_size * it.block_it->size, "File_Blocks::read_block::2");
+    data_file.read_at((uint8*)input.ptr, block_size * it.block_it->size,
+        (int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::2");
+    verify_checksum(*it.block_it, input.ptr);
     LZ4_Inflate().decompress(input.ptr, block_size * it.block_it->size, buffer.ptr, block_size * compression_factor);
   }
 
@@ -593,18 +613,24 @@ template< typename TIndex, typename TIterator, typename TRangeIterator >
 void* File_Blocks< TIndex, TIterator, TRangeIterator >::read_block
     (const File_Blocks_Basic_Iterator< TIndex >& it, void* buffer_) const
 {
-  data_file.seek((int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::3");
-
   if (compression_method == File_Blocks_Index< TIndex >::NO_COMPRESSION)
-    data_file.read((uint8*)buffer_, block_size * it.block_it->size, "File_Blocks::read_block::4");
+  {
+    data_file.read_at((uint8*)buffer_, block_size * it.block_it->size,
+        (int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::4");
+    verify_checksum(*it.block_it, buffer_);
+  }
   else if (compression_method == File_Blocks_Index< TIndex >::ZLIB_COMPRESSION)
   {
-    data_file.read((uint8*)buffer.ptr, block_size * it.block_it->size, "File_Blocks::read_block::4");
+    data_file.read_at((uint8*)buffer.ptr, block_size * it.block_it->size,
+        (int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::4");
+    verify_checksum(*it.block_it, buffer.ptr);
     Zlib_Inflate().decompress(buffer.ptr, block_size * it.block_it->size, buffer_, block_size * compression_factor);
   }
   else if (compression_method == File_Blocks_Index< TIndex >::LZ4_COMPRESSION)
   {
-    data_file.read((uint8*)buffer.ptr, block_size * it.block_it->size, "File_Blocks::read_block::4");
+    data_file.read_at((uint8*)buffer.ptr, block_size * it.block_it->size,
+        (int64)(it.block_it->pos) * block_size, "File_Blocks::read_block::4");
+    verify_checksum(*it.block_it, buffer.ptr);
     LZ4_Inflate().decompress(buffer.ptr, block_size * it.block_it->size, buffer_, block_size * compression_factor);
   }
 
@@ -736,7 +762,7 @@ typename File_Blocks< TIndex, TIterator, TRangeIterator >::Discrete_Iterator
   data_file.write((uint8*)target, block_size * data_size, "File_Blocks::insert_block::2");
 
   TIndex index(((uint8*)buf)+(sizeof(uint32)+sizeof(uint32)));
-  File_Block_Index_Entry< TIndex > entry(index, pos, data_size, max_keysize);
+  File_Block_Index_Entry< TIndex > entry(index, pos, data_size, max_keysize, block_checksum(target, data_size));
   Discrete_Iterator return_it(it);
   if (return_it.block_it == return_it.block_begin)
   {
@@ -780,6 +806,7 @@ typename File_Blocks< TIndex, TIterator, TRangeIterator >::Discrete_Iterator
     it.block_it->index = TIndex((uint8*)buf+(sizeof(uint32)+sizeof(uint32)));
     it.block_it->max_keysize = max_keysize;
     it.block_it->size = data_size;
+    it.block_it->checksum = block_checksum(target, data_size);
 
     return it;
   }
@@ -798,4 +825,168 @@ typename File_Blocks< TIndex, TIterator, TRangeIterator >::Discrete_Iterator
   }
 }
 
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+void File_Blocks< TIndex, TIterator, TRangeIterator >::verify_checksum
+    (const File_Block_Index_Entry< TIndex >& entry, const void* data) const
+{
+  if (index->has_checksums() && checksum_verification_due()
+      && crc32c(data, block_size * entry.size) != entry.checksum)
+    throw File_Error(0, index->get_data_file_name(), "File_Blocks::read_block: Checksum mismatch");
+}
+
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+uint32 File_Blocks< TIndex, TIterator, TRangeIterator >::add_checksums()
+{
+  Void_Pointer< uint8 > buf(0);
+  uint32 buf_size = 0;
+  uint32 count = 0;
+  for (typename std::list< File_Block_Index_Entry< TIndex > >::iterator it = index->get_blocks().begin();
+      it != index->get_blocks().end(); ++it)
+  {
+    if (buf_size < block_size * it->size)
+    {
+      buf_size = block_size * it->size;
+      buf.resize(buf_size);
+    }
+    data_file.read_at(buf.ptr, block_size * it->size, ((int64)it->pos)*block_size,
+        "File_Blocks::add_checksums::1");
+    it->checksum = crc32c(buf.ptr, block_size * it->size);
+    ++count;
+  }
+  index->enable_checksums();
+  return count;
+}
+
+
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+void File_Blocks< TIndex, TIterator, TRangeIterator >::move_block
+    (File_Block_Index_Entry< TIndex >& entry, uint32 pos)
+{
+  // The block is copied as stored, hence compressed blocks need not be recompressed
+  Void_Pointer< uint8 > buf(block_size * entry.size);
+  data_file.read_at(buf.ptr, block_size * entry.size, ((int64)entry.pos)*block_size,
+      "File_Blocks::move_block::1");
+  data_file.seek(((int64)pos)*block_size, "File_Blocks::move_block::2");
+  data_file.write(buf.ptr, block_size * entry.size, "File_Blocks::move_block::3");
+  entry.pos = pos;
+}
+
+
+/* Each block has a target position such that the blocks follow each other in index order.
+ * A block is moved to its target if that space is free.
+ * Otherwise, the blocks occupying the target are moved to the end of the file.
+ * The space they leave is only free in a later transaction,
+ * because readers may still use the old positions until the current transaction is committed.
+ * Hence compact() needs to be called in several transactions until it reports completion. */
+template< typename TIndex, typename TIterator, typename TRangeIterator >
+uint64 File_Blocks< TIndex, TIterator, TRangeIterator >::compact(uint64 max_bytes, bool& complete)
+{
+  typedef typename std::list< File_Block_Index_Entry< TIndex > >::iterator Block_Iterator;
+
+  // Skip the blocks that are already in place
+  uint32 target = 0;
+  Block_Iterator it = index->get_blocks().begin();
+  while (it != index->get_blocks().end() && it->pos == target)
+  {
+    target += it->size;
+    ++it;
+  }
+
+  std::map< uint32, uint32 > free_runs;
+  for (std::vector< std::pair< uint32, uint32 > >::const_iterator vit = index->get_void_blocks().begin();
+      vit != index->get_void_blocks().end(); ++vit)
+    free_runs[vit->second] = vit->first;
+
+  std::map< uint32, Block_Iterator > occupied;
+  for (Block_Iterator oit = it; oit != index->get_blocks().end(); ++oit)
+    occupied[oit->pos] = oit;
+
+  uint64 written = 0;
+  complete = true;
+  for (; it != index->get_blocks().end(); ++it)
+  {
+    if (it->pos == target)
+    {
+      target += it->size;
+      continue;
+    }
+    complete = false;
+    if (written >= max_bytes)
+      break;
+
+    uint32 target_end = target + it->size;
+    bool target_free = (target >= index->block_count);
+    std::map< uint32, uint32 >::iterator run = free_runs.upper_bound(target);
+    if (!target_free && run != free_runs.begin())
+    {
+      --run;
+      uint32 run_end = run->first + run->second;
+      target_free = (run_end > target && (run_end >= target_end || run_end == index->block_count));
+    }
+
+    if (target_free)
+    {
+      // The target is free: cut it out of its gap and move the block there
+      if (target < index->block_count)
+      {
+        uint32 run_start = run->first;
+        uint32 run_end = run->first + run->second;
+        free_runs.erase(run);
+        if (run_start < target)
+          free_runs[run_start] = target - run_start;
+        if (target_end < run_end)
+          free_runs[target_end] = run_end - target_end;
+      }
+      index->block_count = std::max(index->block_count, target_end);
+      occupied.erase(it->pos);
+      move_block(*it, target);
+      occupied[target] = it;
+      written += block_size * it->size;
+    }
+    else
+    {
+      // Clear the target for a later transaction
+      typename std::map< uint32, Block_Iterator >::iterator oit = occupied.lower_bound(target);
+      if (oit != occupied.begin())
+      {
+        --oit;
+        if (oit->first + oit->second->size <= target)
+          ++oit;
+      }
+      while (oit != occupied.end() && oit->first < target_end)
+      {
+        Block_Iterator evicted = oit->second;
+        occupied.erase(oit++);
+        uint32 pos = std::max(index->block_count, target_end);
+        index->block_count = pos + evicted->size;
+        move_block(*evicted, pos);
+        occupied[pos] = evicted;
+        written += block_size * evicted->size;
+      }
+    }
+    target = target_end;
+  }
+
+  // A gap at the end of the file can be cut off
+  if (!free_runs.empty())
+  {
+    std::map< uint32, uint32 >::iterator run = --free_runs.end();
+    if (run->first + run->second == index->block_count)
+    {
+      index->block_count = run->first;
+      free_runs.erase(run);
+      data_file.resize(((int64)index->block_count)*block_size, "File_Blocks::compact::1");
+    }
+  }
+
+  index->get_void_blocks().clear();
+  for (std::map< uint32, uint32 >::const_iterator rit = free_runs.begin(); rit != free_runs.end(); ++rit)
+    index->get_void_blocks().push_back(std::make_pair(rit->second, rit->first));
+  std::stable_sort(index->get_void_blocks().begin(), index->get_void_blocks().end());
+
+  return written;
+}
+
 #endif
@@ -1579,6 +1579,32 @@ int main(int argc, char* args[])
   if ((test_to_execute == "") || (test_to_execute == "23"))
     variable_block_read_test();
 
+  if ((test_to_execute == "") || (test_to_execute == "26"))
+    std::cout<<"** Test the compaction of a fragmented file\n";
+  try
+  {
+    bool complete = false;
+    while (!complete)
+    {
+      Nonsynced_Transaction transaction(true, false, BASE_DIRECTORY, "");
+      Variable_Block_Test_File tf;
+      File_Blocks< IntIndex, IntIterator, IntRangeIterator > blocks
+          (transaction.data_index(&tf));
+
+      uint64 written = blocks.compact(4 * Variable_Block_Test_File().get_block_size(), complete);
+      if ((test_to_execute == "") || (test_to_execute == "26"))
+        std::cout<<"Compaction batch: "<<written<<" bytes written, complete: "<<complete<<'\n';
+    }
+  }
+  catch (File_Error e)
+  {
+    std::cout<<"File error catched: "
+        <<e.error_number<<' '<<e.filename<<' '<<e.origin<<'\n';
+    std::cout<<"(This is unexpected)\n";
+  }
+  if ((test_to_execute == "") || (test_to_execute == "26"))
+    variable_block_read_test();
+
   remove((BASE_DIRECTORY
       + Variable_Block_Test_File().get_file_name_trunk() + Variable_Block_Test_File().get_data_suffix()
       + Variable_Block_Test_File().get_index_suffix()).c_str());
@@ -1649,6 +1675,49 @@ int main(int argc, char* args[])
   if ((test_to_execute == "") || (test_to_execute == "25"))
     compressed_read_test();
 
+  if ((test_to_execute == "") || (test_to_execute == "27"))
+    std::cout<<"** Test checksums for the blocks of a compressed file\n";
+  try
+  {
+    Nonsynced_Transaction transaction(true, false, BASE_DIRECTORY, "");
+    Compressed_Test_File tf;
+    File_Blocks< IntIndex, IntIterator, IntRangeIterator > blocks
+        (transaction.data_index(&tf));
+    uint32 count = blocks.add_checksums();
+    if ((test_to_execute == "") || (test_to_execute == "27"))
+      std::cout<<"Added checksums to "<<count<<" blocks\n";
+
+    void* buf = malloc(Compressed_Test_File().get_block_size() * Compressed_Test_File().get_compression_factor());
+    std::list< IntIndex > indices;
+    for (int i = 2000; i < 2010; ++i)
+      indices.push_back(IntIndex(i));
+    uint32 max_keysize = prepare_block(buf, indices);
+    blocks.insert_block(blocks.discrete_end(), buf, max_keysize);
+    free(buf);
+  }
+  catch (File_Error e)
+  {
+    std::cout<<"File error catched: "
+        <<e.error_number<<' '<<e.filename<<' '<<e.origin<<'\n';
+    std::cout<<"(This is unexpected)\n";
+  }
+  if ((test_to_execute == "") || (test_to_execute == "27"))
+  {
+    compressed_read_test();
+
+    std::cout<<"Corrupting the first block on disk\n";
+    int data_fd = open64
+        ((BASE_DIRECTORY
+          + Compressed_Test_File().get_file_name_trunk()
+          + Compressed_Test_File().get_data_suffix()).c_str(), O_RDWR);
+    uint8 byte = 0;
+    pread64(data_fd, &byte, 1, 8);
+    byte ^= 0xff;
+    pwrite64(data_fd, &byte, 1, 8);
+    close(data_fd);
+    compressed_read_test();
+  }
+
   remove((BASE_DIRECTORY
       + Compressed_Test_File().get_file_name_trunk() + Compressed_Test_File().get_data_suffix()
       + Compressed_Test_File().get_index_suffix()).c_str());
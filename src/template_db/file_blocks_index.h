@@ -41,13 +41,16 @@ struct File_Block_Index_Entry
   static const int SEGMENT = 3;
   static const int LAST_SEGMENT = 4;
 
-  File_Block_Index_Entry(const TIndex& index_, uint32 pos_, uint32 size_, uint32 max_keysize_)
-    : index(index_), pos(pos_), size(size_), max_keysize(max_keysize_) {}
+  File_Block_Index_Entry(const TIndex& index_, uint32 pos_, uint32 size_, uint32 max_keysize_,
+                         uint32 checksum_ = 0)
+    : index(index_), pos(pos_), size(size_), max_keysize(max_keysize_), checksum(checksum_) {}
 
   TIndex index;
   uint32 pos;
   uint32 size;
   uint32 max_keysize;
+  // CRC-32C of the block as stored in the data file, only valid if the index has checksums
+  uint32 checksum;
 };
 
 
@@ -67,6 +70,9 @@ public:
   uint64 get_block_size() const { return block_size_; }
   uint32 get_compression_factor() const { return compression_factor; }
   uint32 get_compression_method() const { return compression_method; }
+  bool has_checksums() const { return checksums; }
+  // The caller must have set the checksums of all blocks before
+  void enable_checksums() { checksums = true; }
 
   std::list< File_Block_Index_Entry< TIndex > >& get_blocks()
   {
@@ -82,6 +88,8 @@ public:
   }
 
   static const int FILE_FORMAT_VERSION = 7512;
+  // Same as FILE_FORMAT_VERSION, but each entry has the checksum of its block after max_keysize
+  static const int FILE_FORMAT_VERSION_CHECKSUMS = 7513;
   static const int NO_COMPRESSION = 0;
   static const int ZLIB_COMPRESSION = 1;
   static const int LZ4_COMPRESSION = 2;
@@ -101,6 +109,7 @@ private:
   uint64 block_size_;
   uint32 compression_factor;
   int compression_method;
+  bool checksums;
 
   void init_structure_params();
   void init_blocks();
@@ -138,6 +147,7 @@ File_Blocks_Index< TIndex >::File_Blocks_Index
      compression_factor(file_prop.get_compression_factor()), // can be overwritten by index file
      compression_method(compression_method_ == USE_DEFAULT ?
         file_prop.get_compression_method() : compression_method_), // can be overwritten by index file
+     checksums(file_prop.get_block_checksums()), // can be overwritten by index file
      block_count(0)
 {
   try
@@ -182,8 +192,9 @@ void File_Blocks_Index< TIndex >::init_structure_params()
   {
     if (file_name_extension_ != ".legacy")
     {
-      if (*(int32*)index_buf.ptr != FILE_FORMAT_VERSION)
+      if (*(int32*)index_buf.ptr != FILE_FORMAT_VERSION && *(int32*)index_buf.ptr != FILE_FORMAT_VERSION_CHECKSUMS)
 	throw File_Error(0, index_file_name, "File_Blocks_Index: Unsupported index file format version");
+      checksums = (*(int32*)index_buf.ptr == FILE_FORMAT_VERSION_CHECKSUMS);
       block_size_ = 1ull<<*(uint8*)(index_buf.ptr + 4);
       compression_factor = 1u<<*(uint8*)(index_buf.ptr + 5);
       compression_method = *(uint16*)(index_buf.ptr + 6);
@@ -201,6 +212,7 @@ void File_Blocks_Index< TIndex >::init_blocks()
     if (file_name_extension_ == ".legacy")
       // We support this way the old format although it has no version marker.
     {
+      checksums = false;
       uint32 pos = 0;
       while (pos < index_size)
       {
@@ -219,18 +231,20 @@ void File_Blocks_Index< TIndex >::init_blocks()
     else if (index_size > 0)
     {
       uint32 pos = 8;
+      uint32 entry_head_size = (checksums ? 16 : 12);
       while (pos < index_size)
       {
-        TIndex index(index_buf.ptr + pos + 12);
+        TIndex index(index_buf.ptr + pos + entry_head_size);
         File_Block_Index_Entry< TIndex >
             entry(index,
 	    *(uint32*)(index_buf.ptr + pos),
 	    *(uint32*)(index_buf.ptr + pos + 4),
-	    *(uint32*)(index_buf.ptr + pos + 8));
+	    *(uint32*)(index_buf.ptr + pos + 8),
+	    checksums ? *(uint32*)(index_buf.ptr + pos + 12) : 0);
         blocks.push_back(entry);
         if (entry.pos >= block_count)
 	  throw File_Error(0, index_file_name, "File_Blocks_Index: bad pos in index file");
-	pos += 12;
+	pos += entry_head_size;
         pos += TIndex::size_of(index_buf.ptr + pos);
       }
     }
@@ -305,11 +319,11 @@ File_Blocks_Index< TIndex >::~File_Blocks_Index()
 
   for (typename std::list< File_Block_Index_Entry< TIndex > >::const_iterator
       it(blocks.begin()); it != blocks.end(); ++it)
-    index_size += 12 + it->index.size_of();
+    index_size += (checksums ? 16 : 12) + it->index.size_of();
 
   Void_Pointer< uint8 > index_buf(index_size);
 
-  *(uint32*)index_buf.ptr = FILE_FORMAT_VERSION;
+  *(uint32*)index_buf.ptr = (checksums ? FILE_FORMAT_VERSION_CHECKSUMS : FILE_FORMAT_VERSION);
   *(uint8*)(index_buf.ptr + 4) = shift_log(block_size_);
   *(uint8*)(index_buf.ptr + 5) = shift_log(compression_factor);
   *(uint16*)(index_buf.ptr + 6) = compression_method;
@@ -323,6 +337,11 @@ File_Blocks_Index< TIndex >::~File_Blocks_Index()
     pos += 4;
     *(uint32*)(index_buf.ptr+pos) = it->max_keysize;
     pos += 4;
+    if (checksums)
+    {
+      *(uint32*)(index_buf.ptr+pos) = it->checksum;
+      pos += 4;
+    }
     it->index.to_data(index_buf.ptr+pos);
     pos += it->index.size_of();
   }
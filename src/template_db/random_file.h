@@ -167,18 +167,20 @@ void Random_File< Key, Value >::move_cache_window(uint32 pos)
   }
   else
   {
-    val_file.seek((int64)(index->get_blocks()[pos].pos)*block_size, "Random_File:23");
     if (index->get_compression_method() == File_Blocks_Index_Base::NO_COMPRESSION)
-      val_file.read(cache.ptr, block_size * index->get_blocks()[pos].size, "Random_File:24");
+      val_file.read_at(cache.ptr, block_size * index->get_blocks()[pos].size,
+          (int64)(index->get_blocks()[pos].pos)*block_size, "Random_File:24");
     else if (index->get_compression_method() == File_Blocks_Index_Base::ZLIB_COMPRESSION)
     {
-      val_file.read(buffer.ptr, block_size * index->get_blocks()[pos].size, "Random_File:25");
+      val_file.read_at(buffer.ptr, block_size * index->get_blocks()[pos].size,
+          (int64)(index->get_blocks()[pos].pos)*block_size, "Random_File:25");
       Zlib_Inflate().decompress
           (buffer.ptr, block_size * index->get_blocks()[pos].size, cache.ptr, block_size * index->get_compression_factor());
     }
     else if (index->get_compression_method() == File_Blocks_Index_Base::LZ4_COMPRESSION)
     {
-      val_file.read(buffer.ptr, block_size * index->get_blocks()[pos].size, "Random_File:26");
+      val_file.read_at(buffer.ptr, block_size * index->get_blocks()[pos].size,
+          (int64)(index->get_blocks()[pos].pos)*block_size, "Random_File:26");
       LZ4_Inflate().decompress
           (buffer.ptr, block_size * index->get_blocks()[pos].size, cache.ptr, block_size * index->get_compression_factor());
     }
@@ -49,6 +49,78 @@ int& global_read_counter()
 }
 
 
+namespace
+{
+  struct Crc32c_Table
+  {
+    Crc32c_Table()
+    {
+      for (uint32 i = 0; i < 256; ++i)
+      {
+        uint32 crc = i;
+        for (int j = 0; j < 8; ++j)
+          crc = (crc>>1) ^ (0x82f63b78 & (0 - (crc & 1)));
+        table[i] = crc;
+      }
+    }
+
+    uint32 table[256];
+  };
+
+
+  uint32 crc32c_software(uint32 crc, const uint8* data, uint64 size)
+  {
+    static Crc32c_Table crc_table;
+    for (uint64 i = 0; i < size; ++i)
+      crc = crc_table.table[(crc ^ data[i]) & 0xff] ^ (crc>>8);
+    return crc;
+  }
+
+
+#if defined(__GNUC__) && defined(__x86_64__)
+  __attribute__((target("sse4.2")))
+  uint32 crc32c_hardware(uint32 crc, const uint8* data, uint64 size)
+  {
+    uint64 crc64 = crc;
+    for (; size >= 8; size -= 8, data += 8)
+    {
+      uint64 word;
+      memcpy(&word, data, 8);
+      crc64 = __builtin_ia32_crc32di(crc64, word);
+    }
+    crc = crc64;
+    for (; size > 0; --size, ++data)
+      crc = __builtin_ia32_crc32qi(crc, *data);
+    return crc;
+  }
+
+
+  bool cpu_has_crc32c()
+  {
+    static bool result = __builtin_cpu_supports("sse4.2");
+    return result;
+  }
+#endif
+}
+
+
+uint32 crc32c(const void* data, uint64 size)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+  if (cpu_has_crc32c())
+    return ~crc32c_hardware(0xffffffff, (const uint8*)data, size);
+#endif
+  return ~crc32c_software(0xffffffff, (const uint8*)data, size);
+}
+
+
+uint32& checksum_verification_interval()
+{
+  static uint32 interval = 1;
+  return interval;
+}
+
+
 void millisleep(uint32 milliseconds)
 {
   struct timeval timeout_;
@@ -33,6 +33,7 @@
 #define ftruncate64 ftruncate
 #define lseek64 lseek
 #define open64 open
+#define pread64 pread
 #endif
 
 
@@ -98,6 +99,8 @@ struct File_Properties
   virtual std::vector< bool > get_data_footprint(const std::string& db_dir) const = 0;
   virtual std::vector< bool > get_map_footprint(const std::string& db_dir) const = 0;
   virtual uint32 id_max_size_of() const = 0;
+  // Whether a newly created index stores a checksum per block. An existing index keeps its format.
+  virtual bool get_block_checksums() const { return false; }
 
   // The returned object is of type File_Blocks_Index< .. >*
   // and goes into the ownership of the caller.
@@ -120,6 +123,9 @@ class Raw_File
     uint64 size(const std::string& caller_id) const;
     void resize(uint64 size, const std::string& caller_id) const;
     void read(uint8* buf, uint64 size, const std::string& caller_id) const;
+    // Reads from the given position without moving the file offset.
+    // Processes that share the descriptor after fork() can use it concurrently.
+    void read_at(uint8* buf, uint64 size, uint64 pos, const std::string& caller_id) const;
     void write(uint8* buf, uint64 size, const std::string& caller_id) const;
     void seek(uint64 pos, const std::string& caller_id) const;
 
@@ -219,6 +225,13 @@ inline void Raw_File::read(uint8* buf, uint64 size, const std::string& caller_id
     throw File_Error(errno, name, caller_id);
 }
 
+inline void Raw_File::read_at(uint8* buf, uint64 size, uint64 pos, const std::string& caller_id) const
+{
+  uint64 foo = pread64(fd_, buf, size, pos);
+  if (foo != size)
+    throw File_Error(errno, name, caller_id);
+}
+
 inline void Raw_File::write(uint8* buf, uint64 size, const std::string& caller_id) const
 {
   uint64 foo = ::write(fd_, buf, size);
@@ -280,6 +293,20 @@ inline void zero_padding(uint8* from, uint32 bytes)
 int& global_read_counter();
 
 
+// CRC-32C (Castagnoli) of the given bytes. Uses the CRC instruction of the CPU if available.
+uint32 crc32c(const void* data, uint64 size);
+
+// Every n-th block read is checked against its checksum if the index has checksums.
+// Zero disables the check on read.
+uint32& checksum_verification_interval();
+
+inline bool checksum_verification_due()
+{
+  uint32 interval = checksum_verification_interval();
+  return interval > 0 && (uint32)global_read_counter() % interval == 0;
+}
+
+
 void millisleep(uint32 milliseconds);
 
 
@@ -18,6 +18,9 @@
 
 #include "zlib_wrapper.h"
 
+#include <sys/types.h>
+
+#include <cstdio>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
@@ -58,6 +61,86 @@ int Zlib_Deflate::compress(const void* in, int in_size, void* out, int out_buffe
 }
 
 
+Gzip_Streambuf::Gzip_Streambuf(std::streambuf* target_, int level)
+    : target(target_), in_buf(64*1024), out_buf(64*1024), finished(false), unflushed(false)
+{
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  // 16 added to the window bits selects the gzip header instead of the zlib header
+  int ret = deflateInit2(&strm, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+  if (ret != Z_OK)
+    throw Zlib_Deflate::Error(ret);
+  setp(&in_buf[0], &in_buf[0] + in_buf.size());
+}
+
+
+Gzip_Streambuf::~Gzip_Streambuf()
+{
+  deflateEnd(&strm);
+}
+
+
+bool Gzip_Streambuf::deflate_pending(int flush)
+{
+  strm.avail_in = pptr() - pbase();
+  strm.next_in = (unsigned char*)pbase();
+  if (flush == Z_SYNC_FLUSH && strm.avail_in == 0 && !unflushed)
+    return true;
+  unflushed = (flush == Z_NO_FLUSH);
+
+  int ret = Z_OK;
+  do
+  {
+    strm.avail_out = out_buf.size();
+    strm.next_out = (unsigned char*)&out_buf[0];
+    ret = deflate(&strm, flush);
+    if (ret == Z_STREAM_ERROR)
+      return false;
+    std::streamsize size = out_buf.size() - strm.avail_out;
+    if (target->sputn(&out_buf[0], size) != size)
+      return false;
+  }
+  while (strm.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+
+  setp(&in_buf[0], &in_buf[0] + in_buf.size());
+  return true;
+}
+
+
+Gzip_Streambuf::int_type Gzip_Streambuf::overflow(int_type c)
+{
+  if (finished || !deflate_pending(Z_NO_FLUSH))
+    return traits_type::eof();
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+  {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+
+int Gzip_Streambuf::sync()
+{
+  if (finished)
+    return target->pubsync();
+  if (!deflate_pending(Z_SYNC_FLUSH))
+    return -1;
+  return target->pubsync();
+}
+
+
+void Gzip_Streambuf::finish()
+{
+  if (finished)
+    return;
+  deflate_pending(Z_FINISH);
+  finished = true;
+  target->pubsync();
+}
+
+
 Zlib_Inflate::Zlib_Inflate()
 {
   strm.zalloc = Z_NULL;
@@ -109,3 +192,33 @@ const char* Zlib_Inflate::Error::what() const throw()
   out<<"Zlib_Inflate: "<<error_code;
   return out.str().c_str();
 }
+
+
+namespace
+{
+  ssize_t gzip_cookie_read(void* cookie, char* buf, size_t size)
+  {
+    int len = gzread((gzFile)cookie, buf, size);
+    return len < 0 ? -1 : len;
+  }
+
+
+  int gzip_cookie_close(void* cookie)
+  {
+    return gzclose((gzFile)cookie) == Z_OK ? 0 : EOF;
+  }
+}
+
+
+FILE* fopen_gzip(const std::string& file_name)
+{
+  gzFile file = gzopen(file_name.c_str(), "rb");
+  if (!file)
+    return 0;
+
+  cookie_io_functions_t functions = { gzip_cookie_read, 0, 0, gzip_cookie_close };
+  FILE* result = fopencookie(file, "r", functions);
+  if (!result)
+    gzclose(file);
+  return result;
+}
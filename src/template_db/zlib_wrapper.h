@@ -21,7 +21,11 @@
 
 #include "zlib.h"
 
+#include <cstdio>
 #include <exception>
+#include <streambuf>
+#include <string>
+#include <vector>
 
 
 class Zlib_Deflate
@@ -44,6 +48,33 @@ private:
 };
 
 
+/* Compresses everything written to it in gzip format and passes the result on to the target buffer.
+ * A sync emits all data received so far such that a client can decompress it immediately. */
+class Gzip_Streambuf : public std::streambuf
+{
+public:
+  Gzip_Streambuf(std::streambuf* target, int level);
+  ~Gzip_Streambuf();
+
+  // Writes the gzip trailer. Nothing must be written afterwards.
+  void finish();
+
+protected:
+  virtual int_type overflow(int_type c);
+  virtual int sync();
+
+private:
+  std::streambuf* target;
+  z_stream strm;
+  std::vector< char > in_buf;
+  std::vector< char > out_buf;
+  bool finished;
+  bool unflushed;
+
+  bool deflate_pending(int flush);
+};
+
+
 class Zlib_Inflate
 {
 public:
@@ -64,4 +95,10 @@ private:
 };
 
 
+/* Opens a gzip compressed file for reading. The returned FILE delivers the decompressed content,
+ * hence it can be passed to any reader of plain files. It must be closed with fclose,
+ * which fails if the compressed content has turned out to be corrupt. Returns 0 on failure. */
+FILE* fopen_gzip(const std::string& file_name);
+
+
 #endif
@@ -84,6 +84,10 @@ $BASEDIR/test-bin/run_testsuite_interpreter.sh $DATA_SIZE $2
 
 $BASEDIR/test-bin/run_unittests_output_csv.sh $DATA_SIZE $2
 
+$BASEDIR/test-bin/run_unittests_output_pbf.sh $DATA_SIZE $2
+
+$BASEDIR/test-bin/run_unittests_clone_delta.sh $DATA_SIZE $2
+
 $BASEDIR/test-bin/run_unittests_areas.sh $DATA_SIZE $2
 
 if [[ $DATA_SIZE -gt 800 ]]; then
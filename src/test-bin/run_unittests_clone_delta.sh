@@ -0,0 +1,144 @@
+#!/usr/bin/env bash
+
+# Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+#
+# This file is part of Overpass_API.
+#
+# Overpass_API is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as
+# published by the Free Software Foundation, either version 3 of the
+# License, or (at your option) any later version.
+#
+# Overpass_API is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with Overpass_API. If not, see <https://www.gnu.org/licenses/>.
+
+if [[ -z $1  ]]; then
+{
+  echo "Usage: $0 test_size"
+  echo
+  echo "An appropriate value for a fast test is 40, a comprehensive value is 2000."
+  exit 0
+};
+fi
+
+# The size of the test pattern. Asymptotically, the test pattern consists of
+# size^2 elements. The size must be divisible by ten. For a full featured test,
+# set the value to 2000.
+DATA_SIZE="$1"
+BASEDIR="$(cd `dirname $0` && pwd)/.."
+NOTIMES="$2"
+
+EXEC="clone_delta"
+ANY_FAILED=
+
+report_test()
+{
+  I="$1"
+
+  if [[ -n $FAILED ]]; then
+  {
+    echo `date +%T` "Test $EXEC $I FAILED."
+    ANY_FAILED=YES
+  }; else
+  {
+    echo `date +%T` "Test $EXEC $I succeeded."
+  }; fi
+};
+
+# Compares all files of the clone in $1 to the same files in $2
+compare_clone()
+{
+  for MANIFEST in `ls $1/*.manifest`; do
+  {
+    FILE=`basename ${MANIFEST%.manifest}`
+    if ! cmp -s "$1/$FILE" "$2/$FILE"; then
+    {
+      echo "In Test $EXEC $I: $2/$FILE differs from $1/$FILE."
+      FAILED=YES
+    }; fi
+  }; done
+};
+
+mkdir -p run/$EXEC
+pushd run/$EXEC/ >/dev/null
+rm -fR *
+
+mkdir -p db/templates
+cp -p $BASEDIR/templates/* db/templates/
+$BASEDIR/test-bin/generate_test_file_meta $DATA_SIZE >init.osm
+$BASEDIR/bin/update_database --db-dir=db/ --meta --version=mock-up-init <init.osm 2>/dev/null
+
+mkdir -p old
+$BASEDIR/bin/osm3s_query --db-dir=db/ --clone=old/ >old.out 2>&1
+
+# Change a few blocks: a node moved far away and a way with a new tag
+cat >diff.osc <<EOF
+<osmChange version="0.6">
+<modify>
+  <node id="1" lat="-40.0" lon="-120.0" version="4" timestamp="2003-01-01T00:00:01Z" changeset="101" uid="11" user="User_11">
+    <tag k="clone" v="delta"/>
+  </node>
+  <way id="1" version="5" timestamp="2003-01-01T00:00:02Z" changeset="101" uid="11" user="User_11">
+    <nd ref="1"/>
+    <nd ref="2"/>
+    <tag k="clone" v="delta"/>
+  </way>
+</modify>
+</osmChange>
+EOF
+$BASEDIR/bin/update_database --db-dir=db/ --meta --version=mock-up-diff <diff.osc 2>/dev/null
+
+mkdir -p new
+$BASEDIR/bin/osm3s_query --db-dir=db/ --clone=new/ >new.out 2>&1
+
+FILES=
+for MANIFEST in `ls new/*.manifest`; do
+  FILES="$FILES --file=`basename ${MANIFEST%.manifest}`"
+done
+
+# Test 1: a replica at the state of the old clone reaches the state of the new clone
+I=1
+FAILED=
+cp -pR old replica
+if ! $BASEDIR/bin/clone_delta --db-dir=replica/ --source="$(pwd)/new/" $FILES >delta_$I.out 2>delta_$I.err; then
+{
+  echo "In Test $EXEC $I: clone_delta failed."
+  FAILED=YES
+}; fi
+compare_clone new replica
+# Moving the node changes a single block of the map file
+if [[ -z `awk '$1 == "nodes.map:" && $3 == 1 && $5 > 1' delta_$I.out` ]]; then
+{
+  echo "In Test $EXEC $I: Not only the changed block of nodes.map has been fetched."
+  FAILED=YES
+}; fi
+report_test $I
+
+# Test 2: a failed fetch leaves the local file untouched and no partial file behind
+I=2
+FAILED=
+cp -pR old replica_2
+cp -pR new broken
+: >broken/nodes.bin
+if $BASEDIR/bin/clone_delta --db-dir=replica_2/ --source="$(pwd)/broken/" --file=nodes.bin >delta_$I.out 2>delta_$I.err; then
+{
+  echo "In Test $EXEC $I: clone_delta has not reported the failed fetch."
+  FAILED=YES
+}; fi
+if [[ -f replica_2/nodes.bin.delta ]]; then
+{
+  echo "In Test $EXEC $I: replica_2/nodes.bin.delta has been left behind."
+  FAILED=YES
+}; fi
+compare_clone old replica_2
+report_test $I
+
+popd >/dev/null
+if [[ -z $ANY_FAILED ]]; then
+  rm -fR run/$EXEC/
+fi
@@ -0,0 +1,136 @@
+#!/usr/bin/env bash
+
+# Copyright 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018 Roland Olbricht et al.
+#
+# This file is part of Overpass_API.
+#
+# Overpass_API is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero General Public License as
+# published by the Free Software Foundation, either version 3 of the
+# License, or (at your option) any later version.
+#
+# Overpass_API is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with Overpass_API. If not, see <https://www.gnu.org/licenses/>.
+
+if [[ -z $1  ]]; then
+{
+  echo "Usage: $0 test_size"
+  echo
+  echo "An appropriate value for a fast test is 40, a comprehensive value is 2000."
+  exit 0
+};
+fi
+
+# The size of the test pattern. Asymptotically, the test pattern consists of
+# size^2 elements. The size must be divisible by ten. For a full featured test,
+# set the value to 2000.
+DATA_SIZE="$1"
+BASEDIR="$(cd `dirname $0` && pwd)/.."
+NOTIMES="$2"
+
+evaluate_test()
+{
+  DIRNAME="$1"
+
+  FAILED=
+  for FILE in `ls ../../expected/$DIRNAME/`; do
+  {
+    if [[ ! -f $FILE ]]; then
+    {
+      echo "In Test $EXEC $I: Expected file \"$FILE\" doesn't exist."
+      FAILED=YES
+    }; fi
+  }; done
+  for FILE in `ls`; do
+  {
+    if [[ ! -f "../../expected/$DIRNAME/$FILE" ]]; then
+    {
+      echo "In Test $EXEC $I: Unexpected file \"$FILE\" exists."
+      FAILED=YES
+    }; else
+    {
+      RES=`diff -q "../../expected/$DIRNAME/$FILE" "$FILE"`
+      if [[ -n $RES ]]; then
+      {
+        echo $RES
+        FAILED=YES
+      }; fi
+    }; fi
+  }; done
+};
+
+perform_test_query()
+{
+  EXEC="output_pbf"
+  I="$1"
+
+  mkdir -p "run/${EXEC}_$I"
+  pushd "run/${EXEC}_$I/" >/dev/null
+  rm -f *
+  # Only the decoder writes to stderr.log, hence any problem with the encoding shows up there
+  $BASEDIR/bin/osm3s_query --db-dir=../../input/update_database/ <"../../input/${EXEC}_$I/stdin.log" 2>/dev/null \
+      | $BASEDIR/test-bin/output_pbf >stdout.log 2>stderr.log
+  evaluate_test "${EXEC}_$I"
+  if [[ -n $FAILED ]]; then
+  {
+    echo `date +%T` "Test $EXEC $I FAILED."
+  }; else
+  {
+    echo `date +%T` "Test $EXEC $I succeeded."
+    rm -R *
+  }; fi
+  popd >/dev/null
+};
+
+# Prepare testing the statements with meta
+mkdir -p input/update_database/
+rm -f input/update_database/*
+mkdir -p input/update_database/templates/
+cp -p $BASEDIR/templates/* input/update_database/templates/
+$BASEDIR/test-bin/generate_test_file_meta 40 more_tags >input/update_database/stdin.log
+$BASEDIR/bin/update_database --db-dir=input/update_database/ --meta --version=mock-up-init <input/update_database/stdin.log
+
+II=1
+while [[ $II -lt 12 ]]; do
+{
+  mkdir -p input/output_pbf_$II/
+  II=$(($II + 1))
+}; done
+
+# Nodes always carry their position, also in the modes without coordinates
+echo '[out:pbf];(node(1);node(2);node(7);node(14);way(1);way(2);way(7);way(14);rel(1);rel(2);rel(42);rel(161););out ids;' >input/output_pbf_1/stdin.log
+echo '[out:pbf];(node(1);node(2);node(7);node(14);way(1);way(2);way(7);way(14);rel(1);rel(2);rel(42);rel(161););out tags;' >input/output_pbf_2/stdin.log
+echo '[out:pbf];(node(1);node(2);node(7);node(14);way(1);way(2);way(7);way(14);rel(1);rel(2);rel(42);rel(161););out skel;' >input/output_pbf_3/stdin.log
+echo '[out:pbf];(node(1);node(2);node(7);node(14);way(1);way(2);way(7);way(14);rel(1);rel(2);rel(42);rel(161););out;' >input/output_pbf_4/stdin.log
+echo '[out:pbf];(node(1);node(2);node(7);node(14);way(1);way(2);way(7);way(14);rel(1);rel(2);rel(42);rel(161););out meta;' >input/output_pbf_5/stdin.log
+
+# Ways with and without node locations
+echo '[out:pbf];(node(1);node(2);node(7);node(14);way(1);way(2);way(7);way(14);rel(1);rel(2);rel(42);rel(161););out geom;' >input/output_pbf_6/stdin.log
+echo '[out:pbf];(node(1);node(2);node(7);node(14);way(1);way(2);way(7);way(14);rel(1);rel(2);rel(42);rel(161););out geom meta;' >input/output_pbf_7/stdin.log
+echo '[out:pbf];(node(1);node(2);node(7);node(14);way(1);way(2);way(7);way(14);rel(1);rel(2);rel(42);rel(161););out center;' >input/output_pbf_8/stdin.log
+
+# Many elements with the same tags and users share the entries of the string tables
+echo '[out:pbf];node(10.0,1.0,10.06,2.0);out meta;' >input/output_pbf_9/stdin.log
+echo '[out:pbf];way(10.0,1.0,10.06,2.0);out meta;' >input/output_pbf_10/stdin.log
+echo '[out:pbf];(node(10.0,1.0,10.06,2.0);way(10.0,1.0,10.06,2.0);rel(10.0,1.0,10.06,2.0););out meta;' >input/output_pbf_11/stdin.log
+
+II=1
+while [[ $II -lt 12 ]]; do
+{
+  perform_test_query $II
+  II=$(($II + 1))
+}; done
+
+rm -fR input/update_database/*
+
+II=1
+while [[ $II -lt 12 ]]; do
+{
+  rm -fR input/output_pbf_$II/
+  II=$(($II + 1))
+}; done